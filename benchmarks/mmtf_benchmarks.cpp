@@ -0,0 +1,435 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Google Benchmark suite for the binary codecs and the top-level APIs.
+// Build with -Dmmtf_build_benchmarks=ON and run e.g.:
+//   ./benchmarks/mmtf_benchmarks --benchmark_filter=BinaryDecode
+//
+// Synthetic structures (mmtf::generateSyntheticStructure) are used at sizes
+// from 1k to 10M atoms (argument "atoms" of each benchmark) and the files in
+// temporary_test_data.
+//
+// *************************************************************************
+
+#include <mmtf.hpp>
+#include <mmtf/export_helpers.hpp>
+#include <mmtf/synthetic.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::vector<int64_t> kSizes = {1000, 10000, 100000, 1000000, 10000000};
+// generating huge PDB-like strings is not useful
+const std::vector<int64_t> kPrintSizes = {1000, 10000, 100000, 1000000};
+
+// ------------------------------------------------------------------------
+// synthetic data
+// ------------------------------------------------------------------------
+
+const mmtf::StructureData& syntheticStructure(int64_t num_atoms) {
+  static std::map<int64_t, mmtf::StructureData> cache;
+  mmtf::StructureData& sd = cache[num_atoms];
+  if (sd.numAtoms == 0) {
+    mmtf::SyntheticOptions options;
+    options.numAtoms = int32_t(num_atoms);
+    mmtf::generateSyntheticStructure(sd, options);
+  }
+  return sd;
+}
+
+const std::string& packedStructure(int64_t num_atoms) {
+  static std::map<int64_t, std::string> cache;
+  std::string& packed = cache[num_atoms];
+  if (packed.empty()) {
+    std::stringstream buffer;
+    mmtf::encodeToStream(syntheticStructure(num_atoms), buffer);
+    packed = buffer.str();
+  }
+  return packed;
+}
+
+// per-atom columns for codecs without a matching field
+struct Columns {
+  std::vector<int8_t> small;        // runs of small values
+  std::vector<char> chars;          // runs of letters
+  std::vector<std::string> names;   // atom names
+  std::vector<int32_t> scaled;      // B-factors * 100
+  std::vector<int16_t> scaled16;    // same as 16 bit ints
+  std::vector<int32_t> tiny;        // values in [-100, 100]
+  std::vector<float> tiny_floats;   // tiny / 100
+  std::vector<float> trajectory;    // 10 models with slightly moving atoms
+  std::vector<int32_t> model_sizes; // sizes of models in trajectory
+};
+
+const Columns& syntheticColumns(int64_t num_atoms) {
+  static std::map<int64_t, Columns> cache;
+  Columns& columns = cache[num_atoms];
+  if (!columns.small.empty()) return columns;
+  const mmtf::StructureData& sd = syntheticStructure(num_atoms);
+  for (int32_t g = 0; g < sd.numGroups; ++g) {
+    const mmtf::GroupType& group = sd.groupList[sd.groupTypeList[g]];
+    columns.names.insert(columns.names.end(), group.atomNameList.begin(),
+                         group.atomNameList.end());
+  }
+  for (int32_t i = 0; i < sd.numAtoms; ++i) {
+    columns.small.push_back(int8_t((i / 37) % 4 - 1));
+    columns.chars.push_back(char('A' + (i / 53) % 3));
+    columns.scaled.push_back(int32_t(std::lround(sd.bFactorList[i] * 100)));
+    columns.scaled16.push_back(int16_t(columns.scaled.back()));
+    columns.tiny.push_back((i * 37) % 201 - 100);
+    columns.tiny_floats.push_back(float(columns.tiny.back()) / 100);
+  }
+  const int32_t model_size = sd.numAtoms / 10;
+  columns.model_sizes.assign(10, model_size);
+  for (int32_t m = 0; m < 10; ++m) {
+    for (int32_t i = 0; i < model_size; ++i) {
+      const float jitter = 0.001f * float((i * 7 + m * 13) % 101 - 50);
+      columns.trajectory.push_back(sd.xCoordList[i] + jitter);
+    }
+  }
+  return columns;
+}
+
+std::string toString(const std::vector<char>& bytes) {
+  return std::string(bytes.begin(), bytes.end());
+}
+
+std::string makeStrategyBinary(int32_t strategy, int64_t num_atoms) {
+  const mmtf::StructureData& sd = syntheticStructure(num_atoms);
+  const Columns& c = syntheticColumns(num_atoms);
+  switch (strategy) {
+  case 1: return toString(mmtf::encodeFourByteFloat(sd.xCoordList));
+  case 2: return toString(mmtf::encodeInt8ToByte(c.small));
+  case 3: return toString(mmtf::encodeTwoByteInt(c.scaled16));
+  case 4: return toString(mmtf::encodeFourByteInt(sd.atomIdList));
+  case 5: return toString(mmtf::encodeStringVector(c.names, 4));
+  case 6: return toString(mmtf::encodeRunLengthChar(c.chars));
+  case 7:
+    return toString(mmtf::encodeRunLengthInt(
+        std::vector<int32_t>(c.small.begin(), c.small.end())));
+  case 8: return toString(mmtf::encodeRunLengthDeltaInt(sd.atomIdList));
+  case 9: return toString(mmtf::encodeRunLengthFloat(sd.occupancyList, 100));
+  case 10: return toString(mmtf::encodeDeltaRecursiveFloat(sd.xCoordList, 1000));
+  case 11: return toString(mmtf::encodeTwoByteFloat(sd.bFactorList, 100));
+  case 12: return toString(mmtf::encodeRecursiveFloat(sd.bFactorList, 100));
+  case 13:
+    return toString(mmtf::encodeRecursiveByteFloat(c.tiny_floats, 100));
+  case 14: return toString(mmtf::encodeRecursiveInt(c.scaled));
+  case 15: return toString(mmtf::encodeRecursiveByteInt(c.tiny));
+  case 16: return toString(mmtf::encodeRunLengthInt8(c.small));
+  case 100:
+    return toString(mmtf::encodeModelDeltaFloat(c.trajectory, c.model_sizes,
+                                                1000));
+  }
+  return std::string();
+}
+
+// ------------------------------------------------------------------------
+// binary codecs
+// ------------------------------------------------------------------------
+
+template <typename T>
+void decodeBinary(benchmark::State& state, const std::string& binary) {
+  mmtf::BinaryDecoder bd(binary, "benchmark");
+  T decoded;
+  for (auto _ : state) {
+    bd.decode(decoded);
+    benchmark::DoNotOptimize(decoded.data());
+  }
+  state.SetItemsProcessed(state.iterations() * decoded.size());
+  state.SetBytesProcessed(state.iterations() * binary.size());
+}
+
+void BM_BinaryDecode(benchmark::State& state) {
+  const int32_t strategy = int32_t(state.range(0));
+  const std::string binary = makeStrategyBinary(strategy, state.range(1));
+  switch (strategy) {
+  case 2: case 16:
+    decodeBinary<std::vector<int8_t> >(state, binary);
+    break;
+  case 3:
+    decodeBinary<std::vector<int16_t> >(state, binary);
+    break;
+  case 4: case 7: case 8: case 14: case 15:
+    decodeBinary<std::vector<int32_t> >(state, binary);
+    break;
+  case 5:
+    decodeBinary<std::vector<std::string> >(state, binary);
+    break;
+  case 6:
+    decodeBinary<std::vector<char> >(state, binary);
+    break;
+  default:
+    decodeBinary<std::vector<float> >(state, binary);
+  }
+}
+BENCHMARK(BM_BinaryDecode)
+    ->ArgNames({"strategy", "atoms"})
+    ->ArgsProduct({{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 100},
+                   kSizes})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_BinaryDecodeFixedWidth(benchmark::State& state) {
+  // strategy 5 into packed strings instead of std::vector<std::string>
+  const std::string binary = makeStrategyBinary(5, state.range(0));
+  mmtf::BinaryDecoder bd(binary, "benchmark");
+  mmtf::FixedWidthStringList decoded;
+  for (auto _ : state) {
+    bd.decode(decoded);
+    benchmark::DoNotOptimize(decoded.bytes().data());
+  }
+  state.SetItemsProcessed(state.iterations() * decoded.size());
+  state.SetBytesProcessed(state.iterations() * binary.size());
+}
+BENCHMARK(BM_BinaryDecodeFixedWidth)->ArgName("atoms")->ArgsProduct({kSizes})
+    ->Unit(benchmark::kMicrosecond);
+
+template <typename Encode>
+void encodeBinary(benchmark::State& state, Encode encode) {
+  size_t num_bytes = 0;
+  for (auto _ : state) {
+    const std::vector<char> encoded = encode();
+    benchmark::DoNotOptimize(encoded.data());
+    num_bytes = encoded.size();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes"] = double(num_bytes);
+}
+
+void BM_encodeInt8ToByte(benchmark::State& state) {
+  const Columns& c = syntheticColumns(state.range(0));
+  encodeBinary(state, [&] { return mmtf::encodeInt8ToByte(c.small); });
+}
+void BM_encodeFourByteInt(benchmark::State& state) {
+  const mmtf::StructureData& sd = syntheticStructure(state.range(0));
+  encodeBinary(state, [&] { return mmtf::encodeFourByteInt(sd.atomIdList); });
+}
+void BM_encodeStringVector(benchmark::State& state) {
+  const Columns& c = syntheticColumns(state.range(0));
+  encodeBinary(state, [&] { return mmtf::encodeStringVector(c.names, 4); });
+}
+void BM_encodeRunLengthChar(benchmark::State& state) {
+  const Columns& c = syntheticColumns(state.range(0));
+  encodeBinary(state, [&] { return mmtf::encodeRunLengthChar(c.chars); });
+}
+void BM_encodeRunLengthDeltaInt(benchmark::State& state) {
+  const mmtf::StructureData& sd = syntheticStructure(state.range(0));
+  encodeBinary(state, [&] {
+    return mmtf::encodeRunLengthDeltaInt(sd.atomIdList);
+  });
+}
+void BM_encodeRunLengthFloat(benchmark::State& state) {
+  const mmtf::StructureData& sd = syntheticStructure(state.range(0));
+  encodeBinary(state, [&] {
+    return mmtf::encodeRunLengthFloat(sd.occupancyList, 100);
+  });
+}
+void BM_encodeDeltaRecursiveFloat(benchmark::State& state) {
+  const mmtf::StructureData& sd = syntheticStructure(state.range(0));
+  encodeBinary(state, [&] {
+    return mmtf::encodeDeltaRecursiveFloat(sd.xCoordList, 1000);
+  });
+}
+void BM_encodeRunLengthInt8(benchmark::State& state) {
+  const Columns& c = syntheticColumns(state.range(0));
+  encodeBinary(state, [&] { return mmtf::encodeRunLengthInt8(c.small); });
+}
+void BM_encodeModelDeltaFloat(benchmark::State& state) {
+  const Columns& c = syntheticColumns(state.range(0));
+  encodeBinary(state, [&] {
+    return mmtf::encodeModelDeltaFloat(c.trajectory, c.model_sizes, 1000);
+  });
+}
+void BM_encodeBinary(benchmark::State& state) {
+  // encoders without a dedicated benchmark above
+  const int32_t strategy = int32_t(state.range(1));
+  const mmtf::StructureData& sd = syntheticStructure(state.range(0));
+  const Columns& c = syntheticColumns(state.range(0));
+  switch (strategy) {
+  case 3:
+    encodeBinary(state, [&] { return mmtf::encodeBinary(c.scaled16, 3); });
+    break;
+  case 7: case 14:
+    encodeBinary(state, [&] {
+      return mmtf::encodeBinary(c.scaled, strategy);
+    });
+    break;
+  case 15:
+    encodeBinary(state, [&] { return mmtf::encodeBinary(c.tiny, 15); });
+    break;
+  case 13:
+    encodeBinary(state, [&] {
+      return mmtf::encodeBinary(c.tiny_floats, 13, 100);
+    });
+    break;
+  default:
+    encodeBinary(state, [&] {
+      return mmtf::encodeBinary(sd.bFactorList, strategy, 100);
+    });
+  }
+}
+BENCHMARK(BM_encodeInt8ToByte)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeFourByteInt)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeStringVector)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeRunLengthChar)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeRunLengthDeltaInt)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeRunLengthFloat)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeDeltaRecursiveFloat)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeRunLengthInt8)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeModelDeltaFloat)->ArgName("atoms")->ArgsProduct({kSizes});
+BENCHMARK(BM_encodeBinary)->ArgNames({"atoms", "strategy"})
+    ->ArgsProduct({kSizes, {1, 3, 7, 11, 12, 13, 14, 15}});
+
+// ------------------------------------------------------------------------
+// top-level APIs
+// ------------------------------------------------------------------------
+
+void mapDecoderInit(benchmark::State& state, const std::string& packed) {
+  for (auto _ : state) {
+    mmtf::MapDecoder md;
+    mmtf::mapDecoderFromBuffer(md, packed.data(), packed.size());
+    benchmark::DoNotOptimize(&md);
+  }
+  state.SetBytesProcessed(state.iterations() * packed.size());
+}
+
+void decodeFromBuffer(benchmark::State& state, const std::string& packed) {
+  for (auto _ : state) {
+    mmtf::StructureData sd;
+    mmtf::decodeFromBuffer(sd, packed.data(), packed.size());
+    benchmark::DoNotOptimize(sd.xCoordList.data());
+  }
+  state.SetBytesProcessed(state.iterations() * packed.size());
+}
+
+void encodeToStream(benchmark::State& state, const mmtf::StructureData& sd,
+                    bool check_consistency = true) {
+  size_t num_bytes = 0;
+  for (auto _ : state) {
+    std::stringstream buffer;
+    mmtf::encodeToStream(sd, buffer, 1000, 100, 4, check_consistency);
+    num_bytes = size_t(buffer.tellp());
+  }
+  state.SetBytesProcessed(state.iterations() * num_bytes);
+}
+
+void BM_MapDecoderInit(benchmark::State& state) {
+  mapDecoderInit(state, packedStructure(state.range(0)));
+}
+void BM_decodeFromBuffer(benchmark::State& state) {
+  decodeFromBuffer(state, packedStructure(state.range(0)));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+void BM_encodeToStream(benchmark::State& state) {
+  encodeToStream(state, syntheticStructure(state.range(0)));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+void BM_encodeToStreamTrusted(benchmark::State& state) {
+  encodeToStream(state, syntheticStructure(state.range(0)), false);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+void BM_hasConsistentData(benchmark::State& state) {
+  const mmtf::StructureData& sd = syntheticStructure(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sd.hasConsistentData());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+void BM_compressGroupList(benchmark::State& state) {
+  // one group type per group as produced by many converters
+  const mmtf::StructureData& sd = syntheticStructure(state.range(0));
+  mmtf::StructureData expanded;
+  for (int32_t g = 0; g < sd.numGroups; ++g) {
+    expanded.groupList.push_back(sd.groupList[sd.groupTypeList[g]]);
+    expanded.groupTypeList.push_back(g);
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    mmtf::StructureData work;
+    work.groupList = expanded.groupList;
+    work.groupTypeList = expanded.groupTypeList;
+    state.ResumeTiming();
+    mmtf::compressGroupList(work);
+    benchmark::DoNotOptimize(work.groupList.data());
+  }
+  state.SetItemsProcessed(state.iterations() * sd.numGroups);
+}
+void BM_print(benchmark::State& state) {
+  const mmtf::StructureData& sd = syntheticStructure(state.range(0));
+  for (auto _ : state) {
+    const std::string printed = sd.print();
+    benchmark::DoNotOptimize(printed.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MapDecoderInit)->ArgName("atoms")->ArgsProduct({kSizes})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_decodeFromBuffer)->ArgName("atoms")->ArgsProduct({kSizes})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_encodeToStream)->ArgName("atoms")->ArgsProduct({kSizes})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_encodeToStreamTrusted)->ArgName("atoms")->ArgsProduct({kSizes})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_hasConsistentData)->ArgName("atoms")->ArgsProduct({kSizes})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_compressGroupList)->ArgName("atoms")->ArgsProduct({kSizes})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_print)->ArgName("atoms")->ArgsProduct({kPrintSizes})
+    ->Unit(benchmark::kMillisecond);
+
+// ------------------------------------------------------------------------
+// test data files
+// ------------------------------------------------------------------------
+
+void registerFileBenchmarks() {
+  static const char* files[] = {"1PEF_with_resonance.mmtf", "3zqs.mmtf",
+                                "all_canoncial.mmtf"};
+  static std::vector<std::string> names;
+  static std::vector<std::string> buffers;
+  static std::vector<mmtf::StructureData> structures;
+  for (const char* file : files) {
+    const std::string path = std::string(MMTF_BENCHMARK_DATA_DIR) + "/" + file;
+    std::ifstream ifs(path.c_str(), std::ios::binary);
+    if (!ifs) continue;
+    std::stringstream contents;
+    contents << ifs.rdbuf();
+    names.push_back(file);
+    buffers.push_back(contents.str());
+  }
+  structures.resize(buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    const std::string& packed = buffers[i];
+    mmtf::decodeFromBuffer(structures[i], packed.data(), packed.size());
+    const std::string& name = names[i];
+    const mmtf::StructureData& sd = structures[i];
+    benchmark::RegisterBenchmark(("BM_MapDecoderInit/" + name).c_str(),
+        [&packed](benchmark::State& state) { mapDecoderInit(state, packed); });
+    benchmark::RegisterBenchmark(("BM_decodeFromBuffer/" + name).c_str(),
+        [&packed](benchmark::State& state) { decodeFromBuffer(state, packed); });
+    benchmark::RegisterBenchmark(("BM_encodeToStream/" + name).c_str(),
+        [&sd](benchmark::State& state) { encodeToStream(state, sd); });
+  }
+}
+
+} // anon ns
+
+int main(int argc, char** argv) {
+  registerFileBenchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,65 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Generates a synthetic structure of given size with
+// mmtf::generateSyntheticStructure and writes it as MMTF file.
+// *************************************************************************
+
+#include <mmtf.hpp>
+#include <mmtf/synthetic.hpp>
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+namespace {
+
+// parse positive int32 number (false for garbage, overflow or values < 1)
+bool parsePositive(const char* str, int32_t& value) {
+    char* end;
+    errno = 0;
+    const long parsed = std::strtol(str, &end, 10);
+    if (end == str || *end != '\0' || errno == ERANGE || parsed < 1
+        || parsed > INT_MAX) {
+        return false;
+    }
+    value = int32_t(parsed);
+    return true;
+}
+
+} // anon ns
+
+int main(int argc, char** argv) {
+    // check arguments
+    if (argc < 3 || argc > 5) {
+      std::cout << "USAGE: ./generate_synthetic <out mmtf file> <num atoms> "
+                   "[num models] [seed]" << std::endl;
+      return 1;
+    }
+
+    mmtf::SyntheticOptions options;
+    if (   !parsePositive(argv[2], options.numAtoms)
+        || (argc > 3 && !parsePositive(argv[3], options.numModels))) {
+      std::cerr << "Number of atoms and models must be positive integers"
+                << std::endl;
+      return 1;
+    }
+    if (argc > 4) options.seed = uint32_t(std::strtoul(argv[4], NULL, 10));
+    mmtf::StructureData d;
+    try {
+      mmtf::generateSyntheticStructure(d, options);
+      mmtf::encodeToFile(d, argv[1]);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    std::cout << "Wrote " << d.numAtoms << " atoms, " << d.numGroups
+              << " groups, " << d.numChains << " chains and " << d.numModels
+              << " models to " << argv[1] << std::endl;
+    return 0;
+}
@@ -0,0 +1,226 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Decodes, re-encodes and re-decodes a corpus of MMTF files on N threads,
+// verifies that the round trip yields equal data and reports throughput
+// (files/s, MB/s, atoms/s) and per-phase latency percentiles (p50/p99).
+//
+// Inputs are MMTF files, directories (all *.mmtf files, not recursive; not
+// supported on Windows) or @list files with one path per line.
+// *************************************************************************
+
+#include <mmtf.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
+namespace {
+
+enum Phase { READ, DECODE, ENCODE, REDECODE, VERIFY, NUM_PHASES };
+const char* const PHASE_NAMES[NUM_PHASES] = {"read", "decode", "encode",
+                                             "re-decode", "verify"};
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool hasSuffix(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size()
+           && str.compare(str.size() - suffix.size(), suffix.size(),
+                          suffix) == 0;
+}
+
+// add file, files of directory or files listed in @list file
+void collectFiles(const std::string& arg, std::vector<std::string>& files) {
+    if (!arg.empty() && arg[0] == '@') {
+        std::ifstream list(arg.substr(1).c_str());
+        if (!list) throw std::runtime_error("Could not open " + arg.substr(1));
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty()) files.push_back(line);
+        }
+        return;
+    }
+#ifndef _WIN32
+    DIR* dir = opendir(arg.c_str());
+    if (dir) {
+        std::vector<std::string> entries;
+        while (dirent* entry = readdir(dir)) {
+            const std::string name(entry->d_name);
+            if (hasSuffix(name, ".mmtf")) entries.push_back(arg + "/" + name);
+        }
+        closedir(dir);
+        std::sort(entries.begin(), entries.end());
+        files.insert(files.end(), entries.begin(), entries.end());
+        return;
+    }
+#endif
+    files.push_back(arg);
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = size_t(p * double(values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+struct Result {
+    double seconds[NUM_PHASES];
+    uint64_t bytes;
+    int64_t atoms;
+    std::string error;  // empty if round trip succeeded
+};
+
+Result roundTrip(const std::string& filename) {
+    Result result;
+    std::fill(result.seconds, result.seconds + NUM_PHASES, 0.0);
+    result.bytes = 0;
+    result.atoms = 0;
+    try {
+        Clock::time_point start = Clock::now();
+        std::ifstream ifs(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!ifs) throw mmtf::DecodeError("Could not open file: " + filename);
+        std::string buffer((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+        result.bytes = buffer.size();
+        result.seconds[READ] = secondsSince(start);
+
+        start = Clock::now();
+        mmtf::StructureData data;
+        mmtf::decodeFromBuffer(data, buffer.data(), buffer.size());
+        result.atoms = data.numAtoms;
+        result.seconds[DECODE] = secondsSince(start);
+
+        start = Clock::now();
+        std::ostringstream encoded;
+        mmtf::encodeToStream(data, encoded);
+        const std::string packed = encoded.str();
+        result.seconds[ENCODE] = secondsSince(start);
+
+        start = Clock::now();
+        mmtf::StructureData data2;
+        mmtf::decodeFromBuffer(data2, packed.data(), packed.size());
+        result.seconds[REDECODE] = secondsSince(start);
+
+        start = Clock::now();
+        const bool equal = (data == data2);
+        result.seconds[VERIFY] = secondsSince(start);
+        if (!equal) result.error = "round trip yielded NON-equal data";
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+} // anon ns
+
+int main(int argc, char** argv) {
+    // check arguments
+    int num_threads = int(std::thread::hardware_concurrency());
+    std::vector<std::string> files;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg(argv[i]);
+            if (arg == "-j" && i + 1 < argc) {
+                num_threads = std::atoi(argv[++i]);
+            } else {
+                collectFiles(arg, files);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (files.empty()) {
+        std::cout << "USAGE: ./roundtrip_throughput [-j <num threads>] "
+                     "<mmtf file | directory | @list file>...\n"
+                     "(directories are not supported on Windows, use @list "
+                     "files there)" << std::endl;
+        return 1;
+    }
+    num_threads = std::max(1, std::min(num_threads, int(files.size())));
+
+    // process files on all threads
+    std::vector<Result> results(files.size());
+    std::atomic<size_t> next(0);
+    std::mutex output_mutex;
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.push_back(std::thread([&]() {
+            for (size_t i = next++; i < files.size(); i = next++) {
+                results[i] = roundTrip(files[i]);
+                if (!results[i].error.empty()) {
+                    std::lock_guard<std::mutex> lock(output_mutex);
+                    std::cerr << "FAILED " << files[i] << ": "
+                              << results[i].error << std::endl;
+                }
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); ++t) threads[t].join();
+    const double wall = secondsSince(start);
+
+    // report
+    size_t num_failed = 0;
+    uint64_t bytes = 0;
+    int64_t atoms = 0;
+    std::vector<double> latencies[NUM_PHASES];
+    std::vector<double> totals;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        if (!r.error.empty()) {
+            ++num_failed;
+            continue;
+        }
+        bytes += r.bytes;
+        atoms += r.atoms;
+        double total = 0;
+        for (int p = 0; p < NUM_PHASES; ++p) {
+            latencies[p].push_back(r.seconds[p]);
+            total += r.seconds[p];
+        }
+        totals.push_back(total);
+    }
+    const size_t num_ok = files.size() - num_failed;
+    std::cout << std::fixed << std::setprecision(1)
+              << "Files:   " << num_ok << " ok, " << num_failed << " failed"
+              << " (" << num_threads << " threads, " << wall << " s)\n"
+              << "Rate:    " << double(num_ok) / wall << " files/s, "
+              << double(bytes) / wall / 1e6 << " MB/s, "
+              << double(atoms) / wall / 1e6 << " M atoms/s\n"
+              << std::setprecision(3)
+              << "Latency per file in ms (p50 / p99):\n";
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        std::cout << "  " << std::setw(10) << std::left << PHASE_NAMES[p]
+                  << std::right << std::setw(10)
+                  << 1e3 * percentile(latencies[p], 0.5) << " / "
+                  << 1e3 * percentile(latencies[p], 0.99) << "\n";
+    }
+    std::cout << "  " << std::setw(10) << std::left << "total" << std::right
+              << std::setw(10) << 1e3 * percentile(totals, 0.5) << " / "
+              << 1e3 * percentile(totals, 0.99) << std::endl;
+    return num_failed == 0 ? 0 : 1;
+}
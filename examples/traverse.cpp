@@ -10,6 +10,7 @@
 // *************************************************************************
 
 #include <mmtf.hpp>
+#include <mmtf/hierarchy_index.hpp>
 
 // C-style libraries used here to keep it close to traverse.c
 #include <stdio.h>
@@ -312,28 +313,22 @@ void traverse_main(const mmtf::StructureData& example) {
     printf("numChains: %d\n", example.numChains);
     printf("numModels: %d\n", example.numModels);
 
-    //  # initialize index counters
-    int modelIndex = 0;
-    int chainIndex = 0;
-    int groupIndex = 0;
-    int atomIndex = 0;
-    //# traverse models
-    int i;
-    for (i = 0; i < example.numModels; i++) {
-        int modelChainCount = example.chainsPerModel[i];
-        printf("modelIndex: %d\n", modelIndex);
-        //    # traverse chains
-        int j;
-        for (j = 0; j < modelChainCount; j++) {
+    // traverse models, chains, groups and atoms with precomputed offsets
+    const mmtf::HierarchyIndex index(example);
+    for (mmtf::ModelIterator model = mmtf::modelsBegin(example, index);
+         model != mmtf::modelsEnd(example, index); ++model) {
+        printf("modelIndex: %d\n", model->modelIndex());
+        for (mmtf::ChainIterator chain = model->chainsBegin();
+             chain != model->chainsEnd(); ++chain) {
+            const int chainIndex = chain->chainIndex();
             printf(" chainIndex : %d\n", chainIndex);
-            printval("  Chain id: %s\n", example.chainIdList[chainIndex]);
+            printval("  Chain id: %s\n", chain->chainId());
             printvalo("  Chain name: %s\n", example.chainNameList, chainIndex);
-            int chainGroupCount = example.groupsPerChain[chainIndex];
-            //        # traverse groups
-            int k;
-            for (k = 0; k < chainGroupCount; k++) {
+            for (mmtf::GroupIterator group = chain->groupsBegin();
+                 group != chain->groupsEnd(); ++group) {
+                const int groupIndex = group->groupIndex();
                 printf("  groupIndex: %d\n", groupIndex);
-                printf("   groupId: %d\n", example.groupIdList[groupIndex]);
+                printf("   groupId: %d\n", group->groupId());
                 printvalo("   insCodeList: %c\n", example.insCodeList,
                           groupIndex);
                 printvalo("   secStruc: %d\n", example.secStructList,
@@ -341,33 +336,30 @@ void traverse_main(const mmtf::StructureData& example) {
                 printvalo("   seqIndex: %i\n", example.sequenceIndexList,
                           groupIndex);
                 printf("   groupType: %d\n", example.groupTypeList[groupIndex]);
-                const mmtf::GroupType& group =
-                        example.groupList[example.groupTypeList[groupIndex]];
-                printval("    Group name: %s\n", group.groupName);
-                printf("    Single letter code: %c\n", group.singleLetterCode);
-                printval("    Chem comp type: %s\n", group.chemCompType);
-                int atomOffset = atomIndex;
-
-                int l;
-                for (l = 0; l < group.bondAtomList.size(); l += 2) {
+                const mmtf::GroupType& groupType = group->group();
+                printval("    Group name: %s\n", groupType.groupName);
+                printf("    Single letter code: %c\n",
+                       groupType.singleLetterCode);
+                printval("    Chem comp type: %s\n", groupType.chemCompType);
+                const int atomOffset = group->atomsBegin()->atomIndex();
+
+                for (size_t l = 0; l < groupType.bondAtomList.size(); l += 2) {
                     printf("    Atom id One: %d\n",
-                           (atomOffset + group.bondAtomList[l]));
+                           (atomOffset + groupType.bondAtomList[l]));
                     printf("    Atom id Two: %d\n",
-                           (atomOffset + group.bondAtomList[l + 1]));
+                           (atomOffset + groupType.bondAtomList[l + 1]));
                     printvalo("    Bond order: %d\n",
-                              group.bondOrderList, l / 2);
+                              groupType.bondOrderList, l / 2);
                     printvalo("    Bond resonance: %d\n",
-                              group.bondResonanceList, l / 2);
+                              groupType.bondResonanceList, l / 2);
                 }
-                int groupAtomCount = group.atomNameList.size();
-                for (l = 0; l < groupAtomCount; l++) {
+                for (mmtf::AtomIterator atom = group->atomsBegin();
+                     atom != group->atomsEnd(); ++atom) {
+                    const int atomIndex = atom->atomIndex();
                     printf("    atomIndex: %d\n", atomIndex);
-                    printf("     x coord: %.3f\n",
-                           example.xCoordList[atomIndex]);
-                    printf("     y coord: %.3f\n",
-                           example.yCoordList[atomIndex]);
-                    printf("     z coord: %.3f\n",
-                           example.zCoordList[atomIndex]);
+                    printf("     x coord: %.3f\n", atom->x());
+                    printf("     y coord: %.3f\n", atom->y());
+                    printf("     z coord: %.3f\n", atom->z());
                     printvalo("     b factor: %.2f\n", example.bFactorList,
                               atomIndex);
                     printvalo("     atom id: %d\n", example.atomIdList,
@@ -376,20 +368,16 @@ void traverse_main(const mmtf::StructureData& example) {
                               atomIndex);
                     printvalo("     occupancy: %.2f\n", example.occupancyList,
                               atomIndex);
-                    printf("     charge: %d\n", group.formalChargeList[l]);
-                    printval("     atom name: %s\n", group.atomNameList[l]);
-                    printval("     element: %s\n", group.elementList[l]);
-                    atomIndex++;
+                    printf("     charge: %d\n", atom->formalCharge());
+                    printval("     atom name: %s\n", atom->atomName());
+                    printval("     element: %s\n", atom->element());
                 }
-                groupIndex++;
             }
-            chainIndex++;
         }
-        modelIndex++;
     }
     printf("Number of inter group bonds: %d\n",
            (int) example.bondAtomList.size() / 2);
-    for (i = 0; i < example.bondAtomList.size(); i += 2) {
+    for (size_t i = 0; i < example.bondAtomList.size(); i += 2) {
         printf(" Atom One: %d\n", example.bondAtomList[i]);
         printf(" Atom Two: %d\n", example.bondAtomList[i + 1]);
         printvalo(" Bond order: %d\n", example.bondOrderList, i / 2);
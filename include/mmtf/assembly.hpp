@@ -0,0 +1,774 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Expansion and virtual views of biological assemblies and NCS copies stored
+// in mmtf::StructureData.
+// See "tests/mmtf_tests.cpp" (Test buildAssembly, Test AssemblyView,
+// Test NCS expansion) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_ASSEMBLY_H
+#define MMTF_ASSEMBLY_H
+
+#include "structure_data.hpp"
+#include "hierarchy_index.hpp"
+#include "errors.hpp"
+
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cfloat>
+#include <math.h>
+
+namespace mmtf {
+
+/**
+ * @brief Apply a 4x4 transformation matrix to coordinate arrays.
+ * @param[in]  matrix   Row-major 4x4 matrix as in Transform::matrix
+ *                      (translation in elements 3, 7 and 11)
+ * @param[in]  x, y, z  Input coordinates (num entries each)
+ * @param[in]  num      Number of points
+ * @param[out] out_x, out_y, out_z  Output coordinates (may equal input)
+ *
+ * Plain loop over structure-of-arrays data which compilers auto-vectorize.
+ */
+inline void transformCoordinates(const float* matrix, const float* x,
+                                 const float* y, const float* z, int32_t num,
+                                 float* out_x, float* out_y, float* out_z);
+
+/**
+ * @brief Build a new structure for one biological assembly.
+ * @param[out] assembly        Expanded structure (previous content replaced)
+ * @param[in]  data            Consistent source structure
+ * @param[in]  assembly_index  Index into data.bioAssemblyList
+ * @throw mmtf::DecodeError if assembly_index or chain indices of transforms
+ *        are invalid or the hierarchy of data is inconsistent
+ *
+ * For every model, the chains of that model are copied once per transform
+ * that lists them (transform order first, then order of chainIndexList) with
+ * transformed coordinates. Copies are filled in parallel if OpenMP is enabled.
+ * Per-chain, per-group and per-atom lists are duplicated, entities refer to
+ * all copies of their chains and inter-group bonds are kept if both atoms are
+ * copied by the same transform. The group list and structure-level metadata
+ * are kept, bioAssemblyList, ncsOperatorList and the *Properties maps are
+ * left empty.
+ */
+inline void buildAssembly(StructureData& assembly, const StructureData& data,
+                          size_t assembly_index);
+
+/**
+ * @brief Build a new structure for an assembly not stored in data.
+ * @param[out] assembly      Expanded structure (previous content replaced)
+ * @param[in]  data          Consistent source structure
+ * @param[in]  bio_assembly  Transforms referring to chains of data (e.g. from
+ *                           getNcsAssembly or findSymmetryMates)
+ * @throw mmtf::DecodeError if chain indices of transforms are invalid or the
+ *        hierarchy of data is inconsistent
+ * @see buildAssembly(StructureData&, const StructureData&, size_t)
+ */
+inline void buildAssembly(StructureData& assembly, const StructureData& data,
+                          const BioAssembly& bio_assembly);
+
+/**
+ * @brief Get NCS operators as one contiguous array.
+ * @param[in]  data      Structure with ncsOperatorList
+ * @param[out] matrices  16 floats per operator (row-major, layout as
+ *                       Transform::matrix)
+ * @throw mmtf::DecodeError if an operator does not have 16 entries
+ */
+inline void getNcsOperators(const StructureData& data,
+                            std::vector<float>& matrices);
+
+/**
+ * @brief Create an assembly applying all NCS operators to all chains.
+ * @param[in]  data          Structure with ncsOperatorList
+ * @param[out] bio_assembly  Assembly named "ncs" with one transform per
+ *                           operator listing all chains of data; an identity
+ *                           transform is put first unless the operators
+ *                           contain one
+ * @throw mmtf::DecodeError if an operator does not have 16 entries
+ *
+ * Use with buildAssembly to expand or AssemblyView to view the NCS copies.
+ */
+inline void getNcsAssembly(const StructureData& data,
+                           BioAssembly& bio_assembly);
+
+/**
+ * @brief Build a new structure with all NCS copies of data.
+ * @param[out] expanded  Expanded structure (previous content replaced)
+ * @param[in]  data      Consistent source structure with ncsOperatorList
+ * @throw mmtf::DecodeError if operators or the hierarchy are invalid
+ *
+ * Same as buildAssembly with the result of getNcsAssembly.
+ */
+inline void buildNcsAssembly(StructureData& expanded,
+                             const StructureData& data);
+
+/**
+ * @brief Read-only view of a biological assembly without expanding it.
+ *
+ * Presents the atoms of the assembly in the same order as buildAssembly would
+ * create them, but only stores O(number of copies) data. A copy is one
+ * (transform, chain) pair. Transformed coordinates are computed on the fly for
+ * single atoms or in tiles (ranges) with transformCoordinates. Bounding boxes
+ * of every copy are computed once from per-chain bounding boxes of the source
+ * (8 transformed corners) and are used to cull copies in spatial queries.
+ *
+ * Per-atom data other than coordinates is accessed through the source atom,
+ * e.g. with sourceAtom(i), which returns an AtomIterator into the source data.
+ * The source data must stay alive and unchanged while the view is used.
+ */
+class AssemblyView {
+public:
+    /**
+     * @brief Construct empty view. Use init to fill it.
+     */
+    AssemblyView(): data_(NULL), assembly_(NULL), atomOffsets_(1, 0) {}
+
+    /**
+     * @brief Construct view for one assembly of data.
+     * @param data            Consistent source structure (must outlive view).
+     * @param assembly_index  Index into data.bioAssemblyList.
+     * @throw mmtf::DecodeError if assembly_index or chain indices of
+     *        transforms are invalid or the hierarchy of data is inconsistent.
+     */
+    AssemblyView(const StructureData& data, size_t assembly_index);
+
+    /**
+     * @brief Construct view for an assembly not stored in data.
+     * @param data          Consistent source structure (must outlive view).
+     * @param bio_assembly  Transforms referring to chains of data (must
+     *                      outlive view, e.g. from getNcsAssembly).
+     * @throw mmtf::DecodeError if chain indices of transforms are invalid or
+     *        the hierarchy of data is inconsistent.
+     */
+    AssemblyView(const StructureData& data, const BioAssembly& bio_assembly);
+
+    /**
+     * @brief (Re)build view. See constructors.
+     */
+    void init(const StructureData& data, size_t assembly_index);
+    void init(const StructureData& data, const BioAssembly& bio_assembly);
+
+    /// @name Sizes
+    /// @{
+    int32_t numModels() const { return int32_t(copyOffsets_.size()) - 1; }
+    int32_t numCopies() const { return int32_t(copyChain_.size()); }
+    int32_t numAtoms() const { return atomOffsets_.back(); }
+    /// @}
+
+    /// @name Copies (ordered by model; copies of model m are
+    ///       [copyBegin(m), copyEnd(m)))
+    /// @{
+    int32_t copyBegin(int32_t model_index) const {
+        return copyOffsets_[model_index];
+    }
+    int32_t copyEnd(int32_t model_index) const {
+        return copyOffsets_[model_index + 1];
+    }
+    int32_t copyChainIndex(int32_t copy_index) const {
+        return copyChain_[copy_index];
+    }
+    int32_t copyTransformIndex(int32_t copy_index) const {
+        return copyTransform_[copy_index];
+    }
+    /// Row-major matrix of copy (Transform::matrix of its transform)
+    const float* copyMatrix(int32_t copy_index) const {
+        return assembly_->transformList[copyTransform_[copy_index]].matrix;
+    }
+    int32_t copyAtomBegin(int32_t copy_index) const {
+        return atomOffsets_[copy_index];
+    }
+    int32_t copyAtomEnd(int32_t copy_index) const {
+        return atomOffsets_[copy_index + 1];
+    }
+    /// Axis aligned box of copy: min x, y, z followed by max x, y, z
+    /// (min > max for copies without atoms)
+    const float* copyBoundingBox(int32_t copy_index) const {
+        return &boxes_[6 * copy_index];
+    }
+    /// @}
+
+    /// @name Atoms (indices as in the output of buildAssembly)
+    /// @{
+    /// Copy containing an atom (O(log numCopies))
+    int32_t copyIndexOfAtom(int32_t atom_index) const;
+    /// Index of atom in source data
+    int32_t sourceAtomIndex(int32_t atom_index) const {
+        const int32_t k = copyIndexOfAtom(atom_index);
+        return index_.chainAtomBegin(copyChain_[k]) + atom_index
+               - atomOffsets_[k];
+    }
+    /// Iterator at source atom (names, elements, groups, chains, ...)
+    AtomIterator sourceAtom(int32_t atom_index) const {
+        return AtomIterator(*data_, index_, sourceAtomIndex(atom_index));
+    }
+    /// Transformed coordinates of one atom
+    void getCoordinates(int32_t atom_index, float& x, float& y,
+                        float& z) const;
+    /**
+     * @brief Transformed coordinates of atoms [begin, end) (a tile).
+     * @param[in]  begin, end  Atom range (may span several copies).
+     * @param[out] x, y, z     Arrays with at least end - begin entries.
+     */
+    void getCoordinates(int32_t begin, int32_t end, float* x, float* y,
+                        float* z) const;
+    /// @}
+
+    /// @name Culled spatial queries
+    /// @{
+    /**
+     * @brief Find copies whose bounding box intersects an axis aligned box.
+     * @param[in]  box_min, box_max  Corners of query box (3 entries each).
+     * @param[out] copies            Copy indices (cleared first; sorted).
+     */
+    void findCopiesInBox(const float* box_min, const float* box_max,
+                         std::vector<int32_t>& copies) const;
+    /**
+     * @brief Find copies whose bounding box intersects a sphere.
+     * @param[in]  x, y, z, radius  Query sphere.
+     * @param[out] copies           Copy indices (cleared first; sorted).
+     */
+    void findCopiesWithinRadius(float x, float y, float z, float radius,
+                                std::vector<int32_t>& copies) const;
+    /**
+     * @brief Find all assembly atoms within radius (inclusive) of a position.
+     * @param[in]  x, y, z, radius  Query sphere.
+     * @param[out] result           Atom indices (cleared first; sorted).
+     *
+     * Only copies passing the bounding box test are transformed (in tiles).
+     */
+    void findWithinRadius(float x, float y, float z, float radius,
+                          std::vector<int32_t>& result) const;
+    /// @}
+
+    /// Index of the source data
+    const HierarchyIndex& hierarchy() const { return index_; }
+
+private:
+    const StructureData* data_;
+    const BioAssembly* assembly_;
+    HierarchyIndex index_;
+    std::vector<int32_t> copyOffsets_;    // model -> first copy
+    std::vector<int32_t> copyTransform_;
+    std::vector<int32_t> copyChain_;
+    std::vector<int32_t> atomOffsets_;    // copy -> first atom
+    std::vector<float> boxes_;            // 6 per copy
+};
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+inline void transformCoordinates(const float* matrix, const float* x,
+                                 const float* y, const float* z, int32_t num,
+                                 float* out_x, float* out_y, float* out_z) {
+    const float m0 = matrix[0], m1 = matrix[1], m2 = matrix[2];
+    const float m3 = matrix[3], m4 = matrix[4], m5 = matrix[5];
+    const float m6 = matrix[6], m7 = matrix[7], m8 = matrix[8];
+    const float m9 = matrix[9], m10 = matrix[10], m11 = matrix[11];
+    for (int32_t i = 0; i < num; ++i) {
+        const float xi = x[i];
+        const float yi = y[i];
+        const float zi = z[i];
+        out_x[i] = m0 * xi + m1 * yi + m2 * zi + m3;
+        out_y[i] = m4 * xi + m5 * yi + m6 * zi + m7;
+        out_z[i] = m8 * xi + m9 * yi + m10 * zi + m11;
+    }
+}
+
+namespace {
+
+// copy range of optional list (only if present in source)
+template <typename T>
+inline void assemblyCopyRange(const std::vector<T>& source, size_t begin,
+                              size_t end, std::vector<T>& target,
+                              size_t target_begin) {
+    if (source.empty()) return;
+    std::copy(source.begin() + begin, source.begin() + end,
+              target.begin() + target_begin);
+}
+
+template <typename T>
+inline void assemblyResize(const std::vector<T>& source, size_t size,
+                           std::vector<T>& target) {
+    if (source.empty()) target.clear();
+    else                target.resize(size);
+}
+
+// list copies (transform, chain) of an assembly ordered by model
+inline void assemblyCopies(const HierarchyIndex& index,
+                           const BioAssembly& bio_assembly,
+                           std::vector<int32_t>& copy_transform,
+                           std::vector<int32_t>& copy_chain,
+                           std::vector<int32_t>& chains_per_model) {
+    const int32_t num_chains = index.numChains();
+    std::vector<std::vector<int32_t> > model_copies(index.numModels());
+    for (size_t t = 0; t < bio_assembly.transformList.size(); ++t) {
+        const Transform& transform = bio_assembly.transformList[t];
+        for (size_t k = 0; k < transform.chainIndexList.size(); ++k) {
+            const int32_t chain = transform.chainIndexList[k];
+            if (chain < 0 || chain >= num_chains) {
+                throw DecodeError("Cannot build assembly: invalid chain index "
+                                  "in transform");
+            }
+            model_copies[index.modelIndexOfChain(chain)].push_back(int32_t(t));
+            model_copies[index.modelIndexOfChain(chain)].push_back(chain);
+        }
+    }
+    copy_transform.clear();
+    copy_chain.clear();
+    chains_per_model.clear();
+    for (size_t m = 0; m < model_copies.size(); ++m) {
+        chains_per_model.push_back(int32_t(model_copies[m].size() / 2));
+        for (size_t k = 0; k < model_copies[m].size(); k += 2) {
+            copy_transform.push_back(model_copies[m][k]);
+            copy_chain.push_back(model_copies[m][k + 1]);
+        }
+    }
+}
+
+// throw if assembly_index is not valid for data
+inline void assemblyCheckIndex(const StructureData& data,
+                               size_t assembly_index) {
+    if (assembly_index >= data.bioAssemblyList.size()) {
+        std::stringstream err;
+        err << "Invalid bioassembly index " << assembly_index << " (found "
+            << data.bioAssemblyList.size() << " assemblies)";
+        throw DecodeError(err.str());
+    }
+}
+
+} // anon ns
+
+inline void buildAssembly(StructureData& assembly, const StructureData& data,
+                          size_t assembly_index) {
+    assemblyCheckIndex(data, assembly_index);
+    buildAssembly(assembly, data, data.bioAssemblyList[assembly_index]);
+}
+
+inline void buildAssembly(StructureData& assembly, const StructureData& data,
+                          const BioAssembly& bio_assembly) {
+    if (&assembly == &data) {
+        // bio_assembly may be part of data
+        const StructureData source(data);
+        const BioAssembly source_assembly(bio_assembly);
+        buildAssembly(assembly, source, source_assembly);
+        return;
+    }
+    const HierarchyIndex index(data);
+    const int32_t num_chains = index.numChains();
+    if (int32_t(data.xCoordList.size()) != index.numAtoms()
+        || data.yCoordList.size() != data.xCoordList.size()
+        || data.zCoordList.size() != data.xCoordList.size()) {
+        throw DecodeError("Cannot build assembly: coordinate lists are "
+                          "inconsistent with hierarchy");
+    }
+
+    // copies (transform, chain) ordered by model
+    const size_t num_transforms = bio_assembly.transformList.size();
+    std::vector<int32_t> copy_transform;
+    std::vector<int32_t> copy_chain;
+    StructureData& result = assembly;
+    result = StructureData();
+    assemblyCopies(index, bio_assembly, copy_transform, copy_chain,
+                   result.chainsPerModel);
+    const int32_t num_copies = int32_t(copy_chain.size());
+
+    // output offsets per copy
+    std::vector<int32_t> group_offsets(num_copies + 1, 0);
+    std::vector<int32_t> atom_offsets(num_copies + 1, 0);
+    std::vector<int32_t> copy_of(num_transforms * num_chains, -1);
+    for (int32_t k = 0; k < num_copies; ++k) {
+        const int32_t c = copy_chain[k];
+        group_offsets[k + 1] = group_offsets[k]
+            + index.groupEnd(c) - index.groupBegin(c);
+        atom_offsets[k + 1] = atom_offsets[k]
+            + index.chainAtomEnd(c) - index.chainAtomBegin(c);
+        copy_of[copy_transform[k] * num_chains + c] = k;
+    }
+    const int32_t num_groups = group_offsets.back();
+    const int32_t num_atoms = atom_offsets.back();
+
+    // per-chain data
+    for (int32_t k = 0; k < num_copies; ++k) {
+        const int32_t c = copy_chain[k];
+        result.chainIdList.push_back(data.chainIdList[c]);
+        if (!data.chainNameList.empty()) {
+            result.chainNameList.push_back(data.chainNameList[c]);
+        }
+        result.groupsPerChain.push_back(data.groupsPerChain[c]);
+    }
+
+    // per-group and per-atom data (copies are independent)
+    result.groupTypeList.resize(num_groups);
+    result.groupIdList.resize(num_groups);
+    assemblyResize(data.secStructList, num_groups, result.secStructList);
+    assemblyResize(data.insCodeList, num_groups, result.insCodeList);
+    assemblyResize(data.sequenceIndexList, num_groups,
+                   result.sequenceIndexList);
+    result.xCoordList.resize(num_atoms);
+    result.yCoordList.resize(num_atoms);
+    result.zCoordList.resize(num_atoms);
+    assemblyResize(data.bFactorList, num_atoms, result.bFactorList);
+    assemblyResize(data.atomIdList, num_atoms, result.atomIdList);
+    assemblyResize(data.altLocList, num_atoms, result.altLocList);
+    assemblyResize(data.occupancyList, num_atoms, result.occupancyList);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int32_t k = 0; k < num_copies; ++k) {
+        const int32_t c = copy_chain[k];
+        const size_t g_begin = index.groupBegin(c);
+        const size_t g_end = index.groupEnd(c);
+        const size_t g_out = group_offsets[k];
+        assemblyCopyRange(data.groupTypeList, g_begin, g_end,
+                          result.groupTypeList, g_out);
+        assemblyCopyRange(data.groupIdList, g_begin, g_end,
+                          result.groupIdList, g_out);
+        assemblyCopyRange(data.secStructList, g_begin, g_end,
+                          result.secStructList, g_out);
+        assemblyCopyRange(data.insCodeList, g_begin, g_end,
+                          result.insCodeList, g_out);
+        assemblyCopyRange(data.sequenceIndexList, g_begin, g_end,
+                          result.sequenceIndexList, g_out);
+
+        const int32_t a_begin = index.chainAtomBegin(c);
+        const int32_t a_end = index.chainAtomEnd(c);
+        const int32_t a_out = atom_offsets[k];
+        assemblyCopyRange(data.bFactorList, a_begin, a_end,
+                          result.bFactorList, a_out);
+        assemblyCopyRange(data.atomIdList, a_begin, a_end,
+                          result.atomIdList, a_out);
+        assemblyCopyRange(data.altLocList, a_begin, a_end,
+                          result.altLocList, a_out);
+        assemblyCopyRange(data.occupancyList, a_begin, a_end,
+                          result.occupancyList, a_out);
+        if (a_end > a_begin) {
+            transformCoordinates(
+                bio_assembly.transformList[copy_transform[k]].matrix,
+                &data.xCoordList[a_begin], &data.yCoordList[a_begin],
+                &data.zCoordList[a_begin], a_end - a_begin,
+                &result.xCoordList[a_out], &result.yCoordList[a_out],
+                &result.zCoordList[a_out]);
+        }
+    }
+
+    // entities refer to all copies of their chains (first entity listing a
+    // chain wins, as in is_polymer and ClassificationTable)
+    std::vector<int32_t> chain_entity(num_chains, -1);
+    for (size_t e = 0; e < data.entityList.size(); ++e) {
+        const std::vector<int32_t>& chains = data.entityList[e].chainIndexList;
+        for (size_t i = 0; i < chains.size(); ++i) {
+            if (   chains[i] >= 0 && chains[i] < num_chains
+                && chain_entity[chains[i]] == -1) {
+                chain_entity[chains[i]] = int32_t(e);
+            }
+        }
+    }
+    result.entityList = data.entityList;
+    for (size_t e = 0; e < result.entityList.size(); ++e) {
+        result.entityList[e].chainIndexList.clear();
+    }
+    for (int32_t k = 0; k < num_copies; ++k) {
+        const int32_t e = chain_entity[copy_chain[k]];
+        if (e >= 0) result.entityList[e].chainIndexList.push_back(k);
+    }
+
+    // bonds: group bonds come with group types, inter-group bonds are
+    // kept if both chains are copied by the same transform
+    int32_t num_bonds = 0;
+    for (int32_t g = 0; g < num_groups; ++g) {
+        num_bonds += int32_t(
+            data.groupList[result.groupTypeList[g]].bondAtomList.size() / 2);
+    }
+    const bool has_orders = !data.bondOrderList.empty();
+    const bool has_resonance = !data.bondResonanceList.empty();
+    for (size_t t = 0; t < num_transforms; ++t) {
+        for (size_t b = 0; b + 1 < data.bondAtomList.size(); b += 2) {
+            const int32_t atom1 = data.bondAtomList[b];
+            const int32_t atom2 = data.bondAtomList[b + 1];
+            const int32_t chain1 = index.chainIndexOfAtom(atom1);
+            const int32_t chain2 = index.chainIndexOfAtom(atom2);
+            const int32_t k1 = copy_of[t * num_chains + chain1];
+            const int32_t k2 = copy_of[t * num_chains + chain2];
+            if (k1 < 0 || k2 < 0) continue;
+            result.bondAtomList.push_back(
+                atom_offsets[k1] + atom1 - index.chainAtomBegin(chain1));
+            result.bondAtomList.push_back(
+                atom_offsets[k2] + atom2 - index.chainAtomBegin(chain2));
+            if (has_orders) {
+                result.bondOrderList.push_back(data.bondOrderList[b / 2]);
+            }
+            if (has_resonance) {
+                result.bondResonanceList.push_back(
+                    data.bondResonanceList[b / 2]);
+            }
+            ++num_bonds;
+        }
+    }
+
+    // structure level data
+    result.mmtfVersion = data.mmtfVersion;
+    result.mmtfProducer = data.mmtfProducer;
+    result.unitCell = data.unitCell;
+    result.spaceGroup = data.spaceGroup;
+    result.structureId = data.structureId;
+    result.title = data.title;
+    result.depositionDate = data.depositionDate;
+    result.releaseDate = data.releaseDate;
+    result.experimentalMethods = data.experimentalMethods;
+    result.resolution = data.resolution;
+    result.rFree = data.rFree;
+    result.rWork = data.rWork;
+    result.groupList = data.groupList;
+    result.numBonds = num_bonds;
+    result.numAtoms = num_atoms;
+    result.numGroups = num_groups;
+    result.numChains = num_copies;
+    result.numModels = int32_t(result.chainsPerModel.size());
+}
+
+inline void getNcsOperators(const StructureData& data,
+                            std::vector<float>& matrices) {
+    matrices.resize(16 * data.ncsOperatorList.size());
+    for (size_t k = 0; k < data.ncsOperatorList.size(); ++k) {
+        const std::vector<float>& op = data.ncsOperatorList[k];
+        if (op.size() != 16) {
+            std::stringstream err;
+            err << "Invalid NCS operator " << k << " (found " << op.size()
+                << " entries instead of 16)";
+            throw DecodeError(err.str());
+        }
+        std::copy(op.begin(), op.end(), matrices.begin() + 16 * k);
+    }
+}
+
+inline void getNcsAssembly(const StructureData& data,
+                           BioAssembly& bio_assembly) {
+    std::vector<float> matrices;
+    getNcsOperators(data, matrices);
+    const size_t num_ops = matrices.size() / 16;
+    bool has_identity = false;
+    for (size_t k = 0; k < num_ops && !has_identity; ++k) {
+        has_identity = true;
+        for (int i = 0; i < 16; ++i) {
+            const float expected = (i % 5 == 0) ? 1.0f : 0.0f;
+            if (fabs(matrices[16 * k + i] - expected) > 1e-4f) {
+                has_identity = false;
+                break;
+            }
+        }
+    }
+    std::vector<int32_t> chains(data.numChains);
+    for (int32_t c = 0; c < data.numChains; ++c) chains[c] = c;
+    bio_assembly.name = "ncs";
+    bio_assembly.transformList.clear();
+    bio_assembly.transformList.reserve(num_ops + 1);
+    if (!has_identity) {
+        bio_assembly.transformList.push_back(Transform());
+        Transform& transform = bio_assembly.transformList.back();
+        transform.chainIndexList = chains;
+        for (int i = 0; i < 16; ++i) {
+            transform.matrix[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+        }
+    }
+    for (size_t k = 0; k < num_ops; ++k) {
+        bio_assembly.transformList.push_back(Transform());
+        Transform& transform = bio_assembly.transformList.back();
+        transform.chainIndexList = chains;
+        std::copy(&matrices[16 * k], &matrices[16 * k] + 16, transform.matrix);
+    }
+}
+
+inline void buildNcsAssembly(StructureData& expanded,
+                             const StructureData& data) {
+    BioAssembly bio_assembly;
+    getNcsAssembly(data, bio_assembly);
+    buildAssembly(expanded, data, bio_assembly);
+}
+
+inline AssemblyView::AssemblyView(const StructureData& data,
+                                  size_t assembly_index) {
+    init(data, assembly_index);
+}
+
+inline AssemblyView::AssemblyView(const StructureData& data,
+                                  const BioAssembly& bio_assembly) {
+    init(data, bio_assembly);
+}
+
+inline void AssemblyView::init(const StructureData& data,
+                               size_t assembly_index) {
+    assemblyCheckIndex(data, assembly_index);
+    init(data, data.bioAssemblyList[assembly_index]);
+}
+
+inline void AssemblyView::init(const StructureData& data,
+                               const BioAssembly& bio_assembly) {
+    index_.init(data);
+    if (int32_t(data.xCoordList.size()) != index_.numAtoms()
+        || data.yCoordList.size() != data.xCoordList.size()
+        || data.zCoordList.size() != data.xCoordList.size()) {
+        throw DecodeError("Cannot build assembly: coordinate lists are "
+                          "inconsistent with hierarchy");
+    }
+    data_ = &data;
+    assembly_ = &bio_assembly;
+    std::vector<int32_t> copies_per_model;
+    assemblyCopies(index_, *assembly_, copyTransform_, copyChain_,
+                   copies_per_model);
+    copyOffsets_.assign(1, 0);
+    for (size_t m = 0; m < copies_per_model.size(); ++m) {
+        copyOffsets_.push_back(copyOffsets_.back() + copies_per_model[m]);
+    }
+    const int32_t num_copies = numCopies();
+    atomOffsets_.assign(num_copies + 1, 0);
+    for (int32_t k = 0; k < num_copies; ++k) {
+        const int32_t c = copyChain_[k];
+        atomOffsets_[k + 1] = atomOffsets_[k]
+            + index_.chainAtomEnd(c) - index_.chainAtomBegin(c);
+    }
+
+    // bounding boxes of source chains
+    const int32_t num_chains = index_.numChains();
+    std::vector<float> chain_boxes(6 * num_chains);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int32_t c = 0; c < num_chains; ++c) {
+        float* box = &chain_boxes[6 * c];
+        box[0] = box[1] = box[2] = FLT_MAX;
+        box[3] = box[4] = box[5] = -FLT_MAX;
+        for (int32_t i = index_.chainAtomBegin(c);
+             i < index_.chainAtomEnd(c); ++i) {
+            box[0] = std::min(box[0], data.xCoordList[i]);
+            box[1] = std::min(box[1], data.yCoordList[i]);
+            box[2] = std::min(box[2], data.zCoordList[i]);
+            box[3] = std::max(box[3], data.xCoordList[i]);
+            box[4] = std::max(box[4], data.yCoordList[i]);
+            box[5] = std::max(box[5], data.zCoordList[i]);
+        }
+    }
+
+    // boxes of copies enclose the 8 transformed corners
+    boxes_.resize(6 * num_copies);
+    for (int32_t k = 0; k < num_copies; ++k) {
+        const float* src = &chain_boxes[6 * copyChain_[k]];
+        float* box = &boxes_[6 * k];
+        if (src[0] > src[3]) {
+            std::copy(src, src + 6, box);
+            continue;
+        }
+        float cx[8], cy[8], cz[8];
+        for (int corner = 0; corner < 8; ++corner) {
+            cx[corner] = src[(corner & 1) ? 3 : 0];
+            cy[corner] = src[(corner & 2) ? 4 : 1];
+            cz[corner] = src[(corner & 4) ? 5 : 2];
+        }
+        transformCoordinates(copyMatrix(k), cx, cy, cz, 8, cx, cy, cz);
+        box[0] = *std::min_element(cx, cx + 8);
+        box[1] = *std::min_element(cy, cy + 8);
+        box[2] = *std::min_element(cz, cz + 8);
+        box[3] = *std::max_element(cx, cx + 8);
+        box[4] = *std::max_element(cy, cy + 8);
+        box[5] = *std::max_element(cz, cz + 8);
+    }
+}
+
+inline int32_t AssemblyView::copyIndexOfAtom(int32_t atom_index) const {
+    // last copy starting at or before atom_index (skips empty copies)
+    return int32_t(std::upper_bound(atomOffsets_.begin(), atomOffsets_.end(),
+                                    atom_index)
+                   - atomOffsets_.begin()) - 1;
+}
+
+inline void AssemblyView::getCoordinates(int32_t atom_index, float& x,
+                                         float& y, float& z) const {
+    const int32_t i = sourceAtomIndex(atom_index);
+    transformCoordinates(copyMatrix(copyIndexOfAtom(atom_index)),
+                         &data_->xCoordList[i], &data_->yCoordList[i],
+                         &data_->zCoordList[i], 1, &x, &y, &z);
+}
+
+inline void AssemblyView::getCoordinates(int32_t begin, int32_t end,
+                                         float* x, float* y, float* z) const {
+    int32_t atom = begin;
+    while (atom < end) {
+        const int32_t k = copyIndexOfAtom(atom);
+        const int32_t seg_end = std::min(end, atomOffsets_[k + 1]);
+        const int32_t i = index_.chainAtomBegin(copyChain_[k]) + atom
+                          - atomOffsets_[k];
+        const int32_t out = atom - begin;
+        transformCoordinates(copyMatrix(k), &data_->xCoordList[i],
+                             &data_->yCoordList[i], &data_->zCoordList[i],
+                             seg_end - atom, x + out, y + out, z + out);
+        atom = seg_end;
+    }
+}
+
+inline void AssemblyView::findCopiesInBox(const float* box_min,
+                                          const float* box_max,
+                                          std::vector<int32_t>& copies) const {
+    copies.clear();
+    for (int32_t k = 0; k < numCopies(); ++k) {
+        const float* box = &boxes_[6 * k];
+        if (box[0] <= box_max[0] && box[3] >= box_min[0]
+            && box[1] <= box_max[1] && box[4] >= box_min[1]
+            && box[2] <= box_max[2] && box[5] >= box_min[2]) {
+            copies.push_back(k);
+        }
+    }
+}
+
+inline void AssemblyView::findCopiesWithinRadius(
+        float x, float y, float z, float radius,
+        std::vector<int32_t>& copies) const {
+    copies.clear();
+    const float r2 = radius * radius;
+    for (int32_t k = 0; k < numCopies(); ++k) {
+        const float* box = &boxes_[6 * k];
+        if (box[0] > box[3]) continue;
+        // distance from point to box
+        const float dx = std::max(std::max(box[0] - x, x - box[3]), 0.0f);
+        const float dy = std::max(std::max(box[1] - y, y - box[4]), 0.0f);
+        const float dz = std::max(std::max(box[2] - z, z - box[5]), 0.0f);
+        if (dx * dx + dy * dy + dz * dz <= r2) copies.push_back(k);
+    }
+}
+
+inline void AssemblyView::findWithinRadius(
+        float x, float y, float z, float radius,
+        std::vector<int32_t>& result) const {
+    result.clear();
+    std::vector<int32_t> copies;
+    findCopiesWithinRadius(x, y, z, radius, copies);
+    const float r2 = radius * radius;
+    const int32_t tile_size = 256;
+    float tx[tile_size], ty[tile_size], tz[tile_size];
+    for (size_t n = 0; n < copies.size(); ++n) {
+        const int32_t k = copies[n];
+        for (int32_t begin = atomOffsets_[k]; begin < atomOffsets_[k + 1];
+             begin += tile_size) {
+            const int32_t end = std::min(begin + tile_size,
+                                         atomOffsets_[k + 1]);
+            getCoordinates(begin, end, tx, ty, tz);
+            for (int32_t i = 0; i < end - begin; ++i) {
+                const float dx = tx[i] - x;
+                const float dy = ty[i] - y;
+                const float dz = tz[i] - z;
+                if (dx * dx + dy * dy + dz * dz <= r2) {
+                    result.push_back(begin + i);
+                }
+            }
+        }
+    }
+}
+
+} // mmtf namespace
+
+#endif
@@ -15,15 +15,45 @@
 
 #include "structure_data.hpp"
 #include "errors.hpp"
+#include "fixed_width_string_list.hpp"
+#include "model_delta.hpp"
 
 #include <msgpack.hpp>
 #include <cstring> // low level mem
+#include <cstddef>
 #include <sstream>
 #include <limits>
 #include <algorithm>
 
 namespace mmtf {
 
+/**
+ * @brief Position in an encoded binary from which decoding can resume.
+ *
+ * Obtained with BinaryDecoder::seek or BinaryDecoder::findSeekPoints and only
+ * valid for the binary it was obtained from.
+ */
+struct BinarySeekPoint {
+    int32_t  index;   ///< Index of next value to be decoded
+    uint32_t offset;  ///< Byte offset into encoded data (variable width)
+    int32_t  skip;    ///< Values of run at offset already consumed (RLE)
+    int32_t  value;   ///< Last decoded integer (delta coding)
+
+    BinarySeekPoint(): index(0), offset(0), skip(0), value(0) {}
+};
+
+/**
+ * @brief Key in extraProperties holding checkpoints of binary fields.
+ * See mmtf::encodeCheckpoints.
+ */
+const char* const CHECKPOINTS_KEY = "mmtf-cpp:checkpoints";
+
+/**
+ * @brief Key in extraProperties holding tiled per-atom fields.
+ * See mmtf::encodeTiles.
+ */
+const char* const TILES_KEY = "mmtf-cpp:tiles";
+
 /**
  * @brief Helper class to decode msgpack binary into a vector.
  */
@@ -59,11 +89,13 @@ public:
      * @param[out] target   Store decoded vector into this field.
      *
      * @tparam T Can be one of:
-     *           - std::vector<float>       (strategies: 1, 9, 10, 11, 12, 13)
+     *           - std::vector<float>       (strategies: 1, 9, 10, 11, 12, 13,
+     *                                       100)
      *           - std::vector<int8_t>      (strategies: 2, 16)
      *           - std::vector<int16_t>     (strategies: 3)
      *           - std::vector<int32_t>     (strategies: 4, 7, 8, 14, 15)
      *           - std::vector<std::string> (strategies: 5)
+     *           - FixedWidthStringList     (strategies: 5, copies data)
      *           - std::vector<char>        (strategies: 6)
      *
      * @throw mmtf::DecodeError if we fail to decode.
@@ -71,6 +103,132 @@ public:
     template<typename T>
     void decode(T& target) const;
 
+    /**
+     * @brief Decode values of a single model of a model delta binary.
+     *
+     * Only the models from the last keyframe up to model_index are decoded
+     * (see encodeModelDeltaFloat).
+     *
+     * @param[in]  model_index  Index of model to decode.
+     * @param[out] target       Store decoded values of that model here.
+     *
+     * @throw mmtf::DecodeError if strategy is not 100, model_index is invalid
+     *        or we fail to decode.
+     */
+    void decodeModel(int32_t model_index, std::vector<float>& target) const;
+
+    /**
+     * @brief Decode binary using checkpoints (see ::findSeekPoints).
+     *
+     * The binary is split at the checkpoints into chunks which are decoded
+     * independently (in parallel if OpenMP is enabled). Each chunk must end
+     * exactly at the next checkpoint. Checkpoints are only an optimization:
+     * if they do not match the binary (e.g. a stale table left by a writer
+     * which re-encoded the field), the binary is decoded sequentially as with
+     * ::decode. Checkpoints are also ignored unless ::needsScan is true.
+     *
+     * @param[in]  checkpoints  Seek points with increasing indices in
+     *                          (0, length).
+     * @param[out] target       Store decoded vector into this field (same
+     *                          types as ::decode).
+     *
+     * @throw mmtf::DecodeError if we fail to decode (same as ::decode).
+     */
+    template<typename T>
+    void decode(const std::vector<BinarySeekPoint>& checkpoints,
+                std::vector<T>& target) const;
+    // overload for targets without checkpoint support (ignores checkpoints)
+    template<typename T>
+    void decode(const std::vector<BinarySeekPoint>& checkpoints,
+                T& target) const;
+
+    /**
+     * @brief Decode only values [begin, end) of the binary.
+     *
+     * Values before begin are skipped without materializing them: direct
+     * offset for fixed width strategies (1-5, 11), a scan over runs for
+     * run-length encoded (6-9, 16) and over words for recursive indexed
+     * (10, 12-15) strategies and decoding from the last keyframe for
+     * strategy 100. Use ::seek to avoid repeated scans.
+     *
+     * @param[in]  begin   Index of first value to decode.
+     * @param[in]  end     Index after last value to decode.
+     * @param[out] target  Store decoded values into this field (same types as
+     *                     ::decode).
+     *
+     * @throw mmtf::DecodeError if range is invalid or we fail to decode.
+     */
+    template<typename T>
+    void decodeRange(int32_t begin, int32_t end, T& target) const;
+
+    /**
+     * @brief Decode values [start.index, end) starting from a seek point.
+     *
+     * Same as decodeRange(start.index, end, target) without scanning. Decoding
+     * from different seek points is independent and can run in parallel.
+     */
+    template<typename T>
+    void decodeRange(const BinarySeekPoint& start, int32_t end,
+                     T& target) const;
+
+    /**
+     * @brief Get seek point to resume decoding at given index.
+     * @throw mmtf::DecodeError if index is invalid or we fail to decode.
+     */
+    BinarySeekPoint seek(int32_t index) const;
+
+    /**
+     * @brief Get seek point for index by scanning from an earlier seek point.
+     * @throw mmtf::DecodeError if index < from.index or we fail to decode.
+     */
+    BinarySeekPoint seek(const BinarySeekPoint& from, int32_t index) const;
+
+    /**
+     * @brief Get number of values stored in binary (from binary header).
+     */
+    int32_t length() const { return length_; }
+
+    /**
+     * @brief Get strategy used to encode binary (from binary header).
+     */
+    int32_t strategy() const { return strategy_; }
+
+    /**
+     * @brief Get strategy parameter (e.g. divisor or string length) from
+     *        binary header.
+     */
+    int32_t parameter() const { return parameter_; }
+
+    /**
+     * @brief True if values can only be located by scanning the binary
+     *        (run-length encoded and recursive indexed strategies).
+     */
+    bool needsScan() const {
+        return (strategy_ >= 6 && strategy_ <= 10)
+            || (strategy_ >= 12 && strategy_ <= 16);
+    }
+
+    /**
+     * @brief Check if checkpoints match this binary.
+     *
+     * Scanning from each checkpoint (the first one from the start of the
+     * binary) must end exactly at the next checkpoint. The scans are
+     * independent (in parallel if OpenMP is enabled).
+     *
+     * @param[in]  checkpoints  Seek points (see ::decode with checkpoints).
+     * @return True if checkpoints can be used with ::seek and ::decodeRange.
+     */
+    bool matchesCheckpoints(const std::vector<BinarySeekPoint>& checkpoints) const;
+
+    /**
+     * @brief Get seek points for many indices with a single scan.
+     * @param[in]  indices  Sorted indices in [0, length].
+     * @param[out] points   Seek point for each index.
+     * @throw mmtf::DecodeError if indices are invalid or we fail to decode.
+     */
+    void findSeekPoints(const std::vector<int32_t>& indices,
+                        std::vector<BinarySeekPoint>& points) const;
+
 private:
     // for error reporting
     std::string key_;
@@ -122,6 +280,35 @@ private:
     template<typename Int>
     void decodeDivide_(const std::vector<Int>& input, float const divisor,
                        std::vector<float>& output) const;
+
+    // model delta decoding (strategy 100): layout and blocks as ints
+    void modelDeltaLayout_(int32_t& keyframe_interval,
+                           std::vector<int32_t>& model_sizes,
+                           std::vector<int32_t>& offsets,
+                           const char*& blocks) const;
+    void modelDeltaBlock_(const char* blocks,
+                          const std::vector<int32_t>& offsets,
+                          int32_t model_index, int32_t expected_size,
+                          bool keyframe, std::vector<int32_t>& output) const;
+    void modelDeltaRange_(int32_t begin, int32_t end,
+                          std::vector<int32_t>& output) const;
+
+    // range decoding: advance point to end (appending values if output set)
+    template<typename T>
+    void decodeRange_(BinarySeekPoint& point, int32_t end, T& target) const;
+    void scan_(BinarySeekPoint& point, int32_t end,
+               std::vector<int32_t>* output) const;
+    template<typename SmallInt>
+    void recursiveIndexScan_(BinarySeekPoint& point, int32_t end, bool delta,
+                             std::vector<int32_t>* output) const;
+    // get pointer to values [begin, end) of a fixed width strategy (throws)
+    const char* fixedWidthRange_(int32_t begin, int32_t end,
+                                 int32_t item_size) const;
+    void checkRange_(int32_t begin, int32_t end) const;
+    // check for increasing checkpoint indices in (0, length)
+    bool hasIncreasingCheckpoints_(
+            const std::vector<BinarySeekPoint>& checkpoints) const;
+    void throwInvalidRangeStrategy_(const std::string& type) const;
 };
 
 // *************************************************************************
@@ -183,6 +370,14 @@ void arrayCopyBigendian2(void* dst, const char* src, size_t n) {
     }
 }
 
+inline void readBigendian(int16_t& dst, const char* src) {
+    assignBigendian2(&dst, src);
+}
+
+inline void readBigendian(int8_t& dst, const char* src) {
+    dst = int8_t(*src);
+}
+
 } // anon ns
 
 
@@ -269,6 +464,34 @@ inline void BinaryDecoder::decode(std::vector<float>& output) const {
         decodeDivide_(step2, static_cast<float>(parameter_), output);
         break;
     }
+    case 100: {
+        int32_t keyframe_interval;
+        std::vector<int32_t> model_sizes;
+        std::vector<int32_t> offsets;
+        const char* blocks;
+        modelDeltaLayout_(keyframe_interval, model_sizes, offsets, blocks);
+        std::vector<int32_t> step1;
+        std::vector<int32_t> step2;
+        step2.reserve(length_);
+        for (size_t k = 0; k < model_sizes.size(); ++k) {
+            const int32_t model = int32_t(k);
+            const bool keyframe = isModelDeltaKeyframe(model, model_sizes,
+                                                       keyframe_interval);
+            modelDeltaBlock_(blocks, offsets, model, model_sizes[k], keyframe,
+                             step1);
+            if (keyframe) {
+                deltaDecode_(step1);
+            } else {
+                const size_t prev = step2.size() - step1.size();
+                for (size_t i = 0; i < step1.size(); ++i) {
+                    step1[i] += step2[prev + i];
+                }
+            }
+            step2.insert(step2.end(), step1.begin(), step1.end());
+        }
+        decodeDivide_(step2, static_cast<float>(parameter_), output);
+        break;
+    }
     default: {
         std::stringstream err;
         err << "Invalid strategy " << strategy_ << " for binary '" + key_
@@ -396,6 +619,35 @@ inline void BinaryDecoder::decode(std::vector<std::string>& output) const {
     checkLength_(output.size());
 }
 
+template<>
+inline void BinaryDecoder::decode(FixedWidthStringList& output) const {
+
+    // check strategy to parse
+    switch (strategy_) {
+    case 5: {
+        const int32_t str_len = parameter_;
+        if (str_len <= 0) {
+            std::stringstream err;
+            err << "Invalid string length " << str_len << " for binary '"
+                << key_ << "'";
+            throw DecodeError(err.str());
+        }
+        checkDivisibleBy_(str_len);
+        output.assign(encodedData_, encodedDataLength_ / str_len, str_len);
+        break;
+    }
+    default: {
+        std::stringstream err;
+        err << "Invalid strategy " << strategy_ << " for binary '" + key_
+            << "': does not decode to string array";
+        throw DecodeError(err.str());
+    }
+    }
+
+    // check size
+    checkLength_(output.size());
+}
+
 template<>
 inline void BinaryDecoder::decode(std::vector<char>& output) const {
 
@@ -419,6 +671,567 @@ inline void BinaryDecoder::decode(std::vector<char>& output) const {
     checkLength_(output.size());
 }
 
+inline void BinaryDecoder::decodeModel(int32_t model_index,
+                                       std::vector<float>& output) const {
+    if (strategy_ != 100) {
+        std::stringstream err;
+        err << "Invalid strategy " << strategy_ << " for binary '" + key_
+            << "': cannot decode single models";
+        throw DecodeError(err.str());
+    }
+    int32_t keyframe_interval;
+    std::vector<int32_t> model_sizes;
+    std::vector<int32_t> offsets;
+    const char* blocks;
+    modelDeltaLayout_(keyframe_interval, model_sizes, offsets, blocks);
+    if (model_index < 0 || model_index >= int32_t(model_sizes.size())) {
+        std::stringstream err;
+        err << "Invalid model index " << model_index << " for binary '"
+            << key_ << "' with " << model_sizes.size() << " models";
+        throw DecodeError(err.str());
+    }
+    // go back to last keyframe
+    int32_t first = model_index;
+    while (!isModelDeltaKeyframe(first, model_sizes, keyframe_interval)) {
+        --first;
+    }
+    std::vector<int32_t> values;
+    std::vector<int32_t> deltas;
+    modelDeltaBlock_(blocks, offsets, first, model_sizes[first], true,
+                     values);
+    deltaDecode_(values);
+    for (int32_t k = first + 1; k <= model_index; ++k) {
+        modelDeltaBlock_(blocks, offsets, k, model_sizes[k], false, deltas);
+        for (size_t i = 0; i < values.size(); ++i) values[i] += deltas[i];
+    }
+    decodeDivide_(values, static_cast<float>(parameter_), output);
+}
+
+// model delta decoding
+inline void BinaryDecoder::modelDeltaLayout_(int32_t& keyframe_interval,
+                                             std::vector<int32_t>& model_sizes,
+                                             std::vector<int32_t>& offsets,
+                                             const char*& blocks) const {
+    const char* p = encodedData_;
+    const char* end = encodedData_ + encodedDataLength_;
+    int32_t num_models = -1;
+    keyframe_interval = 0;
+    if (end - p >= 8) {
+        assignBigendian4(&num_models, p);
+        assignBigendian4(&keyframe_interval, p + 4);
+        p += 8;
+    }
+    if (num_models < 0 || keyframe_interval < 1
+        || end - p < 4 || (end - p - 4) / 8 < num_models) {
+        throw DecodeError("Invalid model delta layout in binary '" + key_
+                          + "'");
+    }
+    model_sizes.resize(num_models);
+    offsets.resize(num_models + 1);
+    if (num_models > 0) {
+        arrayCopyBigendian4(&model_sizes[0], p, 4 * num_models);
+        p += 4 * num_models;
+    }
+    arrayCopyBigendian4(&offsets[0], p, 4 * (num_models + 1));
+    p += 4 * (num_models + 1);
+    blocks = p;
+    // 64 bit sum of non-negative sizes cannot overflow
+    int64_t total = 0;
+    for (int32_t k = 0; k < num_models; ++k) {
+        if (model_sizes[k] < 0 || offsets[k + 1] < offsets[k]) {
+            throw DecodeError("Invalid model delta layout in binary '" + key_
+                              + "'");
+        }
+        total += model_sizes[k];
+    }
+    if (offsets[0] != 0 || total != int64_t(length_)
+        || (end - p) != std::ptrdiff_t(offsets[num_models])) {
+        throw DecodeError("Invalid model delta layout in binary '" + key_
+                          + "'");
+    }
+}
+
+inline void BinaryDecoder::modelDeltaBlock_(const char* blocks,
+                                            const std::vector<int32_t>& offsets,
+                                            int32_t model_index,
+                                            int32_t expected_size,
+                                            bool keyframe,
+                                            std::vector<int32_t>& output) const {
+    // keyframes use 16 bit words, others single bytes
+    const int32_t begin = offsets[model_index];
+    const int32_t num_bytes = offsets[model_index + 1] - begin;
+    if (keyframe) {
+        if (num_bytes % 2 != 0) {
+            throw DecodeError("Invalid model delta layout in binary '" + key_
+                              + "'");
+        }
+        std::vector<int16_t> words(num_bytes / 2);
+        if (!words.empty()) {
+            arrayCopyBigendian2(&words[0], blocks + begin, num_bytes);
+        }
+        recursiveIndexDecode_(words, output);
+    } else {
+        const std::vector<int8_t> bytes(blocks + begin,
+                                        blocks + begin + num_bytes);
+        recursiveIndexDecode_(bytes, output);
+    }
+    if (int32_t(output.size()) != expected_size) {
+        std::stringstream err;
+        err << "Length mismatch for model " << model_index << " of binary '"
+            << key_ << "': " << output.size() << " vs " << expected_size;
+        throw DecodeError(err.str());
+    }
+}
+
+inline void BinaryDecoder::modelDeltaRange_(int32_t begin, int32_t end,
+                                            std::vector<int32_t>& output) const {
+    int32_t keyframe_interval;
+    std::vector<int32_t> model_sizes;
+    std::vector<int32_t> offsets;
+    const char* blocks;
+    modelDeltaLayout_(keyframe_interval, model_sizes, offsets, blocks);
+    output.clear();
+    if (begin == end) return;
+    output.reserve(end - begin);
+    // first model overlapping range and its last keyframe
+    int32_t model = 0;
+    int32_t model_begin = 0;
+    while (model_begin + model_sizes[model] <= begin) {
+        model_begin += model_sizes[model];
+        ++model;
+    }
+    int32_t first = model;
+    while (!isModelDeltaKeyframe(first, model_sizes, keyframe_interval)) {
+        --first;
+    }
+    std::vector<int32_t> values;
+    std::vector<int32_t> deltas;
+    for (int32_t k = first; model_begin < end; ++k) {
+        if (isModelDeltaKeyframe(k, model_sizes, keyframe_interval)) {
+            modelDeltaBlock_(blocks, offsets, k, model_sizes[k], true, values);
+            deltaDecode_(values);
+        } else {
+            modelDeltaBlock_(blocks, offsets, k, model_sizes[k], false,
+                             deltas);
+            for (size_t i = 0; i < values.size(); ++i) values[i] += deltas[i];
+        }
+        if (k < model) continue;
+        const int32_t lo = std::max(begin, model_begin) - model_begin;
+        const int32_t hi = std::min(end, model_begin + model_sizes[k])
+                         - model_begin;
+        output.insert(output.end(), values.begin() + lo, values.begin() + hi);
+        model_begin += model_sizes[k];
+    }
+}
+
+// range decoding
+template<typename T>
+void BinaryDecoder::decodeRange(int32_t begin, int32_t end, T& target) const {
+    checkRange_(begin, end);
+    decodeRange(seek(begin), end, target);
+}
+
+template<typename T>
+void BinaryDecoder::decodeRange(const BinarySeekPoint& start, int32_t end,
+                                T& target) const {
+    BinarySeekPoint point(start);
+    decodeRange_(point, end, target);
+}
+
+template<typename T>
+void BinaryDecoder::decodeRange_(BinarySeekPoint&, int32_t, T&) const {
+    throw mmtf::DecodeError("Invalid target type for binary '" + key_ + "'");
+}
+
+template<>
+inline void BinaryDecoder::decodeRange_(BinarySeekPoint& point,
+                                        int32_t end,
+                                        std::vector<float>& output) const {
+    checkRange_(point.index, end);
+    switch (strategy_) {
+    case 1: {
+        const char* bytes = fixedWidthRange_(point.index, end, 4);
+        output.resize(end - point.index);
+        if (!output.empty()) {
+            arrayCopyBigendian4(&output[0], bytes, 4 * output.size());
+        }
+        break;
+    }
+    case 11: {
+        const char* bytes = fixedWidthRange_(point.index, end, 2);
+        std::vector<int16_t> step1(end - point.index);
+        if (!step1.empty()) {
+            arrayCopyBigendian2(&step1[0], bytes, 2 * step1.size());
+        }
+        decodeDivide_(step1, static_cast<float>(parameter_), output);
+        break;
+    }
+    case 9:
+    case 10:
+    case 12:
+    case 13: {
+        std::vector<int32_t> step1;
+        scan_(point, end, &step1);
+        decodeDivide_(step1, static_cast<float>(parameter_), output);
+        break;
+    }
+    case 100: {
+        std::vector<int32_t> step1;
+        modelDeltaRange_(point.index, end, step1);
+        decodeDivide_(step1, static_cast<float>(parameter_), output);
+        break;
+    }
+    default:
+        throwInvalidRangeStrategy_("float");
+    }
+    point.index = end;
+}
+
+template<>
+inline void BinaryDecoder::decodeRange_(BinarySeekPoint& point,
+                                        int32_t end,
+                                        std::vector<int8_t>& output) const {
+    checkRange_(point.index, end);
+    switch (strategy_) {
+    case 2: {
+        const char* bytes = fixedWidthRange_(point.index, end, 1);
+        output.assign(bytes, bytes + (end - point.index));
+        break;
+    }
+    case 16: {
+        std::vector<int32_t> step1;
+        scan_(point, end, &step1);
+        output.assign(step1.begin(), step1.end());
+        break;
+    }
+    default:
+        throwInvalidRangeStrategy_("int8");
+    }
+    point.index = end;
+}
+
+template<>
+inline void BinaryDecoder::decodeRange_(BinarySeekPoint& point,
+                                        int32_t end,
+                                        std::vector<int16_t>& output) const {
+    checkRange_(point.index, end);
+    switch (strategy_) {
+    case 3: {
+        const char* bytes = fixedWidthRange_(point.index, end, 2);
+        output.resize(end - point.index);
+        if (!output.empty()) {
+            arrayCopyBigendian2(&output[0], bytes, 2 * output.size());
+        }
+        break;
+    }
+    default:
+        throwInvalidRangeStrategy_("int16");
+    }
+    point.index = end;
+}
+
+template<>
+inline void BinaryDecoder::decodeRange_(BinarySeekPoint& point,
+                                        int32_t end,
+                                        std::vector<int32_t>& output) const {
+    checkRange_(point.index, end);
+    switch (strategy_) {
+    case 4: {
+        const char* bytes = fixedWidthRange_(point.index, end, 4);
+        output.resize(end - point.index);
+        if (!output.empty()) {
+            arrayCopyBigendian4(&output[0], bytes, 4 * output.size());
+        }
+        break;
+    }
+    case 7:
+    case 8:
+    case 14:
+    case 15: {
+        output.clear();
+        scan_(point, end, &output);
+        break;
+    }
+    default:
+        throwInvalidRangeStrategy_("int32");
+    }
+    point.index = end;
+}
+
+template<>
+inline void BinaryDecoder::decodeRange_(BinarySeekPoint& point,
+                                        int32_t end,
+                                        std::vector<std::string>& output) const {
+    checkRange_(point.index, end);
+    switch (strategy_) {
+    case 5: {
+        const int32_t str_len = parameter_;
+        const char* bytes = fixedWidthRange_(point.index, end, str_len);
+        output.resize(end - point.index);
+        for (size_t i = 0; i < output.size(); ++i) {
+            impl::assignFixedWidth(output[i], bytes + i * str_len, str_len);
+        }
+        break;
+    }
+    default:
+        throwInvalidRangeStrategy_("string");
+    }
+    point.index = end;
+}
+
+template<>
+inline void BinaryDecoder::decodeRange_(BinarySeekPoint& point,
+                                        int32_t end,
+                                        std::vector<char>& output) const {
+    checkRange_(point.index, end);
+    switch (strategy_) {
+    case 6: {
+        std::vector<int32_t> step1;
+        scan_(point, end, &step1);
+        output.assign(step1.begin(), step1.end());
+        break;
+    }
+    default:
+        throwInvalidRangeStrategy_("char");
+    }
+    point.index = end;
+}
+
+inline BinarySeekPoint BinaryDecoder::seek(int32_t index) const {
+    return seek(BinarySeekPoint(), index);
+}
+
+inline BinarySeekPoint BinaryDecoder::seek(const BinarySeekPoint& from,
+                                           int32_t index) const {
+    checkRange_(from.index, index);
+    BinarySeekPoint point(from);
+    scan_(point, index, NULL);
+    return point;
+}
+
+// decoding with checkpoints
+template<typename T>
+void BinaryDecoder::decode(const std::vector<BinarySeekPoint>&,
+                           T& target) const {
+    decode(target);
+}
+
+template<typename T>
+void BinaryDecoder::decode(const std::vector<BinarySeekPoint>& checkpoints,
+                           std::vector<T>& target) const {
+    if (   checkpoints.empty() || !needsScan()
+        || !hasIncreasingCheckpoints_(checkpoints)) {
+        decode(target);
+        return;
+    }
+    // chunk i starts at checkpoint i - 1 and must end at checkpoint i
+    const int32_t num_chunks = int32_t(checkpoints.size()) + 1;
+    std::vector<char> valid(num_chunks, 0);
+    target.resize(length_);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int32_t i = 0; i < num_chunks; ++i) {
+        BinarySeekPoint point;
+        if (i > 0) point = checkpoints[i - 1];
+        const int32_t begin = point.index;
+        const int32_t end = (i + 1 < num_chunks) ? checkpoints[i].index
+                                                 : length_;
+        std::vector<T> chunk;
+        try {
+            decodeRange_(point, end, chunk);
+        } catch (DecodeError&) {
+            continue;
+        }
+        if (i + 1 < num_chunks) {
+            const BinarySeekPoint& next = checkpoints[i];
+            if (   point.offset != next.offset || point.skip != next.skip
+                || point.value != next.value) {
+                continue;
+            }
+        }
+        std::copy(chunk.begin(), chunk.end(), target.begin() + begin);
+        valid[i] = 1;
+    }
+    if (std::find(valid.begin(), valid.end(), 0) != valid.end()) {
+        // stale checkpoints or wrong target type: sequential decoding either
+        // succeeds or reports the actual error
+        decode(target);
+    }
+}
+
+inline bool BinaryDecoder::matchesCheckpoints(
+        const std::vector<BinarySeekPoint>& checkpoints) const {
+    if (!hasIncreasingCheckpoints_(checkpoints)) return false;
+    const int32_t num_checkpoints = int32_t(checkpoints.size());
+    std::vector<char> valid(num_checkpoints, 0);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int32_t i = 0; i < num_checkpoints; ++i) {
+        BinarySeekPoint point;
+        if (i > 0) point = checkpoints[i - 1];
+        const BinarySeekPoint& next = checkpoints[i];
+        try {
+            scan_(point, next.index, NULL);
+        } catch (DecodeError&) {
+            continue;
+        }
+        valid[i] = (   point.offset == next.offset && point.skip == next.skip
+                    && point.value == next.value);
+    }
+    return std::find(valid.begin(), valid.end(), 0) == valid.end();
+}
+
+inline void BinaryDecoder::findSeekPoints(const std::vector<int32_t>& indices,
+                                          std::vector<BinarySeekPoint>& points) const {
+    points.clear();
+    points.reserve(indices.size());
+    BinarySeekPoint point;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        checkRange_(point.index, indices[i]);
+        scan_(point, indices[i], NULL);
+        points.push_back(point);
+    }
+}
+
+inline void BinaryDecoder::scan_(BinarySeekPoint& point, int32_t end,
+                                 std::vector<int32_t>* output) const {
+    switch (strategy_) {
+    case 6:
+    case 7:
+    case 8:
+    case 9:
+    case 16: {
+        // run-length encoded pairs (value, number)
+        const bool delta = (strategy_ == 8);
+        if (output) output->reserve(output->size() + (end - point.index));
+        while (point.index < end) {
+            if (point.offset > encodedDataLength_
+                || encodedDataLength_ - point.offset < 8) {
+                throw DecodeError("Unexpected end of binary '" + key_ + "'");
+            }
+            int32_t value;
+            int32_t number;
+            assignBigendian4(&value, encodedData_ + point.offset);
+            assignBigendian4(&number, encodedData_ + point.offset + 4);
+            const int32_t count = std::min(number - point.skip,
+                                           end - point.index);
+            if (count > 0) {
+                if (output && delta) {
+                    for (int32_t j = 0; j < count; ++j) {
+                        point.value += value;
+                        output->push_back(point.value);
+                    }
+                } else {
+                    if (output) output->insert(output->end(), count, value);
+                    if (delta) point.value += value * count;
+                }
+                point.index += count;
+                point.skip += count;
+            }
+            if (point.skip >= number) {
+                point.offset += 8;
+                point.skip = 0;
+            }
+        }
+        break;
+    }
+    case 10:
+        recursiveIndexScan_<int16_t>(point, end, true, output);
+        break;
+    case 12:
+    case 14:
+        recursiveIndexScan_<int16_t>(point, end, false, output);
+        break;
+    case 13:
+    case 15:
+        recursiveIndexScan_<int8_t>(point, end, false, output);
+        break;
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+    case 5:
+    case 11:
+    case 100:
+        // fixed width or indexed blocks: nothing to scan
+        point.index = end;
+        break;
+    default: {
+        std::stringstream err;
+        err << "Invalid strategy " << strategy_ << " for binary '" + key_
+            << "'";
+        throw DecodeError(err.str());
+    }
+    }
+}
+
+template<typename SmallInt>
+void BinaryDecoder::recursiveIndexScan_(BinarySeekPoint& point, int32_t end,
+                                        bool delta,
+                                        std::vector<int32_t>* output) const {
+    const SmallInt min_int = std::numeric_limits<SmallInt>::min();
+    const SmallInt max_int = std::numeric_limits<SmallInt>::max();
+    const uint32_t word_size = sizeof(SmallInt);
+    if (output) output->reserve(output->size() + (end - point.index));
+    int32_t cur_val = 0;
+    while (point.index < end) {
+        if (point.offset > encodedDataLength_
+            || encodedDataLength_ - point.offset < word_size) {
+            throw DecodeError("Unexpected end of binary '" + key_ + "'");
+        }
+        SmallInt word;
+        readBigendian(word, encodedData_ + point.offset);
+        point.offset += word_size;
+        cur_val += word;
+        if (word != min_int && word != max_int) {
+            if (delta) cur_val += point.value;
+            point.value = cur_val;
+            if (output) output->push_back(cur_val);
+            cur_val = 0;
+            ++point.index;
+        }
+    }
+}
+
+inline const char* BinaryDecoder::fixedWidthRange_(int32_t begin, int32_t end,
+                                                   int32_t item_size) const {
+    if (item_size <= 0
+        || encodedDataLength_ / uint32_t(item_size) < uint32_t(end)) {
+        throw DecodeError("Unexpected end of binary '" + key_ + "'");
+    }
+    return encodedData_ + std::size_t(begin) * item_size;
+}
+
+inline void BinaryDecoder::checkRange_(int32_t begin, int32_t end) const {
+    if (begin < 0 || end < begin || end > length_) {
+        std::stringstream err;
+        err << "Invalid range [" << begin << ", " << end << ") for binary '"
+            << key_ << "' of length " << length_;
+        throw DecodeError(err.str());
+    }
+}
+
+inline bool BinaryDecoder::hasIncreasingCheckpoints_(
+        const std::vector<BinarySeekPoint>& checkpoints) const {
+    for (size_t i = 0; i < checkpoints.size(); ++i) {
+        const int32_t prev = (i == 0) ? 0 : checkpoints[i - 1].index;
+        if (   checkpoints[i].index <= prev || checkpoints[i].index >= length_
+            || checkpoints[i].skip < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void BinaryDecoder::throwInvalidRangeStrategy_(const std::string& type) const {
+    std::stringstream err;
+    err << "Invalid strategy " << strategy_ << " for binary '" + key_
+        << "': does not decode to " << type << " array";
+    throw DecodeError(err.str());
+}
+
 // checks
 inline void BinaryDecoder::checkLength_(int32_t exp_length) const {
     if (length_ != exp_length) {
@@ -476,16 +1289,20 @@ inline void BinaryDecoder::decodeFromBytes_(std::vector<int32_t>& output) const
 }
 // special one: decode to vector of strings
 inline void BinaryDecoder::decodeFromBytes_(std::vector<std::string>& output) const {
-    char NULL_BYTE = 0x00;
     // check parameter
     const int32_t str_len = parameter_;
+    if (str_len <= 0) {
+        std::stringstream err;
+        err << "Invalid string length " << str_len << " for binary '" << key_
+            << "'";
+        throw DecodeError(err.str());
+    }
     checkDivisibleBy_(str_len);
     // prepare memory
     output.resize(encodedDataLength_ / str_len);
-    // get data
+    // get data (single assign per string, padding removed on the fly)
     for (size_t i = 0; i < output.size(); ++i) {
-        output[i].assign(encodedData_ + i * str_len, str_len);
-        output[i].erase(std::remove(output[i].begin(), output[i].end(), NULL_BYTE), output[i].end());
+        impl::assignFixedWidth(output[i], encodedData_ + i * str_len, str_len);
     }
 }
 
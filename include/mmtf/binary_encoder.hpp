@@ -11,7 +11,11 @@
 
 #ifndef MMTF_BINARY_ENCODER_H
 #define MMTF_BINARY_ENCODER_H
+#include "errors.hpp"
+#include "fixed_width_string_list.hpp"
+#include "model_delta.hpp"
 #include <math.h>
+#include <cstring>
 #include <vector>
 #include <string>
 #include <sstream>
@@ -66,6 +70,14 @@ inline std::vector<int32_t> runLengthEncode(std::vector<Int> const & vec_in );
 inline std::vector<int32_t> recursiveIndexEncode(std::vector<int32_t> const & vec_in,
                                              int max=32767, int min=-32768);
 
+/**
+ * @brief Write ints as big endian 32 bit, 16 bit or 8 bit ints to a stream.
+ * @param[in] ss            stringstream to write to
+ * @param[in] vec_in        vector of ints (must fit into Int)
+ */
+template<typename Int>
+inline void writeInts(std::stringstream & ss, std::vector<int32_t> const & vec_in);
+
 /**
  * @brief Add mmtf header to a stream
  * @param[in] ss            stringstream to add a header to
@@ -82,18 +94,38 @@ inline void add_header(std::stringstream & ss, uint32_t array_size, uint32_t cod
  */
 inline std::vector<char> stringstreamToCharVector(std::stringstream & ss);
 
+/**
+ * @brief Error for strategy not supported by encodeBinary
+ * @param[in] strategy      requested strategy
+ * @param[in] type          name of value type
+ * @return                  error to throw
+ */
+inline EncodeError unsupportedStrategy(int32_t const strategy, const char* type);
+
 } // anon ns
 
 // *************************************************************************
 // PUBLIC FUNCTIONS
 // *************************************************************************
 
+/** Encode 32 bit float encoding (type 1)
+ * @param[in] floats_in     Vector of floats to encode
+ * @return Char vector of encoded bytes
+ */
+inline std::vector<char> encodeFourByteFloat(std::vector<float> const & floats_in);
+
 /** Encode 8 bit int to bytes encoding (type 2)
  * @param[in] vec_in        Vector of ints to encode
  * @return Char vector of encoded bytes
  */
 inline std::vector<char> encodeInt8ToByte(std::vector<int8_t> vec_in);
 
+/** Encode 16 bit int encoding (type 3)
+ * @param[in] vec_in        Vector of ints to encode
+ * @return Char vector of encoded bytes
+ */
+inline std::vector<char> encodeTwoByteInt(std::vector<int16_t> const & vec_in);
+
 /** Encode 4 bytes to int encoding (type 4)
  * @param[in] vec_in        Vector of ints to encode
  * @return Char vector of encoded bytes
@@ -104,9 +136,20 @@ inline std::vector<char> encodeFourByteInt(std::vector<int32_t> const & vec_in);
  * @param[in] in_sv         Vector of strings to encode
  * @param[in] CHAIN_LEN     Maximum length of string
  * @return Char vector of encoded bytes
+ * @throw mmtf::EncodeError if CHAIN_LEN < 1 or a string is longer
  */
 inline std::vector<char> encodeStringVector(std::vector<std::string> const & in_sv, int32_t const CHAIN_LEN);
 
+/** Encode packed string list (type 5)
+ * @param[in] in_sl         Packed strings to encode
+ * @param[in] CHAIN_LEN     Maximum length of string
+ * @return Char vector of encoded bytes
+ *
+ * Records are copied as they are if in_sl.width() == CHAIN_LEN.
+ * @throw mmtf::EncodeError if CHAIN_LEN < 1 or a string is longer
+ */
+inline std::vector<char> encodeStringVector(FixedWidthStringList const & in_sl, int32_t const CHAIN_LEN);
+
 
 /** Encode Run Length Char encoding (type 6)
  * @param[in] in_cv         Vector of chars to encode
@@ -115,6 +158,12 @@ inline std::vector<char> encodeStringVector(std::vector<std::string> const & in_
 inline std::vector<char> encodeRunLengthChar(std::vector<char> const & in_cv);
 
 
+/** Encode Run Length Int encoding (type 7)
+ * @param[in] int_vec       Vector of ints to encode
+ * @return Char vector of encoded bytes
+ */
+inline std::vector<char> encodeRunLengthInt(std::vector<int32_t> const & int_vec);
+
 /** Encode Run Length Delta Int encoding (type 8)
  * @param[in] int_vec       Vector of ints to encode
  * @return Char vector of encoded bytes
@@ -135,12 +184,96 @@ inline std::vector<char> encodeRunLengthFloat(std::vector<float> const & floats_
  */
 inline std::vector<char> encodeDeltaRecursiveFloat(std::vector<float> const & floats_in, int32_t const multiplier);
 
+/** Encode Integer Float encoding (type 11)
+ * @param[in] floats_in     Vector of floats to encode
+ * @param[in] multiplier    Multiplier to convert float to int
+ * @return Char vector of encoded bytes
+ * @throw mmtf::EncodeError if a converted value does not fit into 16 bits
+ */
+inline std::vector<char> encodeTwoByteFloat(std::vector<float> const & floats_in, int32_t const multiplier);
+
+/** Encode Recursive Float encoding (type 12)
+ * @param[in] floats_in     Vector of floats to encode
+ * @param[in] multiplier    Multiplier to convert float to int
+ * @return Char vector of encoded bytes
+ */
+inline std::vector<char> encodeRecursiveFloat(std::vector<float> const & floats_in, int32_t const multiplier);
+
+/** Encode 8 bit Recursive Float encoding (type 13)
+ * @param[in] floats_in     Vector of floats to encode
+ * @param[in] multiplier    Multiplier to convert float to int
+ * @return Char vector of encoded bytes
+ */
+inline std::vector<char> encodeRecursiveByteFloat(std::vector<float> const & floats_in, int32_t const multiplier);
+
+/** Encode Recursive Int encoding (type 14)
+ * @param[in] int_vec       Vector of ints to encode
+ * @return Char vector of encoded bytes
+ */
+inline std::vector<char> encodeRecursiveInt(std::vector<int32_t> const & int_vec);
+
+/** Encode 8 bit Recursive Int encoding (type 15)
+ * @param[in] int_vec       Vector of ints to encode
+ * @return Char vector of encoded bytes
+ */
+inline std::vector<char> encodeRecursiveByteInt(std::vector<int32_t> const & int_vec);
+
 /** Encode Run-Length 8bit int encoding (type 16)
  * @param[in] int8_vec     Vector of ints to encode
  * @return Char vector of encoded bytes
  */
 inline std::vector<char> encodeRunLengthInt8(std::vector<int8_t> const & int8_vec);
 
+/** Encode Model Delta Float encoding (library-specific type 100)
+ * @param[in] floats_in         Vector of floats to encode (all models)
+ * @param[in] model_sizes       Number of values per model
+ * @param[in] multiplier        Multiplier to convert float to int
+ * @param[in] keyframe_interval Every keyframe_interval-th model is encoded
+ *                              like type 10, others as per-value deltas to
+ *                              the previous model
+ * @return Char vector of encoded bytes
+ * @throw mmtf::EncodeError if any model size is negative, if model_sizes do
+ *        not sum up to the size of floats_in or if keyframe_interval < 1
+ *
+ * After the header follow (as 32 bit ints) the number of models, the keyframe
+ * interval, the model sizes and the byte offsets of every model block plus the
+ * end offset. Then follow the model blocks: keyframes as recursive index
+ * encoded 16 bit ints (as in type 10), other models as recursive index encoded
+ * 8 bit ints (small deltas between models take a single byte). Models with a
+ * size different from the previous model are keyframes too (see
+ * mmtf::isModelDeltaKeyframe). Any model can be decoded from the last keyframe
+ * before it (see BinaryDecoder::decodeModel). This type is not part of the
+ * MMTF specification and cannot be read by other MMTF libraries.
+ */
+inline std::vector<char> encodeModelDeltaFloat(std::vector<float> const & floats_in,
+    std::vector<int32_t> const & model_sizes, int32_t const multiplier,
+    int32_t const keyframe_interval = 10);
+
+/** Encode values with given strategy
+ * @param[in] values        Vector of values to encode
+ * @param[in] strategy      Binary strategy (type) to use
+ * @param[in] param         Multiplier for float strategies and string
+ *                          length for type 5 (ignored otherwise)
+ * @return Char vector of encoded bytes
+ * @throw mmtf::EncodeError if strategy cannot encode values of this type,
+ *                          if param < 1 for float strategies 9 to 13 or if
+ *                          a string does not fit into param bytes
+ *
+ * Supported strategies match BinaryDecoder::decode:
+ * - std::vector<float>       (types 1, 9, 10, 11, 12, 13)
+ * - std::vector<int8_t>      (types 2, 16)
+ * - std::vector<int16_t>     (type 3)
+ * - std::vector<int32_t>     (types 4, 7, 8, 14, 15)
+ * - std::vector<std::string> (type 5)
+ * - std::vector<char>        (type 6)
+ */
+inline std::vector<char> encodeBinary(std::vector<float> const & values, int32_t const strategy, int32_t const param = 0);
+inline std::vector<char> encodeBinary(std::vector<int8_t> const & values, int32_t const strategy, int32_t const param = 0);
+inline std::vector<char> encodeBinary(std::vector<int16_t> const & values, int32_t const strategy, int32_t const param = 0);
+inline std::vector<char> encodeBinary(std::vector<int32_t> const & values, int32_t const strategy, int32_t const param = 0);
+inline std::vector<char> encodeBinary(std::vector<std::string> const & values, int32_t const strategy, int32_t const param = 0);
+inline std::vector<char> encodeBinary(std::vector<char> const & values, int32_t const strategy, int32_t const param = 0);
+
 // *************************************************************************
 // IMPLEMENTATION
 // *************************************************************************
@@ -213,6 +346,17 @@ inline std::vector<int32_t> recursiveIndexEncode(
 }
 
 
+template<typename Int>
+inline void writeInts(std::stringstream & ss, std::vector<int32_t> const & vec_in) {
+  for (size_t i=0; i<vec_in.size(); ++i) {
+    Int temp = static_cast<Int>(vec_in[i]);
+    if (sizeof(Int) == 4) temp = static_cast<Int>(htonl(temp));
+    if (sizeof(Int) == 2) temp = static_cast<Int>(htons(temp));
+    ss.write(reinterpret_cast< char * >(&temp), sizeof(temp));
+  }
+}
+
+
 inline void add_header(std::stringstream & ss, uint32_t array_size, uint32_t codec, uint32_t param /* =0 */) {
     uint32_t be_codec = htonl(codec);
     uint32_t be_array_size = htonl(array_size);
@@ -229,9 +373,29 @@ inline std::vector<char> stringstreamToCharVector(std::stringstream & ss) {
   return ret;
 }
 
+
+inline EncodeError unsupportedStrategy(int32_t const strategy, const char* type) {
+  std::stringstream err;
+  err << "Invalid strategy " << strategy << ": cannot encode " << type;
+  return EncodeError(err.str());
+}
+
 } // anon ns
 
 
+inline std::vector<char> encodeFourByteFloat(std::vector<float> const & floats_in) {
+  std::stringstream ss;
+  add_header(ss, floats_in.size(), 1, 0);
+  for (size_t i=0; i<floats_in.size(); ++i) {
+    uint32_t temp;
+    std::memcpy(&temp, &floats_in[i], sizeof(temp));
+    temp = htonl(temp);
+    ss.write(reinterpret_cast< char * >(&temp), sizeof(temp));
+  }
+  return stringstreamToCharVector(ss);
+}
+
+
 inline std::vector<char> encodeInt8ToByte(std::vector<int8_t> vec_in) {
   std::stringstream ss;
   add_header(ss, vec_in.size(), 2, 0);
@@ -242,6 +406,14 @@ inline std::vector<char> encodeInt8ToByte(std::vector<int8_t> vec_in) {
 }
 
 
+inline std::vector<char> encodeTwoByteInt(std::vector<int16_t> const & vec_in) {
+  std::stringstream ss;
+  add_header(ss, vec_in.size(), 3, 0);
+  writeInts<int16_t>(ss, std::vector<int32_t>(vec_in.begin(), vec_in.end()));
+  return stringstreamToCharVector(ss);
+}
+
+
 inline std::vector<char> encodeFourByteInt(std::vector<int32_t> const & vec_in) {
   std::stringstream ss;
   add_header(ss, vec_in.size(), 4, 0);
@@ -254,6 +426,19 @@ inline std::vector<char> encodeFourByteInt(std::vector<int32_t> const & vec_in)
 
 
 inline std::vector<char> encodeStringVector(std::vector<std::string> const & in_sv, int32_t const CHAIN_LEN) {
+  if (CHAIN_LEN < 1) {
+    std::stringstream err;
+    err << "Invalid string length " << CHAIN_LEN << " (type 5)";
+    throw EncodeError(err.str());
+  }
+  for (size_t i=0; i<in_sv.size(); ++i) {
+    if (in_sv[i].size() > size_t(CHAIN_LEN)) {
+      std::stringstream err;
+      err << "String '" << in_sv[i] << "' is longer than " << CHAIN_LEN
+          << " bytes (type 5)";
+      throw EncodeError(err.str());
+    }
+  }
   char NULL_BYTE = 0x00;
   std::stringstream ss;
   add_header(ss, in_sv.size(), 5, CHAIN_LEN);
@@ -271,6 +456,18 @@ inline std::vector<char> encodeStringVector(std::vector<std::string> const & in_
 }
 
 
+inline std::vector<char> encodeStringVector(FixedWidthStringList const & in_sl, int32_t const CHAIN_LEN) {
+  if (in_sl.width() != CHAIN_LEN || CHAIN_LEN < 1) {
+    return encodeStringVector(in_sl.toVector(), CHAIN_LEN);
+  }
+  std::stringstream ss;
+  add_header(ss, in_sl.size(), 5, CHAIN_LEN);
+  std::vector<char> output = stringstreamToCharVector(ss);
+  output.insert(output.end(), in_sl.bytes().begin(), in_sl.bytes().end());
+  return output;
+}
+
+
 inline std::vector<char> encodeRunLengthChar(std::vector<char> const & in_cv) {
   std::stringstream ss;
   add_header(ss, in_cv.size(), 6, 0);
@@ -283,6 +480,14 @@ inline std::vector<char> encodeRunLengthChar(std::vector<char> const & in_cv) {
 }
 
 
+inline std::vector<char> encodeRunLengthInt(std::vector<int32_t> const & int_vec) {
+  std::stringstream ss;
+  add_header(ss, int_vec.size(), 7, 0);
+  writeInts<int32_t>(ss, runLengthEncode(int_vec));
+  return stringstreamToCharVector(ss);
+}
+
+
 inline std::vector<char> encodeRunLengthDeltaInt(std::vector<int32_t> int_vec) {
   std::stringstream ss;
   add_header(ss, int_vec.size(), 8, 0);
@@ -322,6 +527,55 @@ inline std::vector<char> encodeDeltaRecursiveFloat(std::vector<float> const & fl
 }
 
 
+inline std::vector<char> encodeTwoByteFloat(std::vector<float> const & floats_in, int32_t const multiplier) {
+  std::stringstream ss;
+  add_header(ss, floats_in.size(), 11, multiplier);
+  std::vector<int32_t> const int_vec = convertFloatsToInts(floats_in, multiplier);
+  for (size_t i=0; i<int_vec.size(); ++i) {
+    if (int_vec[i] < -32768 || int_vec[i] > 32767) {
+      std::stringstream err;
+      err << "Value " << floats_in[i] << " times " << multiplier
+          << " does not fit into 16 bit int (type 11)";
+      throw EncodeError(err.str());
+    }
+  }
+  writeInts<int16_t>(ss, int_vec);
+  return stringstreamToCharVector(ss);
+}
+
+
+inline std::vector<char> encodeRecursiveFloat(std::vector<float> const & floats_in, int32_t const multiplier) {
+  std::stringstream ss;
+  add_header(ss, floats_in.size(), 12, multiplier);
+  writeInts<int16_t>(ss, recursiveIndexEncode(convertFloatsToInts(floats_in, multiplier)));
+  return stringstreamToCharVector(ss);
+}
+
+
+inline std::vector<char> encodeRecursiveByteFloat(std::vector<float> const & floats_in, int32_t const multiplier) {
+  std::stringstream ss;
+  add_header(ss, floats_in.size(), 13, multiplier);
+  writeInts<int8_t>(ss, recursiveIndexEncode(convertFloatsToInts(floats_in, multiplier), 127, -128));
+  return stringstreamToCharVector(ss);
+}
+
+
+inline std::vector<char> encodeRecursiveInt(std::vector<int32_t> const & int_vec) {
+  std::stringstream ss;
+  add_header(ss, int_vec.size(), 14, 0);
+  writeInts<int16_t>(ss, recursiveIndexEncode(int_vec));
+  return stringstreamToCharVector(ss);
+}
+
+
+inline std::vector<char> encodeRecursiveByteInt(std::vector<int32_t> const & int_vec) {
+  std::stringstream ss;
+  add_header(ss, int_vec.size(), 15, 0);
+  writeInts<int8_t>(ss, recursiveIndexEncode(int_vec, 127, -128));
+  return stringstreamToCharVector(ss);
+}
+
+
 inline std::vector<char> encodeRunLengthInt8(std::vector<int8_t> const & int8_vec) {
   std::stringstream ss;
   add_header(ss, int8_vec.size(), 16, 0);
@@ -333,5 +587,123 @@ inline std::vector<char> encodeRunLengthInt8(std::vector<int8_t> const & int8_ve
   return stringstreamToCharVector(ss);
 }
 
+
+inline std::vector<char> encodeModelDeltaFloat(std::vector<float> const & floats_in,
+    std::vector<int32_t> const & model_sizes, int32_t const multiplier,
+    int32_t const keyframe_interval) {
+  size_t total = 0;
+  bool negative = false;
+  for (size_t k=0; k<model_sizes.size(); ++k) {
+    if (model_sizes[k] < 0) negative = true;
+    else total += model_sizes[k];
+  }
+  if (negative || total != floats_in.size() || keyframe_interval < 1) {
+    throw EncodeError("Invalid model sizes or keyframe interval for model "
+                      "delta encoding");
+  }
+  std::vector<int32_t> const int_vec = convertFloatsToInts(floats_in, multiplier);
+  // one block of deltas per model
+  std::stringstream blocks;
+  std::vector<int32_t> offsets(1, 0);
+  size_t begin = 0;
+  for (size_t k=0; k<model_sizes.size(); ++k) {
+    size_t const size = model_sizes[k];
+    std::vector<int32_t> deltas(size);
+    if (isModelDeltaKeyframe(k, model_sizes, keyframe_interval)) {
+      for (size_t i=0; i<size; ++i) {
+        deltas[i] = int_vec[begin + i] - (i > 0 ? int_vec[begin + i - 1] : 0);
+      }
+      std::vector<int32_t> const block = recursiveIndexEncode(deltas);
+      for (size_t i=0; i<block.size(); ++i) {
+        int16_t temp = htons(block[i]);
+        blocks.write(reinterpret_cast< char * >(&temp), sizeof(temp));
+      }
+      offsets.push_back(offsets.back() + 2 * block.size());
+    } else {
+      for (size_t i=0; i<size; ++i) {
+        deltas[i] = int_vec[begin + i] - int_vec[begin - size + i];
+      }
+      std::vector<int32_t> const block = recursiveIndexEncode(deltas, 127, -128);
+      for (size_t i=0; i<block.size(); ++i) {
+        int8_t temp = block[i];
+        blocks.write(reinterpret_cast< char * >(&temp), sizeof(temp));
+      }
+      offsets.push_back(offsets.back() + block.size());
+    }
+    begin += size;
+  }
+  std::stringstream ss;
+  add_header(ss, floats_in.size(), 100, multiplier);
+  std::vector<int32_t> layout;
+  layout.push_back(model_sizes.size());
+  layout.push_back(keyframe_interval);
+  layout.insert(layout.end(), model_sizes.begin(), model_sizes.end());
+  layout.insert(layout.end(), offsets.begin(), offsets.end());
+  for (size_t i=0; i<layout.size(); ++i) {
+    int32_t temp = htonl(layout[i]);
+    ss.write(reinterpret_cast< char * >(&temp), sizeof(temp));
+  }
+  if (offsets.back() > 0) ss << blocks.rdbuf();
+  return stringstreamToCharVector(ss);
+}
+
+inline std::vector<char> encodeBinary(std::vector<float> const & values, int32_t const strategy, int32_t const param) {
+  // multiplier of 0 would silently decode as NaN
+  if (strategy >= 9 && strategy <= 13 && param < 1) {
+    std::stringstream err;
+    err << "Invalid multiplier " << param << " for float strategy "
+        << strategy;
+    throw EncodeError(err.str());
+  }
+  switch (strategy) {
+    case 1: return encodeFourByteFloat(values);
+    case 9: return encodeRunLengthFloat(values, param);
+    case 10: return encodeDeltaRecursiveFloat(values, param);
+    case 11: return encodeTwoByteFloat(values, param);
+    case 12: return encodeRecursiveFloat(values, param);
+    case 13: return encodeRecursiveByteFloat(values, param);
+  }
+  throw unsupportedStrategy(strategy, "float array");
+}
+
+
+inline std::vector<char> encodeBinary(std::vector<int8_t> const & values, int32_t const strategy, int32_t const) {
+  switch (strategy) {
+    case 2: return encodeInt8ToByte(values);
+    case 16: return encodeRunLengthInt8(values);
+  }
+  throw unsupportedStrategy(strategy, "int8 array");
+}
+
+
+inline std::vector<char> encodeBinary(std::vector<int16_t> const & values, int32_t const strategy, int32_t const) {
+  if (strategy == 3) return encodeTwoByteInt(values);
+  throw unsupportedStrategy(strategy, "int16 array");
+}
+
+
+inline std::vector<char> encodeBinary(std::vector<int32_t> const & values, int32_t const strategy, int32_t const) {
+  switch (strategy) {
+    case 4: return encodeFourByteInt(values);
+    case 7: return encodeRunLengthInt(values);
+    case 8: return encodeRunLengthDeltaInt(values);
+    case 14: return encodeRecursiveInt(values);
+    case 15: return encodeRecursiveByteInt(values);
+  }
+  throw unsupportedStrategy(strategy, "int32 array");
+}
+
+
+inline std::vector<char> encodeBinary(std::vector<std::string> const & values, int32_t const strategy, int32_t const param) {
+  if (strategy == 5) return encodeStringVector(values, param);
+  throw unsupportedStrategy(strategy, "string array");
+}
+
+
+inline std::vector<char> encodeBinary(std::vector<char> const & values, int32_t const strategy, int32_t const) {
+  if (strategy == 6) return encodeRunLengthChar(values);
+  throw unsupportedStrategy(strategy, "char array");
+}
+
 } // mmtf namespace
 #endif
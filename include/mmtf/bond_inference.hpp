@@ -0,0 +1,200 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Distance based bond perception for mmtf::StructureData without bonds.
+// See "tests/mmtf_tests.cpp" (Test inferBonds) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_BOND_INFERENCE_H
+#define MMTF_BOND_INFERENCE_H
+
+#include "structure_data.hpp"
+#include "hierarchy_index.hpp"
+#include "spatial_index.hpp"
+#include "export_helpers.hpp"
+#include "errors.hpp"
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+namespace mmtf {
+
+/**
+ * @brief Get covalent radius of an element.
+ * @param[in] element  Element symbol (case insensitive, e.g. "C", "FE", "Fe")
+ * @return Radius in Angstrom or 0 if element is not known.
+ *
+ * Values from Cordero et al., Dalton Trans. (2008) 2832-2838.
+ */
+inline float getCovalentRadius(const std::string& element);
+
+/**
+ * @brief Replace all bonds of data with bonds inferred from distances.
+ * @param[in,out] data       Consistent system with atoms
+ * @param[in]     tolerance  Atoms i and j are bonded if their distance is
+ *                           between 0.4 and r_i + r_j + tolerance
+ * @return Number of bonds found (= data.numBonds)
+ * @throw mmtf::EncodeError if coordinate lists do not match numAtoms
+ * @throw mmtf::DecodeError if the model/chain/group hierarchy is inconsistent
+ *
+ * Neighbors are found with a SpatialIndex; chains are processed in parallel
+ * if OpenMP is enabled. Atoms of different models, atoms with different
+ * (non-blank) alternate locations and elements without known radius are
+ * never bonded. All bonds get bond order -1 (unknown). Results are added with
+ * BondAdder::addBonds on a copy of groupList without duplicates (inter-group
+ * bonds sorted), followed by compressGroupList. Bond resonance data is
+ * removed.
+ */
+inline int32_t inferBonds(StructureData& data, float tolerance = 0.45f);
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+inline float getCovalentRadius(const std::string& element) {
+    // sorted by symbol for binary search
+    static const struct { const char* symbol; float radius; } radii[] = {
+        {"AG", 1.45f}, {"AL", 1.21f}, {"AS", 1.19f}, {"AU", 1.36f},
+        {"B", 0.84f}, {"BA", 2.15f}, {"BE", 0.96f}, {"BR", 1.20f},
+        {"C", 0.76f}, {"CA", 1.76f}, {"CD", 1.44f}, {"CL", 1.02f},
+        {"CO", 1.26f}, {"CR", 1.39f}, {"CS", 2.44f}, {"CU", 1.32f},
+        {"D", 0.31f}, {"F", 0.57f}, {"FE", 1.32f}, {"GA", 1.22f},
+        {"GD", 1.96f}, {"H", 0.31f}, {"HG", 1.32f}, {"I", 1.39f},
+        {"IR", 1.41f}, {"K", 2.03f}, {"LI", 1.28f}, {"MG", 1.41f},
+        {"MN", 1.39f}, {"MO", 1.54f}, {"N", 0.71f}, {"NA", 1.66f},
+        {"NI", 1.24f}, {"O", 0.66f}, {"OS", 1.44f}, {"P", 1.07f},
+        {"PB", 1.46f}, {"PD", 1.39f}, {"PT", 1.36f}, {"RB", 2.20f},
+        {"RU", 1.46f}, {"S", 1.05f}, {"SB", 1.39f}, {"SE", 1.20f},
+        {"SI", 1.11f}, {"SN", 1.39f}, {"SR", 1.95f}, {"TE", 1.38f},
+        {"V", 1.53f}, {"W", 1.62f}, {"XE", 1.40f}, {"ZN", 1.22f}};
+    const int num = sizeof(radii) / sizeof(radii[0]);
+    if (element.empty() || element.size() > 2) return 0;
+    char symbol[3] = {0, 0, 0};
+    for (size_t i = 0; i < element.size(); ++i) {
+        const char c = element[i];
+        symbol[i] = (c >= 'a' && c <= 'z') ? char(c - 'a' + 'A') : c;
+    }
+    int lo = 0;
+    int hi = num - 1;
+    while (lo <= hi) {
+        const int mid = (lo + hi) / 2;
+        const int cmp = std::strcmp(radii[mid].symbol, symbol);
+        if (cmp == 0) return radii[mid].radius;
+        if (cmp < 0) lo = mid + 1;
+        else         hi = mid - 1;
+    }
+    return 0;
+}
+
+inline int32_t inferBonds(StructureData& data, float tolerance) {
+    const HierarchyIndex index(data);
+    const int32_t num_atoms = index.numAtoms();
+    if (num_atoms != data.numAtoms
+        || int32_t(data.xCoordList.size()) != num_atoms
+        || int32_t(data.yCoordList.size()) != num_atoms
+        || int32_t(data.zCoordList.size()) != num_atoms) {
+        throw EncodeError("Cannot infer bonds: coordinate lists are "
+                          "inconsistent with numAtoms");
+    }
+
+    // per-atom radii via group types
+    std::vector<std::vector<float> > group_radii(data.groupList.size());
+    for (size_t t = 0; t < data.groupList.size(); ++t) {
+        const GroupType& group = data.groupList[t];
+        group_radii[t].resize(group.elementList.size());
+        for (size_t l = 0; l < group.elementList.size(); ++l) {
+            group_radii[t][l] = getCovalentRadius(group.elementList[l]);
+        }
+    }
+    std::vector<float> radii(num_atoms);
+    float max_radius = 0;
+    for (int32_t g = 0; g < index.numGroups(); ++g) {
+        const std::vector<float>& r = group_radii[data.groupTypeList[g]];
+        for (int32_t i = index.atomBegin(g); i < index.atomEnd(g); ++i) {
+            radii[i] = r[i - index.atomBegin(g)];
+            if (radii[i] > max_radius) max_radius = radii[i];
+        }
+    }
+    const bool has_alt_locs = !isDefaultValue(data.altLocList);
+
+    // candidate search per chain
+    const SpatialIndex grid(data, 2 * max_radius + tolerance);
+    const int32_t num_chains = index.numChains();
+    std::vector<std::vector<int32_t> > chain_bonds(num_chains);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int32_t c = 0; c < num_chains; ++c) {
+        std::vector<int32_t> neighbors;
+        std::vector<int32_t>& bonds = chain_bonds[c];
+        const int32_t model = index.modelIndexOfChain(c);
+        for (int32_t i = index.chainAtomBegin(c); i < index.chainAtomEnd(c);
+             ++i) {
+            if (radii[i] == 0) continue;
+            const float x = data.xCoordList[i];
+            const float y = data.yCoordList[i];
+            const float z = data.zCoordList[i];
+            grid.findWithinRadius(x, y, z, radii[i] + max_radius + tolerance,
+                                  neighbors);
+            // sorted -> same bond order in identical groups
+            std::sort(neighbors.begin(), neighbors.end());
+            for (size_t k = 0; k < neighbors.size(); ++k) {
+                const int32_t j = neighbors[k];
+                if (j <= i || radii[j] == 0) continue;
+                if (index.modelIndexOfAtom(j) != model) continue;
+                if (has_alt_locs) {
+                    const char a = data.altLocList[i];
+                    const char b = data.altLocList[j];
+                    if (a != b && a > ' ' && b > ' ') continue;
+                }
+                const float dx = data.xCoordList[j] - x;
+                const float dy = data.yCoordList[j] - y;
+                const float dz = data.zCoordList[j] - z;
+                const float d2 = dx * dx + dy * dy + dz * dz;
+                const float max_d = radii[i] + radii[j] + tolerance;
+                if (d2 >= 0.16f && d2 <= max_d * max_d) {
+                    bonds.push_back(i);
+                    bonds.push_back(j);
+                }
+            }
+        }
+    }
+    std::vector<int32_t> bond_atoms;
+    for (int32_t c = 0; c < num_chains; ++c) {
+        bond_atoms.insert(bond_atoms.end(), chain_bonds[c].begin(),
+                          chain_bonds[c].end());
+    }
+    const std::vector<int8_t> bond_orders(bond_atoms.size() / 2, -1);
+
+    // remove old bonds and give every group its own group type
+    std::vector<GroupType> group_list;
+    group_list.reserve(data.groupTypeList.size());
+    for (size_t g = 0; g < data.groupTypeList.size(); ++g) {
+        group_list.push_back(data.groupList[data.groupTypeList[g]]);
+        GroupType& group = group_list.back();
+        group.bondAtomList.clear();
+        group.bondOrderList.clear();
+        group.bondResonanceList.clear();
+        data.groupTypeList[g] = int32_t(g);
+    }
+    data.groupList.swap(group_list);
+    data.bondAtomList.clear();
+    data.bondOrderList.clear();
+    data.bondResonanceList.clear();
+    data.numBonds = 0;
+
+    BondAdder bond_adder(data);
+    bond_adder.addBonds(bond_atoms, bond_orders, true);
+    compressGroupList(data);
+    return data.numBonds;
+}
+
+} // mmtf namespace
+
+#endif
@@ -0,0 +1,716 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Crystal symmetry for mmtf::StructureData (unitCell and spaceGroup).
+// See "tests/mmtf_tests.cpp" (Test crystal symmetry) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_CRYSTAL_H
+#define MMTF_CRYSTAL_H
+
+#include "structure_data.hpp"
+#include "hierarchy_index.hpp"
+#include "spatial_index.hpp"
+#include "assembly.hpp"
+#include "errors.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <math.h>
+
+namespace mmtf {
+
+/**
+ * @brief Get matrix converting fractional to Cartesian coordinates.
+ * @param[in]  unit_cell  a, b, c (Angstrom), alpha, beta, gamma (degrees)
+ *                        as in StructureData::unitCell
+ * @param[out] matrix     Row-major 4x4 matrix as in Transform::matrix (a
+ *                        along x, b in xy-plane as in the PDB convention)
+ * @return False if unit_cell does not have 6 entries or is degenerate.
+ */
+inline bool getOrthogonalizationMatrix(const std::vector<float>& unit_cell,
+                                       float* matrix);
+
+/**
+ * @brief Get matrix converting Cartesian to fractional coordinates.
+ * @see getOrthogonalizationMatrix (this is its inverse)
+ */
+inline bool getFractionalizationMatrix(const std::vector<float>& unit_cell,
+                                       float* matrix);
+
+/**
+ * @brief Parse a symmetry operator given as string (e.g. "-y,x-y,z+1/3").
+ * @param[in]  op      Comma separated expressions for x', y' and z'
+ * @param[out] matrix  Row-major 4x4 matrix acting on fractional
+ *                     coordinates (translation in elements 3, 7 and 11)
+ * @return False if op cannot be parsed.
+ */
+inline bool parseSymmetryOperator(const std::string& op, float* matrix);
+
+/**
+ * @brief Get all symmetry operators of a space group.
+ * @param[in]  space_group  Hermann-Mauguin symbol as in
+ *                          StructureData::spaceGroup (e.g. "P 21 21 21",
+ *                          "P 1 21 1", "H 3")
+ * @param[out] operators    Row-major 4x4 matrices (16 floats each, layout as
+ *                          Transform::matrix) acting on fractional
+ *                          coordinates, identity first, translations in
+ *                          [0, 1)
+ * @return False if space group is not in the built-in table (the 65 space
+ *         groups allowed for chiral molecules and P -1).
+ *
+ * Operators are generated from Hall symbols, including centering translations.
+ */
+inline bool getSymmetryOperators(const std::string& space_group,
+                                 std::vector<float>& operators);
+
+/**
+ * @brief Find symmetry mates in contact with the asymmetric unit.
+ * @param[in]  data    Consistent structure with unitCell and spaceGroup
+ * @param[in]  cutoff  Maximal distance between atoms in contact
+ * @param[out] mates   One entry per (symmetry operator, lattice translation)
+ *                     with a Cartesian matrix and the chains which have an
+ *                     atom within cutoff of an atom of the same model in data
+ *                     (previous content replaced)
+ * @throw mmtf::DecodeError if unitCell, spaceGroup or the hierarchy of data
+ *        are invalid
+ *
+ * The identity is never reported. Candidate operators and translations are
+ * pruned with bounding boxes of the asymmetric unit in fractional space and
+ * of every chain in Cartesian space; remaining chains are transformed in tiles
+ * with transformCoordinates and checked with a SpatialIndex. Candidates are
+ * processed in parallel if OpenMP is enabled. The result can be stored as
+ * transformList of a BioAssembly (together with the identity) to expand or
+ * view the crystal environment with buildAssembly or AssemblyView.
+ */
+inline void findSymmetryMates(const StructureData& data, float cutoff,
+                              std::vector<Transform>& mates);
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+namespace {
+
+// Seitz matrix with integer rotation (row-major) and translation in 1/12
+struct CrystalSymOp {
+    int r[9];
+    int t[3];
+
+    bool operator==(const CrystalSymOp& other) const {
+        return std::memcmp(r, other.r, sizeof(r)) == 0
+               && std::memcmp(t, other.t, sizeof(t)) == 0;
+    }
+};
+
+inline CrystalSymOp crystalMakeOp(const int* r, int t0, int t1, int t2) {
+    CrystalSymOp op;
+    std::memcpy(op.r, r, sizeof(op.r));
+    op.t[0] = ((t0 % 12) + 12) % 12;
+    op.t[1] = ((t1 % 12) + 12) % 12;
+    op.t[2] = ((t2 % 12) + 12) % 12;
+    return op;
+}
+
+// a * b (apply b first)
+inline CrystalSymOp crystalMultiply(const CrystalSymOp& a,
+                                    const CrystalSymOp& b) {
+    int r[9];
+    int t[3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            r[3 * i + j] = a.r[3 * i] * b.r[j] + a.r[3 * i + 1] * b.r[3 + j]
+                           + a.r[3 * i + 2] * b.r[6 + j];
+        }
+        t[i] = a.r[3 * i] * b.t[0] + a.r[3 * i + 1] * b.t[1]
+               + a.r[3 * i + 2] * b.t[2] + a.t[i];
+    }
+    return crystalMakeOp(r, t[0], t[1], t[2]);
+}
+
+// rotation part of Hall matrix symbol (order 1, 2, 3, 4, 6)
+inline bool crystalHallRotation(int order, char axis, char ref_axis,
+                                int* r) {
+    static const int identity[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    static const int x2[9] = {1, 0, 0, 0, -1, 0, 0, 0, -1};
+    static const int x3[9] = {1, 0, 0, 0, 0, -1, 0, 1, -1};
+    static const int x4[9] = {1, 0, 0, 0, 0, -1, 0, 1, 0};
+    static const int x6[9] = {1, 0, 0, 0, 1, -1, 0, 1, 0};
+    static const int y2[9] = {-1, 0, 0, 0, 1, 0, 0, 0, -1};
+    static const int y3[9] = {-1, 0, 1, 0, 1, 0, -1, 0, 0};
+    static const int y4[9] = {0, 0, 1, 0, 1, 0, -1, 0, 0};
+    static const int y6[9] = {0, 0, 1, 0, 1, 0, -1, 0, 1};
+    static const int z2[9] = {-1, 0, 0, 0, -1, 0, 0, 0, 1};
+    static const int z3[9] = {0, -1, 0, 1, -1, 0, 0, 0, 1};
+    static const int z4[9] = {0, -1, 0, 1, 0, 0, 0, 0, 1};
+    static const int z6[9] = {1, -1, 0, 1, 0, 0, 0, 0, 1};
+    // face diagonals perpendicular to reference axis
+    static const int x2p[9] = {-1, 0, 0, 0, 0, -1, 0, -1, 0};
+    static const int x2pp[9] = {-1, 0, 0, 0, 0, 1, 0, 1, 0};
+    static const int y2p[9] = {0, 0, -1, 0, -1, 0, -1, 0, 0};
+    static const int y2pp[9] = {0, 0, 1, 0, -1, 0, 1, 0, 0};
+    static const int z2p[9] = {0, -1, 0, -1, 0, 0, 0, 0, -1};
+    static const int z2pp[9] = {0, 1, 0, 1, 0, 0, 0, 0, -1};
+    // body diagonal
+    static const int d3[9] = {0, 0, 1, 1, 0, 0, 0, 1, 0};
+    const int* m = NULL;
+    if (order == 1) {
+        m = identity;
+    } else if (axis == '\'' || axis == '"') {
+        if (order != 2) return false;
+        const bool p = (axis == '\'');
+        if (ref_axis == 'x')      m = p ? x2p : x2pp;
+        else if (ref_axis == 'y') m = p ? y2p : y2pp;
+        else                      m = p ? z2p : z2pp;
+    } else if (axis == '*') {
+        if (order != 3) return false;
+        m = d3;
+    } else {
+        const int* const xs[7] = {NULL, NULL, x2, x3, x4, NULL, x6};
+        const int* const ys[7] = {NULL, NULL, y2, y3, y4, NULL, y6};
+        const int* const zs[7] = {NULL, NULL, z2, z3, z4, NULL, z6};
+        if (order < 2 || order > 6) return false;
+        if (axis == 'x')      m = xs[order];
+        else if (axis == 'y') m = ys[order];
+        else if (axis == 'z') m = zs[order];
+    }
+    if (m == NULL) return false;
+    std::memcpy(r, m, 9 * sizeof(int));
+    return true;
+}
+
+// generate all operators of a Hall symbol (e.g. "P 2ac 2ab")
+inline bool crystalParseHall(const char* hall,
+                             std::vector<CrystalSymOp>& ops) {
+    static const int identity[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    static const int inversion[9] = {-1, 0, 0, 0, -1, 0, 0, 0, -1};
+    std::vector<CrystalSymOp> generators;
+    const char* p = hall;
+
+    // lattice
+    if (*p == '-') {
+        generators.push_back(crystalMakeOp(inversion, 0, 0, 0));
+        ++p;
+    }
+    switch (*p) {
+        case 'P': break;
+        case 'A': generators.push_back(crystalMakeOp(identity, 0, 6, 6));
+                  break;
+        case 'B': generators.push_back(crystalMakeOp(identity, 6, 0, 6));
+                  break;
+        case 'C': generators.push_back(crystalMakeOp(identity, 6, 6, 0));
+                  break;
+        case 'I': generators.push_back(crystalMakeOp(identity, 6, 6, 6));
+                  break;
+        case 'R': generators.push_back(crystalMakeOp(identity, 8, 4, 4));
+                  break;
+        case 'F': generators.push_back(crystalMakeOp(identity, 0, 6, 6));
+                  generators.push_back(crystalMakeOp(identity, 6, 0, 6));
+                  break;
+        default: return false;
+    }
+    ++p;
+
+    // matrix symbols
+    int num_symbols = 0;
+    int prev_order = 0;
+    char prev_axis = 'z';
+    int shift[3] = {0, 0, 0};
+    for (;;) {
+        while (*p == ' ') ++p;
+        if (*p == '\0') break;
+        if (*p == '(') {
+            // change of basis given as shift in 1/12
+            const char* q = p + 1;
+            for (int i = 0; i < 3; ++i) {
+                char* end;
+                shift[i] = int(std::strtol(q, &end, 10));
+                if (end == q) return false;
+                q = end;
+            }
+            break;
+        }
+        const bool improper = (*p == '-');
+        if (improper) ++p;
+        if (*p < '1' || *p > '6') return false;
+        const int order = *p++ - '0';
+        int screw = 0;
+        if (*p >= '1' && *p < '0' + order) screw = *p++ - '0';
+        char axis = 0;
+        if (*p == 'x' || *p == 'y' || *p == 'z' || *p == '\''
+            || *p == '"' || *p == '*') {
+            axis = *p++;
+        } else if (num_symbols == 0) {
+            axis = 'z';
+        } else if (num_symbols == 1 && order == 2) {
+            axis = (prev_order == 2 || prev_order == 4) ? 'x' : '\'';
+        } else if (num_symbols == 2 && order == 3) {
+            axis = '*';
+        } else if (order != 1) {
+            return false;
+        }
+        int r[9];
+        if (!crystalHallRotation(order, axis, prev_axis, r)) return false;
+        if (improper) {
+            for (int i = 0; i < 9; ++i) r[i] = -r[i];
+        }
+        int t[3] = {0, 0, 0};
+        if (screw > 0) {
+            const int d = (axis == 'x') ? 0 : (axis == 'y') ? 1 : 2;
+            t[d] += 12 * screw / order;
+        }
+        for (; *p != '\0' && *p != ' '; ++p) {
+            switch (*p) {
+                case 'a': t[0] += 6; break;
+                case 'b': t[1] += 6; break;
+                case 'c': t[2] += 6; break;
+                case 'n': t[0] += 6; t[1] += 6; t[2] += 6; break;
+                case 'u': t[0] += 3; break;
+                case 'v': t[1] += 3; break;
+                case 'w': t[2] += 3; break;
+                case 'd': t[0] += 3; t[1] += 3; t[2] += 3; break;
+                default: return false;
+            }
+        }
+        generators.push_back(crystalMakeOp(r, t[0], t[1], t[2]));
+        ++num_symbols;
+        prev_order = order;
+        if (axis == 'x' || axis == 'y' || axis == 'z') prev_axis = axis;
+    }
+
+    // closure
+    ops.assign(1, crystalMakeOp(identity, 0, 0, 0));
+    for (size_t i = 0; i < ops.size(); ++i) {
+        for (size_t g = 0; g < generators.size(); ++g) {
+            const CrystalSymOp op = crystalMultiply(generators[g], ops[i]);
+            if (std::find(ops.begin(), ops.end(), op) == ops.end()) {
+                if (ops.size() >= 192) return false;
+                ops.push_back(op);
+            }
+        }
+    }
+
+    // change of basis: (R, t) -> (R, t + v - R v)
+    for (size_t i = 0; i < ops.size(); ++i) {
+        CrystalSymOp& op = ops[i];
+        int t[3];
+        for (int k = 0; k < 3; ++k) {
+            t[k] = op.t[k] + shift[k] - op.r[3 * k] * shift[0]
+                   - op.r[3 * k + 1] * shift[1] - op.r[3 * k + 2] * shift[2];
+        }
+        op = crystalMakeOp(op.r, t[0], t[1], t[2]);
+    }
+    return true;
+}
+
+// Hall symbol for Hermann-Mauguin symbol (NULL if unknown)
+inline const char* crystalHallSymbol(const std::string& space_group) {
+    static const struct { const char* name; const char* hall; } table[] = {
+        {"P 1", "P 1"}, {"P -1", "-P 1"},
+        {"P 1 2 1", "P 2y"}, {"P 2", "P 2y"},
+        {"P 1 21 1", "P 2yb"}, {"P 21", "P 2yb"},
+        {"C 1 2 1", "C 2y"}, {"C 2", "C 2y"},
+        {"I 1 2 1", "I 2y"}, {"I 2", "I 2y"},
+        {"P 2 2 2", "P 2 2"}, {"P 2 2 21", "P 2c 2"},
+        {"P 21 21 2", "P 2 2ab"}, {"P 21 21 21", "P 2ac 2ab"},
+        {"C 2 2 21", "C 2c 2"}, {"C 2 2 2", "C 2 2"},
+        {"F 2 2 2", "F 2 2"}, {"I 2 2 2", "I 2 2"},
+        {"I 21 21 21", "I 2b 2c"},
+        {"P 4", "P 4"}, {"P 41", "P 4w"}, {"P 42", "P 4c"},
+        {"P 43", "P 4cw"}, {"I 4", "I 4"}, {"I 41", "I 4bw"},
+        {"P 4 2 2", "P 4 2"}, {"P 4 21 2", "P 4ab 2ab"},
+        {"P 41 2 2", "P 4w 2c"}, {"P 41 21 2", "P 4abw 2nw"},
+        {"P 42 2 2", "P 4c 2"}, {"P 42 21 2", "P 4n 2n"},
+        {"P 43 2 2", "P 4cw 2c"}, {"P 43 21 2", "P 4nw 2abw"},
+        {"I 4 2 2", "I 4 2"}, {"I 41 2 2", "I 4bw 2bw"},
+        {"P 3", "P 3"}, {"P 31", "P 31"}, {"P 32", "P 32"},
+        {"H 3", "R 3"}, {"R 3", "P 3*"},
+        {"P 3 1 2", "P 3 2"}, {"P 3 2 1", "P 3 2\""},
+        {"P 31 1 2", "P 31 2c (0 0 1)"}, {"P 31 2 1", "P 31 2\""},
+        {"P 32 1 2", "P 32 2c (0 0 -1)"}, {"P 32 2 1", "P 32 2\""},
+        {"H 3 2", "R 3 2\""}, {"R 3 2", "P 3* 2"},
+        {"P 6", "P 6"}, {"P 61", "P 61"}, {"P 65", "P 65"},
+        {"P 62", "P 62"}, {"P 64", "P 64"}, {"P 63", "P 6c"},
+        {"P 6 2 2", "P 6 2"}, {"P 61 2 2", "P 61 2 (0 0 -1)"},
+        {"P 65 2 2", "P 65 2 (0 0 1)"}, {"P 62 2 2", "P 62 2c (0 0 1)"},
+        {"P 64 2 2", "P 64 2c (0 0 -1)"}, {"P 63 2 2", "P 6c 2c"},
+        {"P 2 3", "P 2 2 3"}, {"F 2 3", "F 2 2 3"}, {"I 2 3", "I 2 2 3"},
+        {"P 21 3", "P 2ac 2ab 3"}, {"I 21 3", "I 2b 2c 3"},
+        {"P 4 3 2", "P 4 2 3"}, {"P 42 3 2", "P 4n 2 3"},
+        {"F 4 3 2", "F 4 2 3"}, {"F 41 3 2", "F 4d 2 3"},
+        {"I 4 3 2", "I 4 2 3"}, {"P 43 3 2", "P 4acd 2ab 3"},
+        {"P 41 3 2", "P 4bd 2ab 3"}, {"I 41 3 2", "I 4bd 2c 3"}};
+    // normalize white space
+    std::string name;
+    for (size_t i = 0; i < space_group.size(); ++i) {
+        const char c = space_group[i];
+        if (c == ' ' || c == '\t') {
+            if (!name.empty() && name[name.size() - 1] != ' ') name += ' ';
+        } else {
+            name += c;
+        }
+    }
+    if (!name.empty() && name[name.size() - 1] == ' ') {
+        name.erase(name.size() - 1);
+    }
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); ++i) {
+        if (name == table[i].name) return table[i].hall;
+    }
+    return NULL;
+}
+
+// 3x3 part of orthogonalization matrix (row-major), false if degenerate
+inline bool crystalOrthogonalization(const std::vector<float>& unit_cell,
+                                     double* o) {
+    if (unit_cell.size() != 6) return false;
+    const double to_rad = 3.14159265358979323846 / 180.0;
+    const double a = unit_cell[0];
+    const double b = unit_cell[1];
+    const double c = unit_cell[2];
+    const double cos_alpha = cos(unit_cell[3] * to_rad);
+    const double cos_beta = cos(unit_cell[4] * to_rad);
+    const double cos_gamma = cos(unit_cell[5] * to_rad);
+    const double sin_gamma = sin(unit_cell[5] * to_rad);
+    const double v2 = 1 - cos_alpha * cos_alpha - cos_beta * cos_beta
+                      - cos_gamma * cos_gamma
+                      + 2 * cos_alpha * cos_beta * cos_gamma;
+    if (!(a > 0 && b > 0 && c > 0 && v2 > 0 && sin_gamma > 0)) return false;
+    o[0] = a;
+    o[1] = b * cos_gamma;
+    o[2] = c * cos_beta;
+    o[3] = 0;
+    o[4] = b * sin_gamma;
+    o[5] = c * (cos_alpha - cos_beta * cos_gamma) / sin_gamma;
+    o[6] = 0;
+    o[7] = 0;
+    o[8] = c * sqrt(v2) / sin_gamma;
+    return true;
+}
+
+// inverse of upper triangular orthogonalization matrix (row-major)
+inline void crystalInvertUpper(const double* o, double* f) {
+    f[0] = 1 / o[0];
+    f[1] = -o[1] / (o[0] * o[4]);
+    f[2] = (o[1] * o[5] - o[2] * o[4]) / (o[0] * o[4] * o[8]);
+    f[3] = 0;
+    f[4] = 1 / o[4];
+    f[5] = -o[5] / (o[4] * o[8]);
+    f[6] = 0;
+    f[7] = 0;
+    f[8] = 1 / o[8];
+}
+
+// row-major 3x3 rotation + translation to row-major 4x4 (as in Transform)
+inline void crystalToMatrix(const double* r, const double* t,
+                            float* matrix) {
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            matrix[4 * row + col] = float(r[3 * row + col]);
+        }
+        matrix[4 * row + 3] = float(t[row]);
+        matrix[12 + row] = 0;
+    }
+    matrix[15] = 1;
+}
+
+// box (min x, y, z, max x, y, z) of 8 transformed corners of box
+inline void crystalTransformBox(const float* matrix, const float* box,
+                                float* result) {
+    float x[8], y[8], z[8];
+    for (int corner = 0; corner < 8; ++corner) {
+        x[corner] = box[(corner & 1) ? 3 : 0];
+        y[corner] = box[(corner & 2) ? 4 : 1];
+        z[corner] = box[(corner & 4) ? 5 : 2];
+    }
+    transformCoordinates(matrix, x, y, z, 8, x, y, z);
+    result[0] = *std::min_element(x, x + 8);
+    result[1] = *std::min_element(y, y + 8);
+    result[2] = *std::min_element(z, z + 8);
+    result[3] = *std::max_element(x, x + 8);
+    result[4] = *std::max_element(y, y + 8);
+    result[5] = *std::max_element(z, z + 8);
+}
+
+inline bool crystalBoxesOverlap(const float* a, const float* b) {
+    return a[0] <= b[3] && b[0] <= a[3] && a[1] <= b[4] && b[1] <= a[4]
+           && a[2] <= b[5] && b[2] <= a[5];
+}
+
+} // anon ns
+
+inline bool getOrthogonalizationMatrix(const std::vector<float>& unit_cell,
+                                       float* matrix) {
+    double o[9];
+    if (!crystalOrthogonalization(unit_cell, o)) return false;
+    const double t[3] = {0, 0, 0};
+    crystalToMatrix(o, t, matrix);
+    return true;
+}
+
+inline bool getFractionalizationMatrix(const std::vector<float>& unit_cell,
+                                       float* matrix) {
+    double o[9];
+    if (!crystalOrthogonalization(unit_cell, o)) return false;
+    double f[9];
+    crystalInvertUpper(o, f);
+    const double t[3] = {0, 0, 0};
+    crystalToMatrix(f, t, matrix);
+    return true;
+}
+
+inline bool parseSymmetryOperator(const std::string& op, float* matrix) {
+    double r[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    double t[3] = {0, 0, 0};
+    const char* p = op.c_str();
+    for (int row = 0; row < 3; ++row) {
+        bool empty = true;
+        for (;;) {
+            while (*p == ' ') ++p;
+            if (*p == ',' || *p == '\0') break;
+            double sign = 1;
+            if (*p == '+' || *p == '-') {
+                sign = (*p == '-') ? -1 : 1;
+                ++p;
+                while (*p == ' ') ++p;
+            }
+            // optional number (fraction or decimal), optional variable
+            double value = 1;
+            bool has_number = false;
+            if ((*p >= '0' && *p <= '9') || *p == '.') {
+                char* end;
+                value = std::strtod(p, &end);
+                p = end;
+                if (*p == '/') {
+                    const double denominator = std::strtod(p + 1, &end);
+                    if (end == p + 1 || denominator == 0) return false;
+                    value /= denominator;
+                    p = end;
+                }
+                has_number = true;
+                if (*p == '*') ++p;
+            }
+            const char c = *p;
+            if (c == 'x' || c == 'X' || c == 'y' || c == 'Y' || c == 'z'
+                || c == 'Z') {
+                const int col = (c == 'x' || c == 'X') ? 0
+                                : (c == 'y' || c == 'Y') ? 1 : 2;
+                r[3 * row + col] += sign * value;
+                ++p;
+            } else if (has_number) {
+                t[row] += sign * value;
+            } else {
+                return false;
+            }
+            empty = false;
+        }
+        if (empty) return false;
+        if (row < 2) {
+            if (*p != ',') return false;
+            ++p;
+        }
+    }
+    while (*p == ' ') ++p;
+    if (*p != '\0') return false;
+    crystalToMatrix(r, t, matrix);
+    return true;
+}
+
+inline bool getSymmetryOperators(const std::string& space_group,
+                                 std::vector<float>& operators) {
+    const char* hall = crystalHallSymbol(space_group);
+    std::vector<CrystalSymOp> ops;
+    if (hall == NULL || !crystalParseHall(hall, ops)) return false;
+    operators.resize(16 * ops.size());
+    for (size_t i = 0; i < ops.size(); ++i) {
+        double r[9];
+        double t[3];
+        for (int k = 0; k < 9; ++k) r[k] = ops[i].r[k];
+        for (int k = 0; k < 3; ++k) t[k] = ops[i].t[k] / 12.0;
+        crystalToMatrix(r, t, &operators[16 * i]);
+    }
+    return true;
+}
+
+inline void findSymmetryMates(const StructureData& data, float cutoff,
+                              std::vector<Transform>& mates) {
+    mates.clear();
+    double o[9];
+    if (!crystalOrthogonalization(data.unitCell, o)) {
+        throw DecodeError("Cannot find symmetry mates: invalid unitCell");
+    }
+    double f[9];
+    crystalInvertUpper(o, f);
+    std::vector<float> operators;
+    if (!getSymmetryOperators(data.spaceGroup, operators)) {
+        throw DecodeError("Cannot find symmetry mates: unknown space group '"
+                          + data.spaceGroup + "'");
+    }
+    const HierarchyIndex index(data);
+    const int32_t num_atoms = index.numAtoms();
+    if (int32_t(data.xCoordList.size()) != num_atoms
+        || data.yCoordList.size() != data.xCoordList.size()
+        || data.zCoordList.size() != data.xCoordList.size()) {
+        throw DecodeError("Cannot find symmetry mates: coordinate lists are "
+                          "inconsistent with hierarchy");
+    }
+    if (num_atoms == 0) return;
+
+    // boxes of chains and asymmetric unit (Cartesian)
+    const int32_t num_chains = index.numChains();
+    std::vector<float> chain_boxes(6 * num_chains);
+    float box[6] = {data.xCoordList[0], data.yCoordList[0],
+                    data.zCoordList[0], data.xCoordList[0],
+                    data.yCoordList[0], data.zCoordList[0]};
+    for (int32_t c = 0; c < num_chains; ++c) {
+        const int32_t begin = index.chainAtomBegin(c);
+        if (begin == index.chainAtomEnd(c)) continue;
+        float* chain_box = &chain_boxes[6 * c];
+        chain_box[0] = chain_box[3] = data.xCoordList[begin];
+        chain_box[1] = chain_box[4] = data.yCoordList[begin];
+        chain_box[2] = chain_box[5] = data.zCoordList[begin];
+        for (int32_t i = begin; i < index.chainAtomEnd(c); ++i) {
+            chain_box[0] = std::min(chain_box[0], data.xCoordList[i]);
+            chain_box[1] = std::min(chain_box[1], data.yCoordList[i]);
+            chain_box[2] = std::min(chain_box[2], data.zCoordList[i]);
+            chain_box[3] = std::max(chain_box[3], data.xCoordList[i]);
+            chain_box[4] = std::max(chain_box[4], data.yCoordList[i]);
+            chain_box[5] = std::max(chain_box[5], data.zCoordList[i]);
+        }
+        for (int d = 0; d < 3; ++d) {
+            box[d] = std::min(box[d], chain_box[d]);
+            box[d + 3] = std::max(box[d + 3], chain_box[d + 3]);
+        }
+    }
+    float contact_box[6];
+    for (int d = 0; d < 3; ++d) {
+        contact_box[d] = box[d] - cutoff;
+        contact_box[d + 3] = box[d + 3] + cutoff;
+    }
+
+    // boxes of asymmetric unit in fractional space (plain and with cutoff)
+    float frac_matrix[16];
+    const double zero[3] = {0, 0, 0};
+    crystalToMatrix(f, zero, frac_matrix);
+    float frac_box[6];
+    crystalTransformBox(frac_matrix, box, frac_box);
+    float frac_contact[6];
+    for (int d = 0; d < 3; ++d) {
+        const double row = sqrt(f[3 * d] * f[3 * d]
+                                + f[3 * d + 1] * f[3 * d + 1]
+                                + f[3 * d + 2] * f[3 * d + 2]);
+        frac_contact[d] = frac_box[d] - float(cutoff * row);
+        frac_contact[d + 3] = frac_box[d + 3] + float(cutoff * row);
+    }
+
+    // candidate (operator, lattice translation) pairs as Cartesian matrices
+    std::vector<float> candidates;
+    const size_t num_ops = operators.size() / 16;
+    for (size_t s = 0; s < num_ops; ++s) {
+        const float* op = &operators[16 * s];
+        float op_box[6];
+        crystalTransformBox(op, frac_box, op_box);
+        int lo[3], hi[3];
+        for (int d = 0; d < 3; ++d) {
+            lo[d] = int(ceil(frac_contact[d] - op_box[d + 3]));
+            hi[d] = int(floor(frac_contact[d + 3] - op_box[d]));
+        }
+        // rotation O * R * F
+        double rf[9];
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                rf[3 * i + j] = op[4 * i] * f[j] + op[4 * i + 1] * f[3 + j]
+                                + op[4 * i + 2] * f[6 + j];
+            }
+        }
+        double r[9];
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                r[3 * i + j] = o[3 * i] * rf[j] + o[3 * i + 1] * rf[3 + j]
+                               + o[3 * i + 2] * rf[6 + j];
+            }
+        }
+        for (int n0 = lo[0]; n0 <= hi[0]; ++n0) {
+            for (int n1 = lo[1]; n1 <= hi[1]; ++n1) {
+                for (int n2 = lo[2]; n2 <= hi[2]; ++n2) {
+                    if (s == 0 && n0 == 0 && n1 == 0 && n2 == 0) continue;
+                    // translation O * (t + n)
+                    const double tn[3] = {op[3] + n0, op[7] + n1,
+                                          op[11] + n2};
+                    double t[3];
+                    for (int i = 0; i < 3; ++i) {
+                        t[i] = o[3 * i] * tn[0] + o[3 * i + 1] * tn[1]
+                               + o[3 * i + 2] * tn[2];
+                    }
+                    candidates.resize(candidates.size() + 16);
+                    crystalToMatrix(r, t, &candidates[candidates.size() - 16]);
+                }
+            }
+        }
+    }
+
+    // check chains of every candidate
+    const SpatialIndex grid(data, cutoff);
+    const int32_t num_candidates = int32_t(candidates.size() / 16);
+    std::vector<std::vector<int32_t> > contacts(num_candidates);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int32_t k = 0; k < num_candidates; ++k) {
+        const float* matrix = &candidates[16 * k];
+        const int32_t tile_size = 256;
+        float tx[tile_size], ty[tile_size], tz[tile_size];
+        std::vector<int32_t> neighbors;
+        for (int32_t c = 0; c < num_chains; ++c) {
+            const int32_t chain_begin = index.chainAtomBegin(c);
+            const int32_t chain_end = index.chainAtomEnd(c);
+            if (chain_begin == chain_end) continue;
+            float mate_box[6];
+            crystalTransformBox(matrix, &chain_boxes[6 * c], mate_box);
+            if (!crystalBoxesOverlap(mate_box, contact_box)) continue;
+            const int32_t model = index.modelIndexOfChain(c);
+            bool found = false;
+            for (int32_t begin = chain_begin; begin < chain_end && !found;
+                 begin += tile_size) {
+                const int32_t num = std::min(tile_size, chain_end - begin);
+                transformCoordinates(matrix, &data.xCoordList[begin],
+                                     &data.yCoordList[begin],
+                                     &data.zCoordList[begin], num,
+                                     tx, ty, tz);
+                for (int32_t i = 0; i < num && !found; ++i) {
+                    if (tx[i] < contact_box[0] || tx[i] > contact_box[3]
+                        || ty[i] < contact_box[1] || ty[i] > contact_box[4]
+                        || tz[i] < contact_box[2] || tz[i] > contact_box[5]) {
+                        continue;
+                    }
+                    grid.findWithinRadius(tx[i], ty[i], tz[i], cutoff,
+                                          neighbors);
+                    for (size_t n = 0; n < neighbors.size(); ++n) {
+                        if (index.modelIndexOfAtom(neighbors[n]) == model) {
+                            found = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (found) contacts[k].push_back(c);
+        }
+    }
+    for (int32_t k = 0; k < num_candidates; ++k) {
+        if (contacts[k].empty()) continue;
+        mates.push_back(Transform());
+        mates.back().chainIndexList.swap(contacts[k]);
+        std::copy(&candidates[16 * k], &candidates[16 * k] + 16,
+                  mates.back().matrix);
+    }
+}
+
+} // mmtf namespace
+
+#endif
@@ -17,6 +17,7 @@
 #include "errors.hpp"
 #include "msgpack_decoders.hpp"
 #include "map_decoder.hpp"
+#include "statistics.hpp"
 
 #include <msgpack.hpp>
 #include <fstream>
@@ -29,9 +30,33 @@ namespace mmtf {
  * @brief Decode an MMTF data structure from a mapDecoder.
  * @param[out] data   MMTF data structure to be filled
  * @param[in]  mapDecoder MapDecoder holding raw mmtf data
+ * @param[in]  copy_properties  Copy property maps (atomProperties, ...) into
+ *                              data. If false, they are left empty and can be
+ *                              accessed without copies with a
+ *                              mmtf::PropertyView on mapDecoder.
  * @throw mmtf::DecodeError if an error occured
  */
-inline void decodeFromMapDecoder(StructureData& data, MapDecoder& mapDecoder);
+inline void decodeFromMapDecoder(StructureData& data, MapDecoder& mapDecoder,
+                                 bool copy_properties = true);
+
+/**
+ * @brief Decode an MMTF data structure from a mapDecoder and record per-field
+ *        statistics.
+ * @param[out] data   MMTF data structure to be filled
+ * @param[in]  mapDecoder MapDecoder holding raw mmtf data
+ * @param[in,out] stats  Sink for per-field statistics (encoded bytes, number
+ *                       of elements, strategy and decode time)
+ * @param[in]  copy_properties  As in ::decodeFromMapDecoder
+ * @tparam Stats Any type with a member function
+ *               record(const FieldStatistics&) (e.g. mmtf::Statistics)
+ * @throw mmtf::DecodeError if an error occured
+ *
+ * With mmtf::NoStatistics, this is identical to ::decodeFromMapDecoder
+ * without overhead.
+ */
+template <typename Stats>
+inline void decodeFromMapDecoder(StructureData& data, MapDecoder& mapDecoder,
+                                 Stats& stats, bool copy_properties = true);
 
 /**
  * @brief Decode an MMTF data structure from a byte buffer.
@@ -99,8 +124,15 @@ inline void mapDecoderFromFile(MapDecoder& mapDecoder,
 // IMPLEMENTATION
 // *************************************************************************
 
-inline void decodeFromMapDecoder(StructureData& data, MapDecoder& md) {
-    mmtf::impl::decodeFromMapDecoder(data, md);
+inline void decodeFromMapDecoder(StructureData& data, MapDecoder& md,
+                                 bool copy_properties) {
+    mmtf::impl::decodeFromMapDecoder(data, md, copy_properties);
+}
+
+template <typename Stats>
+inline void decodeFromMapDecoder(StructureData& data, MapDecoder& md,
+                                 Stats& stats, bool copy_properties) {
+    mmtf::impl::decodeFromMapDecoder(data, md, stats, copy_properties);
 }
 
 inline void decodeFromBuffer(StructureData& data, const char* buffer,
@@ -16,7 +16,12 @@
 #include "errors.hpp"
 #include "msgpack_encoders.hpp"
 #include "binary_encoder.hpp"
+#include "binary_decoder.hpp"
+#include "hierarchy_index.hpp"
+#include "statistics.hpp"
+#include <algorithm>
 #include <string>
+#include <sstream>
 #include <fstream>
 
 namespace mmtf {
@@ -28,6 +33,12 @@ namespace mmtf {
  * @param[in] coord_divider               Divisor for coordinates
  * @param[in] occupancy_b_factor_divider  Divisor for occupancy and b-factor
  * @param[in] chain_name_max_length       Max. length for chain name strings
+ * @param[in] check_consistency  Check data with
+ *                               StructureData::hasConsistentData first. Only
+ *                               set to false ("trusted" mode) for data known
+ *                               to be consistent (e.g. just decoded or
+ *                               already checked), as inconsistent data may
+ *                               crash or produce corrupt files.
  * @throw mmtf::EncodeError if an error occurred
  *
  * Common settings for the divisors are the default values for a loss-less
@@ -36,7 +47,7 @@ namespace mmtf {
 inline void encodeToFile(const StructureData& data,
     const std::string& filename, int32_t coord_divider = 1000,
     int32_t occupancy_b_factor_divider = 100,
-    int32_t chain_name_max_length  = 4);
+    int32_t chain_name_max_length  = 4, bool check_consistency = true);
 
 /**
  * @brief Encode an MMTF data structure into a stream.
@@ -50,7 +61,7 @@ inline void encodeToFile(const StructureData& data,
 template <typename Stream>
 inline void encodeToStream(const StructureData& data, Stream& stream,
     int32_t coord_divider = 1000, int32_t occupancy_b_factor_divider = 100,
-    int32_t chain_name_max_length = 4);
+    int32_t chain_name_max_length = 4, bool check_consistency = true);
 
 /**
  * @brief Encode an MMTF data structure into a map of msgpack objects.
@@ -64,169 +75,481 @@ inline void encodeToStream(const StructureData& data, Stream& stream,
 inline std::map<std::string, msgpack::object>
 encodeToMap(const StructureData& data, msgpack::zone& m_zone,
     int32_t coord_divider = 1000, int32_t occupancy_b_factor_divider = 100,
-    int32_t chain_name_max_length = 4);
+    int32_t chain_name_max_length = 4, bool check_consistency = true);
+
+/**
+ * @brief Encode an MMTF data structure into a map of msgpack objects and
+ *        record per-field statistics.
+ * @param[in,out] stats  Sink for per-field statistics (encoded bytes, number
+ *                       of elements, strategy and encode time)
+ * @tparam Stats Any type with a member function
+ *               record(const FieldStatistics&) (e.g. mmtf::Statistics)
+ *
+ * Other parameters and behavior are as in ::encodeToMap. With
+ * mmtf::NoStatistics, this is identical to ::encodeToMap without overhead.
+ */
+template <typename Stats>
+inline std::map<std::string, msgpack::object>
+encodeToMap(const StructureData& data, msgpack::zone& m_zone,
+    int32_t coord_divider, int32_t occupancy_b_factor_divider,
+    int32_t chain_name_max_length, Stats& stats,
+    bool check_consistency = true);
+
+/**
+ * @brief Replace coordinate columns of encodeToMap output by model deltas.
+ * @param[in,out] data_map  Map returned by ::encodeToMap for data
+ * @param[in] data          MMTF data structure used for data_map
+ * @param[in] m_zone        msgpack::zone object used for data_map
+ * @param[in] coord_divider      Divisor for coordinates
+ * @param[in] keyframe_interval  Every keyframe_interval-th model is encoded
+ *                               independently
+ * @throw mmtf::EncodeError if keyframe_interval < 1
+ *
+ * xCoordList, yCoordList and zCoordList are stored with the library-specific
+ * strategy 100 (see ::encodeModelDeltaFloat), where the coordinates of a
+ * model are deltas to the same atoms in the previous model. This is much
+ * smaller for NMR ensembles and trajectories and allows decoding single
+ * models with BinaryDecoder::decodeModel. Files written like this can only
+ * be decoded by this library.
+ */
+inline void encodeModelDeltaCoordinates(
+    std::map<std::string, msgpack::object>& data_map,
+    const StructureData& data, msgpack::zone& m_zone,
+    int32_t coord_divider = 1000, int32_t keyframe_interval = 10);
+
+/**
+ * @brief Add checkpoints for binary fields of encodeToMap output.
+ * @param[in,out] data_map  Map returned by ::encodeToMap
+ * @param[in] m_zone        msgpack::zone object used for data_map
+ * @param[in] interval      Number of values between checkpoints
+ * @throw mmtf::EncodeError if interval < 1
+ *
+ * For each run-length encoded or recursive indexed binary field, the decoder
+ * state (see BinarySeekPoint) is stored every interval values. The table is
+ * stored in extraProperties under the key mmtf::CHECKPOINTS_KEY, which other
+ * MMTF readers keep as application specific data. This library uses it to
+ * decode such fields in parallel chunks (BinaryDecoder::decode with
+ * checkpoints) and to locate models in ModelDecoder without a full scan.
+ * Call this after all binary fields in data_map are final.
+ */
+inline void encodeCheckpoints(std::map<std::string, msgpack::object>& data_map,
+                              msgpack::zone& m_zone, int32_t interval = 16384);
+
+/**
+ * @brief Split per-atom columns of encodeToMap output into tiles.
+ * @param[in,out] data_map  Map returned by ::encodeToMap for data
+ * @param[in] data          MMTF data structure used for data_map
+ * @param[in] m_zone        msgpack::zone object used for data_map
+ * @param[in] tile_size     Number of atoms per tile
+ * @throw mmtf::EncodeError if tile_size < 1, if a column does not have
+ *        data.numAtoms values or if its strategy cannot be split (e.g. 100).
+ *
+ * Each binary per-atom column (xCoordList, yCoordList, zCoordList,
+ * bFactorList, occupancyList, atomIdList and altLocList) is replaced by
+ * independently encoded row groups of tile_size atoms (the last one may be
+ * shorter) with the column's strategy and parameter. The tiles are stored in
+ * extraProperties under the key mmtf::TILES_KEY, all other fields (incl. the
+ * hierarchy) stay global. Decoding a single tile (see mmtf::TiledDecoder) or
+ * model (see mmtf::ModelDecoder) then only touches the tiles it needs, which
+ * allows out-of-core processing of giant structures. ::decodeFromMapDecoder
+ * transparently concatenates the tiles. Files written like this can only be
+ * decoded by this library. Call ::encodeCheckpoints after this.
+ */
+inline void encodeTiles(std::map<std::string, msgpack::object>& data_map,
+                        const StructureData& data, msgpack::zone& m_zone,
+                        int32_t tile_size = 65536);
 
 // *************************************************************************
 // IMPLEMENTATION
 // *************************************************************************
 inline void encodeToFile(const StructureData& data,
     const std::string& filename, int32_t coord_divider,
-    int32_t occupancy_b_factor_divider, int32_t chain_name_max_length) {
+    int32_t occupancy_b_factor_divider, int32_t chain_name_max_length,
+    bool check_consistency) {
     // encode to a file
     std::ofstream ofs(filename.c_str(), std::ios::binary | std::ios::out );
     if ( !ofs ) {
         throw EncodeError("Could not open >" + filename + "< for writing, exiting.");
     }
     encodeToStream(data, ofs, coord_divider,
-      occupancy_b_factor_divider, chain_name_max_length);
+      occupancy_b_factor_divider, chain_name_max_length, check_consistency);
 }
 
 template <typename Stream>
 inline void encodeToStream(const StructureData& data, Stream& stream,
     int32_t coord_divider, int32_t occupancy_b_factor_divider,
-    int32_t chain_name_max_length) {
+    int32_t chain_name_max_length, bool check_consistency) {
   msgpack::pack(stream, encodeToMap(data, data.msgpack_zone, coord_divider,
-              occupancy_b_factor_divider, chain_name_max_length));
+              occupancy_b_factor_divider, chain_name_max_length,
+              check_consistency));
+}
+
+inline std::map<std::string, msgpack::object>
+encodeToMap(const StructureData& data, msgpack::zone& m_zone,
+    int32_t coord_divider, int32_t occupancy_b_factor_divider,
+    int32_t chain_name_max_length, bool check_consistency) {
+  NoStatistics stats;
+  return encodeToMap(data, m_zone, coord_divider, occupancy_b_factor_divider,
+                     chain_name_max_length, stats, check_consistency);
 }
 
+template <typename Stats>
 inline std::map<std::string, msgpack::object>
 encodeToMap(const StructureData& data, msgpack::zone& m_zone,
     int32_t coord_divider, int32_t occupancy_b_factor_divider,
-    int32_t chain_name_max_length) {
-  if (!data.hasConsistentData(true, chain_name_max_length)) {
+    int32_t chain_name_max_length, Stats& stats, bool check_consistency) {
+  if (   check_consistency
+      && !data.hasConsistentData(true, chain_name_max_length)) {
     throw mmtf::EncodeError("mmtf EncoderError, StructureData does not have Consistent data... exiting!");
   }
 
 
   std::map<std::string, msgpack::object> data_map;
+  impl::FieldRecorder<Stats> rec(stats);
   // std::string
+  rec.start();
   data_map["mmtfVersion"] = msgpack::object(data.mmtfVersion, m_zone);
+  rec.stop(data_map, "mmtfVersion");
+  rec.start();
   data_map["mmtfProducer"] = msgpack::object(data.mmtfProducer, m_zone);
+  rec.stop(data_map, "mmtfProducer");
   if (!mmtf::isDefaultValue(data.spaceGroup)) {
+    rec.start();
     data_map["spaceGroup"] = msgpack::object(data.spaceGroup, m_zone);
+    rec.stop(data_map, "spaceGroup");
   }
   if (!mmtf::isDefaultValue(data.structureId)) {
+    rec.start();
     data_map["structureId"] = msgpack::object(data.structureId, m_zone);
+    rec.stop(data_map, "structureId");
   }
   if (!mmtf::isDefaultValue(data.title)) {
+    rec.start();
     data_map["title"] = msgpack::object(data.title, m_zone);
+    rec.stop(data_map, "title");
   }
   if (!mmtf::isDefaultValue(data.depositionDate)) {
+    rec.start();
     data_map["depositionDate"] = msgpack::object(data.depositionDate, m_zone);
+    rec.stop(data_map, "depositionDate");
   }
   if (!mmtf::isDefaultValue(data.releaseDate)) {
+    rec.start();
     data_map["releaseDate"] = msgpack::object(data.releaseDate, m_zone);
+    rec.stop(data_map, "releaseDate");
   }
   // std::vector<std::string>
+  rec.start();
   data_map["chainIdList"] = msgpack::object(mmtf::encodeStringVector(data.chainIdList, chain_name_max_length), m_zone);
+  rec.stop(data_map, "chainIdList");
   if (!mmtf::isDefaultValue(data.chainNameList)) {
+    rec.start();
     data_map["chainNameList"] = msgpack::object(mmtf::encodeStringVector(data.chainNameList, chain_name_max_length), m_zone);
+    rec.stop(data_map, "chainNameList");
   }
   if (!mmtf::isDefaultValue(data.experimentalMethods)) {
+    rec.start();
     data_map["experimentalMethods"] =
       msgpack::object(data.experimentalMethods, m_zone);
+    rec.stop(data_map, "experimentalMethods");
   }
   // std::vector<char>
   if (!mmtf::isDefaultValue(data.altLocList)) {
+    rec.start();
     data_map["altLocList"] =
       msgpack::object(mmtf::encodeRunLengthChar(data.altLocList), m_zone);
+    rec.stop(data_map, "altLocList");
   }
   if (!mmtf::isDefaultValue(data.insCodeList)) {
+    rec.start();
     data_map["insCodeList"] = msgpack::object(mmtf::encodeRunLengthChar(data.insCodeList), m_zone);
+    rec.stop(data_map, "insCodeList");
   }
   // std::vector<int8_t>
   if (!mmtf::isDefaultValue(data.bondOrderList)) {
+    rec.start();
     data_map["bondOrderList"] =
       msgpack::object(mmtf::encodeInt8ToByte(data.bondOrderList), m_zone);
+    rec.stop(data_map, "bondOrderList");
   }
   // std::vector<int8_t>
   if (!mmtf::isDefaultValue(data.bondResonanceList)) {
+    rec.start();
     data_map["bondResonanceList"] =
       msgpack::object(mmtf::encodeRunLengthInt8(data.bondResonanceList), m_zone);
+    rec.stop(data_map, "bondResonanceList");
   }
   if (!mmtf::isDefaultValue(data.secStructList)) {
+    rec.start();
     data_map["secStructList"] =
       msgpack::object(mmtf::encodeInt8ToByte(data.secStructList), m_zone);
+    rec.stop(data_map, "secStructList");
   }
   // int32_t
+  rec.start();
   data_map["numBonds"] = msgpack::object(data.numBonds, m_zone);
+  rec.stop(data_map, "numBonds");
+  rec.start();
   data_map["numAtoms"] = msgpack::object(data.numAtoms, m_zone);
+  rec.stop(data_map, "numAtoms");
+  rec.start();
   data_map["numGroups"] = msgpack::object(data.numGroups, m_zone);
+  rec.stop(data_map, "numGroups");
+  rec.start();
   data_map["numChains"] = msgpack::object(data.numChains, m_zone);
+  rec.stop(data_map, "numChains");
+  rec.start();
   data_map["numModels"] = msgpack::object(data.numModels, m_zone);
+  rec.stop(data_map, "numModels");
   // std::vector<int32_t>
+  rec.start();
   data_map["groupTypeList"] = msgpack::object(mmtf::encodeFourByteInt(data.groupTypeList), m_zone);
+  rec.stop(data_map, "groupTypeList");
+  rec.start();
   data_map["groupIdList"] = msgpack::object(mmtf::encodeRunLengthDeltaInt(data.groupIdList), m_zone);
+  rec.stop(data_map, "groupIdList");
+  rec.start();
   data_map["groupsPerChain"] = msgpack::object(data.groupsPerChain, m_zone);
+  rec.stop(data_map, "groupsPerChain");
+  rec.start();
   data_map["chainsPerModel"] = msgpack::object(data.chainsPerModel, m_zone);
+  rec.stop(data_map, "chainsPerModel");
   if (!mmtf::isDefaultValue(data.bondAtomList)) {
+    rec.start();
     data_map["bondAtomList"] = msgpack::object(mmtf::encodeFourByteInt(data.bondAtomList), m_zone);
+    rec.stop(data_map, "bondAtomList");
   }
   if (!mmtf::isDefaultValue(data.atomIdList)) {
+    rec.start();
     data_map["atomIdList"] = msgpack::object(mmtf::encodeRunLengthDeltaInt(data.atomIdList), m_zone);
+    rec.stop(data_map, "atomIdList");
   }
   if (!mmtf::isDefaultValue(data.sequenceIndexList)) {
+    rec.start();
     data_map["sequenceIndexList"] = msgpack::object(mmtf::encodeRunLengthDeltaInt(data.sequenceIndexList), m_zone);
+    rec.stop(data_map, "sequenceIndexList");
   }
   // float
   if (!mmtf::isDefaultValue(data.resolution)) {
+    rec.start();
     data_map["resolution"] = msgpack::object(data.resolution, m_zone);
+    rec.stop(data_map, "resolution");
   }
   if (!mmtf::isDefaultValue(data.rFree)) {
+    rec.start();
     data_map["rFree"] = msgpack::object(data.rFree, m_zone);
+    rec.stop(data_map, "rFree");
   }
   if (!mmtf::isDefaultValue(data.rWork)) {
+    rec.start();
     data_map["rWork"] = msgpack::object(data.rWork, m_zone);
+    rec.stop(data_map, "rWork");
   }
   // std::vector<float>
+  rec.start();
   data_map["xCoordList"] = msgpack::object(mmtf::encodeDeltaRecursiveFloat(data.xCoordList, coord_divider), m_zone);
+  rec.stop(data_map, "xCoordList");
+  rec.start();
   data_map["yCoordList"] = msgpack::object(mmtf::encodeDeltaRecursiveFloat(data.yCoordList, coord_divider), m_zone);
+  rec.stop(data_map, "yCoordList");
+  rec.start();
   data_map["zCoordList"] = msgpack::object(mmtf::encodeDeltaRecursiveFloat(data.zCoordList, coord_divider), m_zone);
+  rec.stop(data_map, "zCoordList");
   if (!mmtf::isDefaultValue(data.bFactorList)) {
+    rec.start();
     data_map["bFactorList"] = msgpack::object(mmtf::encodeDeltaRecursiveFloat(data.bFactorList, occupancy_b_factor_divider), m_zone);
+    rec.stop(data_map, "bFactorList");
   }
   if (!mmtf::isDefaultValue(data.occupancyList)) {
+    rec.start();
     data_map["occupancyList"] = msgpack::object(mmtf::encodeRunLengthFloat(data.occupancyList, occupancy_b_factor_divider), m_zone);
+    rec.stop(data_map, "occupancyList");
   }
   if (!mmtf::isDefaultValue(data.unitCell)) {
+      rec.start();
       data_map["unitCell"] = msgpack::object(data.unitCell, m_zone);
+      rec.stop(data_map, "unitCell");
   }
   // std::vector<GroupType>
+  rec.start();
   data_map["groupList"] = msgpack::object(data.groupList, m_zone);
+  rec.stop(data_map, "groupList");
   // std::vector<BioAssembly>
   if (!mmtf::isDefaultValue(data.bioAssemblyList)) {
+    rec.start();
     data_map["bioAssemblyList"] = msgpack::object(data.bioAssemblyList, m_zone);
+    rec.stop(data_map, "bioAssemblyList");
   }
   // std::vector<Entity>
   if (!mmtf::isDefaultValue(data.entityList)) {
+    rec.start();
     data_map["entityList"] = msgpack::object(data.entityList, m_zone);
+    rec.stop(data_map, "entityList");
   }
   // std::vector<std::vector<float>>
   if (!mmtf::isDefaultValue(data.ncsOperatorList)) {
+    rec.start();
     data_map["ncsOperatorList"] = msgpack::object(data.ncsOperatorList, m_zone);
+    rec.stop(data_map, "ncsOperatorList");
   }
   // extraProperties
   if (!mmtf::isDefaultValue(data.bondProperties)) {
+    rec.start();
     data_map["bondProperties"] = msgpack::object(data.bondProperties, m_zone);
+    rec.stop(data_map, "bondProperties");
   }
   if (!mmtf::isDefaultValue(data.atomProperties)) {
+    rec.start();
     data_map["atomProperties"] = msgpack::object(data.atomProperties, m_zone);
+    rec.stop(data_map, "atomProperties");
   }
   if (!mmtf::isDefaultValue(data.groupProperties)) {
+    rec.start();
     data_map["groupProperties"] = msgpack::object(data.groupProperties, m_zone);
+    rec.stop(data_map, "groupProperties");
   }
   if (!mmtf::isDefaultValue(data.chainProperties)) {
+    rec.start();
     data_map["chainProperties"] = msgpack::object(data.chainProperties, m_zone);
+    rec.stop(data_map, "chainProperties");
   }
   if (!mmtf::isDefaultValue(data.modelProperties)) {
+    rec.start();
     data_map["modelProperties"] = msgpack::object(data.modelProperties, m_zone);
+    rec.stop(data_map, "modelProperties");
   }
   if (!mmtf::isDefaultValue(data.extraProperties)) {
+    rec.start();
     data_map["extraProperties"] = msgpack::object(data.extraProperties, m_zone);
+    rec.stop(data_map, "extraProperties");
   }
   return data_map;
 }
 
+inline void encodeModelDeltaCoordinates(
+    std::map<std::string, msgpack::object>& data_map,
+    const StructureData& data, msgpack::zone& m_zone,
+    int32_t coord_divider, int32_t keyframe_interval) {
+  const HierarchyIndex index(data);
+  std::vector<int32_t> model_sizes(index.numModels());
+  for (int32_t m = 0; m < index.numModels(); ++m) {
+    model_sizes[m] = index.modelAtomEnd(m) - index.modelAtomBegin(m);
+  }
+  data_map["xCoordList"] = msgpack::object(mmtf::encodeModelDeltaFloat(data.xCoordList, model_sizes, coord_divider, keyframe_interval), m_zone);
+  data_map["yCoordList"] = msgpack::object(mmtf::encodeModelDeltaFloat(data.yCoordList, model_sizes, coord_divider, keyframe_interval), m_zone);
+  data_map["zCoordList"] = msgpack::object(mmtf::encodeModelDeltaFloat(data.zCoordList, model_sizes, coord_divider, keyframe_interval), m_zone);
+}
+
+namespace impl {
+
+// replace binary column key in data_map by tiles of values in columns
+template <typename T>
+inline void encodeTiledColumn(std::map<std::string, msgpack::object>& data_map,
+                              std::map<std::string, msgpack::object>& columns,
+                              const std::string& key,
+                              const std::vector<T>& values, int32_t num_atoms,
+                              msgpack::zone& m_zone, int32_t tile_size) {
+  std::map<std::string, msgpack::object>::iterator it = data_map.find(key);
+  if (it == data_map.end() || it->second.type != msgpack::type::BIN) return;
+  if (values.size() != size_t(num_atoms)) {
+    std::stringstream err;
+    err << "Cannot tile " << key << " with " << values.size()
+        << " values for " << num_atoms << " atoms";
+    throw EncodeError(err.str());
+  }
+  const BinaryDecoder bd(it->second, key);
+  std::vector<msgpack::object> tiles;
+  tiles.reserve((values.size() + tile_size - 1) / tile_size);
+  for (size_t begin = 0; begin < values.size(); begin += tile_size) {
+    const size_t end = std::min(values.size(), begin + size_t(tile_size));
+    const std::vector<T> tile(values.begin() + begin, values.begin() + end);
+    tiles.push_back(msgpack::object(
+      encodeBinary(tile, bd.strategy(), bd.parameter()), m_zone));
+  }
+  columns[key] = msgpack::object(tiles, m_zone);
+  data_map.erase(it);
+}
+
+} // impl namespace
+
+inline void encodeTiles(std::map<std::string, msgpack::object>& data_map,
+                        const StructureData& data, msgpack::zone& m_zone,
+                        int32_t tile_size) {
+  if (tile_size < 1) {
+    throw EncodeError("Tile size must be positive");
+  }
+  std::map<std::string, msgpack::object> columns;
+  impl::encodeTiledColumn(data_map, columns, "xCoordList", data.xCoordList,
+                          data.numAtoms, m_zone, tile_size);
+  impl::encodeTiledColumn(data_map, columns, "yCoordList", data.yCoordList,
+                          data.numAtoms, m_zone, tile_size);
+  impl::encodeTiledColumn(data_map, columns, "zCoordList", data.zCoordList,
+                          data.numAtoms, m_zone, tile_size);
+  impl::encodeTiledColumn(data_map, columns, "bFactorList", data.bFactorList,
+                          data.numAtoms, m_zone, tile_size);
+  impl::encodeTiledColumn(data_map, columns, "occupancyList",
+                          data.occupancyList, data.numAtoms, m_zone,
+                          tile_size);
+  impl::encodeTiledColumn(data_map, columns, "atomIdList", data.atomIdList,
+                          data.numAtoms, m_zone, tile_size);
+  impl::encodeTiledColumn(data_map, columns, "altLocList", data.altLocList,
+                          data.numAtoms, m_zone, tile_size);
+  if (columns.empty()) return;
+  std::map<std::string, msgpack::object> tiles;
+  tiles["tileSize"] = msgpack::object(tile_size, m_zone);
+  tiles["columns"] = msgpack::object(columns, m_zone);
+  std::map<std::string, msgpack::object> extra;
+  std::map<std::string, msgpack::object>::iterator extra_it =
+    data_map.find("extraProperties");
+  if (extra_it != data_map.end()) extra_it->second.convert(extra);
+  extra[TILES_KEY] = msgpack::object(tiles, m_zone);
+  data_map["extraProperties"] = msgpack::object(extra, m_zone);
+}
+
+inline void encodeCheckpoints(std::map<std::string, msgpack::object>& data_map,
+                              msgpack::zone& m_zone, int32_t interval) {
+  if (interval < 1) {
+    throw EncodeError("Checkpoint interval must be positive");
+  }
+  std::map<std::string, msgpack::object> table;
+  std::map<std::string, msgpack::object>::const_iterator it;
+  for (it = data_map.begin(); it != data_map.end(); ++it) {
+    if (it->second.type != msgpack::type::BIN) continue;
+    BinaryDecoder bd(it->second, it->first);
+    if (!bd.needsScan()) continue;
+    std::vector<int32_t> indices;
+    for (int32_t i = interval; i < bd.length(); i += interval) {
+      indices.push_back(i);
+    }
+    if (indices.empty()) continue;
+    std::vector<BinarySeekPoint> points;
+    bd.findSeekPoints(indices, points);
+    // flat (index, offset, skip, value) quadruples
+    std::vector<int32_t> flat;
+    flat.reserve(4 * points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+      flat.push_back(points[i].index);
+      flat.push_back(int32_t(points[i].offset));
+      flat.push_back(points[i].skip);
+      flat.push_back(points[i].value);
+    }
+    table[it->first] = msgpack::object(mmtf::encodeFourByteInt(flat), m_zone);
+  }
+  std::map<std::string, msgpack::object> extra;
+  std::map<std::string, msgpack::object>::iterator extra_it =
+    data_map.find("extraProperties");
+  if (extra_it != data_map.end()) extra_it->second.convert(extra);
+  extra.erase(CHECKPOINTS_KEY);
+  if (!table.empty()) {
+    extra[CHECKPOINTS_KEY] = msgpack::object(table, m_zone);
+  }
+  if (!extra.empty()) {
+    data_map["extraProperties"] = msgpack::object(extra, m_zone);
+  } else if (extra_it != data_map.end()) {
+    data_map.erase(extra_it);
+  }
+}
+
 } // mmtf namespace
 
 #endif
@@ -18,6 +18,8 @@
 #include "structure_data.hpp"
 
 #include <vector>
+#include <string>
+#include <algorithm>
 
 namespace mmtf
 {
@@ -35,6 +37,17 @@ class BondAdder {
   std::vector<int32_t> m_atom2groupType;
   std::vector<int32_t> m_atomOffsets;
 
+  // inter-group bond for sorting
+  struct InterBond {
+    int32_t atom1;
+    int32_t atom2;
+    int8_t order;
+    bool operator<(const InterBond& other) const {
+      return atom1 < other.atom1 ||
+             (atom1 == other.atom1 && atom2 < other.atom2);
+    }
+  };
+
 public:
   /**
    * @param[in,out] data Consistent system with atoms
@@ -42,10 +55,10 @@ public:
    * @throw mmtf::EncodeError if groupTypeList has duplicates
    */
   BondAdder(StructureData& data)
-      : m_data(&data), m_atomOffsets(data.groupTypeList.size(), -1)
+      : m_data(&data), m_atomOffsets(data.groupList.size(), -1)
   {
-    m_atom2groupType.reserve(data.numAtoms);
-
+    // offsets first, so that the atom map is allocated only once
+    int32_t atomOffset = 0;
     for (size_t i = 0; i < data.groupTypeList.size(); ++i) {
       int32_t groupType = data.groupTypeList[i];
 
@@ -54,11 +67,17 @@ public:
         throw EncodeError("groupTypeList has duplicates");
       }
 
-      size_t atomOffset = m_atom2groupType.size();
-      size_t groupSize = data.groupList[groupType].atomNameList.size();
-
       m_atomOffsets[groupType] = atomOffset;
-      m_atom2groupType.resize(atomOffset + groupSize, groupType);
+      atomOffset += data.groupList[groupType].atomNameList.size();
+    }
+
+    m_atom2groupType.resize(atomOffset);
+    for (size_t i = 0; i < data.groupTypeList.size(); ++i) {
+      int32_t groupType = data.groupTypeList[i];
+      std::fill(m_atom2groupType.begin() + m_atomOffsets[groupType],
+                m_atom2groupType.begin() + m_atomOffsets[groupType] +
+                    data.groupList[groupType].atomNameList.size(),
+                groupType);
     }
   }
 
@@ -73,8 +92,8 @@ public:
    */
   bool operator()(int32_t atom1, int32_t atom2, int8_t order)
   {
-    if (atom1 >= m_atom2groupType.size() ||
-        atom2 >= m_atom2groupType.size())
+    if (atom1 < 0 || atom1 >= int32_t(m_atom2groupType.size()) ||
+        atom2 < 0 || atom2 >= int32_t(m_atom2groupType.size()))
       return false;
 
     if (m_atom2groupType[atom1] == m_atom2groupType[atom2]) {
@@ -92,43 +111,249 @@ public:
     ++m_data->numBonds;
     return true;
   }
+
+  /**
+   * @brief Add many bonds at once
+   *
+   * Bonds are counted per group first, so that every bond list grows only
+   * once. Groups are filled in parallel if OpenMP is enabled. Intra-group
+   * bonds keep their input order.
+   *
+   * @param[in] atomPairs  2 * numBonds atom indices (zero-based)
+   * @param[in] orders     numBonds bond orders
+   * @param[in] numBonds   Number of bonds
+   * @param[in] sortInterGroup  If true, inter-group bonds added here are
+   *                            stored as (lower, higher) atom index pairs in
+   *                            ascending order (compresses better)
+   *
+   * @return False if any atom index is out of bounds (no bond is added then)
+   */
+  bool addBonds(const int32_t* atomPairs, const int8_t* orders,
+                size_t numBonds, bool sortInterGroup = false)
+  {
+    const int32_t numAtoms = m_atom2groupType.size();
+    const int32_t numGroupTypes = m_atomOffsets.size();
+
+    // validate and count per group type (last bucket: inter-group)
+    std::vector<size_t> counts(numGroupTypes + 1, 0);
+    for (size_t i = 0; i < numBonds; ++i) {
+      const int32_t atom1 = atomPairs[2 * i];
+      const int32_t atom2 = atomPairs[2 * i + 1];
+      if (atom1 < 0 || atom1 >= numAtoms || atom2 < 0 || atom2 >= numAtoms)
+        return false;
+      const int32_t groupType = m_atom2groupType[atom1];
+      ++counts[(groupType == m_atom2groupType[atom2]) ? groupType
+                                                       : numGroupTypes];
+    }
+
+    // bucket bond indices by group type (stable)
+    std::vector<size_t> bucketOffsets(numGroupTypes + 2, 0);
+    for (int32_t g = 0; g <= numGroupTypes; ++g) {
+      bucketOffsets[g + 1] = bucketOffsets[g] + counts[g];
+    }
+    std::vector<size_t> buckets(numBonds);
+    {
+      std::vector<size_t> fill(bucketOffsets.begin(), bucketOffsets.end() - 1);
+      for (size_t i = 0; i < numBonds; ++i) {
+        const int32_t groupType = m_atom2groupType[atomPairs[2 * i]];
+        const int32_t bucket =
+            (groupType == m_atom2groupType[atomPairs[2 * i + 1]])
+                ? groupType : numGroupTypes;
+        buckets[fill[bucket]++] = i;
+      }
+    }
+
+    // intra-group bonds: each group type is an independent shard
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 64)
+    #endif
+    for (int32_t g = 0; g < numGroupTypes; ++g) {
+      if (counts[g] == 0) continue;
+      GroupType& group = m_data->groupList[g];
+      const int32_t offset = m_atomOffsets[g];
+      size_t pos = group.bondOrderList.size();
+      group.bondAtomList.resize(group.bondAtomList.size() + 2 * counts[g]);
+      group.bondOrderList.resize(pos + counts[g]);
+      for (size_t k = bucketOffsets[g]; k < bucketOffsets[g + 1]; ++k, ++pos) {
+        const size_t i = buckets[k];
+        group.bondAtomList[2 * pos] = atomPairs[2 * i] - offset;
+        group.bondAtomList[2 * pos + 1] = atomPairs[2 * i + 1] - offset;
+        group.bondOrderList[pos] = orders[i];
+      }
+    }
+
+    // inter-group bonds
+    const size_t numInter = counts[numGroupTypes];
+    std::vector<InterBond> inter(numInter);
+    for (size_t k = 0; k < numInter; ++k) {
+      const size_t i = buckets[bucketOffsets[numGroupTypes] + k];
+      inter[k].atom1 = atomPairs[2 * i];
+      inter[k].atom2 = atomPairs[2 * i + 1];
+      inter[k].order = orders[i];
+      if (sortInterGroup && inter[k].atom2 < inter[k].atom1) {
+        std::swap(inter[k].atom1, inter[k].atom2);
+      }
+    }
+    if (sortInterGroup) {
+      std::stable_sort(inter.begin(), inter.end());
+    }
+    m_data->bondAtomList.reserve(m_data->bondAtomList.size() + 2 * numInter);
+    m_data->bondOrderList.reserve(m_data->bondOrderList.size() + numInter);
+    for (size_t k = 0; k < numInter; ++k) {
+      m_data->bondAtomList.push_back(inter[k].atom1);
+      m_data->bondAtomList.push_back(inter[k].atom2);
+      m_data->bondOrderList.push_back(inter[k].order);
+    }
+
+    m_data->numBonds += numBonds;
+    return true;
+  }
+
+  /**
+   * @brief Add many bonds at once
+   *
+   * @param[in] bondAtomList   Pairs of atom indices (zero-based)
+   * @param[in] bondOrderList  Bond orders (half the size of bondAtomList)
+   * @param[in] sortInterGroup See addBonds(const int32_t*, const int8_t*,
+   *                           size_t, bool)
+   *
+   * @return False if atom indices out of bounds or sizes do not match
+   */
+  bool addBonds(const std::vector<int32_t>& bondAtomList,
+                const std::vector<int8_t>& bondOrderList,
+                bool sortInterGroup = false)
+  {
+    if (bondAtomList.size() != 2 * bondOrderList.size())
+      return false;
+    if (bondOrderList.empty())
+      return true;
+    return addBonds(&bondAtomList[0], &bondOrderList[0], bondOrderList.size(),
+                    sortInterGroup);
+  }
 };
 
+namespace {
+
+// FNV-1a hash helpers for compressGroupList
+inline uint32_t hashGroupBytes(uint32_t hash, const void* data, size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+inline uint32_t hashGroupString(uint32_t hash, const std::string& str)
+{
+  hash = hashGroupBytes(hash, str.data(), str.size());
+  return (hash ^ 0xffu) * 16777619u; // separator
+}
+
+template <typename T>
+inline uint32_t hashGroupVector(uint32_t hash, const std::vector<T>& vec)
+{
+  const uint32_t size = vec.size();
+  hash = hashGroupBytes(hash, &size, sizeof(size));
+  return vec.empty() ? hash : hashGroupBytes(hash, &vec[0], vec.size() * sizeof(T));
+}
+
+inline uint32_t hashGroupVector(uint32_t hash, const std::vector<std::string>& vec)
+{
+  const uint32_t size = vec.size();
+  hash = hashGroupBytes(hash, &size, sizeof(size));
+  for (size_t i = 0; i < vec.size(); ++i) {
+    hash = hashGroupString(hash, vec[i]);
+  }
+  return hash;
+}
+
+// content hash consistent with GroupType::operator==
+inline uint32_t hashGroupType(const GroupType& group)
+{
+  uint32_t hash = 2166136261u;
+  hash = hashGroupString(hash, group.groupName);
+  hash = hashGroupString(hash, group.chemCompType);
+  hash = hashGroupBytes(hash, &group.singleLetterCode, 1);
+  hash = hashGroupVector(hash, group.atomNameList);
+  hash = hashGroupVector(hash, group.elementList);
+  hash = hashGroupVector(hash, group.formalChargeList);
+  hash = hashGroupVector(hash, group.bondAtomList);
+  hash = hashGroupVector(hash, group.bondOrderList);
+  hash = hashGroupVector(hash, group.bondResonanceList);
+  return hash;
+}
+
+// O(1) "move" for C++03
+inline void swapGroupType(GroupType& a, GroupType& b)
+{
+  a.formalChargeList.swap(b.formalChargeList);
+  a.atomNameList.swap(b.atomNameList);
+  a.elementList.swap(b.elementList);
+  a.bondAtomList.swap(b.bondAtomList);
+  a.bondOrderList.swap(b.bondOrderList);
+  a.bondResonanceList.swap(b.bondResonanceList);
+  a.groupName.swap(b.groupName);
+  std::swap(a.singleLetterCode, b.singleLetterCode);
+  a.chemCompType.swap(b.chemCompType);
+}
+
+} // anon ns
+
 /**
  * @brief Eliminate redundant groups from groupList
  *
- * Modifies groupList and groupTypeList
+ * Modifies groupList and groupTypeList. Unique groups keep the order of
+ * their first occurrence. Uses a hash table over the group content, so this
+ * is O(n) in groupList.size() (plus one full comparison per duplicate).
  *
  * @param[in,out] data Consistent system
  */
 inline void compressGroupList(StructureData& data)
 {
-  size_t n_old = data.groupList.size();
-  size_t i_free = 0;
+  const size_t n_old = data.groupList.size();
+  if (n_old < 2) return;
+
+  // open addressing table (power of two, load factor <= 0.5) of unique ids
+  size_t table_size = 2;
+  while (table_size < 2 * n_old) table_size *= 2;
+  const size_t mask = table_size - 1;
+  std::vector<size_t> table(table_size, size_t(-1));
+  std::vector<uint32_t> hashes(n_old);
+
   std::vector<size_t> idremap(n_old, 0);
+  size_t n_new = 0;
 
-  for (size_t i = 1; i < n_old; ++i) {
-    size_t i_found = 0;
+  for (size_t i = 0; i < n_old; ++i) {
+    const uint32_t hash = hashGroupType(data.groupList[i]);
+    size_t slot = hash & mask;
+    size_t i_found = size_t(-1);
 
-    while (i_found < i && !(data.groupList[i] == data.groupList[i_found])) {
-      ++i_found;
+    for (; table[slot] != size_t(-1); slot = (slot + 1) & mask) {
+      const size_t candidate = table[slot];
+      if (hashes[candidate] == hash &&
+          data.groupList[candidate] == data.groupList[i]) {
+        i_found = candidate;
+        break;
+      }
     }
 
-    if (i_found == i) {
-      if (i_free != 0) {
-        data.groupList[i_free] = data.groupList[i]; // std::move possible with C++11
-        i_found = i_free;
-        ++i_free;
+    if (i_found == size_t(-1)) {
+      // new unique group: move it to the front part of the list
+      if (n_new != i) {
+        swapGroupType(data.groupList[n_new], data.groupList[i]);
       }
-    } else if (i_free == 0) {
-      i_free = i;
+      hashes[n_new] = hash;
+      table[slot] = n_new;
+      i_found = n_new;
+      ++n_new;
     }
 
     idremap[i] = i_found;
   }
 
-  if (i_free != 0) {
-    data.groupList.resize(i_free);
+  if (n_new != n_old) {
+    data.groupList.resize(n_new);
 
     for (size_t i = 0; i < data.groupTypeList.size(); ++i) {
       data.groupTypeList[i] = idremap[data.groupTypeList[i]];
@@ -0,0 +1,240 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Packed storage for short strings of fixed max. width (e.g. chain IDs).
+// See tests/mmtf_tests.cpp (Test fixed width string list) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_FIXED_WIDTH_STRING_LIST_H
+#define MMTF_FIXED_WIDTH_STRING_LIST_H
+
+#include "errors.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace mmtf {
+
+/**
+ * @brief List of strings stored as contiguous, zero-padded fixed width
+ *        records.
+ *
+ * Same layout as binary strategy 5 used for chainIdList and chainNameList,
+ * so that BinaryDecoder::decode and ::encodeStringVector only copy memory.
+ * Each string takes width() bytes instead of a std::string (usually 32 bytes
+ * plus heap allocations for long strings). Padding is only removed when a
+ * string is accessed.
+ */
+class FixedWidthStringList {
+public:
+    /** @brief Empty list with width 0. */
+    FixedWidthStringList(): width_(0), size_(0) {}
+
+    /**
+     * @brief List of size empty strings of given width.
+     * @throw mmtf::EncodeError if width is negative.
+     */
+    explicit FixedWidthStringList(int32_t width, size_t size = 0);
+
+    /**
+     * @brief Pack strings into records of given width.
+     * @throw mmtf::EncodeError if width is negative or a string is too long.
+     */
+    FixedWidthStringList(const std::vector<std::string>& strings,
+                         int32_t width);
+
+    /** @brief Max. length of strings (bytes per record). */
+    int32_t width() const { return width_; }
+
+    /** @brief Number of strings (also counted for width 0). */
+    size_t size() const { return size_; }
+
+    /** @brief True if list has no strings. */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief Pointer to zero-padded record i (not zero terminated if string
+     *        has max. length).
+     */
+    const char* data(size_t i) const {
+        return bytes_.empty() ? NULL : &bytes_[0] + i * width_;
+    }
+
+    /** @brief Length of string i (number of non-zero bytes). */
+    size_t length(size_t i) const;
+
+    /** @brief String i without padding (all zero bytes removed). */
+    std::string get(size_t i) const;
+    std::string operator[](size_t i) const { return get(i); }
+
+    /**
+     * @brief Set string i.
+     * @throw mmtf::EncodeError if s is longer than width().
+     */
+    void set(size_t i, const std::string& s);
+
+    /**
+     * @brief Append string.
+     * @throw mmtf::EncodeError if s is longer than width().
+     */
+    void push_back(const std::string& s);
+
+    /** @brief Resize list (new strings are empty). */
+    void resize(size_t size) {
+        bytes_.resize(size * width_, '\0');
+        size_ = size;
+    }
+
+    /** @brief Remove all strings (keeps width). */
+    void clear() {
+        bytes_.clear();
+        size_ = 0;
+    }
+
+    /**
+     * @brief Replace content by num_strings zero-padded records of given width
+     *        (e.g. data of strategy 5 binary).
+     * @throw mmtf::EncodeError if width is negative.
+     */
+    void assign(const char* records, size_t num_strings, int32_t width);
+
+    /** @brief All records (size() * width() bytes). */
+    const std::vector<char>& bytes() const { return bytes_; }
+
+    /** @brief Unpacked strings (as decoded into std::vector<std::string>). */
+    std::vector<std::string> toVector() const;
+
+    bool operator==(const FixedWidthStringList& other) const {
+        return    width_ == other.width_ && size_ == other.size_
+               && bytes_ == other.bytes_;
+    }
+    bool operator!=(const FixedWidthStringList& other) const {
+        return !(*this == other);
+    }
+
+private:
+    int32_t width_;
+    size_t size_;
+    std::vector<char> bytes_;
+
+    void checkWidth_(int32_t width) const;
+    void checkLength_(const std::string& s) const;
+};
+
+namespace impl {
+
+/**
+ * @brief Assign zero-padded record to string with all zero bytes removed.
+ */
+inline void assignFixedWidth(std::string& output, const char* record,
+                             size_t width);
+
+} // impl namespace
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+inline FixedWidthStringList::FixedWidthStringList(int32_t width, size_t size)
+    : width_(width), size_(size) {
+    checkWidth_(width);
+    bytes_.resize(size * width_, '\0');
+}
+
+inline FixedWidthStringList::FixedWidthStringList(
+        const std::vector<std::string>& strings, int32_t width)
+    : width_(width), size_(strings.size()) {
+    checkWidth_(width);
+    bytes_.resize(strings.size() * width_, '\0');
+    for (size_t i = 0; i < strings.size(); ++i) set(i, strings[i]);
+}
+
+inline size_t FixedWidthStringList::length(size_t i) const {
+    const char* record = data(i);
+    size_t len = 0;
+    for (int32_t j = 0; j < width_; ++j) len += (record[j] != '\0');
+    return len;
+}
+
+inline std::string FixedWidthStringList::get(size_t i) const {
+    std::string s;
+    impl::assignFixedWidth(s, data(i), size_t(width_));
+    return s;
+}
+
+inline void FixedWidthStringList::set(size_t i, const std::string& s) {
+    checkLength_(s);
+    if (width_ == 0) return;
+    char* record = &bytes_[i * width_];
+    std::memset(record, 0, width_);
+    if (!s.empty()) std::memcpy(record, s.data(), s.size());
+}
+
+inline void FixedWidthStringList::push_back(const std::string& s) {
+    checkLength_(s);
+    bytes_.insert(bytes_.end(), s.begin(), s.end());
+    bytes_.resize(bytes_.size() + (width_ - s.size()), '\0');
+    ++size_;
+}
+
+inline void FixedWidthStringList::assign(const char* records,
+                                         size_t num_strings, int32_t width) {
+    checkWidth_(width);
+    width_ = width;
+    size_ = num_strings;
+    bytes_.assign(records, records + num_strings * width_);
+}
+
+inline std::vector<std::string> FixedWidthStringList::toVector() const {
+    std::vector<std::string> strings(size());
+    for (size_t i = 0; i < strings.size(); ++i) {
+        impl::assignFixedWidth(strings[i], data(i), size_t(width_));
+    }
+    return strings;
+}
+
+inline void FixedWidthStringList::checkWidth_(int32_t width) const {
+    if (width < 0) {
+        throw EncodeError("Invalid width for FixedWidthStringList");
+    }
+}
+
+inline void FixedWidthStringList::checkLength_(const std::string& s) const {
+    if (s.size() > size_t(width_)) {
+        throw EncodeError("String '" + s + "' is longer than width of "
+                          "FixedWidthStringList");
+    }
+}
+
+namespace impl {
+
+inline void assignFixedWidth(std::string& output, const char* record,
+                             size_t width) {
+    if (width == 0) {
+        output.clear();
+        return;
+    }
+    // common case: padding only at end
+    const char* end = static_cast<const char*>(std::memchr(record, '\0',
+                                                           width));
+    if (!end) {
+        output.assign(record, width);
+        return;
+    }
+    output.assign(record, end);
+    for (const char* c = end + 1; c < record + width; ++c) {
+        if (*c != '\0') output.push_back(*c);
+    }
+}
+
+} // impl namespace
+
+} // mmtf namespace
+
+#endif
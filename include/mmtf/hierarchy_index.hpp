@@ -0,0 +1,514 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Precomputed model/chain/group/atom hierarchy for mmtf::StructureData.
+// See "examples/traverse.cpp" for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_HIERARCHY_INDEX_H
+#define MMTF_HIERARCHY_INDEX_H
+
+#include "structure_data.hpp"
+#include "errors.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+namespace mmtf {
+
+/**
+ * @brief Prefix-sum index over the model/chain/group/atom hierarchy.
+ *
+ * Built once in O(numAtoms) from StructureData.chainsPerModel,
+ * StructureData.groupsPerChain and StructureData.groupTypeList. Afterwards all
+ * ranges (chains of a model, groups of a chain, atoms of a group) and all
+ * reverse lookups (atom -> group -> chain -> model) are O(1).
+ *
+ * Ranges are half-open, e.g. the chains of model m are
+ * [chainBegin(m), chainEnd(m)). The index does not keep a reference to the
+ * StructureData it was built from and must be rebuilt if the hierarchy changes.
+ */
+class HierarchyIndex {
+public:
+    /**
+     * @brief Construct empty index. Use init to fill it.
+     */
+    HierarchyIndex(): chainOffsets_(1, 0), groupOffsets_(1, 0),
+                      atomOffsets_(1, 0) {}
+
+    /**
+     * @brief Construct index for given data.
+     * @throw mmtf::DecodeError if hierarchy of data is inconsistent.
+     */
+    explicit HierarchyIndex(const StructureData& data);
+
+    /**
+     * @brief (Re)build index for given data.
+     * @throw mmtf::DecodeError if hierarchy of data is inconsistent.
+     */
+    void init(const StructureData& data);
+
+    /// @name Sizes
+    /// @{
+    int32_t numModels() const { return int32_t(chainOffsets_.size()) - 1; }
+    int32_t numChains() const { return int32_t(groupOffsets_.size()) - 1; }
+    int32_t numGroups() const { return int32_t(atomOffsets_.size()) - 1; }
+    int32_t numAtoms() const { return int32_t(atomToGroup_.size()); }
+    /// @}
+
+    /// @name Forward ranges (half-open)
+    /// @{
+    int32_t chainBegin(int32_t model_index) const {
+        return chainOffsets_[model_index];
+    }
+    int32_t chainEnd(int32_t model_index) const {
+        return chainOffsets_[model_index + 1];
+    }
+    int32_t groupBegin(int32_t chain_index) const {
+        return groupOffsets_[chain_index];
+    }
+    int32_t groupEnd(int32_t chain_index) const {
+        return groupOffsets_[chain_index + 1];
+    }
+    int32_t atomBegin(int32_t group_index) const {
+        return atomOffsets_[group_index];
+    }
+    int32_t atomEnd(int32_t group_index) const {
+        return atomOffsets_[group_index + 1];
+    }
+    /// @}
+
+    /// @name Atom ranges of chains and models (half-open)
+    /// @{
+    int32_t chainAtomBegin(int32_t chain_index) const {
+        return atomOffsets_[groupOffsets_[chain_index]];
+    }
+    int32_t chainAtomEnd(int32_t chain_index) const {
+        return atomOffsets_[groupOffsets_[chain_index + 1]];
+    }
+    int32_t modelAtomBegin(int32_t model_index) const {
+        return chainAtomBegin(chainOffsets_[model_index]);
+    }
+    int32_t modelAtomEnd(int32_t model_index) const {
+        return chainAtomBegin(chainOffsets_[model_index + 1]);
+    }
+    /// @}
+
+    /// @name Reverse lookups
+    /// @{
+    int32_t modelIndexOfChain(int32_t chain_index) const {
+        return chainToModel_[chain_index];
+    }
+    int32_t chainIndexOfGroup(int32_t group_index) const {
+        return groupToChain_[group_index];
+    }
+    int32_t groupIndexOfAtom(int32_t atom_index) const {
+        return atomToGroup_[atom_index];
+    }
+    int32_t chainIndexOfAtom(int32_t atom_index) const {
+        return groupToChain_[atomToGroup_[atom_index]];
+    }
+    int32_t modelIndexOfAtom(int32_t atom_index) const {
+        return chainToModel_[groupToChain_[atomToGroup_[atom_index]]];
+    }
+    /// @}
+
+    /// @name Raw prefix-sum arrays (size = number of parents + 1)
+    /// @{
+    const std::vector<int32_t>& chainOffsets() const { return chainOffsets_; }
+    const std::vector<int32_t>& groupOffsets() const { return groupOffsets_; }
+    const std::vector<int32_t>& atomOffsets() const { return atomOffsets_; }
+    /// @}
+
+private:
+    std::vector<int32_t> chainOffsets_;  // model -> first chain
+    std::vector<int32_t> groupOffsets_;  // chain -> first group
+    std::vector<int32_t> atomOffsets_;   // group -> first atom
+    std::vector<int32_t> chainToModel_;
+    std::vector<int32_t> groupToChain_;
+    std::vector<int32_t> atomToGroup_;
+};
+
+namespace impl {
+
+/**
+ * @brief Common part of the hierarchy iterators (position and operators).
+ * @tparam Derived  Iterator class deriving from this (CRTP).
+ */
+template <typename Derived>
+class HierarchyIteratorBase {
+public:
+    const Derived& operator*() const { return derived_(); }
+    const Derived* operator->() const { return &derived_(); }
+    Derived& operator++() { ++pos_; return derived_(); }
+    Derived operator++(int) {
+        Derived tmp(derived_());
+        ++pos_;
+        return tmp;
+    }
+    bool operator==(const Derived& other) const {
+        const HierarchyIteratorBase& base = other;
+        return pos_ == base.pos_ && data_ == base.data_;
+    }
+    bool operator!=(const Derived& other) const {
+        return !(*this == other);
+    }
+
+protected:
+    HierarchyIteratorBase(): data_(NULL), index_(NULL), pos_(0) {}
+    HierarchyIteratorBase(const StructureData& data,
+                          const HierarchyIndex& index, int32_t pos)
+        : data_(&data), index_(&index), pos_(pos) {}
+
+    const StructureData* data_;
+    const HierarchyIndex* index_;
+    int32_t pos_;
+
+private:
+    const Derived& derived_() const {
+        return static_cast<const Derived&>(*this);
+    }
+    Derived& derived_() { return static_cast<Derived&>(*this); }
+};
+
+} // impl namespace
+
+/**
+ * @brief Forward iterator over all atoms of a StructureData.
+ *
+ * Dereferencing gives the iterator itself, which knows model, chain, group and
+ * atom indices of the current atom. Can be constructed at any atom index for
+ * random access (e.g. to process models or chains in parallel).
+ *
+ * Data and index must stay alive and unchanged while the iterator is used.
+ */
+class AtomIterator: public impl::HierarchyIteratorBase<AtomIterator> {
+public:
+    AtomIterator() {}
+
+    /**
+     * @brief Iterator pointing to atom with given index.
+     * @param data        Data over which to iterate.
+     * @param index       Index built for data.
+     * @param atom_index  Atom index (numAtoms for end-iterator).
+     */
+    AtomIterator(const StructureData& data, const HierarchyIndex& index,
+                 int32_t atom_index)
+        : impl::HierarchyIteratorBase<AtomIterator>(data, index, atom_index) {}
+
+    /// @name Position in hierarchy
+    /// @{
+    int32_t atomIndex() const { return pos_; }
+    int32_t groupIndex() const { return index_->groupIndexOfAtom(pos_); }
+    int32_t chainIndex() const { return index_->chainIndexOfAtom(pos_); }
+    int32_t modelIndex() const { return index_->modelIndexOfAtom(pos_); }
+    /// Index of atom within its group (index into GroupType atom lists)
+    int32_t groupAtomIndex() const {
+        return pos_ - index_->atomBegin(groupIndex());
+    }
+    /// @}
+
+    /// @name Shortcuts to data
+    /// @{
+    const GroupType& group() const {
+        return data_->groupList[data_->groupTypeList[groupIndex()]];
+    }
+    const std::string& atomName() const {
+        return group().atomNameList[groupAtomIndex()];
+    }
+    const std::string& element() const {
+        return group().elementList[groupAtomIndex()];
+    }
+    int32_t formalCharge() const {
+        return group().formalChargeList[groupAtomIndex()];
+    }
+    float x() const { return data_->xCoordList[pos_]; }
+    float y() const { return data_->yCoordList[pos_]; }
+    float z() const { return data_->zCoordList[pos_]; }
+    /// @}
+};
+
+/**
+ * @brief Forward iterator over groups (e.g. of a chain).
+ *
+ * Same conventions as AtomIterator. Use ::atomsBegin and ::atomsEnd to
+ * iterate over the atoms of the current group.
+ */
+class GroupIterator: public impl::HierarchyIteratorBase<GroupIterator> {
+public:
+    GroupIterator() {}
+
+    /**
+     * @brief Iterator pointing to group with given index.
+     * @param data         Data over which to iterate.
+     * @param index        Index built for data.
+     * @param group_index  Group index (numGroups for end-iterator).
+     */
+    GroupIterator(const StructureData& data, const HierarchyIndex& index,
+                  int32_t group_index)
+        : impl::HierarchyIteratorBase<GroupIterator>(data, index,
+                                                     group_index) {}
+
+    /// @name Position in hierarchy
+    /// @{
+    int32_t groupIndex() const { return pos_; }
+    int32_t chainIndex() const { return index_->chainIndexOfGroup(pos_); }
+    int32_t modelIndex() const {
+        return index_->modelIndexOfChain(chainIndex());
+    }
+    /// @}
+
+    /// @name Shortcuts to data
+    /// @{
+    const GroupType& group() const {
+        return data_->groupList[data_->groupTypeList[pos_]];
+    }
+    int32_t groupId() const { return data_->groupIdList[pos_]; }
+    /// @}
+
+    /// @name Atoms of this group
+    /// @{
+    AtomIterator atomsBegin() const {
+        return AtomIterator(*data_, *index_, index_->atomBegin(pos_));
+    }
+    AtomIterator atomsEnd() const {
+        return AtomIterator(*data_, *index_, index_->atomEnd(pos_));
+    }
+    /// @}
+};
+
+/**
+ * @brief Forward iterator over chains (e.g. of a model).
+ *
+ * Same conventions as AtomIterator. Use ::groupsBegin and ::groupsEnd (or
+ * ::atomsBegin and ::atomsEnd) to iterate over the contents of the chain.
+ */
+class ChainIterator: public impl::HierarchyIteratorBase<ChainIterator> {
+public:
+    ChainIterator() {}
+
+    /**
+     * @brief Iterator pointing to chain with given index.
+     * @param data         Data over which to iterate.
+     * @param index        Index built for data.
+     * @param chain_index  Chain index (numChains for end-iterator).
+     */
+    ChainIterator(const StructureData& data, const HierarchyIndex& index,
+                  int32_t chain_index)
+        : impl::HierarchyIteratorBase<ChainIterator>(data, index,
+                                                     chain_index) {}
+
+    /// @name Position in hierarchy
+    /// @{
+    int32_t chainIndex() const { return pos_; }
+    int32_t modelIndex() const { return index_->modelIndexOfChain(pos_); }
+    /// @}
+
+    /// @name Shortcuts to data
+    /// @{
+    const std::string& chainId() const { return data_->chainIdList[pos_]; }
+    /// @}
+
+    /// @name Contents of this chain
+    /// @{
+    GroupIterator groupsBegin() const {
+        return GroupIterator(*data_, *index_, index_->groupBegin(pos_));
+    }
+    GroupIterator groupsEnd() const {
+        return GroupIterator(*data_, *index_, index_->groupEnd(pos_));
+    }
+    AtomIterator atomsBegin() const {
+        return AtomIterator(*data_, *index_, index_->chainAtomBegin(pos_));
+    }
+    AtomIterator atomsEnd() const {
+        return AtomIterator(*data_, *index_, index_->chainAtomEnd(pos_));
+    }
+    /// @}
+};
+
+/**
+ * @brief Forward iterator over models.
+ *
+ * Same conventions as AtomIterator. Use ::chainsBegin and ::chainsEnd (or
+ * ::atomsBegin and ::atomsEnd) to iterate over the contents of the model.
+ */
+class ModelIterator: public impl::HierarchyIteratorBase<ModelIterator> {
+public:
+    ModelIterator() {}
+
+    /**
+     * @brief Iterator pointing to model with given index.
+     * @param data         Data over which to iterate.
+     * @param index        Index built for data.
+     * @param model_index  Model index (numModels for end-iterator).
+     */
+    ModelIterator(const StructureData& data, const HierarchyIndex& index,
+                  int32_t model_index)
+        : impl::HierarchyIteratorBase<ModelIterator>(data, index,
+                                                     model_index) {}
+
+    /// @name Position in hierarchy
+    /// @{
+    int32_t modelIndex() const { return pos_; }
+    /// @}
+
+    /// @name Contents of this model
+    /// @{
+    ChainIterator chainsBegin() const {
+        return ChainIterator(*data_, *index_, index_->chainBegin(pos_));
+    }
+    ChainIterator chainsEnd() const {
+        return ChainIterator(*data_, *index_, index_->chainEnd(pos_));
+    }
+    AtomIterator atomsBegin() const {
+        return AtomIterator(*data_, *index_, index_->modelAtomBegin(pos_));
+    }
+    AtomIterator atomsEnd() const {
+        return AtomIterator(*data_, *index_, index_->modelAtomEnd(pos_));
+    }
+    /// @}
+};
+
+/**
+ * @brief Iterator to first atom of data.
+ */
+inline AtomIterator atomsBegin(const StructureData& data,
+                               const HierarchyIndex& index);
+
+/**
+ * @brief Iterator past last atom of data.
+ */
+inline AtomIterator atomsEnd(const StructureData& data,
+                             const HierarchyIndex& index);
+
+/**
+ * @brief Iterator to first model of data.
+ */
+inline ModelIterator modelsBegin(const StructureData& data,
+                                 const HierarchyIndex& index);
+
+/**
+ * @brief Iterator past last model of data.
+ */
+inline ModelIterator modelsEnd(const StructureData& data,
+                               const HierarchyIndex& index);
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+namespace {
+
+// throw with consistent message
+inline void throwHierarchyError(const std::string& field, size_t found,
+                                size_t expected) {
+    std::stringstream err;
+    err << "Inconsistent hierarchy: " << field << " has size " << found
+        << " but " << expected << " were expected";
+    throw DecodeError(err.str());
+}
+
+// prefix sums of counts, each prefix must be in [0, num_children]
+inline void hierarchyOffsets(const std::vector<int32_t>& counts,
+                             const std::string& field, size_t num_children,
+                             std::vector<int32_t>& offsets) {
+    offsets.resize(counts.size() + 1);
+    offsets[0] = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (   counts[i] < 0
+            || size_t(counts[i]) > num_children - size_t(offsets[i])) {
+            std::stringstream err;
+            err << "Inconsistent hierarchy: " << field << "[" << i << "] = "
+                << counts[i] << " is out of range";
+            throw DecodeError(err.str());
+        }
+        offsets[i + 1] = offsets[i] + counts[i];
+    }
+}
+
+} // anon ns
+
+inline HierarchyIndex::HierarchyIndex(const StructureData& data) {
+    init(data);
+}
+
+inline void HierarchyIndex::init(const StructureData& data) {
+    const size_t num_models = data.chainsPerModel.size();
+    const size_t num_chains = data.groupsPerChain.size();
+    const size_t num_groups = data.groupTypeList.size();
+
+    // models -> chains
+    hierarchyOffsets(data.chainsPerModel, "chainsPerModel", num_chains,
+                     chainOffsets_);
+    if (size_t(chainOffsets_.back()) != num_chains) {
+        throwHierarchyError("groupsPerChain", num_chains,
+                            chainOffsets_.back());
+    }
+    chainToModel_.resize(num_chains);
+    for (size_t i = 0; i < num_models; ++i) {
+        std::fill(chainToModel_.begin() + chainOffsets_[i],
+                  chainToModel_.begin() + chainOffsets_[i + 1], int32_t(i));
+    }
+
+    // chains -> groups
+    hierarchyOffsets(data.groupsPerChain, "groupsPerChain", num_groups,
+                     groupOffsets_);
+    if (size_t(groupOffsets_.back()) != num_groups) {
+        throwHierarchyError("groupTypeList", num_groups, groupOffsets_.back());
+    }
+    groupToChain_.resize(num_groups);
+    for (size_t i = 0; i < num_chains; ++i) {
+        std::fill(groupToChain_.begin() + groupOffsets_[i],
+                  groupToChain_.begin() + groupOffsets_[i + 1], int32_t(i));
+    }
+
+    // groups -> atoms
+    atomOffsets_.resize(num_groups + 1);
+    atomOffsets_[0] = 0;
+    for (size_t i = 0; i < num_groups; ++i) {
+        const int32_t group_type = data.groupTypeList[i];
+        if (group_type < 0 || size_t(group_type) >= data.groupList.size()) {
+            std::stringstream err;
+            err << "Inconsistent hierarchy: groupTypeList[" << i << "] = "
+                << group_type << " is not a valid groupList index";
+            throw DecodeError(err.str());
+        }
+        atomOffsets_[i + 1] = atomOffsets_[i]
+            + int32_t(data.groupList[group_type].atomNameList.size());
+    }
+    atomToGroup_.resize(atomOffsets_.back());
+    for (size_t i = 0; i < num_groups; ++i) {
+        std::fill(atomToGroup_.begin() + atomOffsets_[i],
+                  atomToGroup_.begin() + atomOffsets_[i + 1], int32_t(i));
+    }
+}
+
+inline AtomIterator atomsBegin(const StructureData& data,
+                               const HierarchyIndex& index) {
+    return AtomIterator(data, index, 0);
+}
+
+inline AtomIterator atomsEnd(const StructureData& data,
+                             const HierarchyIndex& index) {
+    return AtomIterator(data, index, index.numAtoms());
+}
+
+inline ModelIterator modelsBegin(const StructureData& data,
+                                 const HierarchyIndex& index) {
+    return ModelIterator(data, index, 0);
+}
+
+inline ModelIterator modelsEnd(const StructureData& data,
+                               const HierarchyIndex& index) {
+    return ModelIterator(data, index, index.numModels());
+}
+
+} // mmtf namespace
+
+#endif
@@ -19,8 +19,11 @@
 #include "errors.hpp"
 
 #include <msgpack.hpp>
+#include <algorithm>
 #include <map>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
 namespace mmtf {
 
@@ -34,7 +37,7 @@ public:
     /**
      * @brief Construct empty decoder. Use init-functions to fill it.
      */
-    MapDecoder() {}
+    MapDecoder(): tile_size_(0), decode_tiles_(true) {}
 
     /**
      * @brief Construct decoder given a msgpack::object.
@@ -60,8 +63,13 @@ public:
     /**
      * @brief Initialize from byte buffer of given size.
      * Unpacks data and then same effect as MapDecoder::initFromObject.
+     * @param[in]  reference_buffer  If true, binaries and strings are not
+     *                               copied but point into buffer, which must
+     *                               then stay alive while this decoder
+     *                               exists (e.g. a memory-mapped file).
      */
-    void initFromBuffer(const char* buffer, size_t size);
+    void initFromBuffer(const char* buffer, size_t size,
+                        bool reference_buffer = false);
 
     /**
      * @brief Extract value from map and decode into target.
@@ -99,6 +107,75 @@ public:
                 std::map<std::string, msgpack::object>& target,
                 msgpack::zone& zone) const;
 
+    /**
+     * @brief Get raw msgpack object stored for key.
+     * @return Pointer to object (valid while this decoder exists) or NULL if
+     *         key is not in map. Key is not marked as decoded.
+     */
+    const msgpack::object* getObject(const std::string& key) const;
+
+    /**
+     * @brief Mark key as decoded without decoding it (e.g. for property maps
+     *        accessed with a mmtf::PropertyView). Does nothing if key is not
+     *        in map.
+     */
+    void markDecoded(const std::string& key) const;
+
+    /**
+     * @brief Get checkpoints stored for a binary field.
+     *
+     * Checkpoints are read from extraProperties (key mmtf::CHECKPOINTS_KEY,
+     * see mmtf::encodeCheckpoints) and used by ::decode to decode binary
+     * fields in parallel chunks. Malformed entries are skipped and checkpoints
+     * not matching their binary are ignored when decoding.
+     *
+     * @return Pointer to checkpoints (valid while this decoder exists) or NULL
+     *         if there are none for key.
+     */
+    const std::vector<BinarySeekPoint>*
+    getCheckpoints(const std::string& key) const;
+
+    /**
+     * @brief Get number of values per tile of tiled fields.
+     * @return Tile size (see mmtf::encodeTiles) or 0 if there are no tiled
+     *         fields.
+     */
+    int32_t getTileSize() const { return tile_size_; }
+
+    /**
+     * @brief Get tiles stored for a per-atom field.
+     *
+     * Fields split into tiles with mmtf::encodeTiles are not in the map but in
+     * extraProperties. ::decode concatenates the tiles transparently (in
+     * parallel if OpenMP is enabled) unless disabled with ::setDecodeTiles.
+     *
+     * @return Pointer to binaries of all tiles (valid while this decoder
+     *         exists) or NULL if key is not tiled.
+     */
+    const std::vector<const msgpack::object*>*
+    getTiles(const std::string& key) const;
+
+    /**
+     * @brief Set if ::decode concatenates tiles of tiled fields.
+     * If false, tiled fields are marked as decoded but target is left
+     * unchanged (e.g. to decode everything but tiled fields with
+     * ::decodeFromMapDecoder). Default is true.
+     */
+    void setDecodeTiles(bool decode_tiles) { decode_tiles_ = decode_tiles; }
+
+    /**
+     * @brief Decode values [begin, end) of a tiled field.
+     *
+     * Only tiles overlapping the range are decoded (with
+     * BinaryDecoder::decodeRange).
+     *
+     * @throw mmtf::DecodeError if key is not tiled, range is invalid or we
+     *        fail to decode.
+     */
+    template<typename T>
+    void decodeTiledRange(const std::string& key, int32_t begin, int32_t end,
+                          std::vector<T>& target) const;
+
     /**
      * @brief Check if there are any keys, that were not decoded.
      * This is to be called after all expected fields have been decoded.
@@ -115,12 +192,35 @@ private:
     data_map_type_ data_map_;
     // set of keys that were successfully decoded
     mutable std::set<std::string> decoded_keys_;
+    // checkpoints of binary fields found in extraProperties
+    typedef std::map<std::string, std::vector<BinarySeekPoint> >
+        checkpoints_type_;
+    checkpoints_type_ checkpoints_;
+    // tiles of per-atom fields found in extraProperties
+    typedef std::map<std::string, std::vector<const msgpack::object*> >
+        tiles_type_;
+    tiles_type_ tiles_;
+    int32_t tile_size_;
+    bool decode_tiles_;
 
     /**
      * @brief Initialize object given an object
      * helper function used by constructors
      */
     void init_from_msgpack_obj(const msgpack::object& obj);
+    // get entry of extraProperties (NULL if not there)
+    const msgpack::object* getExtraProperty_(const std::string& key) const;
+    // read checkpoints from extraProperties (if any)
+    void initCheckpoints_();
+    // read tiles from extraProperties (if any)
+    void initTiles_();
+    // decode all tiles into target (overload for non-vector targets throws)
+    template<typename T>
+    void decodeTiles_(const std::string& key, std::vector<T>& target) const;
+    template<typename T>
+    void decodeTiles_(const std::string& key, T& target) const;
+    // number of values in tile (last tile may be shorter)
+    int32_t tileLength_(const std::string& key, size_t tile) const;
 
     // type checking (note: doesn't check array elements)
     // -> only writes warning to cerr
@@ -145,25 +245,44 @@ private:
 // IMPLEMENTATION
 // *************************************************************************
 
-inline MapDecoder::MapDecoder(const msgpack::object& obj) {
+inline MapDecoder::MapDecoder(const msgpack::object& obj)
+    : tile_size_(0), decode_tiles_(true) {
     init_from_msgpack_obj(obj);
 }
 
-inline MapDecoder::MapDecoder(const std::map<std::string, msgpack::object>& map_in) {
+inline MapDecoder::MapDecoder(const std::map<std::string, msgpack::object>& map_in)
+    : tile_size_(0), decode_tiles_(true) {
     std::map<std::string, msgpack::object>::const_iterator it;
     for (it = map_in.begin(); it != map_in.end(); ++it) {
         data_map_[it->first] = &(it->second);
     }
+    initCheckpoints_();
+    initTiles_();
 }
 
 inline void MapDecoder::initFromObject(const msgpack::object& obj) {
     data_map_.clear();
     decoded_keys_.clear();
+    checkpoints_.clear();
+    tiles_.clear();
+    tile_size_ = 0;
     init_from_msgpack_obj(obj);
 }
 
-inline void MapDecoder::initFromBuffer(const char* buffer, std::size_t size) {
-    msgpack::unpack(object_handle_, buffer, size);
+namespace {
+// msgpack callback to keep binaries and strings in the unpacked buffer
+inline bool referenceBuffer(msgpack::type::object_type, std::size_t, void*) {
+    return true;
+}
+} // anon ns
+
+inline void MapDecoder::initFromBuffer(const char* buffer, std::size_t size,
+                                       bool reference_buffer) {
+    if (reference_buffer) {
+        msgpack::unpack(object_handle_, buffer, size, referenceBuffer);
+    } else {
+        msgpack::unpack(object_handle_, buffer, size);
+    }
     initFromObject(object_handle_.get());
 }
 
@@ -193,18 +312,106 @@ inline void MapDecoder::decode(const std::string& key, bool required, T& target)
         checkType_(key, it->second->type, target);
         if (it->second->type == msgpack::type::BIN) {
             BinaryDecoder bd(*it->second, key);
-            bd.decode(target);
+            const std::vector<BinarySeekPoint>* checkpoints =
+                getCheckpoints(key);
+            if (checkpoints) bd.decode(*checkpoints, target);
+            else             bd.decode(target);
         } else {
             it->second->convert(target);
         }
         decoded_keys_.insert(key);
     }
+    else if (tiles_.find(key) != tiles_.end()) {
+        if (decode_tiles_) decodeTiles_(key, target);
+        decoded_keys_.insert(key);
+    }
+    else if (required) {
+        throw DecodeError("MsgPack MAP does not contain required entry "
+                          + key);
+    }
+}
+
+// packed strings: binaries are copied, arrays of strings are packed with
+// width of longest string
+template<>
+inline void MapDecoder::decode(const std::string& key, bool required,
+                               FixedWidthStringList& target) const {
+    data_map_type_::const_iterator it = data_map_.find(key);
+    if (it != data_map_.end()) {
+        if (it->second->type == msgpack::type::BIN) {
+            BinaryDecoder bd(*it->second, key);
+            bd.decode(target);
+        } else {
+            std::vector<std::string> strings;
+            checkType_(key, it->second->type, strings);
+            it->second->convert(strings);
+            size_t width = 0;
+            for (size_t i = 0; i < strings.size(); ++i) {
+                width = std::max(width, strings[i].size());
+            }
+            target = FixedWidthStringList(strings, int32_t(width));
+        }
+        decoded_keys_.insert(key);
+    }
     else if (required) {
         throw DecodeError("MsgPack MAP does not contain required entry "
                           + key);
     }
 }
 
+inline const msgpack::object*
+MapDecoder::getObject(const std::string& key) const {
+    data_map_type_::const_iterator it = data_map_.find(key);
+    if (it == data_map_.end()) return NULL;
+    return it->second;
+}
+
+inline void MapDecoder::markDecoded(const std::string& key) const {
+    if (data_map_.find(key) != data_map_.end()) decoded_keys_.insert(key);
+}
+
+inline const std::vector<const msgpack::object*>*
+MapDecoder::getTiles(const std::string& key) const {
+    tiles_type_::const_iterator it = tiles_.find(key);
+    if (it == tiles_.end()) return NULL;
+    return &it->second;
+}
+
+template<typename T>
+void MapDecoder::decodeTiledRange(const std::string& key, int32_t begin,
+                                  int32_t end, std::vector<T>& target) const {
+    const std::vector<const msgpack::object*>* tiles = getTiles(key);
+    if (!tiles) throw DecodeError("Entry " + key + " is not tiled");
+    const int32_t length =
+        tiles->empty() ? 0 : int32_t(tiles->size() - 1) * tile_size_
+                             + tileLength_(key, tiles->size() - 1);
+    if (begin < 0 || begin > end || end > length) {
+        std::stringstream err;
+        err << "Invalid range [" << begin << ", " << end << ") for tiled "
+            << "entry '" << key << "' of length " << length;
+        throw DecodeError(err.str());
+    }
+    std::vector<T> values;
+    values.reserve(end - begin);
+    std::vector<T> chunk;
+    for (int32_t t = begin / tile_size_; t * tile_size_ < end; ++t) {
+        const int32_t tile_begin = t * tile_size_;
+        const int32_t tile_end = tile_begin + tileLength_(key, t);
+        BinaryDecoder bd(*(*tiles)[t], key);
+        bd.decodeRange(std::max(begin, tile_begin) - tile_begin,
+                       std::min(end, tile_end) - tile_begin, chunk);
+        values.insert(values.end(), chunk.begin(), chunk.end());
+    }
+    target.swap(values);
+}
+
+inline const std::vector<BinarySeekPoint>*
+MapDecoder::getCheckpoints(const std::string& key) const {
+    checkpoints_type_::const_iterator it = checkpoints_.find(key);
+    if (it == checkpoints_.end()) return NULL;
+    return &it->second;
+}
+
 
 inline void MapDecoder::checkExtraKeys() const {
     // note: cost of O(N*log(M))) string comparisons (M parsed, N in map)
@@ -239,6 +446,150 @@ inline void MapDecoder::init_from_msgpack_obj(const msgpack::object& obj) {
                       << "! Skipping..." << std::endl;
         }
     }
+    initCheckpoints_();
+    initTiles_();
+}
+
+inline const msgpack::object*
+MapDecoder::getExtraProperty_(const std::string& key) const {
+    data_map_type_::const_iterator it = data_map_.find("extraProperties");
+    if (it == data_map_.end() || it->second->type != msgpack::type::MAP) {
+        return NULL;
+    }
+    const msgpack::object_map& extra = it->second->via.map;
+    for (uint32_t i = 0; i < extra.size; ++i) {
+        const msgpack::object& name = extra.ptr[i].key;
+        if (   name.type == msgpack::type::STR
+            && std::string(name.via.str.ptr, name.via.str.size) == key) {
+            return &extra.ptr[i].val;
+        }
+    }
+    return NULL;
+}
+
+inline void MapDecoder::initCheckpoints_() {
+    // checkpoints are only an optimization: malformed entries are ignored
+    const msgpack::object* table = getExtraProperty_(CHECKPOINTS_KEY);
+    if (!table || table->type != msgpack::type::MAP) return;
+    for (uint32_t j = 0; j < table->via.map.size; ++j) {
+        const msgpack::object& field = table->via.map.ptr[j].key;
+        const msgpack::object& val = table->via.map.ptr[j].val;
+        if (   field.type != msgpack::type::STR
+            || val.type != msgpack::type::BIN) {
+            continue;
+        }
+        const std::string name(field.via.str.ptr, field.via.str.size);
+        // flat (index, offset, skip, value) quadruples
+        std::vector<int32_t> flat;
+        try {
+            BinaryDecoder(val, name).decode(flat);
+        } catch (DecodeError&) {
+            continue;
+        }
+        if (flat.size() % 4 != 0) continue;
+        std::vector<BinarySeekPoint>& points = checkpoints_[name];
+        points.resize(flat.size() / 4);
+        for (size_t k = 0; k < points.size(); ++k) {
+            points[k].index = flat[4 * k];
+            points[k].offset = uint32_t(flat[4 * k + 1]);
+            points[k].skip = flat[4 * k + 2];
+            points[k].value = flat[4 * k + 3];
+        }
+    }
+}
+
+inline void MapDecoder::initTiles_() {
+    const msgpack::object* found = getExtraProperty_(TILES_KEY);
+    if (!found) return;
+    // layout: {"tileSize": int, "columns": {name: [bin, bin, ...]}}
+    const msgpack::object* tile_size = NULL;
+    const msgpack::object* columns = NULL;
+    if (found->type == msgpack::type::MAP) {
+        for (uint32_t i = 0; i < found->via.map.size; ++i) {
+            const msgpack::object& key = found->via.map.ptr[i].key;
+            if (key.type != msgpack::type::STR) continue;
+            const std::string name(key.via.str.ptr, key.via.str.size);
+            if (name == "tileSize") tile_size = &found->via.map.ptr[i].val;
+            else if (name == "columns") columns = &found->via.map.ptr[i].val;
+        }
+    }
+    if (   !tile_size || tile_size->type != msgpack::type::POSITIVE_INTEGER
+        || tile_size->via.u64 == 0 || tile_size->via.u64 > 0x7fffffff
+        || !columns || columns->type != msgpack::type::MAP) {
+        throw DecodeError("Invalid tiles in extraProperties");
+    }
+    tile_size_ = int32_t(tile_size->via.u64);
+    for (uint32_t i = 0; i < columns->via.map.size; ++i) {
+        const msgpack::object& key = columns->via.map.ptr[i].key;
+        const msgpack::object& val = columns->via.map.ptr[i].val;
+        if (   key.type != msgpack::type::STR
+            || val.type != msgpack::type::ARRAY) {
+            throw DecodeError("Invalid tiles in extraProperties");
+        }
+        const std::string name(key.via.str.ptr, key.via.str.size);
+        std::vector<const msgpack::object*>& tiles = tiles_[name];
+        tiles.resize(val.via.array.size);
+        for (uint32_t j = 0; j < val.via.array.size; ++j) {
+            tiles[j] = &val.via.array.ptr[j];
+            // all but the last tile are full, the last one is not empty
+            const int32_t length = tileLength_(name, j);
+            const bool last = (j + 1 == val.via.array.size);
+            if (   (!last && length != tile_size_)
+                || (last && (length < 1 || length > tile_size_))) {
+                std::stringstream err;
+                err << "Invalid length " << length << " of tile " << j
+                    << " for entry '" << name << "'";
+                throw DecodeError(err.str());
+            }
+        }
+    }
+}
+
+inline int32_t MapDecoder::tileLength_(const std::string& key,
+                                       size_t tile) const {
+    const msgpack::object& obj = *tiles_.find(key)->second[tile];
+    if (obj.type != msgpack::type::BIN) {
+        throw DecodeError("Tiles of entry '" + key + "' must be binaries");
+    }
+    return BinaryDecoder(obj, key).length();
+}
+
+template<typename T>
+void MapDecoder::decodeTiles_(const std::string& key,
+                              std::vector<T>& target) const {
+    const std::vector<const msgpack::object*>& tiles = tiles_.find(key)->second;
+    const int32_t num_tiles = int32_t(tiles.size());
+    std::vector<char> valid(num_tiles, 0);
+    target.resize(num_tiles == 0 ? 0 : (num_tiles - 1) * tile_size_
+                                       + tileLength_(key, num_tiles - 1));
+    // tiles are independent (no exceptions may leave the parallel region)
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int32_t i = 0; i < num_tiles; ++i) {
+        std::vector<T> chunk;
+        try {
+            BinaryDecoder(*tiles[i], key).decode(chunk);
+        } catch (DecodeError&) {
+            continue;
+        }
+        std::copy(chunk.begin(), chunk.end(), target.begin() + i * tile_size_);
+        valid[i] = 1;
+    }
+    std::vector<char>::const_iterator it = std::find(valid.begin(),
+                                                     valid.end(), 0);
+    if (it != valid.end()) {
+        // redo serially to report actual error
+        std::vector<T> chunk;
+        BinaryDecoder(*tiles[it - valid.begin()], key).decode(chunk);
+        throw DecodeError("Failed to decode tiles of entry '" + key + "'");
+    }
+}
+
+template<typename T>
+void MapDecoder::decodeTiles_(const std::string& key, T&) const {
+    throw DecodeError("Tiled entry '" + key + "' must be decoded into a "
+                      "vector");
 }
 
 inline void MapDecoder::checkType_(const std::string& key,
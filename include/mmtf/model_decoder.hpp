@@ -0,0 +1,456 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Random access to single models of an MMTF file without decoding all of it.
+// See "tests/mmtf_tests.cpp" (Test ModelDecoder) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_MODEL_DECODER_H
+#define MMTF_MODEL_DECODER_H
+
+#include "structure_data.hpp"
+#include "binary_decoder.hpp"
+#include "map_decoder.hpp"
+#include "decoder.hpp"
+#include "errors.hpp"
+
+#include <msgpack.hpp>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mmtf {
+
+/**
+ * @brief Decoder for single models of an MMTF file.
+ *
+ * On initialization, model independent fields and the hierarchy
+ * (chainsPerModel, groupsPerChain, groupTypeList) are decoded and the chain,
+ * group and atom ranges of every model are computed. Each binary per-chain,
+ * per-group and per-atom field is scanned once (without materializing values,
+ * starting from checkpoints stored with mmtf::encodeCheckpoints if available)
+ * to find the position where each model starts. Afterwards,
+ * ModelDecoder::decodeModel only decodes the values of the requested model.
+ *
+ * decodeModel can be called concurrently. The class cannot be copied as it
+ * contains a MapDecoder.
+ */
+class ModelDecoder {
+public:
+    /**
+     * @brief Construct empty decoder. Use init-functions to fill it.
+     */
+    ModelDecoder() {}
+
+    /**
+     * @brief Construct decoder from byte buffer (see ::initFromBuffer).
+     */
+    ModelDecoder(const char* buffer, std::size_t size);
+
+    /**
+     * @brief Initialize from MMTF file contents.
+     * @param[in]  buffer File contents
+     * @param[in]  size   Size of buffer
+     * @throw mmtf::DecodeError if an error occured
+     */
+    void initFromBuffer(const char* buffer, std::size_t size);
+
+    /**
+     * @brief Initialize from an existing MMTF file.
+     * @param[in]  filename Path to file to load
+     * @throw mmtf::DecodeError if an error occured
+     */
+    void initFromFile(const std::string& filename);
+
+    /**
+     * @brief Number of models in the file.
+     */
+    int32_t numModels() const {
+        return int32_t(chainsPerModel_.size());
+    }
+
+    /**
+     * @brief Decode a single model.
+     *
+     * The result is a consistent single model structure: model independent
+     * fields are as in the file, bonds and chain indices of entities and
+     * bioassemblies are restricted to the model and renumbered. The per-item
+     * property maps (bondProperties, atomProperties, ...) are not decoded
+     * since they cannot be sliced generically.
+     *
+     * @param[out] data         MMTF data structure to be filled
+     * @param[in]  model_index  Index of model to decode
+     * @throw mmtf::DecodeError if model_index is invalid or an error occured
+     */
+    void decodeModel(StructureData& data, int32_t model_index) const;
+
+private:
+    MapDecoder md_;
+    // model independent fields (hierarchy and bonds kept separately)
+    StructureData header_;
+    std::vector<int32_t> chainsPerModel_;
+    std::vector<int32_t> groupsPerChain_;
+    std::vector<int32_t> groupTypeList_;
+    std::vector<int32_t> bondAtomList_;
+    std::vector<int8_t> bondOrderList_;
+    std::vector<int8_t> bondResonanceList_;
+    // model -> first chain / group / atom (size numModels + 1)
+    std::vector<int32_t> chainOffsets_;
+    std::vector<int32_t> groupOffsets_;
+    std::vector<int32_t> atomOffsets_;
+    // binary field -> seek point of each model (empty if binary is empty)
+    typedef std::map<std::string, std::vector<BinarySeekPoint> > seek_map_;
+    seek_map_ seekPoints_;
+
+    void init_();
+    void findSeekPoints_(const std::string& key,
+                         const std::vector<int32_t>& offsets);
+    template<typename T>
+    void decodeSlice_(const std::string& key, bool required,
+                      const std::vector<int32_t>& offsets,
+                      int32_t model_index, T& target) const;
+};
+
+/**
+ * @brief Decode a single model of an MMTF file from a byte buffer.
+ * @param[out] data         MMTF data structure to be filled
+ * @param[in]  buffer       File contents
+ * @param[in]  size         Size of buffer
+ * @param[in]  model_index  Index of model to decode
+ * @throw mmtf::DecodeError if an error occured
+ *
+ * See ModelDecoder::decodeModel for details. Use ModelDecoder directly to
+ * decode several models of the same file.
+ */
+inline void decodeModelFromBuffer(StructureData& data, const char* buffer,
+                                  std::size_t size, int32_t model_index);
+
+/**
+ * @brief Decode a single model of an existing MMTF file.
+ * @param[out] data         MMTF data structure to be filled
+ * @param[in]  filename     Path to file to load
+ * @param[in]  model_index  Index of model to decode
+ * @throw mmtf::DecodeError if an error occured
+ */
+inline void decodeModelFromFile(StructureData& data,
+                                const std::string& filename,
+                                int32_t model_index);
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+namespace {
+
+// keep chain indices in [begin, end) and make them relative to begin
+inline void selectChainIndices(std::vector<int32_t>& chain_indices,
+                               int32_t begin, int32_t end) {
+    size_t num = 0;
+    for (size_t i = 0; i < chain_indices.size(); ++i) {
+        const int32_t chain = chain_indices[i];
+        if (chain >= begin && chain < end) chain_indices[num++] = chain - begin;
+    }
+    chain_indices.resize(num);
+}
+
+} // anon ns
+
+inline ModelDecoder::ModelDecoder(const char* buffer, std::size_t size) {
+    initFromBuffer(buffer, size);
+}
+
+inline void ModelDecoder::initFromBuffer(const char* buffer,
+                                         std::size_t size) {
+    mapDecoderFromBuffer(md_, buffer, size);
+    init_();
+}
+
+inline void ModelDecoder::initFromFile(const std::string& filename) {
+    mapDecoderFromFile(md_, filename);
+    init_();
+}
+
+inline void ModelDecoder::decodeModel(StructureData& data,
+                                      int32_t model_index) const {
+    if (model_index < 0 || model_index >= numModels()) {
+        std::stringstream err;
+        err << "Invalid model index " << model_index << " for file with "
+            << numModels() << " models";
+        throw DecodeError(err.str());
+    }
+    const int32_t chain_begin = chainOffsets_[model_index];
+    const int32_t chain_end = chainOffsets_[model_index + 1];
+    const int32_t group_begin = groupOffsets_[model_index];
+    const int32_t group_end = groupOffsets_[model_index + 1];
+    const int32_t atom_begin = atomOffsets_[model_index];
+    const int32_t atom_end = atomOffsets_[model_index + 1];
+
+    data = header_;
+    data.numModels = 1;
+    data.numChains = chain_end - chain_begin;
+    data.numGroups = group_end - group_begin;
+    data.numAtoms = atom_end - atom_begin;
+    data.chainsPerModel.assign(1, data.numChains);
+    data.groupsPerChain.assign(groupsPerChain_.begin() + chain_begin,
+                               groupsPerChain_.begin() + chain_end);
+    data.groupTypeList.assign(groupTypeList_.begin() + group_begin,
+                              groupTypeList_.begin() + group_end);
+
+    // bonds within the model
+    const bool has_orders = (bondOrderList_.size() * 2 == bondAtomList_.size());
+    const bool has_resonance =
+        (bondResonanceList_.size() * 2 == bondAtomList_.size());
+    int32_t num_bonds = 0;
+    for (size_t i = 0; i < bondAtomList_.size(); i += 2) {
+        const int32_t a = bondAtomList_[i];
+        const int32_t b = bondAtomList_[i + 1];
+        if (a < atom_begin || a >= atom_end || b < atom_begin
+            || b >= atom_end) {
+            continue;
+        }
+        data.bondAtomList.push_back(a - atom_begin);
+        data.bondAtomList.push_back(b - atom_begin);
+        if (has_orders) data.bondOrderList.push_back(bondOrderList_[i / 2]);
+        if (has_resonance) {
+            data.bondResonanceList.push_back(bondResonanceList_[i / 2]);
+        }
+        ++num_bonds;
+    }
+    for (size_t g = 0; g < data.groupTypeList.size(); ++g) {
+        const GroupType& group = header_.groupList[data.groupTypeList[g]];
+        num_bonds += int32_t(group.bondAtomList.size() / 2);
+    }
+    data.numBonds = num_bonds;
+
+    // chains referenced by entities and bioassemblies
+    for (size_t i = 0; i < data.entityList.size(); ++i) {
+        selectChainIndices(data.entityList[i].chainIndexList, chain_begin,
+                           chain_end);
+    }
+    for (size_t i = 0; i < data.bioAssemblyList.size(); ++i) {
+        std::vector<Transform>& transforms =
+            data.bioAssemblyList[i].transformList;
+        for (size_t j = 0; j < transforms.size(); ++j) {
+            selectChainIndices(transforms[j].chainIndexList, chain_begin,
+                               chain_end);
+        }
+    }
+
+    // per-item fields
+    decodeSlice_("xCoordList", true, atomOffsets_, model_index,
+                 data.xCoordList);
+    decodeSlice_("yCoordList", true, atomOffsets_, model_index,
+                 data.yCoordList);
+    decodeSlice_("zCoordList", true, atomOffsets_, model_index,
+                 data.zCoordList);
+    decodeSlice_("bFactorList", false, atomOffsets_, model_index,
+                 data.bFactorList);
+    decodeSlice_("atomIdList", false, atomOffsets_, model_index,
+                 data.atomIdList);
+    decodeSlice_("altLocList", false, atomOffsets_, model_index,
+                 data.altLocList);
+    decodeSlice_("occupancyList", false, atomOffsets_, model_index,
+                 data.occupancyList);
+    decodeSlice_("groupIdList", true, groupOffsets_, model_index,
+                 data.groupIdList);
+    decodeSlice_("secStructList", false, groupOffsets_, model_index,
+                 data.secStructList);
+    decodeSlice_("insCodeList", false, groupOffsets_, model_index,
+                 data.insCodeList);
+    decodeSlice_("sequenceIndexList", false, groupOffsets_, model_index,
+                 data.sequenceIndexList);
+    decodeSlice_("chainIdList", true, chainOffsets_, model_index,
+                 data.chainIdList);
+    decodeSlice_("chainNameList", false, chainOffsets_, model_index,
+                 data.chainNameList);
+}
+
+inline void ModelDecoder::init_() {
+    header_ = StructureData();
+    seekPoints_.clear();
+    StructureData& data = header_;
+    md_.decode("mmtfVersion", true, data.mmtfVersion);
+    if (!mmtf::isVersionSupported(data.mmtfVersion)) {
+        throw mmtf::DecodeError("Unsupported MMTF version "
+                                + data.mmtfVersion);
+    }
+    md_.decode("mmtfProducer", true, data.mmtfProducer);
+    md_.decode("unitCell", false, data.unitCell);
+    md_.decode("spaceGroup", false, data.spaceGroup);
+    md_.decode("structureId", false, data.structureId);
+    md_.decode("title", false, data.title);
+    md_.decode("depositionDate", false, data.depositionDate);
+    md_.decode("releaseDate", false, data.releaseDate);
+    md_.decode("ncsOperatorList", false, data.ncsOperatorList);
+    md_.decode("bioAssemblyList", false, data.bioAssemblyList);
+    md_.decode("entityList", false, data.entityList);
+    md_.decode("experimentalMethods", false, data.experimentalMethods);
+    md_.decode("resolution", false, data.resolution);
+    md_.decode("rFree", false, data.rFree);
+    md_.decode("rWork", false, data.rWork);
+    md_.decode("groupList", true, data.groupList);
+    impl::copyExtraProperties(md_, data);
+    md_.decode("bondAtomList", false, bondAtomList_);
+    md_.decode("bondOrderList", false, bondOrderList_);
+    md_.decode("bondResonanceList", false, bondResonanceList_);
+    md_.decode("groupTypeList", true, groupTypeList_);
+    md_.decode("groupsPerChain", true, groupsPerChain_);
+    md_.decode("chainsPerModel", true, chainsPerModel_);
+    if (bondAtomList_.size() % 2 != 0) {
+        throw DecodeError("Odd number of entries in bondAtomList");
+    }
+
+    // ranges of models
+    const int32_t num_models = numModels();
+    chainOffsets_.resize(num_models + 1);
+    groupOffsets_.resize(num_models + 1);
+    atomOffsets_.resize(num_models + 1);
+    const int32_t num_chains = int32_t(groupsPerChain_.size());
+    const int32_t num_groups = int32_t(groupTypeList_.size());
+    const int32_t num_types = int32_t(header_.groupList.size());
+    int32_t chain = 0;
+    int32_t group = 0;
+    int32_t atom = 0;
+    for (int32_t m = 0; m < num_models; ++m) {
+        chainOffsets_[m] = chain;
+        groupOffsets_[m] = group;
+        atomOffsets_[m] = atom;
+        const int32_t chain_end = chain + chainsPerModel_[m];
+        if (chainsPerModel_[m] < 0 || chain_end > num_chains) {
+            throw DecodeError("Inconsistent chainsPerModel");
+        }
+        for (; chain < chain_end; ++chain) {
+            const int32_t group_end = group + groupsPerChain_[chain];
+            if (groupsPerChain_[chain] < 0 || group_end > num_groups) {
+                throw DecodeError("Inconsistent groupsPerChain");
+            }
+            for (; group < group_end; ++group) {
+                const int32_t type = groupTypeList_[group];
+                if (type < 0 || type >= num_types) {
+                    throw DecodeError("Invalid entry in groupTypeList");
+                }
+                atom += int32_t(header_.groupList[type].atomNameList.size());
+            }
+        }
+    }
+    chainOffsets_[num_models] = chain;
+    groupOffsets_[num_models] = group;
+    atomOffsets_[num_models] = atom;
+    if (chain != num_chains || group != num_groups) {
+        throw DecodeError("Inconsistent model/chain/group hierarchy");
+    }
+
+    // one scan per binary field
+    findSeekPoints_("xCoordList", atomOffsets_);
+    findSeekPoints_("yCoordList", atomOffsets_);
+    findSeekPoints_("zCoordList", atomOffsets_);
+    findSeekPoints_("bFactorList", atomOffsets_);
+    findSeekPoints_("atomIdList", atomOffsets_);
+    findSeekPoints_("altLocList", atomOffsets_);
+    findSeekPoints_("occupancyList", atomOffsets_);
+    findSeekPoints_("groupIdList", groupOffsets_);
+    findSeekPoints_("secStructList", groupOffsets_);
+    findSeekPoints_("insCodeList", groupOffsets_);
+    findSeekPoints_("sequenceIndexList", groupOffsets_);
+    findSeekPoints_("chainIdList", chainOffsets_);
+    findSeekPoints_("chainNameList", chainOffsets_);
+}
+
+inline void ModelDecoder::findSeekPoints_(const std::string& key,
+                                          const std::vector<int32_t>& offsets) {
+    const msgpack::object* obj = md_.getObject(key);
+    if (!obj || obj->type != msgpack::type::BIN) return;
+    BinaryDecoder bd(*obj, key);
+    std::vector<BinarySeekPoint>& points = seekPoints_[key];
+    // empty binary = unset optional field
+    if (bd.length() == 0) return;
+    if (bd.length() != offsets.back()) {
+        std::stringstream err;
+        err << "Length mismatch for binary '" << key << "': "
+            << bd.length() << " vs " << offsets.back();
+        throw DecodeError(err.str());
+    }
+    // stale checkpoints are ignored (they are only an optimization)
+    const std::vector<BinarySeekPoint>* checkpoints = md_.getCheckpoints(key);
+    if (   !checkpoints || !bd.needsScan()
+        || !bd.matchesCheckpoints(*checkpoints)) {
+        bd.findSeekPoints(offsets, points);
+        return;
+    }
+    // scan from last checkpoint before each model
+    points.resize(offsets.size());
+    std::vector<BinarySeekPoint>::const_iterator it = checkpoints->begin();
+    BinarySeekPoint from;
+    for (size_t m = 0; m < offsets.size(); ++m) {
+        while (it != checkpoints->end() && it->index <= offsets[m]) {
+            if (it->index >= from.index) from = *it;
+            ++it;
+        }
+        points[m] = bd.seek(from, offsets[m]);
+        from = points[m];
+    }
+}
+
+template<typename T>
+void ModelDecoder::decodeSlice_(const std::string& key, bool required,
+                                const std::vector<int32_t>& offsets,
+                                int32_t model_index, T& target) const {
+    target.clear();
+    const msgpack::object* obj = md_.getObject(key);
+    if (!obj && md_.getTiles(key)) {
+        // tiled per-atom field: only decode overlapping tiles
+        md_.decodeTiledRange(key, offsets[model_index],
+                             offsets[model_index + 1], target);
+        return;
+    }
+    if (!obj) {
+        if (required) {
+            throw DecodeError("MsgPack MAP does not contain required entry "
+                              + key);
+        }
+        return;
+    }
+    const int32_t begin = offsets[model_index];
+    const int32_t end = offsets[model_index + 1];
+    if (obj->type == msgpack::type::BIN) {
+        const std::vector<BinarySeekPoint>& points =
+            seekPoints_.find(key)->second;
+        if (points.empty()) return;
+        BinaryDecoder bd(*obj, key);
+        bd.decodeRange(points[model_index], end, target);
+    } else {
+        T all;
+        obj->convert(all);
+        if (all.empty()) return;
+        if (all.size() != size_t(offsets.back())) {
+            std::stringstream err;
+            err << "Length mismatch for entry '" << key << "': "
+                << all.size() << " vs " << offsets.back();
+            throw DecodeError(err.str());
+        }
+        target.assign(all.begin() + begin, all.begin() + end);
+    }
+}
+
+inline void decodeModelFromBuffer(StructureData& data, const char* buffer,
+                                  std::size_t size, int32_t model_index) {
+    ModelDecoder decoder(buffer, size);
+    decoder.decodeModel(data, model_index);
+}
+
+inline void decodeModelFromFile(StructureData& data,
+                                const std::string& filename,
+                                int32_t model_index) {
+    ModelDecoder decoder;
+    decoder.initFromFile(filename);
+    decoder.decodeModel(data, model_index);
+}
+
+} // mmtf namespace
+
+#endif
@@ -0,0 +1,40 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Layout helpers shared by model delta encoding and decoding (strategy 100).
+//
+// *************************************************************************
+
+#ifndef MMTF_MODEL_DELTA_H
+#define MMTF_MODEL_DELTA_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace mmtf {
+
+/**
+ * @brief Check if model is encoded independently in model delta encoding.
+ * @param[in] model_index       index of model
+ * @param[in] model_sizes       number of values per model
+ * @param[in] keyframe_interval every keyframe_interval-th model is a keyframe
+ *                              (must be positive)
+ * @return                      true if model is not delta encoded to previous
+ *
+ * Used by both encodeModelDeltaFloat and BinaryDecoder so that they always
+ * agree on the keyframes.
+ */
+inline bool isModelDeltaKeyframe(std::size_t model_index,
+                                 std::vector<int32_t> const & model_sizes,
+                                 int32_t keyframe_interval) {
+  return model_index % keyframe_interval == 0
+      || model_sizes[model_index] != model_sizes[model_index - 1];
+}
+
+} // mmtf namespace
+
+#endif
@@ -16,6 +16,7 @@
 
 #include "structure_data.hpp"
 #include "map_decoder.hpp"
+#include "statistics.hpp"
 #include "errors.hpp"
 
 #include <msgpack.hpp>
@@ -23,8 +24,54 @@
 // custom global function used here and in decoder.hpp
 namespace mmtf {
 namespace impl {
-inline void decodeFromMapDecoder(StructureData& data, MapDecoder& md) {
-    md.decode("mmtfVersion", true, data.mmtfVersion);
+template <typename Stats, typename T>
+inline void decodeField(const MapDecoder& md, const char* key, bool required,
+                        T& target, FieldRecorder<Stats>& rec) {
+    rec.start();
+    md.decode(key, required, target);
+    rec.stop(md, key);
+}
+
+template <typename Stats>
+inline void copyDecodeField(const MapDecoder& md, const char* key,
+                            bool required,
+                            std::map<std::string, msgpack::object>& target,
+                            msgpack::zone& zone, FieldRecorder<Stats>& rec) {
+    rec.start();
+    md.copy_decode(key, required, target, zone);
+    rec.stop(md, key);
+}
+
+// copy extraProperties without the library-specific checkpoints and tiles
+// (tiles can be huge and only refer to the encoded binaries)
+inline void copyExtraProperties(const MapDecoder& md, StructureData& data) {
+    const msgpack::object* obj = md.getObject("extraProperties");
+    if (!obj || obj->type != msgpack::type::MAP) {
+        md.copy_decode("extraProperties", false, data.extraProperties,
+                       data.msgpack_zone);
+        return;
+    }
+    md.markDecoded("extraProperties");
+    data.extraProperties.clear();
+    for (uint32_t i = 0; i < obj->via.map.size; ++i) {
+        const msgpack::object& key = obj->via.map.ptr[i].key;
+        if (key.type != msgpack::type::STR) {
+            std::cerr << "Warning: Found non-string key type " << key.type
+                      << " in extraProperties! Skipping..." << std::endl;
+            continue;
+        }
+        const std::string name(key.via.str.ptr, key.via.str.size);
+        if (name == CHECKPOINTS_KEY || name == TILES_KEY) continue;
+        data.extraProperties[name] = msgpack::object(obj->via.map.ptr[i].val,
+                                                     data.msgpack_zone);
+    }
+}
+
+template <typename Stats>
+inline void decodeFromMapDecoder(StructureData& data, MapDecoder& md,
+                                 Stats& stats, bool copy_properties) {
+    FieldRecorder<Stats> rec(stats);
+    decodeField(md, "mmtfVersion", true, data.mmtfVersion, rec);
 
     // check if version is compatible before continuing
     if (!mmtf::isVersionSupported(data.mmtfVersion)) {
@@ -32,62 +79,81 @@ inline void decodeFromMapDecoder(StructureData& data, MapDecoder& md) {
                                 + data.mmtfVersion);
     }
 
-    md.decode("mmtfProducer", true, data.mmtfProducer);
-    md.decode("unitCell", false, data.unitCell);
-    md.decode("spaceGroup", false, data.spaceGroup);
-    md.decode("structureId", false, data.structureId);
-    md.decode("title", false, data.title);
-    md.decode("depositionDate", false, data.depositionDate);
-    md.decode("releaseDate", false, data.releaseDate);
-    md.decode("ncsOperatorList", false, data.ncsOperatorList);
-    md.decode("bioAssemblyList", false, data.bioAssemblyList);
-    md.decode("entityList", false, data.entityList);
-    md.decode("experimentalMethods", false, data.experimentalMethods);
-    md.decode("resolution", false, data.resolution);
-    md.decode("rFree", false, data.rFree);
-    md.decode("rWork", false, data.rWork);
-    md.decode("numBonds", true, data.numBonds);
-    md.decode("numAtoms", true, data.numAtoms);
-    md.decode("numGroups", true, data.numGroups);
-    md.decode("numChains", true, data.numChains);
-    md.decode("numModels", true, data.numModels);
-    md.decode("groupList", true, data.groupList);
-    md.decode("bondAtomList", false, data.bondAtomList);
-    md.decode("bondOrderList", false, data.bondOrderList);
-    md.decode("bondResonanceList", false, data.bondResonanceList);
-    md.decode("xCoordList", true, data.xCoordList);
-    md.decode("yCoordList", true, data.yCoordList);
-    md.decode("zCoordList", true, data.zCoordList);
-    md.decode("bFactorList", false, data.bFactorList);
-    md.decode("atomIdList", false, data.atomIdList);
-    md.decode("altLocList", false, data.altLocList);
-    md.decode("occupancyList", false, data.occupancyList);
-    md.decode("groupIdList", true, data.groupIdList);
-    md.decode("groupTypeList", true, data.groupTypeList);
-    md.decode("secStructList", false, data.secStructList);
-    md.decode("insCodeList", false, data.insCodeList);
-    md.decode("sequenceIndexList", false, data.sequenceIndexList);
-    md.decode("chainIdList", true, data.chainIdList);
-    md.decode("chainNameList", false, data.chainNameList);
-    md.decode("groupsPerChain", true, data.groupsPerChain);
-    md.decode("chainsPerModel", true, data.chainsPerModel);
+    decodeField(md, "mmtfProducer", true, data.mmtfProducer, rec);
+    decodeField(md, "unitCell", false, data.unitCell, rec);
+    decodeField(md, "spaceGroup", false, data.spaceGroup, rec);
+    decodeField(md, "structureId", false, data.structureId, rec);
+    decodeField(md, "title", false, data.title, rec);
+    decodeField(md, "depositionDate", false, data.depositionDate, rec);
+    decodeField(md, "releaseDate", false, data.releaseDate, rec);
+    decodeField(md, "ncsOperatorList", false, data.ncsOperatorList, rec);
+    decodeField(md, "bioAssemblyList", false, data.bioAssemblyList, rec);
+    decodeField(md, "entityList", false, data.entityList, rec);
+    decodeField(md, "experimentalMethods", false, data.experimentalMethods,
+                rec);
+    decodeField(md, "resolution", false, data.resolution, rec);
+    decodeField(md, "rFree", false, data.rFree, rec);
+    decodeField(md, "rWork", false, data.rWork, rec);
+    decodeField(md, "numBonds", true, data.numBonds, rec);
+    decodeField(md, "numAtoms", true, data.numAtoms, rec);
+    decodeField(md, "numGroups", true, data.numGroups, rec);
+    decodeField(md, "numChains", true, data.numChains, rec);
+    decodeField(md, "numModels", true, data.numModels, rec);
+    decodeField(md, "groupList", true, data.groupList, rec);
+    decodeField(md, "bondAtomList", false, data.bondAtomList, rec);
+    decodeField(md, "bondOrderList", false, data.bondOrderList, rec);
+    decodeField(md, "bondResonanceList", false, data.bondResonanceList, rec);
+    decodeField(md, "xCoordList", true, data.xCoordList, rec);
+    decodeField(md, "yCoordList", true, data.yCoordList, rec);
+    decodeField(md, "zCoordList", true, data.zCoordList, rec);
+    decodeField(md, "bFactorList", false, data.bFactorList, rec);
+    decodeField(md, "atomIdList", false, data.atomIdList, rec);
+    decodeField(md, "altLocList", false, data.altLocList, rec);
+    decodeField(md, "occupancyList", false, data.occupancyList, rec);
+    decodeField(md, "groupIdList", true, data.groupIdList, rec);
+    decodeField(md, "groupTypeList", true, data.groupTypeList, rec);
+    decodeField(md, "secStructList", false, data.secStructList, rec);
+    decodeField(md, "insCodeList", false, data.insCodeList, rec);
+    decodeField(md, "sequenceIndexList", false, data.sequenceIndexList, rec);
+    decodeField(md, "chainIdList", true, data.chainIdList, rec);
+    decodeField(md, "chainNameList", false, data.chainNameList, rec);
+    decodeField(md, "groupsPerChain", true, data.groupsPerChain, rec);
+    decodeField(md, "chainsPerModel", true, data.chainsPerModel, rec);
     // extraProperties (application specific stuff)
     // Perform expensive copy if exists.
-    // Implement outside accessor if speed is necessary
-    md.copy_decode("bondProperties", false, data.bondProperties,
-                   data.msgpack_zone);
-    md.copy_decode("atomProperties", false, data.atomProperties,
-                   data.msgpack_zone);
-    md.copy_decode("groupProperties", false, data.groupProperties,
-                   data.msgpack_zone);
-    md.copy_decode("chainProperties", false, data.chainProperties,
-                   data.msgpack_zone);
-    md.copy_decode("modelProperties", false, data.modelProperties,
-                   data.msgpack_zone);
-    md.copy_decode("extraProperties", false, data.extraProperties,
-                   data.msgpack_zone);
+    // Use PropertyView (property_view.hpp) if speed is necessary
+    if (!copy_properties) {
+        static const char* const keys[] = {
+            "bondProperties", "atomProperties", "groupProperties",
+            "chainProperties", "modelProperties", "extraProperties"
+        };
+        for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+            md.markDecoded(keys[i]);
+        }
+        md.checkExtraKeys();
+        return;
+    }
+    copyDecodeField(md, "bondProperties", false, data.bondProperties,
+                    data.msgpack_zone, rec);
+    copyDecodeField(md, "atomProperties", false, data.atomProperties,
+                    data.msgpack_zone, rec);
+    copyDecodeField(md, "groupProperties", false, data.groupProperties,
+                    data.msgpack_zone, rec);
+    copyDecodeField(md, "chainProperties", false, data.chainProperties,
+                    data.msgpack_zone, rec);
+    copyDecodeField(md, "modelProperties", false, data.modelProperties,
+                    data.msgpack_zone, rec);
+    rec.start();
+    copyExtraProperties(md, data);
+    rec.stop(md, "extraProperties");
     md.checkExtraKeys();
 }
+
+inline void decodeFromMapDecoder(StructureData& data, MapDecoder& md,
+                                 bool copy_properties = true) {
+    NoStatistics stats;
+    decodeFromMapDecoder(data, md, stats, copy_properties);
+}
 }
 }
 
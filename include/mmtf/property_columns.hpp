@@ -0,0 +1,271 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Typed property columns (e.g. per-atom charges) stored as MMTF binaries.
+// See tests/mmtf_tests.cpp (Test property columns) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_PROPERTY_COLUMNS_H
+#define MMTF_PROPERTY_COLUMNS_H
+
+#include "structure_data.hpp"
+#include "binary_decoder.hpp"
+#include "binary_encoder.hpp"
+#include "errors.hpp"
+
+#include <msgpack.hpp>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mmtf {
+
+/**
+ * @brief Property map as used for StructureData::atomProperties and co.
+ */
+typedef std::map<std::string, msgpack::object> PropertyMap;
+
+/**
+ * @brief Store values as binary column in a property map.
+ *
+ * Values are encoded with ::encodeBinary and stored as msgpack binary on
+ * StructureData::msgpack_zone of data. Compared to plain msgpack arrays, this
+ * avoids the per-value msgpack overhead (e.g. 5 bytes per float) and lets
+ * readers decode the column with a BinaryDecoder.
+ *
+ * @param[in,out] data        Structure owning properties (for its zone)
+ * @param[in,out] properties  Property map of data (e.g. data.atomProperties)
+ * @param[in]     name        Name of column (replaced if it exists)
+ * @param[in]     values      Values to store
+ * @param[in]     strategy    Binary strategy (see ::encodeBinary)
+ * @param[in]     param       Multiplier for float strategies (>= 1 for
+ *                            strategies 9 to 13) and string length for
+ *                            strategy 5
+ * @throw mmtf::EncodeError if strategy cannot encode values of type T
+ *        (or if strings do not fit into param bytes).
+ */
+template <typename T>
+inline void setPropertyColumn(StructureData& data, PropertyMap& properties,
+                              const std::string& name,
+                              const std::vector<T>& values, int32_t strategy,
+                              int32_t param = 0);
+
+/**
+ * @brief Decode column of a property map.
+ *
+ * Binary columns are decoded with BinaryDecoder::decode (see there for
+ * supported types), other columns (e.g. plain msgpack arrays) are converted
+ * with msgpack.
+ *
+ * @return False (and values unchanged) if there is no such column.
+ * @throw mmtf::DecodeError if binary decoding fails.
+ */
+template <typename T>
+inline bool getPropertyColumn(const PropertyMap& properties,
+                              const std::string& name, std::vector<T>& values);
+
+/**
+ * @brief Store per-atom values as binary column in data.atomProperties.
+ *
+ * Same as ::setPropertyColumn but checks the number of values.
+ *
+ * @throw mmtf::EncodeError if values.size() != data.numAtoms or if strategy
+ *        cannot encode values of type T.
+ */
+template <typename T>
+inline void setAtomPropertyColumn(StructureData& data, const std::string& name,
+                                  const std::vector<T>& values,
+                                  int32_t strategy, int32_t param = 0);
+
+/**
+ * @brief Decode column of data.atomProperties (see ::getPropertyColumn).
+ */
+template <typename T>
+inline bool getAtomPropertyColumn(const StructureData& data,
+                                  const std::string& name,
+                                  std::vector<T>& values);
+
+/**
+ * @brief Same as ::setAtomPropertyColumn for bondProperties, groupProperties,
+ *        chainProperties and modelProperties (numBonds, numGroups, numChains
+ *        and numModels values).
+ */
+template <typename T>
+inline void setBondPropertyColumn(StructureData& data, const std::string& name,
+                                  const std::vector<T>& values,
+                                  int32_t strategy, int32_t param = 0);
+template <typename T>
+inline void setGroupPropertyColumn(StructureData& data,
+                                   const std::string& name,
+                                   const std::vector<T>& values,
+                                   int32_t strategy, int32_t param = 0);
+template <typename T>
+inline void setChainPropertyColumn(StructureData& data,
+                                   const std::string& name,
+                                   const std::vector<T>& values,
+                                   int32_t strategy, int32_t param = 0);
+template <typename T>
+inline void setModelPropertyColumn(StructureData& data,
+                                   const std::string& name,
+                                   const std::vector<T>& values,
+                                   int32_t strategy, int32_t param = 0);
+
+/**
+ * @brief Same as ::getAtomPropertyColumn for bondProperties, groupProperties,
+ *        chainProperties and modelProperties.
+ */
+template <typename T>
+inline bool getBondPropertyColumn(const StructureData& data,
+                                  const std::string& name,
+                                  std::vector<T>& values);
+template <typename T>
+inline bool getGroupPropertyColumn(const StructureData& data,
+                                   const std::string& name,
+                                   std::vector<T>& values);
+template <typename T>
+inline bool getChainPropertyColumn(const StructureData& data,
+                                   const std::string& name,
+                                   std::vector<T>& values);
+template <typename T>
+inline bool getModelPropertyColumn(const StructureData& data,
+                                   const std::string& name,
+                                   std::vector<T>& values);
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+namespace impl {
+
+template <typename T>
+inline void setSizedPropertyColumn(StructureData& data,
+                                   PropertyMap& properties,
+                                   const char* properties_name,
+                                   int32_t expected_size,
+                                   const std::string& name,
+                                   const std::vector<T>& values,
+                                   int32_t strategy, int32_t param) {
+    if (values.size() != size_t(expected_size)) {
+        std::stringstream err;
+        err << "Column " << name << " for " << properties_name << " has "
+            << values.size() << " values instead of " << expected_size;
+        throw EncodeError(err.str());
+    }
+    setPropertyColumn(data, properties, name, values, strategy, param);
+}
+
+} // impl namespace
+
+template <typename T>
+inline void setPropertyColumn(StructureData& data, PropertyMap& properties,
+                              const std::string& name,
+                              const std::vector<T>& values, int32_t strategy,
+                              int32_t param) {
+    // encode first so that a failed column leaves the map untouched
+    const std::vector<char> encoded = encodeBinary(values, strategy, param);
+    properties[name] = msgpack::object(encoded, data.msgpack_zone);
+}
+
+template <typename T>
+inline bool getPropertyColumn(const PropertyMap& properties,
+                              const std::string& name,
+                              std::vector<T>& values) {
+    PropertyMap::const_iterator it = properties.find(name);
+    if (it == properties.end()) return false;
+    if (it->second.type == msgpack::type::BIN) {
+        BinaryDecoder(it->second, name).decode(values);
+    } else {
+        it->second.convert(values);
+    }
+    return true;
+}
+
+template <typename T>
+inline void setAtomPropertyColumn(StructureData& data, const std::string& name,
+                                  const std::vector<T>& values,
+                                  int32_t strategy, int32_t param) {
+    impl::setSizedPropertyColumn(data, data.atomProperties, "atomProperties",
+                                 data.numAtoms, name, values, strategy, param);
+}
+
+template <typename T>
+inline bool getAtomPropertyColumn(const StructureData& data,
+                                  const std::string& name,
+                                  std::vector<T>& values) {
+    return getPropertyColumn(data.atomProperties, name, values);
+}
+
+template <typename T>
+inline void setBondPropertyColumn(StructureData& data, const std::string& name,
+                                  const std::vector<T>& values,
+                                  int32_t strategy, int32_t param) {
+    impl::setSizedPropertyColumn(data, data.bondProperties, "bondProperties",
+                                 data.numBonds, name, values, strategy, param);
+}
+
+template <typename T>
+inline void setGroupPropertyColumn(StructureData& data,
+                                   const std::string& name,
+                                   const std::vector<T>& values,
+                                   int32_t strategy, int32_t param) {
+    impl::setSizedPropertyColumn(data, data.groupProperties,
+                                 "groupProperties", data.numGroups, name,
+                                 values, strategy, param);
+}
+
+template <typename T>
+inline void setChainPropertyColumn(StructureData& data,
+                                   const std::string& name,
+                                   const std::vector<T>& values,
+                                   int32_t strategy, int32_t param) {
+    impl::setSizedPropertyColumn(data, data.chainProperties,
+                                 "chainProperties", data.numChains, name,
+                                 values, strategy, param);
+}
+
+template <typename T>
+inline void setModelPropertyColumn(StructureData& data,
+                                   const std::string& name,
+                                   const std::vector<T>& values,
+                                   int32_t strategy, int32_t param) {
+    impl::setSizedPropertyColumn(data, data.modelProperties,
+                                 "modelProperties", data.numModels, name,
+                                 values, strategy, param);
+}
+
+template <typename T>
+inline bool getBondPropertyColumn(const StructureData& data,
+                                  const std::string& name,
+                                  std::vector<T>& values) {
+    return getPropertyColumn(data.bondProperties, name, values);
+}
+
+template <typename T>
+inline bool getGroupPropertyColumn(const StructureData& data,
+                                   const std::string& name,
+                                   std::vector<T>& values) {
+    return getPropertyColumn(data.groupProperties, name, values);
+}
+
+template <typename T>
+inline bool getChainPropertyColumn(const StructureData& data,
+                                   const std::string& name,
+                                   std::vector<T>& values) {
+    return getPropertyColumn(data.chainProperties, name, values);
+}
+
+template <typename T>
+inline bool getModelPropertyColumn(const StructureData& data,
+                                   const std::string& name,
+                                   std::vector<T>& values) {
+    return getPropertyColumn(data.modelProperties, name, values);
+}
+
+} // mmtf namespace
+
+#endif
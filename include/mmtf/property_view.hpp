@@ -0,0 +1,266 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Zero-copy access to property maps (e.g. atomProperties) of a MapDecoder.
+// See tests/mmtf_tests.cpp (Test property views) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_PROPERTY_VIEW_H
+#define MMTF_PROPERTY_VIEW_H
+
+#include "binary_decoder.hpp"
+#include "map_decoder.hpp"
+#include "errors.hpp"
+
+#include <msgpack.hpp>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mmtf {
+
+/**
+ * @brief View of the columns of a property map (bondProperties,
+ *        atomProperties, groupProperties, chainProperties, modelProperties or
+ *        extraProperties) without copying them.
+ *
+ * decodeFromMapDecoder copies property maps into StructureData::msgpack_zone.
+ * A PropertyView instead points into the unpacked msgpack data of the
+ * MapDecoder (or msgpack::object) it was constructed from. Binary columns
+ * (e.g. encoded with mmtf::encodeFloat) are decoded on demand with a
+ * BinaryDecoder, other columns are converted with msgpack.
+ *
+ * Use decodeFromMapDecoder with copy_properties = false to skip the copies
+ * and access the properties with views instead.
+ *
+ * @warning The view is only valid while the MapDecoder (or the object) it was
+ *          constructed from exists.
+ */
+class PropertyView {
+public:
+    /** @brief Empty view. */
+    PropertyView() {}
+
+    /**
+     * @brief View of property map stored for key in md.
+     * @param[in]  md   MapDecoder holding raw mmtf data.
+     * @param[in]  key  Name of property map (e.g. "atomProperties").
+     * View is empty if key is missing in md.
+     * @throw mmtf::DecodeError if entry for key is not a map.
+     */
+    PropertyView(const MapDecoder& md, const std::string& key);
+
+    /**
+     * @brief View of given msgpack map.
+     * @param[in]  obj  Map from column names to values.
+     * @param[in]  key  Name of map used to report errors.
+     * @throw mmtf::DecodeError if obj is not a map.
+     */
+    explicit PropertyView(const msgpack::object& obj,
+                          const std::string& key = "UNNAMED_PROPERTIES");
+
+    /** @brief Number of columns. */
+    size_t size() const { return columns_.size(); }
+
+    /** @brief True if there are no columns. */
+    bool empty() const { return columns_.empty(); }
+
+    /** @brief True if there is a column with given name. */
+    bool has(const std::string& name) const {
+        return columns_.find(name) != columns_.end();
+    }
+
+    /** @brief Names of all columns (sorted). */
+    std::vector<std::string> names() const;
+
+    /**
+     * @brief Raw msgpack object of column or NULL if there is no such column.
+     */
+    const msgpack::object* getObject(const std::string& name) const;
+
+    /** @brief True if column exists and is an encoded binary. */
+    bool isBinary(const std::string& name) const;
+
+    /**
+     * @brief Number of values in column (binary length or array size).
+     * @return Number of values or -1 if column is missing or neither a binary
+     *         nor an array.
+     */
+    int32_t length(const std::string& name) const;
+
+    /**
+     * @brief Strategy of binary column or -1 if column is not a binary.
+     */
+    int32_t strategy(const std::string& name) const;
+
+    /**
+     * @brief BinaryDecoder for binary column.
+     *
+     * Use it to decode parts with BinaryDecoder::decodeRange. The decoder
+     * points into the same data as this view.
+     *
+     * @throw mmtf::DecodeError if column is missing or not a binary.
+     */
+    BinaryDecoder binary(const std::string& name) const;
+
+    /**
+     * @brief Decode column into target.
+     *
+     * Binary columns are decoded with BinaryDecoder::decode (see there for
+     * supported types), other columns are converted with msgpack.
+     *
+     * @return False (and target unchanged) if there is no such column.
+     * @throw mmtf::DecodeError if binary decoding fails.
+     */
+    template<typename T>
+    bool decode(const std::string& name, T& target) const;
+
+    /**
+     * @brief Decode values [begin, end) of column into target.
+     *
+     * Binary columns are decoded with BinaryDecoder::decodeRange, only the
+     * requested elements of arrays are converted.
+     *
+     * @return False (and target unchanged) if there is no such column.
+     * @throw mmtf::DecodeError if range is invalid, column is neither a binary
+     *        nor an array or if binary decoding fails.
+     */
+    template<typename T>
+    bool decodeRange(const std::string& name, int32_t begin, int32_t end,
+                     std::vector<T>& target) const;
+
+private:
+    typedef std::map<std::string, const msgpack::object*> columns_type_;
+    columns_type_ columns_;
+    std::string key_;
+
+    void init_(const msgpack::object& obj);
+    std::string columnKey_(const std::string& name) const {
+        return key_ + "." + name;
+    }
+};
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+inline PropertyView::PropertyView(const MapDecoder& md,
+                                  const std::string& key): key_(key) {
+    const msgpack::object* obj = md.getObject(key);
+    if (obj) init_(*obj);
+}
+
+inline PropertyView::PropertyView(const msgpack::object& obj,
+                                  const std::string& key): key_(key) {
+    init_(obj);
+}
+
+inline std::vector<std::string> PropertyView::names() const {
+    std::vector<std::string> result;
+    result.reserve(columns_.size());
+    columns_type_::const_iterator it;
+    for (it = columns_.begin(); it != columns_.end(); ++it) {
+        result.push_back(it->first);
+    }
+    return result;
+}
+
+inline const msgpack::object*
+PropertyView::getObject(const std::string& name) const {
+    columns_type_::const_iterator it = columns_.find(name);
+    if (it == columns_.end()) return NULL;
+    return it->second;
+}
+
+inline bool PropertyView::isBinary(const std::string& name) const {
+    const msgpack::object* obj = getObject(name);
+    return obj && obj->type == msgpack::type::BIN;
+}
+
+inline int32_t PropertyView::length(const std::string& name) const {
+    const msgpack::object* obj = getObject(name);
+    if (!obj) return -1;
+    if (obj->type == msgpack::type::BIN) {
+        return BinaryDecoder(*obj, columnKey_(name)).length();
+    }
+    if (obj->type == msgpack::type::ARRAY) return int32_t(obj->via.array.size);
+    return -1;
+}
+
+inline int32_t PropertyView::strategy(const std::string& name) const {
+    if (!isBinary(name)) return -1;
+    return BinaryDecoder(*getObject(name), columnKey_(name)).strategy();
+}
+
+inline BinaryDecoder PropertyView::binary(const std::string& name) const {
+    const msgpack::object* obj = getObject(name);
+    if (!obj) {
+        throw DecodeError("No column " + name + " in " + key_);
+    }
+    return BinaryDecoder(*obj, columnKey_(name));
+}
+
+template<typename T>
+inline bool PropertyView::decode(const std::string& name, T& target) const {
+    const msgpack::object* obj = getObject(name);
+    if (!obj) return false;
+    if (obj->type == msgpack::type::BIN) {
+        BinaryDecoder(*obj, columnKey_(name)).decode(target);
+    } else {
+        obj->convert(target);
+    }
+    return true;
+}
+
+template<typename T>
+inline bool PropertyView::decodeRange(const std::string& name, int32_t begin,
+                                      int32_t end,
+                                      std::vector<T>& target) const {
+    const msgpack::object* obj = getObject(name);
+    if (!obj) return false;
+    if (obj->type == msgpack::type::BIN) {
+        BinaryDecoder(*obj, columnKey_(name)).decodeRange(begin, end, target);
+        return true;
+    }
+    if (obj->type != msgpack::type::ARRAY) {
+        throw DecodeError("Column " + columnKey_(name)
+                          + " is neither a binary nor an array");
+    }
+    if (begin < 0 || begin > end || uint32_t(end) > obj->via.array.size) {
+        throw DecodeError("Invalid range for column " + columnKey_(name));
+    }
+    std::vector<T> values(end - begin);
+    for (int32_t i = begin; i < end; ++i) {
+        obj->via.array.ptr[i].convert(values[i - begin]);
+    }
+    target.swap(values);
+    return true;
+}
+
+inline void PropertyView::init_(const msgpack::object& obj) {
+    if (obj.type != msgpack::type::MAP) {
+        throw DecodeError("Expected msgpack type of " + key_ + " to be MAP");
+    }
+    const msgpack::object_map& map = obj.via.map;
+    for (uint32_t i = 0; i < map.size; ++i) {
+        const msgpack::object& key = map.ptr[i].key;
+        if (key.type != msgpack::type::STR) {
+            std::cerr << "Warning: Found non-string key type " << key.type
+                      << " in " << key_ << "! Skipping..." << std::endl;
+            continue;
+        }
+        const std::string name(key.via.str.ptr, key.via.str.size);
+        // checkpoints and tiles only refer to the encoded binaries
+        if (name == CHECKPOINTS_KEY || name == TILES_KEY) continue;
+        columns_[name] = &map.ptr[i].val;
+    }
+}
+
+} // mmtf namespace
+
+#endif
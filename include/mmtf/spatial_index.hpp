@@ -0,0 +1,347 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Uniform grid (cell list) over coordinates of mmtf::StructureData.
+// See "tests/mmtf_tests.cpp" (Test SpatialIndex) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_SPATIAL_INDEX_H
+#define MMTF_SPATIAL_INDEX_H
+
+#include "structure_data.hpp"
+#include "errors.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <math.h>
+
+namespace mmtf {
+
+/**
+ * @brief Uniform cell grid for neighbor searches.
+ *
+ * Points are sorted into cubic cells (counting sort, cells computed in
+ * parallel if OpenMP is enabled). The index only stores pointers to the
+ * coordinate columns (e.g. StructureData.xCoordList), which must stay alive
+ * and unchanged while the index is used. All queries are const and may be
+ * called concurrently from several threads.
+ *
+ * For very sparse data, the cell size is increased so that the grid never has
+ * much more cells than points. Points with non-finite (NaN or infinite)
+ * coordinates are ignored for the grid extent and never found by queries.
+ */
+class SpatialIndex {
+public:
+    /**
+     * @brief Construct empty index. Use init to fill it.
+     */
+    SpatialIndex(): x_(NULL), y_(NULL), z_(NULL), num_points_(0),
+                    cell_size_(1), inv_cell_size_(1) {
+        dims_[0] = dims_[1] = dims_[2] = 0;
+        min_[0] = min_[1] = min_[2] = 0;
+    }
+
+    /**
+     * @brief Construct index over all atoms of data.
+     * @param data       Data with coordinates (must outlive the index).
+     * @param cell_size  Edge length of grid cells (typically the largest
+     *                   cutoff used in queries).
+     * @throw mmtf::DecodeError if coordinate lists have inconsistent sizes.
+     */
+    SpatialIndex(const StructureData& data, float cell_size);
+
+    /**
+     * @brief Construct index over given coordinate arrays.
+     * @param x, y, z     Coordinate arrays of size num_points.
+     * @param num_points  Number of points.
+     * @param cell_size   Edge length of grid cells.
+     */
+    SpatialIndex(const float* x, const float* y, const float* z,
+                 int32_t num_points, float cell_size);
+
+    /**
+     * @brief (Re)build index for given data. See constructor.
+     */
+    void init(const StructureData& data, float cell_size);
+
+    /**
+     * @brief (Re)build index for given coordinates. See constructor.
+     */
+    void init(const float* x, const float* y, const float* z,
+              int32_t num_points, float cell_size);
+
+    int32_t numPoints() const { return num_points_; }
+    /// Actual cell size (may be larger than requested for sparse data)
+    float cellSize() const { return cell_size_; }
+
+    /**
+     * @brief Find all points within radius (inclusive) of a position.
+     * @param[in]  x, y, z  Query position.
+     * @param[in]  radius   Search radius.
+     * @param[out] result   Indices of found points (cleared first; not sorted).
+     */
+    void findWithinRadius(float x, float y, float z, float radius,
+                          std::vector<int32_t>& result) const;
+
+    /**
+     * @brief Find k nearest points of a position.
+     * @param[in]  x, y, z     Query position.
+     * @param[in]  k           Number of points to find.
+     * @param[out] result      Indices of found points sorted by distance
+     *                         (cleared first; fewer than k if not enough
+     *                         points within max_radius).
+     * @param[in]  max_radius  Ignore points further away (negative: no limit).
+     */
+    void findNearest(float x, float y, float z, int32_t k,
+                     std::vector<int32_t>& result,
+                     float max_radius = -1) const;
+
+    /**
+     * @brief Visit all pairs of points within cutoff (inclusive).
+     * @param[in] cutoff   Distance cutoff.
+     * @param[in] visitor  Called as visitor(i, j, distance_squared) once for
+     *                     each unordered pair (i != j).
+     * @tparam Visitor Functor type (called serially).
+     */
+    template <typename Visitor>
+    void forEachPairWithin(float cutoff, Visitor& visitor) const;
+
+private:
+    int32_t cellCoord_(float value, int dim) const {
+        // clamp before converting (also for NaN and infinity)
+        const float c = (value - min_[dim]) * inv_cell_size_;
+        if (!(c > 0)) return 0;
+        return (c >= dims_[dim]) ? dims_[dim] - 1 : int32_t(c);
+    }
+    int32_t cellIndex_(int32_t cx, int32_t cy, int32_t cz) const {
+        return (cz * dims_[1] + cy) * dims_[0] + cx;
+    }
+    float distance2_(int32_t i, float x, float y, float z) const {
+        const float dx = x_[i] - x;
+        const float dy = y_[i] - y;
+        const float dz = z_[i] - z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+    // cell ranges [lo, hi] covering a sphere
+    void cellRange_(float x, float y, float z, float radius,
+                    int32_t lo[3], int32_t hi[3]) const;
+
+    const float* x_;
+    const float* y_;
+    const float* z_;
+    int32_t num_points_;
+    float cell_size_;
+    float inv_cell_size_;
+    float min_[3];
+    int32_t dims_[3];
+    std::vector<int32_t> cell_offsets_;  // cell -> first entry in points_
+    std::vector<int32_t> points_;        // point indices sorted by cell
+};
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+inline SpatialIndex::SpatialIndex(const StructureData& data, float cell_size) {
+    init(data, cell_size);
+}
+
+inline SpatialIndex::SpatialIndex(const float* x, const float* y,
+                                  const float* z, int32_t num_points,
+                                  float cell_size) {
+    init(x, y, z, num_points, cell_size);
+}
+
+inline void SpatialIndex::init(const StructureData& data, float cell_size) {
+    const size_t n = data.xCoordList.size();
+    if (data.yCoordList.size() != n || data.zCoordList.size() != n) {
+        throw DecodeError("Cannot build SpatialIndex: coordinate lists have "
+                          "different sizes");
+    }
+    if (n == 0) {
+        init(NULL, NULL, NULL, 0, cell_size);
+    } else {
+        init(&data.xCoordList[0], &data.yCoordList[0], &data.zCoordList[0],
+             int32_t(n), cell_size);
+    }
+}
+
+inline void SpatialIndex::init(const float* x, const float* y, const float* z,
+                               int32_t num_points, float cell_size) {
+    x_ = x;
+    y_ = y;
+    z_ = z;
+    num_points_ = num_points;
+    cell_size_ = (cell_size > 0) ? cell_size : 1;
+
+    // bounding box of finite coordinates (v - v is NaN for NaN and inf)
+    float max[3];
+    const float* coords[3] = {x, y, z};
+    for (int d = 0; d < 3; ++d) {
+        bool found = false;
+        min_[d] = max[d] = 0;
+        for (int32_t i = 0; i < num_points; ++i) {
+            const float v = coords[d][i];
+            if (!(v - v == 0)) continue;
+            if (!found || v < min_[d]) min_[d] = v;
+            if (!found || v > max[d]) max[d] = v;
+            found = true;
+        }
+    }
+    // grid size (at most ~2 cells per point)
+    const double max_cells = 2.0 * num_points + 64;
+    for (;;) {
+        double dims[3];
+        double num_cells = 1;
+        for (int d = 0; d < 3; ++d) {
+            dims[d] = floor((double(max[d]) - min_[d]) / cell_size_) + 1;
+            num_cells *= dims[d];
+        }
+        if (num_cells <= max_cells) {
+            for (int d = 0; d < 3; ++d) dims_[d] = int32_t(dims[d]);
+            break;
+        }
+        cell_size_ *= 1.5f;
+    }
+    inv_cell_size_ = 1 / cell_size_;
+    const int32_t num_cells = dims_[0] * dims_[1] * dims_[2];
+
+    // counting sort of points into cells
+    std::vector<int32_t> point_cells(num_points);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (int32_t i = 0; i < num_points; ++i) {
+        point_cells[i] = cellIndex_(cellCoord_(x[i], 0), cellCoord_(y[i], 1),
+                                    cellCoord_(z[i], 2));
+    }
+    cell_offsets_.assign(num_cells + 1, 0);
+    for (int32_t i = 0; i < num_points; ++i) {
+        ++cell_offsets_[point_cells[i] + 1];
+    }
+    for (int32_t c = 0; c < num_cells; ++c) {
+        cell_offsets_[c + 1] += cell_offsets_[c];
+    }
+    points_.resize(num_points);
+    std::vector<int32_t> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (int32_t i = 0; i < num_points; ++i) {
+        points_[fill[point_cells[i]]++] = i;
+    }
+}
+
+inline void SpatialIndex::cellRange_(float x, float y, float z, float radius,
+                                     int32_t lo[3], int32_t hi[3]) const {
+    const float pos[3] = {x, y, z};
+    for (int d = 0; d < 3; ++d) {
+        lo[d] = cellCoord_(pos[d] - radius, d);
+        hi[d] = cellCoord_(pos[d] + radius, d);
+    }
+}
+
+inline void SpatialIndex::findWithinRadius(float x, float y, float z,
+                                           float radius,
+                                           std::vector<int32_t>& result) const {
+    result.clear();
+    if (num_points_ == 0 || radius < 0) return;
+    const float radius2 = radius * radius;
+    int32_t lo[3], hi[3];
+    cellRange_(x, y, z, radius, lo, hi);
+    for (int32_t cz = lo[2]; cz <= hi[2]; ++cz) {
+        for (int32_t cy = lo[1]; cy <= hi[1]; ++cy) {
+            // cells along x are contiguous in points_
+            const int32_t begin = cell_offsets_[cellIndex_(lo[0], cy, cz)];
+            const int32_t end = cell_offsets_[cellIndex_(hi[0], cy, cz) + 1];
+            for (int32_t k = begin; k < end; ++k) {
+                const int32_t i = points_[k];
+                if (distance2_(i, x, y, z) <= radius2) result.push_back(i);
+            }
+        }
+    }
+}
+
+inline void SpatialIndex::findNearest(float x, float y, float z, int32_t k,
+                                      std::vector<int32_t>& result,
+                                      float max_radius) const {
+    result.clear();
+    if (num_points_ == 0 || k <= 0) return;
+    if (!(x - x == 0 && y - y == 0 && z - z == 0)) return; // NaN or infinity
+    // grow search sphere until it holds k points (or everything)
+    float extent = 0;
+    for (int d = 0; d < 3; ++d) {
+        const float pos = (d == 0) ? x : (d == 1) ? y : z;
+        const float lo = fabs(pos - min_[d]);
+        const float hi = fabs(pos - (min_[d] + dims_[d] * cell_size_));
+        extent += std::max(lo, hi) * std::max(lo, hi);
+    }
+    extent = sqrt(extent);
+    float radius = cell_size_;
+    std::vector<int32_t> candidates;
+    for (;;) {
+        if (max_radius >= 0 && radius > max_radius) radius = max_radius;
+        findWithinRadius(x, y, z, radius, candidates);
+        if (int32_t(candidates.size()) >= k || radius >= extent
+            || (max_radius >= 0 && radius >= max_radius)) {
+            break;
+        }
+        radius *= 2;
+    }
+    std::vector<std::pair<float, int32_t> > sorted(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        sorted[i].first = distance2_(candidates[i], x, y, z);
+        sorted[i].second = candidates[i];
+    }
+    const size_t num = std::min(sorted.size(), size_t(k));
+    std::partial_sort(sorted.begin(), sorted.begin() + num, sorted.end());
+    result.resize(num);
+    for (size_t i = 0; i < num; ++i) result[i] = sorted[i].second;
+}
+
+template <typename Visitor>
+inline void SpatialIndex::forEachPairWithin(float cutoff,
+                                            Visitor& visitor) const {
+    if (num_points_ == 0 || cutoff < 0) return;
+    const float cutoff2 = cutoff * cutoff;
+    const int32_t reach = int32_t(ceil(cutoff * inv_cell_size_));
+    for (int32_t cz = 0; cz < dims_[2]; ++cz) {
+    for (int32_t cy = 0; cy < dims_[1]; ++cy) {
+    for (int32_t cx = 0; cx < dims_[0]; ++cx) {
+        const int32_t cell = cellIndex_(cx, cy, cz);
+        const int32_t begin = cell_offsets_[cell];
+        const int32_t end = cell_offsets_[cell + 1];
+        if (begin == end) continue;
+        // neighbor cells with larger linear index (and same cell) only
+        for (int32_t nz = cz; nz <= std::min(cz + reach, dims_[2] - 1); ++nz) {
+            const int32_t y_lo = (nz == cz) ? cy : std::max(cy - reach, 0);
+            for (int32_t ny = y_lo; ny <= std::min(cy + reach, dims_[1] - 1);
+                 ++ny) {
+                const int32_t x_lo = (nz == cz && ny == cy)
+                                   ? cx : std::max(cx - reach, 0);
+                const int32_t x_hi = std::min(cx + reach, dims_[0] - 1);
+                const int32_t n_begin = cell_offsets_[cellIndex_(x_lo, ny, nz)];
+                const int32_t n_end = cell_offsets_[cellIndex_(x_hi, ny, nz) + 1];
+                for (int32_t a = begin; a < end; ++a) {
+                    const int32_t i = points_[a];
+                    // within own cell: only later entries
+                    int32_t b = n_begin;
+                    if (nz == cz && ny == cy) b = a + 1;
+                    for (; b < n_end; ++b) {
+                        const int32_t j = points_[b];
+                        const float d2 = distance2_(j, x_[i], y_[i], z_[i]);
+                        if (d2 <= cutoff2) visitor(i, j, d2);
+                    }
+                }
+            }
+        }
+    }
+    }
+    }
+}
+
+} // mmtf namespace
+
+#endif
@@ -0,0 +1,256 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Per-field statistics for decodeFromMapDecoder and encodeToMap.
+// See tests/mmtf_tests.cpp (Test field statistics) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_STATISTICS_H
+#define MMTF_STATISTICS_H
+
+#include "binary_decoder.hpp"
+#include "map_decoder.hpp"
+
+#include <msgpack.hpp>
+#include <map>
+#include <string>
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#include <chrono>
+#else
+#include <sys/time.h>
+#endif
+
+namespace mmtf {
+
+/**
+ * @brief Statistics of a single MMTF field.
+ *
+ * Filled for each field by ::decodeFromMapDecoder and ::encodeToMap when they
+ * are given a statistics sink.
+ */
+struct FieldStatistics {
+    std::string key;       ///< Name of the field (e.g. "xCoordList")
+    uint64_t encodedBytes; ///< Size of encoded value (for binaries: size of
+                           ///< binary data incl. 12 byte header)
+    uint64_t numElements;  ///< Number of elements (1 for scalars and strings)
+    int32_t strategy;      ///< Binary strategy or 0 if not binary encoded
+    double seconds;        ///< Wall time to decode or encode the field
+    int32_t count;         ///< Number of merged records (see Statistics)
+
+    FieldStatistics(): encodedBytes(0), numElements(0), strategy(0),
+                       seconds(0), count(0) {}
+};
+
+/**
+ * @brief Statistics sink that records nothing.
+ *
+ * Default for ::decodeFromMapDecoder and ::encodeToMap. Neither timers nor
+ * size computations are compiled in for this sink.
+ */
+struct NoStatistics {
+    void record(const FieldStatistics&) {}
+};
+
+/**
+ * @brief Statistics sink that sums up statistics per field.
+ *
+ * Can be passed to many calls (e.g. for all files of an archive) to find the
+ * fields which dominate decode time and file size. Any other type with a
+ * member function record(const FieldStatistics&) can be used as sink.
+ */
+class Statistics {
+public:
+    typedef std::map<std::string, FieldStatistics> FieldMap;
+
+    /**
+     * @brief Add a record to the sums for its key.
+     *
+     * Bytes, elements, seconds and count are summed up. The strategy is kept
+     * if equal to previous records of the key and set to -1 otherwise.
+     */
+    void record(const FieldStatistics& field);
+
+    /** @brief Summed up statistics per field key. */
+    const FieldMap& fields() const { return fields_; }
+
+    /** @brief Sum of FieldStatistics::seconds of all fields. */
+    double totalSeconds() const;
+
+    /** @brief Sum of FieldStatistics::encodedBytes of all fields. */
+    uint64_t totalBytes() const;
+
+    /** @brief Remove all records. */
+    void clear() { fields_.clear(); }
+
+private:
+    FieldMap fields_;
+};
+
+/**
+ * @brief Simple wall clock timer (C++03 compatible).
+ */
+class WallTimer {
+public:
+    /** @brief Construct and start timer. */
+    WallTimer() { restart(); }
+
+    /** @brief Restart timer. */
+    void restart() { start_ = now_(); }
+
+    /** @brief Seconds since construction or last restart. */
+    double elapsed() const { return now_() - start_; }
+
+private:
+    double start_;
+    static double now_();
+};
+
+namespace impl {
+
+/**
+ * @brief Times and records fields for a statistics sink.
+ *
+ * Used as: start(); decode or encode field; stop(map, key);
+ * Specialized for NoStatistics to do nothing.
+ */
+template <typename Stats>
+class FieldRecorder {
+public:
+    FieldRecorder(Stats& stats): stats_(stats) {}
+    void start() { timer_.restart(); }
+    void stop(const MapDecoder& md, const char* key);
+    void stop(const std::map<std::string, msgpack::object>& data_map,
+              const char* key);
+private:
+    Stats& stats_;
+    WallTimer timer_;
+    void record_(const char* key, const msgpack::object& obj, double seconds);
+};
+
+template <>
+class FieldRecorder<NoStatistics> {
+public:
+    FieldRecorder(NoStatistics&) {}
+    void start() {}
+    void stop(const MapDecoder&, const char*) {}
+    void stop(const std::map<std::string, msgpack::object>&, const char*) {}
+};
+
+} // impl namespace
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+inline void Statistics::record(const FieldStatistics& field) {
+    FieldMap::iterator it = fields_.find(field.key);
+    if (it == fields_.end()) {
+        FieldStatistics& sum = fields_[field.key];
+        sum = field;
+        sum.count = 1;
+        return;
+    }
+    FieldStatistics& sum = it->second;
+    sum.encodedBytes += field.encodedBytes;
+    sum.numElements += field.numElements;
+    sum.seconds += field.seconds;
+    if (sum.strategy != field.strategy) sum.strategy = -1;
+    ++sum.count;
+}
+
+inline double Statistics::totalSeconds() const {
+    double total = 0;
+    for (FieldMap::const_iterator it = fields_.begin(); it != fields_.end();
+         ++it) {
+        total += it->second.seconds;
+    }
+    return total;
+}
+
+inline uint64_t Statistics::totalBytes() const {
+    uint64_t total = 0;
+    for (FieldMap::const_iterator it = fields_.begin(); it != fields_.end();
+         ++it) {
+        total += it->second.encodedBytes;
+    }
+    return total;
+}
+
+inline double WallTimer::now_() {
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return double(tv.tv_sec) + 1e-6 * double(tv.tv_usec);
+#endif
+}
+
+namespace impl {
+
+namespace {
+
+// stream for msgpack::pack which only counts bytes
+struct ByteCounter {
+    uint64_t size;
+    ByteCounter(): size(0) {}
+    void write(const char*, size_t n) { size += n; }
+};
+
+} // anon ns
+
+template <typename Stats>
+inline void FieldRecorder<Stats>::stop(const MapDecoder& md, const char* key) {
+    const double seconds = timer_.elapsed();
+    const msgpack::object* obj = md.getObject(key);
+    if (obj) record_(key, *obj, seconds);
+}
+
+template <typename Stats>
+inline void FieldRecorder<Stats>::stop(
+    const std::map<std::string, msgpack::object>& data_map, const char* key) {
+    const double seconds = timer_.elapsed();
+    std::map<std::string, msgpack::object>::const_iterator it =
+        data_map.find(key);
+    if (it != data_map.end()) record_(key, it->second, seconds);
+}
+
+template <typename Stats>
+inline void FieldRecorder<Stats>::record_(const char* key,
+                                          const msgpack::object& obj,
+                                          double seconds) {
+    FieldStatistics field;
+    field.key = key;
+    field.seconds = seconds;
+    field.count = 1;
+    if (obj.type == msgpack::type::BIN) {
+        BinaryDecoder bd(obj, field.key);
+        field.encodedBytes = obj.via.bin.size;
+        field.numElements = uint64_t(bd.length());
+        field.strategy = bd.strategy();
+    } else {
+        ByteCounter counter;
+        msgpack::pack(counter, obj);
+        field.encodedBytes = counter.size;
+        if (obj.type == msgpack::type::ARRAY) {
+            field.numElements = obj.via.array.size;
+        } else if (obj.type == msgpack::type::MAP) {
+            field.numElements = obj.via.map.size;
+        } else if (obj.type != msgpack::type::NIL) {
+            field.numElements = 1;
+        }
+    }
+    stats_.record(field);
+}
+
+} // impl namespace
+
+} // mmtf namespace
+
+#endif
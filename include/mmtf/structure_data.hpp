@@ -15,6 +15,7 @@
 #define MMTF_STRUCTURE_DATA_H
 
 #include "errors.hpp"
+#include "validation.hpp"
 
 #include <string>
 #include <vector>
@@ -224,9 +225,25 @@ struct StructureData {
    * @param chain_name_max_length   Max allowed chain name length
    * @return True if all required fields are set and vector sizes and indices
    *         are consistent.
+   *
+   * Stops at the first issue. Use validate to collect all issues.
    */
   bool hasConsistentData(bool verbose=false, uint32_t chain_name_max_length = 4) const;
 
+  /**
+   * @brief Check consistency of structural data and collect all issues.
+   * @param[out] report             Issues found (previous issues are removed)
+   * @param chain_name_max_length   Max allowed chain name length
+   * @return True if no issues were found (same as report.isValid()).
+   *
+   * Performs the checks of hasConsistentData but continues after an issue
+   * until the cap of the report is reached. Checks which depend on
+   * inconsistent fields (e.g. traversal of chains with wrong groupsPerChain)
+   * are skipped. Chains are checked in parallel if OpenMP is enabled.
+   */
+  bool validate(ValidationReport& report,
+                uint32_t chain_name_max_length = 4) const;
+
   /**
    * @brief Read out the contents of mmtf::StructureData in a PDB-like fashion
    * Columns are in order:
@@ -328,13 +345,66 @@ inline bool is_hetatm(const char* type);
  * Efficient code needing this information should preferably use the or
  * statement above, precompute the `is_polymer` output for each chain and the
  * `is_hetatm(type)` output for each group instead of calling this on each atom.
+ * mmtf::ClassificationTable does exactly that.
  * 
- * @see is_polymer, is_hetatm
+ * @see is_polymer, is_hetatm, ClassificationTable
  */
 inline bool is_hetatm(const unsigned int chain_index,
                       const std::vector<Entity>& entity_list,
                       const GroupType& group_type);
 
+/**
+ * @brief Precomputed polymer / HETATM classification of a StructureData.
+ *
+ * Holds the entity index and polymer flag of each chain and the
+ * `is_hetatm(chemCompType)` flag of each entry in StructureData.groupList.
+ * Building it costs O(numChains + entity chains + groupList.size()), after
+ * which all lookups are O(1). Results are identical to is_polymer and
+ * is_hetatm (chain_index version).
+ *
+ * Must be rebuilt if entityList or groupList change.
+ */
+struct ClassificationTable {
+  /// Index into entityList for each chain (-1 if chain not in any entity)
+  std::vector<int32_t> chainEntityIndex;
+  /// 1 if chain belongs to a polymer entity, 0 otherwise
+  std::vector<char>    chainIsPolymer;
+  /// 1 if is_hetatm(chemCompType) is true for groupList entry, 0 otherwise
+  std::vector<char>    groupTypeIsHetatm;
+
+  /**
+   * @brief Construct empty table. Use init to fill it.
+   */
+  ClassificationTable() {}
+
+  /**
+   * @brief Construct table for given data.
+   */
+  explicit ClassificationTable(const StructureData& data) { init(data); }
+
+  /**
+   * @brief (Re)compute table for given data.
+   */
+  void init(const StructureData& data);
+
+  /**
+   * @brief Same as is_polymer(chain_index, entityList).
+   * @throw mmtf::DecodeError if chain index doesn't appear in entity list.
+   */
+  bool isPolymer(int32_t chain_index) const;
+
+  /**
+   * @brief Same as is_hetatm(chain_index, entityList, groupList[group_type]).
+   * @param chain_index  Chain index of chain where atom belongs to.
+   * @param group_type   Index into StructureData.groupList (i.e. entry of
+   *                     StructureData.groupTypeList).
+   * @throw mmtf::DecodeError if chain index doesn't appear in entity list.
+   */
+  bool isHetatm(int32_t chain_index, int32_t group_type) const {
+    return groupTypeIsHetatm[group_type] || !isPolymer(chain_index);
+  }
+};
+
 
 // *************************************************************************
 // IMPLEMENTATION
@@ -369,19 +439,229 @@ bool hasRightSizeOptional(const std::vector<T>& v, int exp_size) {
   return (isDefaultValue(v) || (int)v.size() == exp_size);
 }
 
-// check if all indices in vector are in [0, num-1] (T = integer type)
+// index of first element not in [0, num-1] or -1 if all valid
 template<typename T, typename Tnum>
-bool hasValidIndices(const T* v, size_t size, Tnum num) {
-  T tnum = T(num);
-  for (size_t i = 0; i < size; ++i) {
-    if (v[i] < T(0) || v[i] >= tnum) return false;
+int64_t findInvalidIndex(const std::vector<T>& v, Tnum num) {
+  const T tnum = T(num);
+  for (size_t i = 0; i < v.size(); ++i) {
+    if (v[i] < T(0) || v[i] >= tnum) return int64_t(i);
+  }
+  return -1;
+}
+
+// message builder for validation issues: ValidationMessage() << "a" << 1
+class ValidationMessage {
+public:
+  template <typename T>
+  ValidationMessage& operator<<(const T& value) {
+    out_ << value;
+    return *this;
+  }
+  operator std::string() const { return out_.str(); }
+private:
+  std::ostringstream out_;
+};
+
+// field name for validation issues of group type (global field if idx < 0)
+inline std::string validationField(int64_t group_idx, const char* name) {
+  if (group_idx < 0) return name;
+  return ValidationMessage() << "groupList[" << group_idx << "]." << name;
+}
+
+// allowed bond orders are -1, 1, 2, 3 and 4 (bit i set for order i - 1)
+inline bool isValidBondOrder(int8_t order) {
+  const uint32_t idx = uint32_t(int32_t(order) + 1);
+  return idx < 6 && ((0x3Du >> idx) & 1u);
+}
+
+// add all issues of a single bond to report (see validateBonds)
+inline void addBondIssues(size_t bond_idx, const std::vector<int32_t>& atoms,
+    const std::vector<int8_t>& orders, const std::vector<int8_t>& resonances,
+    uint32_t max_atoms, int64_t group_idx, ValidationReport& report) {
+  const std::string msg_prefix = (group_idx < 0) ? "" : "group::";
+  const std::string msg_suffix = (group_idx < 0) ? std::string()
+      : std::string(ValidationMessage() << " in group idx: " << group_idx);
+  if (!orders.empty()) {
+    const int8_t order = orders[bond_idx];
+    if (!isValidBondOrder(order)) {
+      report.add(VALIDATION_INVALID_VALUE,
+          validationField(group_idx, "bondOrderList"), int64_t(bond_idx),
+          ValidationMessage() << "Cannot have bond order of: " << (int)order
+          << " allowed bond orders are: -1, 1, 2, 3 or 4.  at idx: "
+          << bond_idx << msg_suffix);
+    }
+    if (!resonances.empty()) {
+      const int8_t resonance = resonances[bond_idx];
+      if (resonance < -1 || resonance > 1) {
+        report.add(VALIDATION_INVALID_VALUE,
+            validationField(group_idx, "bondResonanceList"), int64_t(bond_idx),
+            ValidationMessage() << msg_prefix
+            << "bondResonanceList had a Resonance of: " << (int)resonance
+            << " and only -1, 0, or 1 are allowed" << msg_suffix);
+      } else if (order == -1 && resonance != 1) {
+        report.add(VALIDATION_INVALID_VALUE,
+            validationField(group_idx, "bondResonanceList"), int64_t(bond_idx),
+            ValidationMessage() << msg_prefix
+            << "bondResonanceList had a Resonance of: " << (int)resonance
+            << " and " << msg_prefix << "bondOrderList had an order of "
+            << (int)order << " we require unknown bondOrders to have resonance"
+            << msg_suffix);
+      }
+    }
+  }
+  for (size_t i = 2 * bond_idx; i < 2 * bond_idx + 2 && i < atoms.size(); ++i) {
+    if (uint32_t(atoms[i]) >= max_atoms) {
+      report.add(VALIDATION_INVALID_INDEX,
+          validationField(group_idx, "bondAtomList"), int64_t(i),
+          ValidationMessage() << "inconsistent " << msg_prefix
+          << "bondAtomList indices (not all in [0, " << int64_t(max_atoms) - 1
+          << "]) at idx: " << i << msg_suffix);
+    }
+  }
+}
+
+// single pass over bond lists with already checked sizes (bond orders and
+// resonances may be empty) adding issues to report (group_idx < 0 for global
+// bonds)
+// -> returns false if report is full
+inline bool validateBonds(const std::vector<int32_t>& atoms,
+    const std::vector<int8_t>& orders, const std::vector<int8_t>& resonances,
+    int64_t num_atoms, int64_t group_idx, ValidationReport& report) {
+  const uint32_t max_atoms = (num_atoms > 0) ? uint32_t(num_atoms) : 0;
+  if (orders.empty()) {
+    for (size_t i = 0; i < atoms.size(); ++i) {
+      if (uint32_t(atoms[i]) >= max_atoms) {
+        addBondIssues(i / 2, atoms, orders, resonances, max_atoms, group_idx,
+                      report);
+        if (report.isFull()) return false;
+        i |= 1; // both atoms of bond reported
+      }
+    }
+    return true;
+  }
+  const bool has_resonances = !resonances.empty();
+  for (size_t i = 0; i < orders.size(); ++i) {
+    const int8_t order = orders[i];
+    bool valid = isValidBondOrder(order)
+              && uint32_t(atoms[2 * i]) < max_atoms
+              && uint32_t(atoms[2 * i + 1]) < max_atoms;
+    if (has_resonances) {
+      const int8_t resonance = resonances[i];
+      valid = valid && resonance >= -1 && resonance <= 1
+                    && (order != -1 || resonance == 1);
+    }
+    if (!valid) {
+      addBondIssues(i, atoms, orders, resonances, max_atoms, group_idx,
+                    report);
+      if (report.isFull()) return false;
+    }
   }
   return true;
 }
-template<typename T, typename Tnum>
-bool hasValidIndices(const std::vector<T>& v, Tnum num) {
-  if (v.empty()) return true;
-  else           return hasValidIndices(&v[0], v.size(), num);
+
+// per group type values used when traversing groups (-1 if list is default)
+struct ConsistencyGroupCounts {
+  int32_t num_atoms;
+  int32_t num_orders;
+  int32_t num_resonances;
+  int32_t num_bonds_from_atoms;
+};
+
+// sums over traversed groups (num_.._lists = number of non-default lists,
+// num_unknown_groups = groups with invalid group type index)
+struct ConsistencySums {
+  int64_t num_atoms;
+  int64_t num_orders;
+  int64_t num_resonances;
+  int64_t num_bonds_from_atoms;
+  int64_t num_order_lists;
+  int64_t num_resonance_lists;
+  int64_t num_atom_lists;
+  int64_t num_unknown_groups;
+  ConsistencySums(): num_atoms(0), num_orders(0), num_resonances(0),
+                     num_bonds_from_atoms(0), num_order_lists(0),
+                     num_resonance_lists(0), num_atom_lists(0),
+                     num_unknown_groups(0) {}
+};
+
+// check chain and its groups (groups of chain given by group_begin) and add
+// group counts to sums
+// -> without report: stop at first issue
+// -> with report: add all issues of chain (until report is full)
+// -> returns true if no issue found
+inline bool hasConsistentChain(const StructureData& sd, int32_t chain_idx,
+    const std::vector<int32_t>& group_begin,
+    const std::vector<ConsistencyGroupCounts>& group_counts,
+    const std::vector<int32_t>& sequence_index_size,
+    uint32_t chain_name_max_length, ValidationReport* report,
+    ConsistencySums& sums) {
+  bool consistent = true;
+  // check chain names (fixed length)
+  if (sd.chainIdList[chain_idx].size() > chain_name_max_length) {
+    if (!report) return false;
+    report->add(VALIDATION_INVALID_FORMAT, "chainIdList", chain_idx,
+        ValidationMessage() << "inconsistent chainIdList size at chain_idx: "
+        << chain_idx << " size: " << sd.chainIdList[chain_idx].size());
+    if (report->isFull()) return false;
+    consistent = false;
+  }
+  const bool has_chain_names = !isDefaultValue(sd.chainNameList);
+  if (   has_chain_names
+      && sd.chainNameList[chain_idx].size() > chain_name_max_length) {
+    if (!report) return false;
+    report->add(VALIDATION_INVALID_FORMAT, "chainNameList", chain_idx,
+        ValidationMessage() << "inconsistent chainNameList size at chain_idx:"
+        << chain_idx << " size: " << sd.chainNameList[chain_idx].size());
+    if (report->isFull()) return false;
+    consistent = false;
+  }
+  // traverse groups
+  const bool has_sequence_indices = !isDefaultValue(sd.sequenceIndexList);
+  const uint32_t num_group_types = uint32_t(group_counts.size());
+  const int32_t group_end = group_begin[chain_idx + 1];
+  for (int32_t group_idx = group_begin[chain_idx]; group_idx < group_end;
+       ++group_idx) {
+    // check seq. idx (-1 is ok here)
+    if (has_sequence_indices) {
+      const int32_t idx = sd.sequenceIndexList[group_idx];
+      if (idx < -1 || idx >= sequence_index_size[chain_idx]) {
+        if (!report) return false;
+        report->add(VALIDATION_INVALID_INDEX, "sequenceIndexList", group_idx,
+            ValidationMessage() << "inconsistent sequenceIndexSize at"
+            " chain_idx: " << chain_idx);
+        if (report->isFull()) return false;
+        consistent = false;
+      }
+    }
+    const int32_t group_type = sd.groupTypeList[group_idx];
+    if (uint32_t(group_type) >= num_group_types) {
+      if (!report) return false;
+      report->add(VALIDATION_INVALID_INDEX, "groupTypeList", group_idx,
+          ValidationMessage() << "inconsistent groupTypeList indices (not all "
+          "in [0, " << int64_t(num_group_types) - 1 << "]) at idx: "
+          << group_idx);
+      if (report->isFull()) return false;
+      consistent = false;
+      ++sums.num_unknown_groups;
+      continue;
+    }
+    // count atoms and bonds
+    const ConsistencyGroupCounts& counts = group_counts[group_type];
+    sums.num_atoms += counts.num_atoms;
+    if (counts.num_orders >= 0) {
+      ++sums.num_order_lists;
+      sums.num_orders += counts.num_orders;
+    }
+    if (counts.num_resonances >= 0) {
+      ++sums.num_resonance_lists;
+      sums.num_resonances += counts.num_resonances;
+    }
+    if (counts.num_bonds_from_atoms >= 0) {
+      ++sums.num_atom_lists;
+      sums.num_bonds_from_atoms += counts.num_bonds_from_atoms;
+    }
+  }
+  return consistent;
 }
 
 } // anon ns
@@ -491,6 +771,42 @@ bool is_hetatm(const unsigned int chain_index,
           || !is_polymer(chain_index, entity_list));
 }
 
+// CLASS ClassificationTable
+
+inline void ClassificationTable::init(const StructureData& data) {
+  const size_t num_chains = data.groupsPerChain.size();
+  chainEntityIndex.assign(num_chains, -1);
+  chainIsPolymer.assign(num_chains, 0);
+  // first entity listing a chain wins (as in is_polymer)
+  for (size_t i = 0; i < data.entityList.size(); ++i) {
+    const Entity& entity = data.entityList[i];
+    const bool polymer = (entity.type == "polymer" || entity.type == "POLYMER");
+    for (size_t j = 0; j < entity.chainIndexList.size(); ++j) {
+      const int32_t chain_index = entity.chainIndexList[j];
+      if (chain_index < 0 || size_t(chain_index) >= num_chains) continue;
+      if (chainEntityIndex[chain_index] == -1) {
+        chainEntityIndex[chain_index] = int32_t(i);
+        chainIsPolymer[chain_index] = polymer;
+      }
+    }
+  }
+  groupTypeIsHetatm.resize(data.groupList.size());
+  for (size_t i = 0; i < data.groupList.size(); ++i) {
+    groupTypeIsHetatm[i] = is_hetatm(data.groupList[i].chemCompType.c_str());
+  }
+}
+
+inline bool ClassificationTable::isPolymer(int32_t chain_index) const {
+  if (chain_index < 0 || size_t(chain_index) >= chainEntityIndex.size()
+      || chainEntityIndex[chain_index] == -1) {
+    std::stringstream err;
+    err << "'isPolymer' unable to find chain_index: " << chain_index
+        << " in entity list";
+    throw DecodeError(err.str());
+  }
+  return chainIsPolymer[chain_index];
+}
+
 
 // CLASS StructureData
 
@@ -570,43 +886,43 @@ inline bool StructureData::operator==(const StructureData& c) const {
 
 
 inline bool StructureData::hasConsistentData(bool verbose, uint32_t chain_name_max_length) const {
-  std::vector<int8_t> allowed_bond_orders;
-  allowed_bond_orders.push_back(-1);
-  allowed_bond_orders.push_back(1);
-  allowed_bond_orders.push_back(2);
-  allowed_bond_orders.push_back(3);
-  allowed_bond_orders.push_back(4);
+  ValidationReport report(1);
+  validate(report, chain_name_max_length);
+  if (verbose && !report.isValid()) {
+    std::cout << report.issues()[0].message << std::endl;
+  }
+  return report.isValid();
+}
 
+inline bool StructureData::validate(ValidationReport& report,
+                                    uint32_t chain_name_max_length) const {
+  report.clear();
   // check unitCell: if given, must be of length 6
   if (!hasRightSizeOptional(unitCell, 6)) {
-    if (verbose) {
-      std::cout << "inconsistent unitCell (unitCell length != 6)" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "unitCell", -1,
+               "inconsistent unitCell (unitCell length != 6)");
+    if (report.isFull()) return false;
   }
   // check dates
   if (!isValidDateFormatOptional(depositionDate)) {
-    if (verbose) {
-      std::cout << "inconsistent depositionDate (does not match 'YYYY-MM-DD' "
-          "or empty)" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_INVALID_FORMAT, "depositionDate", -1,
+               "inconsistent depositionDate (does not match 'YYYY-MM-DD' "
+               "or empty)");
+    if (report.isFull()) return false;
   }
   if (!isValidDateFormatOptional(releaseDate)) {
-    if (verbose) {
-      std::cout << "inconsistent releaseDate (does not match 'YYYY-MM-DD' "
-          "or empty)" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_INVALID_FORMAT, "releaseDate", -1,
+               "inconsistent releaseDate (does not match 'YYYY-MM-DD' "
+               "or empty)");
+    if (report.isFull()) return false;
   }
   // check ncsOperatorList: all elements must have length 16
   for (size_t i = 0; i < ncsOperatorList.size(); ++i) {
     if ((int)ncsOperatorList[i].size() != 16) {
-      if (verbose) {
-        std::cout << "inconsistent ncsOperatorList idx: " << i << " found size: "
-            << ncsOperatorList[i].size() << " != 16" << std::endl;
-      }
-      return false;
+      report.add(VALIDATION_WRONG_SIZE, "ncsOperatorList", int64_t(i),
+          ValidationMessage() << "inconsistent ncsOperatorList idx: " << i
+          << " found size: " << ncsOperatorList[i].size() << " != 16");
+      if (report.isFull()) return false;
     }
   }
   // check chain indices in bioAssembly-transforms and entities
@@ -614,419 +930,342 @@ inline bool StructureData::hasConsistentData(bool verbose, uint32_t chain_name_m
     const BioAssembly& ba = bioAssemblyList[i];
     for (size_t j = 0; j < ba.transformList.size(); ++j) {
       const Transform & t = ba.transformList[j];
-      if (!hasValidIndices(t.chainIndexList, numChains)) {
-        if (verbose) {
-          std::cout << "inconsistent BioAssemby transform i j: " << i
-              << " " << j << std::endl;
-        }
-        return false;
+      const int64_t idx = findInvalidIndex(t.chainIndexList, numChains);
+      if (idx >= 0) {
+        report.add(VALIDATION_INVALID_INDEX, ValidationMessage()
+            << "bioAssemblyList[" << i << "].transformList[" << j
+            << "].chainIndexList", idx, ValidationMessage()
+            << "inconsistent BioAssemby transform i j: " << i << " " << j);
+        if (report.isFull()) return false;
       }
     }
   }
+  bool valid_entities = true;
   for (size_t i = 0; i < entityList.size(); ++i) {
     const Entity& ent = entityList[i];
-    if (!hasValidIndices(ent.chainIndexList, numChains)) {
-      if (verbose) {
-          std::cout << "inconsistent entity idx: " << i << std::endl;
-      }
-      return false;   
+    const int64_t idx = findInvalidIndex(ent.chainIndexList, numChains);
+    if (idx >= 0) {
+      report.add(VALIDATION_INVALID_INDEX, ValidationMessage()
+          << "entityList[" << i << "].chainIndexList", idx,
+          ValidationMessage() << "inconsistent entity idx: " << i);
+      if (report.isFull()) return false;
+      valid_entities = false;
     }
   }
-  // check groups
+  // check groups (single pass over bonds of each group type) and keep counts
+  // for traversal below
+  std::vector<ConsistencyGroupCounts> group_counts(groupList.size());
   for (size_t i = 0; i < groupList.size(); ++i) {
     const GroupType& g = groupList[i];
     const size_t num_atoms = g.formalChargeList.size();
     if (g.atomNameList.size() != num_atoms) {
-      if (verbose) {
-        std::cout << "inconsistent group::atomNameList size at idx: "
-            << i << std::endl;
-      }
-      return false;
+      report.add(VALIDATION_WRONG_SIZE,
+          validationField(int64_t(i), "atomNameList"), -1,
+          ValidationMessage() << "inconsistent group::atomNameList size at "
+          "idx: " << i);
+      if (report.isFull()) return false;
     }
     if (g.elementList.size() != num_atoms) {
-      if (verbose) {
-        std::cout << "inconsistent group::elementList size at idx: "
-            << i << std::endl;
-      }
-      return false;
+      report.add(VALIDATION_WRONG_SIZE,
+          validationField(int64_t(i), "elementList"), -1,
+          ValidationMessage() << "inconsistent group::elementList size at "
+          "idx: " << i);
+      if (report.isFull()) return false;
     }
+    bool valid_bond_sizes = true;
     if (!isDefaultValue(g.bondOrderList)) {
       if (g.bondAtomList.size() != g.bondOrderList.size() * 2) {
-        if (verbose) {
-          std::cout << "inconsistent group::bondAtomList size: " <<
-              g.bondAtomList.size() << " != group::bondOrderList size(*2): " <<
-              g.bondOrderList.size()*2 << " at idx: " << i << std::endl;
-        }
-        return false;
-      }
-      for (size_t j = 0; j < g.bondOrderList.size(); ++j) {
-        if (std::find(allowed_bond_orders.begin(), allowed_bond_orders.end(),
-              g.bondOrderList[j]) == allowed_bond_orders.end()) {
-          if (verbose) {
-            std::cout << "Cannot have bond order of: " << (int)g.bondOrderList[j]
-                << " allowed bond orders are: -1, 1, 2, 3 or 4.  at idx: " << j << std::endl;
-          }
-          return false;
-        }
+        report.add(VALIDATION_WRONG_SIZE,
+            validationField(int64_t(i), "bondAtomList"), -1,
+            ValidationMessage() << "inconsistent group::bondAtomList size: "
+            << g.bondAtomList.size() << " != group::bondOrderList size(*2): "
+            << g.bondOrderList.size()*2 << " at idx: " << i);
+        if (report.isFull()) return false;
+        valid_bond_sizes = false;
       }
     }
     if (!isDefaultValue(g.bondResonanceList)) {
       if (isDefaultValue(g.bondOrderList) || isDefaultValue(g.bondAtomList)) {
-        if (verbose) {
-          std::cout << "Cannot have bondResonanceList without both " <<
-              "bondOrderList and bondAtomList! at idx: " << i << std::endl;
-        }
-        return false;
-      }
-      if (g.bondOrderList.size() != g.bondResonanceList.size()) {
-        if (verbose) {
-          std::cout << "inconsistent group::bondOrderSize size: " <<
-              g.bondOrderList.size() << " != group::bondResonanceList size: " <<
-              g.bondResonanceList.size() << " at idx: " << i << std::endl;
-        }
-        return false;
-      }
-      if (g.bondAtomList.size() != g.bondResonanceList.size() * 2) {
-        if (verbose) {
-          std::cout << "inconsistent group::bondAtomList size: " <<
-              g.bondAtomList.size() << " != group::bondResonanceList size(*2): " <<
-              g.bondResonanceList.size()*2 << " at idx: " << i << std::endl;
-        }
-        return false;
-      }
-      // Check bond resonance matches
-      for (size_t j = 0; j < g.bondResonanceList.size(); ++j) {
-        if (g.bondResonanceList[j] < -1 || g.bondResonanceList[j] > 1) {
-          if (verbose) {
-            std::cout << "group::bondResonanceList had a Resonance of: "
-              << (int)g.bondResonanceList[j] << " and only -1, 0, or 1 are allowed"
-              << std::endl;
-          }
-          return false;
-        }
-        if (g.bondOrderList[j] == -1 && g.bondResonanceList[j] != 1) {
-          if (verbose) {
-            std::cout << "group::bondResonanceList had a Resonance of: "
-              << (int)g.bondResonanceList[j] << " and group::bondOrderList had an order of "
-              << (int)g.bondOrderList[j] << " we require unknown bondOrders to have resonance"
-              << std::endl;
-          }
-          return false;
-        }
+        report.add(VALIDATION_MISSING_FIELD,
+            validationField(int64_t(i), "bondResonanceList"), -1,
+            ValidationMessage() << "Cannot have bondResonanceList without "
+            "both bondOrderList and bondAtomList! at idx: " << i);
+        if (report.isFull()) return false;
+        valid_bond_sizes = false;
+      } else if (g.bondOrderList.size() != g.bondResonanceList.size()) {
+        report.add(VALIDATION_WRONG_SIZE,
+            validationField(int64_t(i), "bondResonanceList"), -1,
+            ValidationMessage() << "inconsistent group::bondOrderSize size: "
+            << g.bondOrderList.size() << " != group::bondResonanceList size: "
+            << g.bondResonanceList.size() << " at idx: " << i);
+        if (report.isFull()) return false;
+        valid_bond_sizes = false;
       }
     }
-    if (!hasValidIndices(g.bondAtomList, num_atoms)) {
-      if (verbose) {
-        std::cout << "inconsistent group::bondAtomList indices (not all in [0, "
-            << num_atoms - 1 << "]) at idx: " << i << std::endl;
+    if (valid_bond_sizes) {
+      if (!validateBonds(g.bondAtomList, g.bondOrderList, g.bondResonanceList,
+                         int64_t(num_atoms), int64_t(i), report)) {
+        return false;
       }
-      return false;
     }
+    ConsistencyGroupCounts& counts = group_counts[i];
+    counts.num_atoms = int32_t(g.atomNameList.size());
+    counts.num_orders = isDefaultValue(g.bondOrderList)
+                      ? -1 : int32_t(g.bondOrderList.size());
+    counts.num_resonances = isDefaultValue(g.bondResonanceList)
+                          ? -1 : int32_t(g.bondResonanceList.size());
+    counts.num_bonds_from_atoms = isDefaultValue(g.bondAtomList)
+                                ? -1 : int32_t(g.bondAtomList.size() / 2);
   }
   // check global bonds
+  bool valid_bond_sizes = true;
   if (!isDefaultValue(bondOrderList)) {
     if (bondAtomList.size() != bondOrderList.size() * 2) {
-      if (verbose) {
-          std::cout << "inconsistent bondAtomList size: " <<
-              bondAtomList.size() << " != bondOrderList size(*2): " <<
-              bondOrderList.size()*2 << std::endl;
-      }
-      return false;
-    }
-    for (size_t i = 0; i < bondOrderList.size(); ++i) {
-      if (std::find(allowed_bond_orders.begin(), allowed_bond_orders.end(),
-            bondOrderList[i]) == allowed_bond_orders.end()) {
-        if (verbose) {
-          std::cout << "Cannot have bond order of: " << (int)bondOrderList[i]
-              << " allowed bond orders are: -1, 1, 2, 3 or 4.  at idx: " << i << std::endl;
-        }
-        return false;
-      }
+      report.add(VALIDATION_WRONG_SIZE, "bondAtomList", -1,
+          ValidationMessage() << "inconsistent bondAtomList size: "
+          << bondAtomList.size() << " != bondOrderList size(*2): "
+          << bondOrderList.size()*2);
+      if (report.isFull()) return false;
+      valid_bond_sizes = false;
     }
   }
   if (!isDefaultValue(bondResonanceList)) {
     if (isDefaultValue(bondOrderList) || isDefaultValue(bondAtomList)) {
-      if (verbose) {
-        std::cout << "Cannot have bondResonanceList without both " <<
-            "bondOrderList and bondAtomList!" << std::endl;
-      }
-      return false;
-    }
-    if (bondAtomList.size() != bondResonanceList.size() * 2) {
-      if (verbose) {
-          std::cout << "inconsistent bondAtomList size: " <<
-              bondAtomList.size() << " != bondResonanceList size(*2): " <<
-              bondResonanceList.size()*2 << std::endl;
-      }
-      return false;
-    }
-    for (size_t i = 0; i < bondResonanceList.size(); ++i) {
-      if (bondResonanceList[i] < -1 || bondResonanceList[i] > 1) {
-        if (verbose) {
-          std::cout << "bondResonanceList had a Resonance of: "
-            << (int)bondResonanceList[i] << " and only -1, 0, or 1 are allowed"
-            << std::endl;
-        }
-        return false;
-      }
-      if (bondOrderList[i] == -1 && bondResonanceList[i] != 1) {
-        if (verbose) {
-          std::cout << "bondResonanceList had a Resonance of: "
-            << (int)bondResonanceList[i] << " and bondOrderList had an order of "
-            << (int)bondOrderList[i] << " we require unknown bondOrders to have resonance"
-            << std::endl;
-        }
-        return false;
-      }
+      report.add(VALIDATION_MISSING_FIELD, "bondResonanceList", -1,
+          "Cannot have bondResonanceList without both bondOrderList and "
+          "bondAtomList!");
+      if (report.isFull()) return false;
+      valid_bond_sizes = false;
+    } else if (bondAtomList.size() != bondResonanceList.size() * 2) {
+      report.add(VALIDATION_WRONG_SIZE, "bondResonanceList", -1,
+          ValidationMessage() << "inconsistent bondAtomList size: "
+          << bondAtomList.size() << " != bondResonanceList size(*2): "
+          << bondResonanceList.size()*2);
+      if (report.isFull()) return false;
+      valid_bond_sizes = false;
     }
   }
-  if (!hasValidIndices(bondAtomList, numAtoms)) {
-    if (verbose) {
-      std::cout << "inconsistent bondAtomList indices (not all in [0, "
-          << numAtoms - 1 << "])" << std::endl;
+  if (valid_bond_sizes) {
+    if (!validateBonds(bondAtomList, bondOrderList, bondResonanceList,
+                       numAtoms, -1, report)) {
+      return false;
     }
-    return false;
   }
-  // check vector sizes
+  // check vector sizes (traversal below needs hierarchy and group lists)
+  bool valid_hierarchy = true;
   if ((int)xCoordList.size() != numAtoms) {
-    if (verbose) {
-      std::cout << "inconsistent xCoordList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "xCoordList", -1,
+               "inconsistent xCoordList size");
+    if (report.isFull()) return false;
   }
   if ((int)yCoordList.size() != numAtoms) {
-    if (verbose) {
-      std::cout << "inconsistent yCoordList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "yCoordList", -1,
+               "inconsistent yCoordList size");
+    if (report.isFull()) return false;
   }
   if ((int)zCoordList.size() != numAtoms) {
-    if (verbose) {
-      std::cout << "inconsistent zCoordList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "zCoordList", -1,
+               "inconsistent zCoordList size");
+    if (report.isFull()) return false;
   }
   if (!hasRightSizeOptional(bFactorList, numAtoms)) {
-    if (verbose) {
-      std::cout << "inconsistent bFactorList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "bFactorList", -1,
+               "inconsistent bFactorList size");
+    if (report.isFull()) return false;
   }
   if (!hasRightSizeOptional(atomIdList, numAtoms)) {
-    if (verbose) {
-      std::cout << "inconsistent atomIdList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "atomIdList", -1,
+               "inconsistent atomIdList size");
+    if (report.isFull()) return false;
   }
   if (!hasRightSizeOptional(altLocList, numAtoms)) {
-    if (verbose) {
-      std::cout << "inconsistent altLocList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "altLocList", -1,
+               "inconsistent altLocList size");
+    if (report.isFull()) return false;
   }
   if (!hasRightSizeOptional(occupancyList, numAtoms)) {
-    if (verbose) {
-      std::cout << "inconsistent occupancyList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "occupancyList", -1,
+               "inconsistent occupancyList size");
+    if (report.isFull()) return false;
   }
   if ((int)groupIdList.size() != numGroups) {
-    if (verbose) {
-      std::cout << "inconsistent groupIdList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "groupIdList", -1,
+               "inconsistent groupIdList size");
+    if (report.isFull()) return false;
   }
   if ((int)groupTypeList.size() != numGroups) {
-    if (verbose) {
-      std::cout << "inconsistent groupTypeList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "groupTypeList", -1,
+               "inconsistent groupTypeList size");
+    if (report.isFull()) return false;
+    valid_hierarchy = false;
   }
   if (!hasRightSizeOptional(secStructList, numGroups)) {
-    if (verbose) {
-      std::cout << "inconsistent secStructList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "secStructList", -1,
+               "inconsistent secStructList size");
+    if (report.isFull()) return false;
   }
   if (!hasRightSizeOptional(insCodeList, numGroups)) {
-    if (verbose) {
-      std::cout << "inconsistent insCodeList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "insCodeList", -1,
+               "inconsistent insCodeList size");
+    if (report.isFull()) return false;
   }
   if (!hasRightSizeOptional(sequenceIndexList, numGroups)) {
-    if (verbose) {
-      std::cout << "inconsistent sequenceIndexList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "sequenceIndexList", -1,
+               "inconsistent sequenceIndexList size");
+    if (report.isFull()) return false;
+    valid_hierarchy = false;
   }
   if ((int)chainIdList.size() != numChains) {
-    if (verbose) {
-      std::cout << "inconsistent chainIdList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "chainIdList", -1,
+               "inconsistent chainIdList size");
+    if (report.isFull()) return false;
+    valid_hierarchy = false;
   }
   if (!hasRightSizeOptional(chainNameList, numChains)) {
-    if (verbose) {
-      std::cout << "inconsistent chainNameList size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "chainNameList", -1,
+               "inconsistent chainNameList size");
+    if (report.isFull()) return false;
+    valid_hierarchy = false;
   }
   if ((int)groupsPerChain.size() != numChains) {
-    if (verbose) {
-      std::cout << "inconsistent groupsPerChain size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "groupsPerChain", -1,
+               "inconsistent groupsPerChain size");
+    if (report.isFull()) return false;
+    valid_hierarchy = false;
   }
   if ((int)chainsPerModel.size() != numModels) {
-    if (verbose) {
-      std::cout << "inconsistent chainsPerModel size" << std::endl;
-    }
-    return false;
+    report.add(VALIDATION_WRONG_SIZE, "chainsPerModel", -1,
+               "inconsistent chainsPerModel size");
+    if (report.isFull()) return false;
+    valid_hierarchy = false;
   }
-  // check indices
-  if (!hasValidIndices(groupTypeList, groupList.size())) {
-    if (verbose) {
-      std::cout << "inconsistent groupTypeList indices (not all in [0, "
-          << groupList.size() - 1 << "])" << std::endl;
-    }
-    return false;
+  if (!valid_hierarchy) return report.isValid();
+  // check hierarchy counts (guarantees valid indices in traversal below)
+  int64_t chain_count = 0;
+  for (int32_t i = 0; i < numModels; ++i) {
+    if (chainsPerModel[i] < 0) chain_count = -1;
+    if (chain_count >= 0) chain_count += chainsPerModel[i];
+  }
+  if (chain_count != numChains) {
+    report.add(VALIDATION_WRONG_COUNT, "numChains", -1,
+               "inconsistent numChains");
+    if (report.isFull()) return false;
+  }
+  std::vector<int32_t> group_begin(numChains + 1, 0);
+  int64_t group_count = 0;
+  for (int32_t i = 0; i < numChains; ++i) {
+    if (groupsPerChain[i] < 0) group_count = -1;
+    if (group_count >= 0) group_count += groupsPerChain[i];
+    group_begin[i + 1] = int32_t(group_count);
+  }
+  if (group_count != numGroups) {
+    report.add(VALIDATION_WRONG_COUNT, "numGroups", -1,
+               "inconsistent numGroups size");
+    return report.isValid();
   }
   // collect sequence lengths from entities and use to check
   std::vector<int32_t> sequenceIndexSize(numChains);
   for (size_t i = 0; i < entityList.size(); ++i) {
       const Entity& ent = entityList[i];
       for (size_t j = 0; j < ent.chainIndexList.size(); ++j) {
-          sequenceIndexSize[ent.chainIndexList[j]] = ent.sequence.length();
+          const int32_t chain_idx = ent.chainIndexList[j];
+          if (valid_entities || (chain_idx >= 0 && chain_idx < numChains)) {
+            sequenceIndexSize[chain_idx] = ent.sequence.length();
+          }
       }
   }
-  // traverse structure for more checks
-  int bond_count_from_atom = 0;
-  int bond_count_from_order = 0;
-  int bond_count_from_resonance = 0;
-  bool all_bond_orderLists_are_default = true;
-  bool all_bond_resonanceLists_are_default = true;
-  bool all_bond_atomLists_are_default = true;
+  // traverse chains for more checks (chains are independent, inconsistent
+  // ones are revisited serially to collect their issues)
+  int64_t num_atoms = 0;
+  int64_t num_orders = 0;
+  int64_t num_resonances = 0;
+  int64_t num_bonds_from_atoms = 0;
+  int64_t num_order_lists = 0;
+  int64_t num_resonance_lists = 0;
+  int64_t num_atom_lists = 0;
+  int num_inconsistent_chains = 0;
+  std::vector<char> inconsistent_chain(numChains, 0);
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(static) reduction(+:num_atoms, \
+      num_orders, num_resonances, num_bonds_from_atoms, num_order_lists, \
+      num_resonance_lists, num_atom_lists, num_inconsistent_chains)
+  #endif
+  for (int32_t chain_idx = 0; chain_idx < numChains; ++chain_idx) {
+    ConsistencySums sums;
+    if (!hasConsistentChain(*this, chain_idx, group_begin, group_counts,
+                            sequenceIndexSize, chain_name_max_length, NULL,
+                            sums)) {
+      inconsistent_chain[chain_idx] = 1;
+      ++num_inconsistent_chains;
+      continue;
+    }
+    num_atoms += sums.num_atoms;
+    num_orders += sums.num_orders;
+    num_resonances += sums.num_resonances;
+    num_bonds_from_atoms += sums.num_bonds_from_atoms;
+    num_order_lists += sums.num_order_lists;
+    num_resonance_lists += sums.num_resonance_lists;
+    num_atom_lists += sums.num_atom_lists;
+  }
+  int64_t num_unknown_groups = 0;
+  for (int32_t chain_idx = 0; num_inconsistent_chains > 0
+                              && chain_idx < numChains; ++chain_idx) {
+    if (!inconsistent_chain[chain_idx]) continue;
+    ConsistencySums sums;
+    hasConsistentChain(*this, chain_idx, group_begin, group_counts,
+                       sequenceIndexSize, chain_name_max_length, &report,
+                       sums);
+    if (report.isFull()) return false;
+    num_atoms += sums.num_atoms;
+    num_orders += sums.num_orders;
+    num_resonances += sums.num_resonances;
+    num_bonds_from_atoms += sums.num_bonds_from_atoms;
+    num_order_lists += sums.num_order_lists;
+    num_resonance_lists += sums.num_resonance_lists;
+    num_atom_lists += sums.num_atom_lists;
+    num_unknown_groups += sums.num_unknown_groups;
+  }
+  // counts are unknown if groups have invalid group types
+  if (num_unknown_groups > 0) return false;
+  // add global bonds
   if (!isDefaultValue(bondOrderList)) {
-    all_bond_orderLists_are_default = false;
-    bond_count_from_order = bondOrderList.size();
+    ++num_order_lists;
+    num_orders += bondOrderList.size();
   }
   if (!isDefaultValue(bondResonanceList)) {
-    all_bond_resonanceLists_are_default = false;
-    bond_count_from_resonance = bondOrderList.size();
+    ++num_resonance_lists;
+    num_resonances += bondResonanceList.size();
   }
   if (!isDefaultValue(bondAtomList)) {
-    all_bond_atomLists_are_default = false;
-    bond_count_from_atom = bondAtomList.size()/2;
-  }
-  int chain_idx = 0; // will be count at end of loop
-  int group_idx = 0; // will be count at end of loop
-  int atom_idx = 0;  // will be count at end of loop
-  // traverse models
-  for (int model_idx = 0; model_idx < numModels; ++model_idx) {
-    // traverse chains
-    for (int j = 0; j < chainsPerModel[model_idx]; ++j, ++chain_idx) {
-      // check chain names (fixed length)
-      if (chainIdList[chain_idx].size() > chain_name_max_length) {
-        if (verbose) {
-          std::cout << "inconsistent chainIdList size at chain_idx: "
-            << chain_idx << " size: "
-            << chainIdList[chain_idx].size() << std::endl;
-        }
-        return false;
-      }
-      if (   !isDefaultValue(chainNameList)
-        && chainNameList[chain_idx].size() > chain_name_max_length) {
-        if (verbose) {
-          std::cout << "inconsistent chainNameList size at chain_idx:"
-            << chain_idx << " size: "
-            << chainNameList[chain_idx].size() << std::endl;
-        }
-        return false;
-      }
-      // traverse groups
-      for (int k = 0; k < groupsPerChain[chain_idx]; ++k, ++group_idx) {
-        // check seq. idx
-        if (!isDefaultValue(sequenceIndexList)) {
-          const int32_t idx = sequenceIndexList[group_idx];
-          // -1 is ok here
-          if (idx < -1 || idx >= sequenceIndexSize[chain_idx]) {
-            if (verbose) {
-              std::cout << "inconsistent sequenceIndexSize at"
-                " chain_idx: " << chain_idx << std::endl;
-            }
-            return false;
-          }
-        }
-        // count atoms
-        const GroupType& group = groupList[groupTypeList[group_idx]];
-        atom_idx += group.atomNameList.size();
-        // count bonds
-        if (!isDefaultValue(group.bondOrderList)) {
-          all_bond_orderLists_are_default = false;
-          bond_count_from_order += group.bondOrderList.size();
-        }
-        if (!isDefaultValue(group.bondResonanceList)) {
-          all_bond_resonanceLists_are_default = false;
-          bond_count_from_resonance += group.bondResonanceList.size();
-        }
-        if (!isDefaultValue(group.bondAtomList)) {
-          all_bond_atomLists_are_default = false;
-          bond_count_from_atom += group.bondAtomList.size()/2;
-        }
-
-      }
-    }
+    ++num_atom_lists;
+    num_bonds_from_atoms += bondAtomList.size() / 2;
   }
   // check sizes
-  if (!all_bond_orderLists_are_default) {
-    if (bond_count_from_order != numBonds) {
-      if (verbose) {
-        std::cout << "inconsistent numBonds vs bond order count" << std::endl;
-      }
-      return false;
-    }
-  }
-  if (!all_bond_resonanceLists_are_default) {
-    if (bond_count_from_resonance != numBonds) {
-      if (verbose) {
-        std::cout << "inconsistent numBonds vs bond resonance count" << std::endl;
-      }
-      return false;
-    }
+  if (num_order_lists > 0 && num_orders != numBonds) {
+    report.add(VALIDATION_WRONG_COUNT, "numBonds", -1,
+               "inconsistent numBonds vs bond order count");
+    if (report.isFull()) return false;
   }
-  if (!all_bond_atomLists_are_default) {
-    if (bond_count_from_atom != numBonds) {
-      if (verbose) {
-        std::cout << "inconsistent numBonds vs bond atom list count" << std::endl;
-      }
-      return false;
-    }
+  if (num_resonance_lists > 0 && num_resonances != numBonds) {
+    report.add(VALIDATION_WRONG_COUNT, "numBonds", -1,
+               "inconsistent numBonds vs bond resonance count");
+    if (report.isFull()) return false;
   }
-  if (chain_idx != numChains) {
-    if (verbose) {
-      std::cout << "inconsistent numChains" << std::endl;
-    }
-    return false;
+  if (num_atom_lists > 0 && num_bonds_from_atoms != numBonds) {
+    report.add(VALIDATION_WRONG_COUNT, "numBonds", -1,
+               "inconsistent numBonds vs bond atom list count");
+    if (report.isFull()) return false;
   }
-  if (group_idx != numGroups) {
-    if (verbose) {
-      std::cout << "inconsistent numGroups size" << std::endl;
-    }
-    return false;
-  }
-  if (atom_idx != numAtoms) {
-    if (verbose) {
-      std::cout << "inconsistent numAtoms size" << std::endl;
-    }
-    return false;
+  if (num_atoms != numAtoms) {
+    report.add(VALIDATION_WRONG_COUNT, "numAtoms", -1,
+               "inconsistent numAtoms size");
   }
-  // All looks good :)
-  return true;
+  return report.isValid();
 }
 
 inline std::string StructureData::print(std::string delim) const {
   std::ostringstream out;
+  const ClassificationTable classification(*this);
   int modelIndex = 0;
   int chainIndex = 0;
   int groupIndex = 0;
@@ -1044,7 +1283,7 @@ inline std::string StructureData::print(std::string delim) const {
 
         for (int l = 0; l < groupAtomCount; l++, atomIndex++) {
           // ATOM or HETATM
-          if (is_hetatm(chainIndex, entityList, group))
+          if (classification.isHetatm(chainIndex, groupTypeList[groupIndex]))
             out << "HETATM" << delim;
           else
             out << "ATOM" << delim;
@@ -1139,6 +1378,7 @@ inline void StructureData::copyAllData_(const StructureData& obj) {
   groupList = obj.groupList;
   bondAtomList = obj.bondAtomList;
   bondOrderList = obj.bondOrderList;
+  bondResonanceList = obj.bondResonanceList;
   xCoordList = obj.xCoordList;
   yCoordList = obj.yCoordList;
   zCoordList = obj.zCoordList;
@@ -0,0 +1,898 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Deterministic generator of synthetic structures of arbitrary size.
+// See tests/mmtf_tests.cpp (Test synthetic structures) and
+// "examples/generate_synthetic.cpp" for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_SYNTHETIC_H
+#define MMTF_SYNTHETIC_H
+
+#include "structure_data.hpp"
+#include "errors.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mmtf {
+
+/**
+ * @brief Options for ::generateSyntheticStructure.
+ */
+struct SyntheticOptions {
+    int32_t numAtoms;         ///< Atoms per model
+    int32_t numModels;        ///< Number of models (> 1 for NMR-like ensembles)
+    int32_t residuesPerChain; ///< Mean number of residues per protein chain
+    float waterFraction;      ///< Fraction of atoms in water molecules
+    float altLocFraction;     ///< Fraction of residues with two conformers
+    uint32_t seed;            ///< Seed for the pseudo random numbers
+
+    SyntheticOptions(): numAtoms(10000), numModels(1), residuesPerChain(250),
+                        waterFraction(0.1f), altLocFraction(0.03f), seed(42) {}
+};
+
+/**
+ * @brief Generate a synthetic but realistic structure.
+ *
+ * @param[out] data    Structure to be filled (previous contents are removed)
+ * @param[in]  options Size, layout and seed of the structure
+ * @throw mmtf::EncodeError if options are invalid (numAtoms, numModels or
+ *        residuesPerChain < 1, fractions outside [0, 1] or more than 2^31-1
+ *        atoms in total)
+ *
+ * Each model consists of protein chains built from the 20 standard amino
+ * acids (heavy atoms with element, bond and bond order information, drawn
+ * with natural abundances), a chain of sulfate ions and a chain of waters.
+ * Chains are compact random walks of C-alpha atoms 3.8 A apart with side
+ * chains grown at bond distance. Neighbouring chains may share an entity
+ * (homo-oligomers), residues have helix, strand and coil runs, B-factors grow
+ * towards side chain tips and solvent, and a fraction of residues has two
+ * side chain conformers (alt-locs A and B with occupancies summing to 1).
+ * Additional models are perturbed copies of the first one. Coordinates,
+ * B-factors and occupancies are rounded to the precision of the default
+ * encoder settings, so that encoding and decoding is loss-less.
+ *
+ * Every model has exactly options.numAtoms atoms. Proteins only get complete
+ * residues and the remaining atoms are filled up with water, so there may be
+ * a few water molecules even for waterFraction 0 (and only water for less
+ * atoms than in the largest residue). The result passes
+ * StructureData::hasConsistentData and only depends on the options (the
+ * pseudo random numbers are platform independent).
+ */
+inline void generateSyntheticStructure(StructureData& data,
+        const SyntheticOptions& options = SyntheticOptions());
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+namespace {
+
+// 64 bit constant without C++11 long long literals
+inline uint64_t syntheticConstant(uint32_t high, uint32_t low) {
+    return (uint64_t(high) << 32) | low;
+}
+
+// splitmix64 pseudo random numbers (same sequence on all platforms)
+class SyntheticRandom {
+public:
+    explicit SyntheticRandom(uint64_t seed): state_(seed) {}
+
+    uint32_t next() {
+        uint64_t z = (state_ += syntheticConstant(0x9E3779B9, 0x7F4A7C15));
+        z = (z ^ (z >> 30)) * syntheticConstant(0xBF58476D, 0x1CE4E5B9);
+        z = (z ^ (z >> 27)) * syntheticConstant(0x94D049BB, 0x133111EB);
+        return uint32_t((z ^ (z >> 31)) >> 32);
+    }
+    // uniform in [0, 1)
+    float uniform() { return float(next() >> 8) * (1.0f / 16777216.0f); }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+    // uniform in [0, n)
+    int32_t index(int32_t n) { return int32_t((uint64_t(next()) * n) >> 32); }
+    // approx. standard normal (Irwin-Hall, avoids platform dependent libm)
+    float normal() {
+        const float sum = uniform() + uniform() + uniform() + uniform();
+        return (sum - 2.0f) * 1.7320508f;
+    }
+    // random direction
+    void direction(float* v) {
+        float len2;
+        do {
+            v[0] = uniform(-1, 1);
+            v[1] = uniform(-1, 1);
+            v[2] = uniform(-1, 1);
+            len2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+        } while (len2 > 1 || len2 < 1e-4f);
+        const float inv = 1.0f / std::sqrt(len2);
+        v[0] *= inv;
+        v[1] *= inv;
+        v[2] *= inv;
+    }
+
+private:
+    uint64_t state_;
+};
+
+// heavy atoms of amino acids ('=' marks double bonds)
+struct SyntheticResidue {
+    const char* name;
+    char code;
+    int weight;  // natural abundance in 1/1000
+    const char* atoms;
+    const char* bonds;
+};
+
+const SyntheticResidue SYNTHETIC_RESIDUES[] = {
+    {"ALA", 'A', 83, "N CA C O CB", "N-CA CA-C C=O CA-CB"},
+    {"ARG", 'R', 55, "N CA C O CB CG CD NE CZ NH1 NH2",
+     "N-CA CA-C C=O CA-CB CB-CG CG-CD CD-NE NE-CZ CZ-NH1 CZ=NH2"},
+    {"ASN", 'N', 41, "N CA C O CB CG OD1 ND2",
+     "N-CA CA-C C=O CA-CB CB-CG CG=OD1 CG-ND2"},
+    {"ASP", 'D', 55, "N CA C O CB CG OD1 OD2",
+     "N-CA CA-C C=O CA-CB CB-CG CG=OD1 CG-OD2"},
+    {"CYS", 'C', 14, "N CA C O CB SG", "N-CA CA-C C=O CA-CB CB-SG"},
+    {"GLN", 'Q', 39, "N CA C O CB CG CD OE1 NE2",
+     "N-CA CA-C C=O CA-CB CB-CG CG-CD CD=OE1 CD-NE2"},
+    {"GLU", 'E', 68, "N CA C O CB CG CD OE1 OE2",
+     "N-CA CA-C C=O CA-CB CB-CG CG-CD CD=OE1 CD-OE2"},
+    {"GLY", 'G', 71, "N CA C O", "N-CA CA-C C=O"},
+    {"HIS", 'H', 23, "N CA C O CB CG ND1 CD2 CE1 NE2",
+     "N-CA CA-C C=O CA-CB CB-CG CG-ND1 CG=CD2 ND1=CE1 CD2-NE2 CE1-NE2"},
+    {"ILE", 'I', 59, "N CA C O CB CG1 CG2 CD1",
+     "N-CA CA-C C=O CA-CB CB-CG1 CB-CG2 CG1-CD1"},
+    {"LEU", 'L', 99, "N CA C O CB CG CD1 CD2",
+     "N-CA CA-C C=O CA-CB CB-CG CG-CD1 CG-CD2"},
+    {"LYS", 'K', 58, "N CA C O CB CG CD CE NZ",
+     "N-CA CA-C C=O CA-CB CB-CG CG-CD CD-CE CE-NZ"},
+    {"MET", 'M', 24, "N CA C O CB CG SD CE",
+     "N-CA CA-C C=O CA-CB CB-CG CG-SD SD-CE"},
+    {"PHE", 'F', 39, "N CA C O CB CG CD1 CD2 CE1 CE2 CZ",
+     "N-CA CA-C C=O CA-CB CB-CG CG=CD1 CG-CD2 CD1-CE1 CD2=CE2 CE1=CZ CE2-CZ"},
+    {"PRO", 'P', 47, "N CA C O CB CG CD",
+     "N-CA CA-C C=O CA-CB CB-CG CG-CD CD-N"},
+    {"SER", 'S', 66, "N CA C O CB OG", "N-CA CA-C C=O CA-CB CB-OG"},
+    {"THR", 'T', 53, "N CA C O CB OG1 CG2",
+     "N-CA CA-C C=O CA-CB CB-OG1 CB-CG2"},
+    {"TRP", 'W', 11, "N CA C O CB CG CD1 CD2 NE1 CE2 CE3 CZ2 CZ3 CH2",
+     "N-CA CA-C C=O CA-CB CB-CG CG=CD1 CG-CD2 CD1-NE1 CD2=CE2 CD2-CE3 "
+     "NE1-CE2 CE2-CZ2 CE3=CZ3 CZ2=CH2 CZ3-CH2"},
+    {"TYR", 'Y', 29, "N CA C O CB CG CD1 CD2 CE1 CE2 CZ OH",
+     "N-CA CA-C C=O CA-CB CB-CG CG=CD1 CG-CD2 CD1-CE1 CD2=CE2 CE1=CZ CE2-CZ "
+     "CZ-OH"},
+    {"VAL", 'V', 69, "N CA C O CB CG1 CG2", "N-CA CA-C C=O CA-CB CB-CG1 CB-CG2"}
+};
+const int32_t SYNTHETIC_NUM_RESIDUES = 20;
+
+// group type with placement information
+struct SyntheticTemplate {
+    GroupType group;
+    std::vector<int32_t> order;   // atoms such that parents come first
+    std::vector<int32_t> parent;  // atom to grow from (-1 for root)
+    std::vector<int32_t> depth;   // bonds from root
+    std::vector<int32_t> rank;    // position in order
+    std::vector<int32_t> closure; // bonded atom placed before (not parent)
+    bool ring;                    // has ring closing bonds
+    std::vector<char> altLoc;     // per atom
+    int32_t n_atom;               // N (or -1)
+    int32_t c_atom;               // C (or -1)
+    int32_t o_atom;               // O (or -1)
+};
+
+inline std::vector<std::string> syntheticSplit(const char* text) {
+    std::vector<std::string> tokens;
+    std::istringstream in(text);
+    std::string token;
+    while (in >> token) tokens.push_back(token);
+    return tokens;
+}
+
+inline int32_t syntheticFind(const std::vector<std::string>& names,
+                             const std::string& name) {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) return int32_t(i);
+    }
+    return -1;
+}
+
+// group type without bonds from atom names (element = first letter)
+inline GroupType syntheticGroup(const char* name, char code,
+                                const char* chem_comp_type,
+                                const char* atoms) {
+    GroupType group;
+    group.groupName = name;
+    group.singleLetterCode = code;
+    group.chemCompType = chem_comp_type;
+    group.atomNameList = syntheticSplit(atoms);
+    for (size_t i = 0; i < group.atomNameList.size(); ++i) {
+        group.elementList.push_back(group.atomNameList[i].substr(0, 1));
+        group.formalChargeList.push_back(0);
+    }
+    return group;
+}
+
+inline void syntheticAddBond(GroupType& group, int32_t a, int32_t b,
+                             int8_t order) {
+    group.bondAtomList.push_back(a);
+    group.bondAtomList.push_back(b);
+    group.bondOrderList.push_back(order);
+}
+
+// fill placement information by breadth first search from root
+inline void syntheticLayout(SyntheticTemplate& t, int32_t root) {
+    const GroupType& group = t.group;
+    const int32_t num_atoms = int32_t(group.atomNameList.size());
+    t.parent.assign(num_atoms, -1);
+    t.depth.assign(num_atoms, -1);
+    t.order.clear();
+    t.order.push_back(root);
+    t.depth[root] = 0;
+    for (size_t k = 0; k < t.order.size(); ++k) {
+        const int32_t atom = t.order[k];
+        for (size_t b = 0; b < group.bondOrderList.size(); ++b) {
+            int32_t other = -1;
+            if (group.bondAtomList[2 * b] == atom) {
+                other = group.bondAtomList[2 * b + 1];
+            } else if (group.bondAtomList[2 * b + 1] == atom) {
+                other = group.bondAtomList[2 * b];
+            }
+            if (other >= 0 && t.depth[other] < 0) {
+                t.parent[other] = atom;
+                t.depth[other] = t.depth[atom] + 1;
+                t.order.push_back(other);
+            }
+        }
+    }
+    // unbonded atoms are placed around root
+    for (int32_t i = 0; i < num_atoms; ++i) {
+        if (t.depth[i] < 0) {
+            t.parent[i] = root;
+            t.depth[i] = 1;
+            t.order.push_back(i);
+        }
+    }
+    t.rank.assign(num_atoms, 0);
+    for (int32_t k = 0; k < num_atoms; ++k) t.rank[t.order[k]] = k;
+    t.closure.assign(num_atoms, -1);
+    t.ring = false;
+    for (size_t b = 0; b < group.bondOrderList.size(); ++b) {
+        int32_t a1 = group.bondAtomList[2 * b];
+        int32_t a2 = group.bondAtomList[2 * b + 1];
+        if (t.parent[a1] == a2 || t.parent[a2] == a1) continue;
+        if (t.rank[a1] < t.rank[a2]) std::swap(a1, a2);
+        t.closure[a1] = a2;
+        t.ring = true;
+    }
+}
+
+inline SyntheticTemplate syntheticAminoAcid(const SyntheticResidue& res) {
+    SyntheticTemplate t;
+    t.group = syntheticGroup(res.name, res.code,
+                             res.code == 'G' ? "PEPTIDE LINKING"
+                                             : "L-PEPTIDE LINKING",
+                             res.atoms);
+    const std::vector<std::string> bonds = syntheticSplit(res.bonds);
+    for (size_t i = 0; i < bonds.size(); ++i) {
+        const size_t sep = bonds[i].find_first_of("-=");
+        syntheticAddBond(t.group,
+                         syntheticFind(t.group.atomNameList,
+                                       bonds[i].substr(0, sep)),
+                         syntheticFind(t.group.atomNameList,
+                                       bonds[i].substr(sep + 1)),
+                         bonds[i][sep] == '=' ? 2 : 1);
+    }
+    syntheticLayout(t, syntheticFind(t.group.atomNameList, "CA"));
+    t.altLoc.assign(t.group.atomNameList.size(), '\0');
+    t.n_atom = syntheticFind(t.group.atomNameList, "N");
+    t.c_atom = syntheticFind(t.group.atomNameList, "C");
+    t.o_atom = syntheticFind(t.group.atomNameList, "O");
+    return t;
+}
+
+// side chain (CB and atoms grown from it) in conformers A and B
+inline SyntheticTemplate syntheticAltLocVariant(const SyntheticTemplate& base) {
+    SyntheticTemplate t = base;
+    const int32_t num_atoms = int32_t(base.group.atomNameList.size());
+    const int32_t cb = syntheticFind(base.group.atomNameList, "CB");
+    std::vector<bool> side(num_atoms, false);
+    std::vector<int32_t> copy(num_atoms, -1);
+    for (size_t k = 0; k < base.order.size(); ++k) {
+        const int32_t atom = base.order[k];
+        side[atom] = (atom == cb)
+                     || (base.parent[atom] >= 0 && side[base.parent[atom]]);
+        if (!side[atom]) continue;
+        copy[atom] = int32_t(t.group.atomNameList.size());
+        t.group.atomNameList.push_back(base.group.atomNameList[atom]);
+        t.group.elementList.push_back(base.group.elementList[atom]);
+        t.group.formalChargeList.push_back(base.group.formalChargeList[atom]);
+        t.altLoc[atom] = 'A';
+        t.altLoc.push_back('B');
+    }
+    for (size_t b = 0; b < base.group.bondOrderList.size(); ++b) {
+        const int32_t a1 = base.group.bondAtomList[2 * b];
+        const int32_t a2 = base.group.bondAtomList[2 * b + 1];
+        if (!side[a1] && !side[a2]) continue;
+        syntheticAddBond(t.group, side[a1] ? copy[a1] : a1,
+                         side[a2] ? copy[a2] : a2,
+                         base.group.bondOrderList[b]);
+    }
+    syntheticLayout(t, syntheticFind(t.group.atomNameList, "CA"));
+    return t;
+}
+
+// rounded as by encoder and decoder with given divisor
+inline float syntheticRound(float value, int32_t divisor) {
+    const float scaled = std::floor(value * float(divisor) + 0.5f);
+    return float(int32_t(scaled)) * (float(1) / float(divisor));
+}
+
+inline std::string syntheticChainName(int32_t index) {
+    std::string name;
+    do {
+        name += char('A' + index % 26);
+        index /= 26;
+    } while (index > 0 && name.size() < 4);
+    return name;
+}
+
+// builds one model atom by atom (residue types, coordinates, B-factors)
+class SyntheticBuilder {
+public:
+    SyntheticBuilder(StructureData& data, SyntheticRandom& rng)
+        : data_(data), rng_(rng), chain_b_(20), prev_c_(-1) {
+        for (int32_t i = 0; i < SYNTHETIC_NUM_RESIDUES; ++i) {
+            templates_.push_back(syntheticAminoAcid(SYNTHETIC_RESIDUES[i]));
+            templates_.push_back(syntheticAltLocVariant(templates_.back()));
+        }
+        SyntheticTemplate sulfate;
+        sulfate.group = syntheticGroup("SO4", '?', "NON-POLYMER",
+                                       "S O1 O2 O3 O4");
+        sulfate.group.formalChargeList[3] = -1;
+        sulfate.group.formalChargeList[4] = -1;
+        syntheticAddBond(sulfate.group, 0, 1, 2);
+        syntheticAddBond(sulfate.group, 0, 2, 2);
+        syntheticAddBond(sulfate.group, 0, 3, 1);
+        syntheticAddBond(sulfate.group, 0, 4, 1);
+        syntheticLayout(sulfate, 0);
+        sulfate.altLoc.assign(5, '\0');
+        sulfate.n_atom = sulfate.c_atom = sulfate.o_atom = -1;
+        templates_.push_back(sulfate);
+        SyntheticTemplate water;
+        water.group = syntheticGroup("HOH", '?', "NON-POLYMER", "O");
+        syntheticLayout(water, 0);
+        water.altLoc.assign(1, '\0');
+        water.n_atom = water.c_atom = water.o_atom = -1;
+        templates_.push_back(water);
+        group_index_.assign(templates_.size(), -1);
+    }
+
+    static int32_t sulfate() { return 2 * SYNTHETIC_NUM_RESIDUES; }
+    static int32_t water() { return 2 * SYNTHETIC_NUM_RESIDUES + 1; }
+    int32_t numAtoms(int32_t t) const {
+        return int32_t(templates_[t].group.atomNameList.size());
+    }
+
+    // start new chain with (mean) B-factor and C-alpha trace within sphere
+    void addChain(const std::string& name, const float* center,
+                  float radius) {
+        data_.chainIdList.push_back(name);
+        data_.chainNameList.push_back(name);
+        data_.groupsPerChain.push_back(0);
+        ++data_.numChains;
+        for (int i = 0; i < 3; ++i) {
+            center_[i] = pos_[i] = next_[i] = center[i];
+            step_[i] = plane_[i] = 0;
+        }
+        radius_ = radius;
+        chain_b_ = rng_.uniform(12, 35);
+        prev_c_ = -1;
+    }
+
+    // append residue t (with alt-locs if requested) to current chain
+    void addResidue(int32_t t, bool alt_loc, int32_t group_id,
+                    int32_t seq_index, int32_t sec_struct) {
+        if (alt_loc) t += 1;
+        const SyntheticTemplate& tmpl = templates_[t];
+        const bool polymer = (tmpl.n_atom >= 0);
+        const bool linked = polymer && prev_c_ >= 0;
+        // peptide plane of previous residue (CA(i-1) -> CA(i))
+        float prev_step[3], prev_plane[3];
+        for (int i = 0; i < 3; ++i) {
+            prev_step[i] = step_[i];
+            prev_plane[i] = plane_[i];
+        }
+        if (polymer) advanceTrace_(linked);
+        else         randomSpot_();
+        if (group_index_[t] < 0) {
+            group_index_[t] = int32_t(data_.groupList.size());
+            data_.groupList.push_back(tmpl.group);
+        }
+        const int32_t first = data_.numAtoms;
+        const int32_t num_atoms = numAtoms(t);
+        data_.xCoordList.resize(first + num_atoms);
+        data_.yCoordList.resize(first + num_atoms);
+        data_.zCoordList.resize(first + num_atoms);
+        data_.bFactorList.resize(first + num_atoms);
+        data_.occupancyList.resize(first + num_atoms);
+        // backbone in peptide planes, others at bond distance from parent
+        // (C-alpha to C or N 1.52 A, C to next N 1.33 A)
+        const float along = 1.235f;
+        const float across = 0.886f;
+        const bool solvent = (t == water());
+        const float res_b = chain_b_ + std::fabs(rng_.normal()) * 4
+                            + (solvent ? 10 : 0);
+        const float occupancy = syntheticRound(rng_.uniform(0.5f, 0.8f), 100);
+        float xyz[3];
+        for (size_t k = 0; k < tmpl.order.size(); ++k) {
+            const int32_t atom = tmpl.order[k];
+            const int32_t parent = tmpl.parent[atom];
+            if (parent < 0) {
+                for (int i = 0; i < 3; ++i) xyz[i] = pos_[i];
+            } else if (atom == tmpl.n_atom) {
+                const float* step = linked ? prev_step : step_;
+                const float* plane = linked ? prev_plane : plane_;
+                for (int i = 0; i < 3; ++i) {
+                    xyz[i] = pos_[i] - along * step[i] + across * plane[i];
+                }
+            } else if (atom == tmpl.c_atom) {
+                for (int i = 0; i < 3; ++i) {
+                    xyz[i] = pos_[i] + along * step_[i] + across * plane_[i];
+                }
+            } else if (atom == tmpl.o_atom) {
+                // in plane, pointing away from C-alpha and next N
+                float dir[3];
+                for (int i = 0; i < 3; ++i) {
+                    dir[i] = 1.23f * (0.952f * plane_[i] - 0.306f * step_[i]);
+                }
+                xyz[0] = data_.xCoordList[first + parent] + dir[0];
+                xyz[1] = data_.yCoordList[first + parent] + dir[1];
+                xyz[2] = data_.zCoordList[first + parent] + dir[2];
+            } else {
+                growAtom_(tmpl, first, k, xyz);
+            }
+            data_.xCoordList[first + atom] = syntheticRound(xyz[0], 1000);
+            data_.yCoordList[first + atom] = syntheticRound(xyz[1], 1000);
+            data_.zCoordList[first + atom] = syntheticRound(xyz[2], 1000);
+            float b = res_b + 2.5f * float(tmpl.depth[atom])
+                      + std::fabs(rng_.normal()) * (solvent ? 8 : 1.5f);
+            if (tmpl.altLoc[atom] != '\0') b += 5;
+            data_.bFactorList[first + atom] =
+                syntheticRound(std::min(b, 150.0f), 100);
+            float occ = 1;
+            if (tmpl.altLoc[atom] == 'A') occ = occupancy;
+            if (tmpl.altLoc[atom] == 'B') occ = syntheticRound(1 - occupancy,
+                                                               100);
+            if (solvent && rng_.index(10) == 0) occ = 0.5f;
+            data_.occupancyList[first + atom] = occ;
+        }
+        for (int32_t i = 0; i < num_atoms; ++i) {
+            data_.altLocList.push_back(tmpl.altLoc[i]);
+            data_.atomIdList.push_back(first + i + 1);
+        }
+        data_.numAtoms += num_atoms;
+        data_.numBonds += int32_t(tmpl.group.bondOrderList.size());
+        // peptide bond to previous residue
+        if (linked) {
+            data_.bondAtomList.push_back(prev_c_);
+            data_.bondAtomList.push_back(first + tmpl.n_atom);
+            data_.bondOrderList.push_back(1);
+            ++data_.numBonds;
+        }
+        prev_c_ = polymer ? first + tmpl.c_atom : -1;
+        data_.groupIdList.push_back(group_id);
+        data_.groupTypeList.push_back(group_index_[t]);
+        data_.secStructList.push_back(int8_t(sec_struct));
+        data_.insCodeList.push_back('\0');
+        data_.sequenceIndexList.push_back(seq_index);
+        ++data_.groupsPerChain.back();
+        ++data_.numGroups;
+    }
+
+private:
+    StructureData& data_;
+    SyntheticRandom& rng_;
+    std::vector<SyntheticTemplate> templates_;
+    std::vector<int32_t> group_index_;  // template -> groupList index
+    float center_[3];
+    float radius_;
+    float pos_[3];    // current C-alpha (or non-polymer root atom)
+    float next_[3];   // next C-alpha
+    float step_[3];   // unit vector from pos_ to next_
+    float plane_[3];  // unit vector perpendicular to step_ (peptide plane)
+    float chain_b_;
+    int32_t prev_c_;  // atom index of C in previous residue (or -1)
+
+    // position of atom order[k] of tmpl at bond distance from its parent
+    // (tetrahedral angles, planar for rings, ring closures between ends)
+    void growAtom_(const SyntheticTemplate& tmpl, int32_t first, size_t k,
+                   float* xyz) {
+        const int32_t atom = tmpl.order[k];
+        const int32_t parent = tmpl.parent[atom];
+        const float length = 1.45f + 0.03f * rng_.normal();
+        float p[3], dir[3];
+        atomPos_(first + parent, p);
+        if (tmpl.closure[atom] >= 0) {
+            float o[3], mid[3], axis[3];
+            atomPos_(first + tmpl.closure[atom], o);
+            for (int i = 0; i < 3; ++i) {
+                mid[i] = 0.5f * (p[i] + o[i]);
+                axis[i] = o[i] - p[i];
+            }
+            const float half2 = 0.25f * dot_(axis, axis);
+            if (half2 < length * length) {
+                const float h = std::sqrt(length * length - half2);
+                perpendicular_(axis, dir);
+                for (int i = 0; i < 3; ++i) xyz[i] = mid[i] + h * dir[i];
+            } else {
+                const float inv = length / std::sqrt(4 * half2);
+                for (int i = 0; i < 3; ++i) xyz[i] = p[i] + inv * axis[i];
+            }
+            return;
+        }
+        const int32_t grand = tmpl.parent[parent];
+        if (grand < 0) {
+            // away from atoms already bonded to parent
+            float away[3] = {0, 0, 0};
+            for (size_t b = 0; b < tmpl.group.bondOrderList.size(); ++b) {
+                int32_t other = -1;
+                if (tmpl.group.bondAtomList[2 * b] == parent) {
+                    other = tmpl.group.bondAtomList[2 * b + 1];
+                } else if (tmpl.group.bondAtomList[2 * b + 1] == parent) {
+                    other = tmpl.group.bondAtomList[2 * b];
+                }
+                if (other < 0 || tmpl.rank[other] >= int32_t(k)) continue;
+                float q[3];
+                atomPos_(first + other, q);
+                for (int i = 0; i < 3; ++i) away[i] += p[i] - q[i];
+            }
+            rng_.direction(dir);
+            const float len2 = dot_(away, away);
+            if (len2 > 1e-4f) {
+                const float inv = 1.0f / std::sqrt(len2);
+                for (int i = 0; i < 3; ++i) {
+                    dir[i] = away[i] * inv + 0.5f * dir[i];
+                }
+                const float norm = 1.0f / std::sqrt(dot_(dir, dir));
+                for (int i = 0; i < 3; ++i) dir[i] *= norm;
+            }
+        } else {
+            // bond angle 109.5 deg to grandparent, torsion 0 in rings
+            float g[3], u[3], w[3];
+            atomPos_(first + grand, g);
+            for (int i = 0; i < 3; ++i) u[i] = p[i] - g[i];
+            const float inv = 1.0f / std::sqrt(std::max(dot_(u, u), 1e-4f));
+            for (int i = 0; i < 3; ++i) u[i] *= inv;
+            const int32_t great = tmpl.parent[grand];
+            if (tmpl.ring && great >= 0) {
+                float q[3];
+                atomPos_(first + great, q);
+                for (int i = 0; i < 3; ++i) w[i] = q[i] - g[i];
+                const float d = dot_(w, u);
+                for (int i = 0; i < 3; ++i) w[i] -= d * u[i];
+                const float len2 = dot_(w, w);
+                if (len2 > 1e-4f) {
+                    const float norm = 1.0f / std::sqrt(len2);
+                    for (int i = 0; i < 3; ++i) w[i] *= norm;
+                } else {
+                    perpendicular_(u, w);
+                }
+            } else {
+                perpendicular_(u, w);
+            }
+            for (int i = 0; i < 3; ++i) dir[i] = 0.334f * u[i] + 0.943f * w[i];
+        }
+        for (int i = 0; i < 3; ++i) xyz[i] = p[i] + length * dir[i];
+    }
+
+    void atomPos_(int32_t index, float* p) const {
+        p[0] = data_.xCoordList[index];
+        p[1] = data_.yCoordList[index];
+        p[2] = data_.zCoordList[index];
+    }
+
+    static float dot_(const float* a, const float* b) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // random unit vector perpendicular to v
+    void perpendicular_(const float* v, float* out) {
+        const float v2 = std::max(dot_(v, v), 1e-8f);
+        float len2 = 0;
+        while (len2 < 1e-2f * v2) {
+            rng_.direction(out);
+            const float d = dot_(out, v) / v2;
+            for (int i = 0; i < 3; ++i) out[i] -= d * v[i];
+            len2 = dot_(out, out);
+        }
+        const float inv = 1.0f / std::sqrt(len2);
+        for (int i = 0; i < 3; ++i) out[i] *= inv;
+    }
+
+    // move to next C-alpha of compact random walk
+    void advanceTrace_(bool linked) {
+        if (linked) {
+            for (int i = 0; i < 3; ++i) pos_[i] = next_[i];
+        }
+        for (int attempt = 0; attempt < 8; ++attempt) {
+            float dir[3];
+            rng_.direction(dir);
+            for (int i = 0; i < 3; ++i) step_[i] = dir[i];
+            for (int i = 0; i < 3; ++i) next_[i] = pos_[i] + 3.8f * dir[i];
+            if (inside_(next_)) break;
+            // step back towards center
+            float len2 = 0;
+            for (int i = 0; i < 3; ++i) {
+                step_[i] = center_[i] - pos_[i];
+                len2 += step_[i] * step_[i];
+            }
+            if (len2 < 1e-4f) continue;
+            const float inv = 1.0f / std::sqrt(len2);
+            for (int i = 0; i < 3; ++i) {
+                step_[i] *= inv;
+                next_[i] = pos_[i] + 3.8f * step_[i];
+            }
+        }
+        perpendicular_(step_, plane_);
+    }
+
+    // random position within chain sphere
+    void randomSpot_() {
+        do {
+            for (int i = 0; i < 3; ++i) {
+                pos_[i] = center_[i] + rng_.uniform(-radius_, radius_);
+            }
+        } while (!inside_(pos_));
+    }
+
+    bool inside_(const float* p) const {
+        float d2 = 0;
+        for (int i = 0; i < 3; ++i) {
+            d2 += (p[i] - center_[i]) * (p[i] - center_[i]);
+        }
+        return d2 <= radius_ * radius_;
+    }
+};
+
+// amino acid with natural abundance
+inline int32_t syntheticAminoAcidType(SyntheticRandom& rng) {
+    int32_t r = rng.index(1000);
+    for (int32_t i = 0; i < SYNTHETIC_NUM_RESIDUES; ++i) {
+        r -= SYNTHETIC_RESIDUES[i].weight;
+        if (r < 0) return i;
+    }
+    return 0;
+}
+
+// copy first model with perturbed coordinates
+inline void syntheticAddModel(StructureData& data, int32_t model_atoms,
+                              int32_t model_groups, int32_t model_chains,
+                              int32_t model_bonds, SyntheticRandom& rng) {
+    for (int32_t c = 0; c < model_chains; ++c) {
+        data.chainIdList.push_back(data.chainIdList[c]);
+        data.chainNameList.push_back(data.chainNameList[c]);
+        data.groupsPerChain.push_back(data.groupsPerChain[c]);
+    }
+    // smooth random displacement along the chains and small per atom noise
+    float shift[3] = {0, 0, 0};
+    int32_t atom = 0;
+    for (int32_t g = 0; g < model_groups; ++g) {
+        data.groupIdList.push_back(data.groupIdList[g]);
+        data.groupTypeList.push_back(data.groupTypeList[g]);
+        data.secStructList.push_back(data.secStructList[g]);
+        data.insCodeList.push_back(data.insCodeList[g]);
+        data.sequenceIndexList.push_back(data.sequenceIndexList[g]);
+        const GroupType& group = data.groupList[data.groupTypeList[g]];
+        for (int i = 0; i < 3; ++i) {
+            shift[i] = 0.9f * shift[i] + 0.15f * rng.normal();
+        }
+        const int32_t num_atoms = int32_t(group.atomNameList.size());
+        for (int32_t i = 0; i < num_atoms; ++i, ++atom) {
+            data.xCoordList.push_back(syntheticRound(data.xCoordList[atom]
+                + shift[0] + 0.05f * rng.normal(), 1000));
+            data.yCoordList.push_back(syntheticRound(data.yCoordList[atom]
+                + shift[1] + 0.05f * rng.normal(), 1000));
+            data.zCoordList.push_back(syntheticRound(data.zCoordList[atom]
+                + shift[2] + 0.05f * rng.normal(), 1000));
+            data.bFactorList.push_back(data.bFactorList[atom]);
+            data.occupancyList.push_back(data.occupancyList[atom]);
+            data.altLocList.push_back(data.altLocList[atom]);
+            data.atomIdList.push_back(data.atomIdList[atom]);
+        }
+        data.numBonds += int32_t(group.bondOrderList.size());
+    }
+    const int32_t offset = data.numAtoms;
+    for (int32_t b = 0; b < model_bonds; ++b) {
+        data.bondAtomList.push_back(data.bondAtomList[2 * b] + offset);
+        data.bondAtomList.push_back(data.bondAtomList[2 * b + 1] + offset);
+        data.bondOrderList.push_back(data.bondOrderList[b]);
+    }
+    data.numBonds += model_bonds;
+    data.numAtoms += model_atoms;
+    data.numGroups += model_groups;
+    data.numChains += model_chains;
+    data.chainsPerModel.push_back(model_chains);
+    ++data.numModels;
+}
+
+} // anon ns
+
+inline void generateSyntheticStructure(StructureData& data,
+                                       const SyntheticOptions& options) {
+    if (   options.numAtoms < 1 || options.numModels < 1
+        || options.residuesPerChain < 1
+        || !(options.waterFraction >= 0 && options.waterFraction <= 1)
+        || !(options.altLocFraction >= 0 && options.altLocFraction <= 1)
+        || int64_t(options.numAtoms) * options.numModels
+           > std::numeric_limits<int32_t>::max()) {
+        throw EncodeError("Invalid options for synthetic structure");
+    }
+    data = StructureData();
+    std::ostringstream title;
+    title << "Synthetic structure (seed " << options.seed << ")";
+    data.title = title.str();
+    data.structureId = "SYNT";
+    data.depositionDate = "2000-01-01";
+    data.releaseDate = "2000-01-01";
+    data.numModels = 0;
+    SyntheticRandom rng(options.seed);
+    SyntheticBuilder builder(data, rng);
+
+    // atom budget and layout of protein chains on a grid
+    const int32_t num_water = int32_t(float(options.numAtoms)
+                                      * options.waterFraction + 0.5f);
+    const int32_t num_sulfate = options.numAtoms / 2000;
+    const int32_t protein_atoms = std::max(options.numAtoms - num_water
+                                           - 5 * num_sulfate, 1);
+    // hard limit for complete residues (rest is filled up with water)
+    const int32_t max_protein_atoms = options.numAtoms - 5 * num_sulfate;
+    int32_t max_residue_atoms = 0;
+    for (int32_t t = 0; t < 2 * SYNTHETIC_NUM_RESIDUES; ++t) {
+        max_residue_atoms = std::max(max_residue_atoms, builder.numAtoms(t));
+    }
+    const float chain_radius =
+        2.2f * std::pow(1.5f * float(options.residuesPerChain), 0.38f) + 3;
+    const float spacing = 2 * chain_radius + 6;
+    int32_t grid = 1;
+    while (int64_t(grid) * grid * grid * 8 * options.residuesPerChain
+           < protein_atoms) {
+        ++grid;
+    }
+
+    // protein chains
+    int32_t chain = 0;
+    while (   data.numAtoms < protein_atoms
+           && data.numAtoms + max_residue_atoms <= max_protein_atoms) {
+        const float center[3] = {spacing * float(chain % grid),
+                                 spacing * float((chain / grid) % grid),
+                                 spacing * float(chain / (grid * grid))};
+        builder.addChain(syntheticChainName(chain), center, chain_radius);
+        // homo-oligomers share entity and sequence with previous chain
+        if (data.entityList.empty() || rng.index(2) == 0) {
+            Entity entity;
+            entity.description = "Synthetic protein";
+            entity.type = "polymer";
+            const int32_t length = std::max(1, int32_t(rng.uniform(0.5f, 1.5f)
+                                            * options.residuesPerChain));
+            for (int32_t i = 0; i < length; ++i) {
+                entity.sequence += SYNTHETIC_RESIDUES[
+                    syntheticAminoAcidType(rng)].code;
+            }
+            data.entityList.push_back(entity);
+        }
+        Entity& entity = data.entityList.back();
+        entity.chainIndexList.push_back(chain);
+        const int32_t first_id = 1 + rng.index(20);
+        int32_t sec_struct = 7;
+        int32_t run = 0;
+        for (int32_t i = 0; i < int32_t(entity.sequence.size())
+                            && data.numAtoms < protein_atoms; ++i) {
+            if (run == 0) {
+                const int32_t r = rng.index(100);
+                if (r < 35)      { sec_struct = 2; run = 6 + rng.index(14); }
+                else if (r < 55) { sec_struct = 3; run = 3 + rng.index(8); }
+                else             { sec_struct = 7; run = 2 + rng.index(8); }
+            }
+            --run;
+            int32_t t = 0;
+            while (SYNTHETIC_RESIDUES[t].code != entity.sequence[i]) ++t;
+            const bool alt_loc = SYNTHETIC_RESIDUES[t].code != 'G'
+                                 && rng.uniform() < options.altLocFraction;
+            if (  data.numAtoms + builder.numAtoms(2 * t + alt_loc)
+                > max_protein_atoms) {
+                break;
+            }
+            builder.addResidue(2 * t, alt_loc, first_id + i, i, sec_struct);
+        }
+        ++chain;
+    }
+    // non-polymers and water spread over protein
+    const float box_center[3] = {0.5f * spacing * float(grid - 1),
+                                 0.5f * spacing * float(grid - 1),
+                                 0.5f * spacing * float(grid - 1)};
+    const float box_radius = 0.87f * spacing * float(grid);
+    if (num_sulfate > 0) {
+        Entity entity;
+        entity.description = "SULFATE ION";
+        entity.type = "non-polymer";
+        entity.chainIndexList.push_back(chain);
+        data.entityList.push_back(entity);
+        builder.addChain(syntheticChainName(chain++), box_center, box_radius);
+        for (int32_t i = 0; i < num_sulfate; ++i) {
+            builder.addResidue(SyntheticBuilder::sulfate(), false, 1001 + i,
+                               -1, -1);
+        }
+    }
+    if (data.numAtoms < options.numAtoms) {
+        Entity entity;
+        entity.description = "water";
+        entity.type = "water";
+        entity.chainIndexList.push_back(chain);
+        data.entityList.push_back(entity);
+        builder.addChain(syntheticChainName(chain++), box_center, box_radius);
+        for (int32_t i = 0; data.numAtoms < options.numAtoms; ++i) {
+            builder.addResidue(SyntheticBuilder::water(), false, 2001 + i,
+                               -1, -1);
+        }
+    }
+    data.chainsPerModel.push_back(data.numChains);
+    data.numModels = 1;
+
+    // further models
+    const int32_t model_atoms = data.numAtoms;
+    const int32_t model_groups = data.numGroups;
+    const int32_t model_chains = data.numChains;
+    const int32_t model_bonds = int32_t(data.bondOrderList.size());
+    for (int32_t m = 1; m < options.numModels; ++m) {
+        syntheticAddModel(data, model_atoms, model_groups, model_chains,
+                          model_bonds, rng);
+    }
+    for (size_t e = 0; e < data.entityList.size(); ++e) {
+        std::vector<int32_t>& chains = data.entityList[e].chainIndexList;
+        const size_t model_chains = chains.size();
+        for (int32_t m = 1; m < options.numModels; ++m) {
+            for (size_t c = 0; c < model_chains; ++c) {
+                chains.push_back(chains[c] + m * data.chainsPerModel[0]);
+            }
+        }
+    }
+
+    // experimental data
+    BioAssembly assembly;
+    assembly.name = "1";
+    Transform transform;
+    for (int32_t c = 0; c < data.chainsPerModel[0]; ++c) {
+        transform.chainIndexList.push_back(c);
+    }
+    for (int i = 0; i < 16; ++i) transform.matrix[i] = (i % 5 == 0) ? 1 : 0;
+    assembly.transformList.push_back(transform);
+    data.bioAssemblyList.push_back(assembly);
+    if (options.numModels > 1) {
+        data.experimentalMethods.push_back("SOLUTION NMR");
+    } else {
+        data.experimentalMethods.push_back("X-RAY DIFFRACTION");
+        const float edge = syntheticRound(spacing * float(grid) + 10, 1000);
+        data.unitCell.push_back(edge);
+        data.unitCell.push_back(edge);
+        data.unitCell.push_back(edge);
+        data.unitCell.push_back(90);
+        data.unitCell.push_back(90);
+        data.unitCell.push_back(90);
+        data.spaceGroup = "P 1";
+        data.resolution = syntheticRound(rng.uniform(1.2f, 3.0f), 100);
+        data.rWork = syntheticRound(rng.uniform(0.15f, 0.22f), 1000);
+        data.rFree = syntheticRound(data.rWork + rng.uniform(0.02f, 0.05f),
+                                    1000);
+    }
+}
+
+} // mmtf namespace
+
+#endif
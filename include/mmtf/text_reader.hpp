@@ -0,0 +1,841 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Fast parsers creating mmtf::StructureData from mmCIF or PDB text.
+// See "tests/mmtf_tests.cpp" (Test text parsers) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_TEXT_READER_H
+#define MMTF_TEXT_READER_H
+
+#include "structure_data.hpp"
+#include "export_helpers.hpp"
+#include "errors.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <math.h>
+
+namespace mmtf {
+
+/**
+ * @brief Parse atoms of the first data block of an mmCIF file.
+ * @param[out] data    StructureData to be filled (previous content is replaced)
+ * @param[in]  buffer  mmCIF text (does not need to be null-terminated)
+ * @param[in]  size    Size of buffer
+ * @throw mmtf::DecodeError if text cannot be parsed
+ *
+ * Reads the _atom_site loop and the _cell / _symmetry items. The buffer is
+ * tokenized in place (no copies of the text are made; memory mapped files can
+ * be passed directly) and atom rows are parsed in parallel if OpenMP is
+ * enabled. Each atom_site row must be on a single line (true for all wwPDB
+ * files).
+ *
+ * Chains are split by label_asym_id and model number, groups by label_seq_id,
+ * auth_seq_id, insertion code and residue name. One entity is created per
+ * label_entity_id. chemCompType is derived from the group_PDB record type
+ * (HETATM -> "NON-POLYMER") so that is_hetatm reproduces the input. Duplicate
+ * groups are merged with compressGroupList. No bonds are created.
+ */
+inline void parseMmCIFFromBuffer(StructureData& data, const char* buffer,
+                                 size_t size);
+
+/**
+ * @brief Parse atoms of an mmCIF file.
+ * @param[out] data      StructureData to be filled
+ * @param[in]  filename  Path to file to load
+ * @throw mmtf::DecodeError if file cannot be opened or parsed
+ *
+ * Other behavior as in ::parseMmCIFFromBuffer.
+ */
+inline void parseMmCIFFromFile(StructureData& data,
+                               const std::string& filename);
+
+/**
+ * @brief Parse ATOM/HETATM records of a PDB file.
+ * @param[out] data    StructureData to be filled (previous content is replaced)
+ * @param[in]  buffer  PDB text (does not need to be null-terminated)
+ * @param[in]  size    Size of buffer
+ * @throw mmtf::DecodeError if text cannot be parsed
+ *
+ * Reads HEADER (idCode), CRYST1, MODEL and ATOM/HETATM records. Records are
+ * parsed in parallel if OpenMP is enabled. Chains are split by chain
+ * identifier and model, groups by residue number, insertion code and residue
+ * name. One entity is created per chain identifier. Missing elements are
+ * guessed from the atom name. Other behavior as in ::parseMmCIFFromBuffer.
+ */
+inline void parsePDBFromBuffer(StructureData& data, const char* buffer,
+                               size_t size);
+
+/**
+ * @brief Parse ATOM/HETATM records of a PDB file.
+ * @param[out] data      StructureData to be filled
+ * @param[in]  filename  Path to file to load
+ * @throw mmtf::DecodeError if file cannot be opened or parsed
+ *
+ * Other behavior as in ::parsePDBFromBuffer.
+ */
+inline void parsePDBFromFile(StructureData& data, const std::string& filename);
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+namespace { // private helpers
+
+// view into the parsed buffer
+struct TextToken {
+    const char* ptr;
+    int32_t len;
+    bool quoted;  // CIF quoted string or text field (never name / keyword)
+
+    TextToken(): ptr(NULL), len(0), quoted(false) {}
+    TextToken(const char* p, int32_t l, bool q = false)
+        : ptr(p), len(l), quoted(q) {}
+
+    std::string str() const { return std::string(ptr, len); }
+    bool operator==(const TextToken& other) const {
+        return len == other.len && std::memcmp(ptr, other.ptr, len) == 0;
+    }
+    bool operator!=(const TextToken& other) const { return !(*this == other); }
+    // CIF null values '?' and '.'
+    bool isNull() const {
+        return len == 0 || (len == 1 && (*ptr == '?' || *ptr == '.'));
+    }
+};
+
+// per-atom fields shared by mmCIF and PDB parsers
+enum TextField {
+    TF_GROUP_PDB, TF_ID, TF_ELEMENT, TF_ATOM_NAME, TF_ALT_LOC, TF_RES_NAME,
+    TF_ASYM_ID, TF_ENTITY_ID, TF_LABEL_SEQ, TF_INS_CODE, TF_X, TF_Y, TF_Z,
+    TF_OCCUPANCY, TF_B_FACTOR, TF_CHARGE, TF_AUTH_SEQ, TF_AUTH_ASYM_ID,
+    TF_MODEL, TF_NUM_FIELDS
+};
+
+struct TextAtomRow {
+    TextToken token[TF_NUM_FIELDS];
+    float x, y, z, occupancy, bFactor;
+    int32_t id, labelSeq, authSeq, charge, model;
+    bool hetatm, valid;
+};
+
+inline bool textIsDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool textIsLetter(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+inline bool textIsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+inline char textToLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+// case insensitive comparison with (lower case) keyword
+inline bool textEqualsNoCase(const TextToken& tok, const char* keyword) {
+    int32_t i = 0;
+    for (; i < tok.len && keyword[i] != 0; ++i) {
+        if (textToLower(tok.ptr[i]) != keyword[i]) return false;
+    }
+    return i == tok.len && keyword[i] == 0;
+}
+inline bool textStartsWithNoCase(const TextToken& tok, const char* keyword) {
+    int32_t i = 0;
+    for (; keyword[i] != 0; ++i) {
+        if (i >= tok.len || textToLower(tok.ptr[i]) != keyword[i]) return false;
+    }
+    return true;
+}
+
+// strip blanks on both sides
+inline TextToken textTrim(const char* begin, const char* end) {
+    while (begin < end && textIsSpace(*begin)) ++begin;
+    while (end > begin && textIsSpace(end[-1])) --end;
+    return TextToken(begin, int32_t(end - begin));
+}
+
+// parse decimal number incl. exponent and CIF standard uncertainty "1.23(4)"
+inline bool textParseFloat(const TextToken& tok, float& value) {
+    static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                   1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14,
+                                   1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+                                   1e22};
+    const char* p = tok.ptr;
+    const char* end = tok.ptr + tok.len;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    double mantissa = 0;
+    int exponent = 0;
+    bool any_digit = false;
+    for (; p < end && textIsDigit(*p); ++p, any_digit = true) {
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && textIsDigit(*p); ++p, any_digit = true) {
+            mantissa = mantissa * 10 + (*p - '0');
+            --exponent;
+        }
+    }
+    if (!any_digit) return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool exp_negative = false;
+        if (p < end && (*p == '-' || *p == '+')) exp_negative = (*p++ == '-');
+        if (p == end || !textIsDigit(*p)) return false;
+        int exp = 0;
+        for (; p < end && textIsDigit(*p); ++p) exp = exp * 10 + (*p - '0');
+        exponent += exp_negative ? -exp : exp;
+    }
+    if (p < end && *p == '(') {
+        while (p < end && *p != ')') ++p;
+        if (p < end) ++p;
+    }
+    if (p != end) return false;
+    if (exponent < 0) {
+        mantissa = (-exponent <= 22) ? mantissa / pow10[-exponent]
+                                     : mantissa / pow(10.0, -exponent);
+    } else if (exponent > 0) {
+        mantissa = (exponent <= 22) ? mantissa * pow10[exponent]
+                                    : mantissa * pow(10.0, exponent);
+    }
+    value = float(negative ? -mantissa : mantissa);
+    return true;
+}
+
+inline bool textParseInt(const TextToken& tok, int32_t& value) {
+    const char* p = tok.ptr;
+    const char* end = tok.ptr + tok.len;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    if (p == end) return false;
+    // magnitude of INT32_MIN fits into uint32_t
+    const uint32_t limit = negative ? 2147483648u : 2147483647u;
+    uint32_t v = 0;
+    for (; p < end; ++p) {
+        if (!textIsDigit(*p)) return false;
+        const uint32_t digit = uint32_t(*p - '0');
+        if (v > (limit - digit) / 10) return false;
+        v = v * 10 + digit;
+    }
+    value = negative ? int32_t(0u - v) : int32_t(v);
+    return true;
+}
+
+// name starts with two-letter symbol in table (second letter in any case)
+inline bool textMatchesPair(const char* name, const char* const* pairs,
+                            size_t num_pairs) {
+    for (size_t i = 0; i < num_pairs; ++i) {
+        if (   name[0] == pairs[i][0]
+            && (name[1] == pairs[i][1]
+                || name[1] == pairs[i][1] - 'A' + 'a')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// two-letter elements which are not easily confused with atom names in
+// ATOM records (e.g. "HG21" is a hydrogen, not mercury)
+inline bool textIsElementPair(const char* name) {
+    static const char* const pairs[] = {
+        "AG", "AL", "AS", "AU", "BA", "BE", "BR", "CA", "CD", "CL", "CO",
+        "CR", "CS", "CU", "FE", "GA", "GD", "IR", "LI", "MG", "MN", "MO",
+        "NA", "NI", "OS", "PB", "PD", "PT", "RB", "RU", "SB", "SE", "SI",
+        "SN", "SR", "TE", "XE", "ZN"
+    };
+    return textMatchesPair(name, pairs, sizeof(pairs) / sizeof(pairs[0]));
+}
+
+// all two-letter element symbols (e.g. "HG" but not "HN")
+inline bool textIsAnyElementPair(const char* name) {
+    static const char* const pairs[] = {
+        "AC", "AG", "AL", "AM", "AR", "AS", "AT", "AU", "BA", "BE", "BH",
+        "BI", "BK", "BR", "CA", "CD", "CE", "CF", "CL", "CM", "CN", "CO",
+        "CR", "CS", "CU", "DB", "DS", "DY", "ER", "ES", "EU", "FE", "FL",
+        "FM", "FR", "GA", "GD", "GE", "HE", "HF", "HG", "HO", "HS", "IN",
+        "IR", "KR", "LA", "LI", "LR", "LU", "LV", "MC", "MD", "MG", "MN",
+        "MO", "MT", "NA", "NB", "ND", "NE", "NH", "NI", "NO", "NP", "OG",
+        "OS", "PA", "PB", "PD", "PM", "PO", "PR", "PT", "PU", "RA", "RB",
+        "RE", "RF", "RG", "RH", "RN", "RU", "SB", "SC", "SE", "SG", "SI",
+        "SM", "SN", "SR", "TA", "TB", "TC", "TE", "TH", "TI", "TL", "TM",
+        "TS", "XE", "YB", "ZN", "ZR"
+    };
+    return textMatchesPair(name, pairs, sizeof(pairs) / sizeof(pairs[0]));
+}
+
+// optional numbers: null values give default
+inline bool textParseFloat(const TextToken& tok, float& value, float missing) {
+    if (tok.isNull()) {
+        value = missing;
+        return true;
+    }
+    return textParseFloat(tok, value);
+}
+inline bool textParseInt(const TextToken& tok, int32_t& value,
+                         int32_t missing) {
+    if (tok.isNull()) {
+        value = missing;
+        return true;
+    }
+    return textParseInt(tok, value);
+}
+
+// next CIF token in [p, end) (p is advanced) -> false at end of text
+// (begin = start of text, needed to find text fields at line starts)
+inline bool textNextCIFToken(const char*& p, const char* begin,
+                             const char* end, TextToken& tok) {
+    while (p < end) {
+        if (textIsSpace(*p)) {
+            ++p;
+        } else if (*p == '#') {
+            while (p < end && *p != '\n') ++p;
+        } else {
+            break;
+        }
+    }
+    if (p >= end) return false;
+    const char* start = p;
+    if (*p == '\'' || *p == '"') {
+        // quote only terminates if followed by whitespace
+        const char q = *p++;
+        while (p < end && !(*p == q && (p + 1 == end || textIsSpace(p[1])))) {
+            if (*p == '\n') break;
+            ++p;
+        }
+        tok = TextToken(start + 1, int32_t(p - start - 1), true);
+        if (p < end && *p == q) ++p;
+    } else if (*p == ';' && (p == begin || p[-1] == '\n')) {
+        // text field: from ";" at line start to next ";" at line start
+        ++p;
+        const char* text_start = p;
+        while (p < end && !(*p == ';' && p[-1] == '\n')) ++p;
+        tok = TextToken(text_start, int32_t(p - text_start), true);
+        if (p < end) ++p;
+    } else {
+        while (p < end && !textIsSpace(*p)) ++p;
+        tok = TextToken(start, int32_t(p - start));
+    }
+    return true;
+}
+
+// unquoted item name (e.g. "_cell.length_a")
+inline bool textIsCIFName(const TextToken& tok) {
+    return !tok.quoted && tok.len > 0 && tok.ptr[0] == '_';
+}
+
+// unquoted reserved word
+inline bool textIsCIFKeyword(const TextToken& tok) {
+    if (tok.quoted) return false;
+    return textEqualsNoCase(tok, "loop_") || textStartsWithNoCase(tok, "data_")
+        || textStartsWithNoCase(tok, "save_")
+        || textEqualsNoCase(tok, "global_") || textEqualsNoCase(tok, "stop_");
+}
+
+// line number of position (1-based) for error messages
+inline size_t textLineNumber(const char* begin, const char* pos) {
+    size_t line = 1;
+    for (const char* p = begin; p < pos; ++p) {
+        if (*p == '\n') ++line;
+    }
+    return line;
+}
+
+inline void textThrowRowError(const char* format, const char* begin,
+                              const char* pos) {
+    std::stringstream err;
+    err << "Cannot parse " << format << " atom record in line "
+        << textLineNumber(begin, pos);
+    throw DecodeError(err.str());
+}
+
+// map atom_site item name (without category) to field (or -1)
+inline int textCIFAtomSiteField(const TextToken& item, bool& is_label) {
+    static const char* names[] = {
+        "group_pdb", "id", "type_symbol", "label_atom_id", "label_alt_id",
+        "label_comp_id", "label_asym_id", "label_entity_id", "label_seq_id",
+        "pdbx_pdb_ins_code", "cartn_x", "cartn_y", "cartn_z", "occupancy",
+        "b_iso_or_equiv", "pdbx_formal_charge", "auth_seq_id", "auth_asym_id",
+        "pdbx_pdb_model_num"};
+    is_label = true;
+    for (int i = 0; i < TF_NUM_FIELDS; ++i) {
+        if (textEqualsNoCase(item, names[i])) return i;
+    }
+    // auth_* fall-backs for label_* items
+    is_label = false;
+    if (textEqualsNoCase(item, "auth_atom_id")) return TF_ATOM_NAME;
+    if (textEqualsNoCase(item, "auth_comp_id")) return TF_RES_NAME;
+    return -1;
+}
+
+// parse one atom_site row (single line) using column -> field map
+inline void textParseCIFRow(TextAtomRow& row, const char* p, const char* end,
+                            const std::vector<int>& column_fields) {
+    row.valid = false;
+    const char* const begin = p;
+    TextToken tok;
+    for (size_t k = 0; k < column_fields.size(); ++k) {
+        if (!textNextCIFToken(p, begin, end, tok)) return;
+        if (column_fields[k] >= 0) row.token[column_fields[k]] = tok;
+    }
+    if (textNextCIFToken(p, begin, end, tok)) return;  // too many values
+
+    row.hetatm = textEqualsNoCase(row.token[TF_GROUP_PDB], "hetatm");
+    row.valid = textParseFloat(row.token[TF_X], row.x)
+             && textParseFloat(row.token[TF_Y], row.y)
+             && textParseFloat(row.token[TF_Z], row.z)
+             && textParseFloat(row.token[TF_OCCUPANCY], row.occupancy, 1.0f)
+             && textParseFloat(row.token[TF_B_FACTOR], row.bFactor, 0.0f)
+             && textParseInt(row.token[TF_ID], row.id, 0)
+             && textParseInt(row.token[TF_LABEL_SEQ], row.labelSeq, 0)
+             && textParseInt(row.token[TF_AUTH_SEQ], row.authSeq, row.labelSeq)
+             && textParseInt(row.token[TF_CHARGE], row.charge, 0)
+             && textParseInt(row.token[TF_MODEL], row.model, 1);
+}
+
+// fixed-column field of PDB record (1-based inclusive columns)
+inline TextToken textPDBColumns(const char* line, const char* end,
+                                int first, int last) {
+    const char* begin = line + first - 1;
+    const char* stop = line + last;
+    if (begin > end) begin = end;
+    if (stop > end) stop = end;
+    return textTrim(begin, stop);
+}
+
+// parse one ATOM/HETATM record
+inline void textParsePDBRow(TextAtomRow& row, const char* line,
+                            const char* end) {
+    row.token[TF_GROUP_PDB] = textPDBColumns(line, end, 1, 6);
+    row.token[TF_ID] = textPDBColumns(line, end, 7, 11);
+    row.token[TF_ATOM_NAME] = textPDBColumns(line, end, 13, 16);
+    row.token[TF_ALT_LOC] = textPDBColumns(line, end, 17, 17);
+    row.token[TF_RES_NAME] = textPDBColumns(line, end, 18, 21);
+    row.token[TF_ASYM_ID] = textPDBColumns(line, end, 22, 22);
+    row.token[TF_AUTH_ASYM_ID] = row.token[TF_ASYM_ID];
+    // entity per chain identifier (also for blank ones)
+    row.token[TF_ENTITY_ID] = TextToken(line + 21, (line + 22 <= end) ? 1 : 0);
+    row.token[TF_AUTH_SEQ] = textPDBColumns(line, end, 23, 26);
+    row.token[TF_INS_CODE] = textPDBColumns(line, end, 27, 27);
+    row.token[TF_X] = textPDBColumns(line, end, 31, 38);
+    row.token[TF_Y] = textPDBColumns(line, end, 39, 46);
+    row.token[TF_Z] = textPDBColumns(line, end, 47, 54);
+    row.token[TF_OCCUPANCY] = textPDBColumns(line, end, 55, 60);
+    row.token[TF_B_FACTOR] = textPDBColumns(line, end, 61, 66);
+    row.token[TF_ELEMENT] = textPDBColumns(line, end, 77, 78);
+    row.token[TF_CHARGE] = textPDBColumns(line, end, 79, 80);
+
+    // element from atom name if missing (e.g. " CA " -> C, "1HG2" -> H):
+    // two letters only if name starts in column 13 and is a known element
+    // (any element for HETATM records, e.g. "HG  " -> HG but "HN1 " -> H;
+    // only unambiguous ones for ATOM records, e.g. "FE  " -> FE but
+    // "HG21" -> H)
+    TextToken& element = row.token[TF_ELEMENT];
+    if (element.len == 0) {
+        const TextToken name = textPDBColumns(line, end, 13, 16);
+        const char* first = name.ptr;
+        const char* name_end = name.ptr + name.len;
+        while (first < name_end && !textIsLetter(*first)) ++first;
+        element = TextToken(first, (first < name_end) ? 1 : 0);
+        if (   first == line + 12 && first + 1 < name_end
+            && (row.token[TF_GROUP_PDB].len == 6 ? textIsAnyElementPair(first)
+                                                 : textIsElementPair(first))) {
+            element.len = 2;
+        }
+    }
+    // charge as "2+" or "-1"
+    row.charge = 0;
+    const TextToken& charge = row.token[TF_CHARGE];
+    for (int32_t i = 0; i < charge.len; ++i) {
+        if (textIsDigit(charge.ptr[i])) row.charge = charge.ptr[i] - '0';
+    }
+    if (charge.len > 0 && std::memchr(charge.ptr, '-', charge.len) != NULL) {
+        row.charge = -row.charge;
+    }
+
+    row.hetatm = (row.token[TF_GROUP_PDB].len == 6);
+    row.labelSeq = 0;
+    row.valid = textParseFloat(row.token[TF_X], row.x)
+             && textParseFloat(row.token[TF_Y], row.y)
+             && textParseFloat(row.token[TF_Z], row.z)
+             && textParseFloat(row.token[TF_OCCUPANCY], row.occupancy, 1.0f)
+             && textParseFloat(row.token[TF_B_FACTOR], row.bFactor, 0.0f)
+             && textParseInt(row.token[TF_AUTH_SEQ], row.authSeq);
+    // serial numbers > 99999 (e.g. hybrid-36) are renumbered
+    if (!textParseInt(row.token[TF_ID], row.id, 0)) row.id = 0;
+}
+
+// chemCompType / singleLetterCode guesses for groups without CCD info
+inline void textSetGroupType(GroupType& group, bool hetatm) {
+    static const char* amino_acids[] = {
+        "ALA", "ARG", "ASN", "ASP", "CYS", "GLN", "GLU", "GLY", "HIS", "ILE",
+        "LEU", "LYS", "MET", "PHE", "PRO", "SER", "THR", "TRP", "TYR", "VAL"};
+    static const char amino_acid_codes[] = "ARNDCQEGHILKMFPSTWYV";
+    group.singleLetterCode = '?';
+    if (hetatm) {
+        group.chemCompType = "NON-POLYMER";
+        return;
+    }
+    const std::string& name = group.groupName;
+    if (name.size() == 2 && name[0] == 'D'
+        && std::strchr("ACGTI", name[1]) != NULL) {
+        group.chemCompType = "DNA LINKING";
+        group.singleLetterCode = name[1];
+    } else if (name.size() == 1 && std::strchr("ACGUI", name[0]) != NULL) {
+        group.chemCompType = "RNA LINKING";
+        group.singleLetterCode = name[0];
+    } else {
+        group.chemCompType = "L-PEPTIDE LINKING";
+        for (int i = 0; i < 20; ++i) {
+            if (name == amino_acids[i]) {
+                group.singleLetterCode = amino_acid_codes[i];
+                break;
+            }
+        }
+    }
+}
+
+// build hierarchy from parsed rows (data must be reset before)
+inline void textBuildStructure(StructureData& data,
+                               const std::vector<TextAtomRow>& rows,
+                               bool has_label_seq, bool has_auth_asym) {
+    const size_t num_rows = rows.size();
+    data.xCoordList.resize(num_rows);
+    data.yCoordList.resize(num_rows);
+    data.zCoordList.resize(num_rows);
+    data.bFactorList.resize(num_rows);
+    data.occupancyList.resize(num_rows);
+    data.atomIdList.resize(num_rows);
+    data.altLocList.resize(num_rows);
+
+    std::map<std::string, int32_t> entity_indices;
+    std::vector<char> entity_has_polymer;
+    std::vector<char> entity_all_water;
+    GroupType* group = NULL;
+    for (size_t i = 0; i < num_rows; ++i) {
+        const TextAtomRow& row = rows[i];
+        const TextAtomRow* prev = (i > 0) ? &rows[i - 1] : NULL;
+
+        const bool new_model = !prev || prev->model != row.model;
+        const bool new_chain = new_model
+            || prev->token[TF_ASYM_ID] != row.token[TF_ASYM_ID];
+        const bool new_group = new_chain || prev->authSeq != row.authSeq
+            || prev->labelSeq != row.labelSeq
+            || prev->token[TF_INS_CODE] != row.token[TF_INS_CODE]
+            || prev->token[TF_RES_NAME] != row.token[TF_RES_NAME]
+            || prev->hetatm != row.hetatm;
+
+        if (new_model) {
+            data.chainsPerModel.push_back(0);
+        }
+        if (new_chain) {
+            data.chainsPerModel.back() += 1;
+            data.groupsPerChain.push_back(0);
+            data.chainIdList.push_back(row.token[TF_ASYM_ID].str());
+            if (has_auth_asym) {
+                data.chainNameList.push_back(row.token[TF_AUTH_ASYM_ID].str());
+            }
+            const TextToken& entity_id = row.token[TF_ENTITY_ID];
+            if (!entity_id.isNull()) {
+                std::map<std::string, int32_t>::iterator it =
+                    entity_indices.insert(std::make_pair(
+                        entity_id.str(), int32_t(data.entityList.size()))).first;
+                if (it->second == int32_t(data.entityList.size())) {
+                    data.entityList.push_back(Entity());
+                    entity_has_polymer.push_back(0);
+                    entity_all_water.push_back(1);
+                }
+                data.entityList[it->second].chainIndexList.push_back(
+                    int32_t(data.chainIdList.size()) - 1);
+            }
+        }
+        if (new_group) {
+            data.groupsPerChain.back() += 1;
+            data.groupTypeList.push_back(int32_t(data.groupList.size()));
+            data.groupIdList.push_back(row.authSeq);
+            if (has_label_seq) {
+                // label_seq_id starts at 1 (missing and invalid ones give -1)
+                data.sequenceIndexList.push_back(
+                    (row.labelSeq > 0) ? row.labelSeq - 1 : -1);
+            }
+            const TextToken& ins_code = row.token[TF_INS_CODE];
+            data.insCodeList.push_back(ins_code.isNull() ? '\0' : ins_code.ptr[0]);
+            data.groupList.resize(data.groupList.size() + 1);
+            group = &data.groupList.back();
+            group->groupName = row.token[TF_RES_NAME].str();
+            textSetGroupType(*group, row.hetatm);
+
+            // entity type from record types and residue names
+            const TextToken& entity_id = row.token[TF_ENTITY_ID];
+            if (!entity_id.isNull()) {
+                const int32_t entity = entity_indices[entity_id.str()];
+                if (!row.hetatm) entity_has_polymer[entity] = 1;
+                if (group->groupName != "HOH" && group->groupName != "DOD"
+                    && group->groupName != "WAT") {
+                    entity_all_water[entity] = 0;
+                }
+            }
+        }
+
+        group->atomNameList.push_back(row.token[TF_ATOM_NAME].str());
+        group->elementList.push_back(row.token[TF_ELEMENT].str());
+        group->formalChargeList.push_back(row.charge);
+        data.xCoordList[i] = row.x;
+        data.yCoordList[i] = row.y;
+        data.zCoordList[i] = row.z;
+        data.bFactorList[i] = row.bFactor;
+        data.occupancyList[i] = row.occupancy;
+        data.atomIdList[i] = (row.id != 0) ? row.id : int32_t(i) + 1;
+        const TextToken& alt_loc = row.token[TF_ALT_LOC];
+        data.altLocList[i] = alt_loc.isNull() ? '\0' : alt_loc.ptr[0];
+    }
+
+    for (size_t i = 0; i < data.entityList.size(); ++i) {
+        data.entityList[i].type = entity_has_polymer[i] ? "polymer"
+                                : entity_all_water[i] ? "water"
+                                : "non-polymer";
+    }
+
+    data.numAtoms = int32_t(num_rows);
+    data.numGroups = int32_t(data.groupTypeList.size());
+    data.numChains = int32_t(data.chainIdList.size());
+    data.numModels = int32_t(data.chainsPerModel.size());
+
+    compressGroupList(data);
+}
+
+// read whole file into buffer
+inline void textReadFile(std::vector<char>& buffer,
+                         const std::string& filename) {
+    std::ifstream ifs(filename.c_str(), std::ifstream::in | std::ios::binary);
+    if (!ifs.is_open()) {
+        throw DecodeError("Could not open file: " + filename);
+    }
+    ifs.seekg(0, std::ios::end);
+    buffer.resize(size_t(ifs.tellg()));
+    ifs.seekg(0, std::ios::beg);
+    if (!buffer.empty()) ifs.read(&buffer[0], buffer.size());
+}
+
+} // anon ns
+
+inline void parseMmCIFFromBuffer(StructureData& data, const char* buffer,
+                                 size_t size) {
+    data = StructureData();
+    const char* const end = buffer + size;
+    const char* p = buffer;
+
+    std::vector<const char*> row_begins;
+    std::vector<const char*> row_ends;
+    std::vector<int> column_fields;
+    bool has_label_seq = false;
+    bool has_auth_asym = false;
+    bool in_data_block = false;
+
+    TextToken tok;
+    bool pending = false;  // tok already read but not handled
+    while (pending || textNextCIFToken(p, buffer, end, tok)) {
+        pending = false;
+        if (tok.quoted) {
+            continue;  // stray value
+        } else if (textStartsWithNoCase(tok, "data_")) {
+            if (in_data_block) break;  // only first data block
+            in_data_block = true;
+            data.structureId = std::string(tok.ptr + 5, tok.len - 5);
+        } else if (textEqualsNoCase(tok, "loop_")) {
+            // item names
+            std::vector<TextToken> items;
+            const char* value_start = p;
+            bool got = textNextCIFToken(p, buffer, end, tok);
+            while (got && textIsCIFName(tok)) {
+                items.push_back(tok);
+                value_start = p;
+                got = textNextCIFToken(p, buffer, end, tok);
+            }
+            const bool is_atom_site = !items.empty()
+                && textStartsWithNoCase(items[0], "_atom_site.");
+            if (!is_atom_site) {
+                // skip values up to next item or keyword
+                while (got && !textIsCIFName(tok) && !textIsCIFKeyword(tok)) {
+                    got = textNextCIFToken(p, buffer, end, tok);
+                }
+                pending = got;
+                continue;
+            }
+            if (!row_begins.empty()) {
+                throw DecodeError("Multiple _atom_site loops in mmCIF data");
+            }
+            column_fields.assign(items.size(), -1);
+            std::vector<char> have_label(TF_NUM_FIELDS, 0);
+            for (size_t k = 0; k < items.size(); ++k) {
+                const TextToken item(items[k].ptr + 11, items[k].len - 11);
+                bool is_label = false;
+                const int field = textCIFAtomSiteField(item, is_label);
+                if (field < 0) continue;
+                if (field == TF_LABEL_SEQ) has_label_seq = true;
+                if (field == TF_AUTH_ASYM_ID) has_auth_asym = true;
+                // label_* wins over auth_* fall-back
+                if (!is_label && have_label[field]) continue;
+                if (is_label) {
+                    for (size_t j = 0; j < k; ++j) {
+                        if (column_fields[j] == field) column_fields[j] = -1;
+                    }
+                    have_label[field] = 1;
+                }
+                column_fields[k] = field;
+            }
+            const int required[] = {TF_ATOM_NAME, TF_RES_NAME, TF_ASYM_ID,
+                                    TF_X, TF_Y, TF_Z};
+            for (int r = 0; r < 6; ++r) {
+                if (std::find(column_fields.begin(), column_fields.end(),
+                              required[r]) == column_fields.end()) {
+                    throw DecodeError("Missing required _atom_site item in "
+                                      "mmCIF data");
+                }
+            }
+            // rows: one per line until next item / keyword
+            const char* line = value_start;
+            while (line < end) {
+                const char* line_end = static_cast<const char*>(
+                    std::memchr(line, '\n', end - line));
+                if (line_end == NULL) line_end = end;
+                const TextToken first = textTrim(line, line_end);
+                if (first.len > 0 && first.ptr[0] != '#') {
+                    if (first.ptr[0] == ';') {
+                        textThrowRowError("mmCIF", buffer, line);
+                    }
+                    const char* first_end = first.ptr;
+                    while (first_end < line_end && !textIsSpace(*first_end)) {
+                        ++first_end;
+                    }
+                    const TextToken word(first.ptr,
+                                         int32_t(first_end - first.ptr));
+                    if (word.ptr[0] == '_' || textIsCIFKeyword(word)) break;
+                    row_begins.push_back(line);
+                    row_ends.push_back(line_end);
+                }
+                line = line_end + 1;
+            }
+            p = (line < end) ? line : end;
+        } else if (textIsCIFName(tok)) {
+            // single item: name value
+            const TextToken name = tok;
+            if (!textNextCIFToken(p, buffer, end, tok)) break;
+            if (textStartsWithNoCase(name, "_cell.")) {
+                static const char* cell_items[] = {
+                    "_cell.length_a", "_cell.length_b", "_cell.length_c",
+                    "_cell.angle_alpha", "_cell.angle_beta",
+                    "_cell.angle_gamma"};
+                for (int i = 0; i < 6; ++i) {
+                    if (!textEqualsNoCase(name, cell_items[i])) continue;
+                    data.unitCell.resize(6, 0.0f);
+                    if (!textParseFloat(tok, data.unitCell[i], 0.0f)) {
+                        throw DecodeError("Cannot parse " + name.str());
+                    }
+                }
+            } else if (textEqualsNoCase(name, "_symmetry.space_group_name_h-m")
+                       && !tok.isNull()) {
+                data.spaceGroup = tok.str();
+            }
+        }
+    }
+
+    // parse rows in parallel
+    const int num_rows = int(row_begins.size());
+    std::vector<TextAtomRow> rows(num_rows);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (int i = 0; i < num_rows; ++i) {
+        textParseCIFRow(rows[i], row_begins[i], row_ends[i], column_fields);
+    }
+    for (int i = 0; i < num_rows; ++i) {
+        if (!rows[i].valid) textThrowRowError("mmCIF", buffer, row_begins[i]);
+    }
+    textBuildStructure(data, rows, has_label_seq, has_auth_asym);
+}
+
+inline void parseMmCIFFromFile(StructureData& data,
+                               const std::string& filename) {
+    std::vector<char> buffer;
+    textReadFile(buffer, filename);
+    parseMmCIFFromBuffer(data, buffer.empty() ? NULL : &buffer[0],
+                         buffer.size());
+}
+
+inline void parsePDBFromBuffer(StructureData& data, const char* buffer,
+                               size_t size) {
+    data = StructureData();
+    const char* const end = buffer + size;
+
+    // find records (serial) -> atom lines are parsed in parallel below
+    std::vector<const char*> row_begins;
+    std::vector<const char*> row_ends;
+    std::vector<int32_t> row_models;
+    int32_t model = 1;
+    bool had_model_record = false;
+    for (const char* line = buffer; line < end;) {
+        const char* line_end = static_cast<const char*>(
+            std::memchr(line, '\n', end - line));
+        if (line_end == NULL) line_end = end;
+        const size_t len = size_t(line_end - line);
+        if (len >= 6 && (std::memcmp(line, "ATOM  ", 6) == 0
+                         || std::memcmp(line, "HETATM", 6) == 0)) {
+            row_begins.push_back(line);
+            row_ends.push_back(line_end);
+            row_models.push_back(model);
+        } else if (len >= 5 && std::memcmp(line, "MODEL", 5) == 0) {
+            // consecutive numbering even if serials are missing
+            if (had_model_record) ++model;
+            had_model_record = true;
+        } else if (len >= 6 && std::memcmp(line, "CRYST1", 6) == 0) {
+            data.unitCell.resize(6);
+            static const int columns[] = {7, 15, 16, 24, 25, 33, 34, 40,
+                                          41, 47, 48, 54};
+            for (int i = 0; i < 6; ++i) {
+                const TextToken tok = textPDBColumns(line, line_end,
+                                                     columns[2 * i],
+                                                     columns[2 * i + 1]);
+                if (!textParseFloat(tok, data.unitCell[i])) {
+                    textThrowRowError("PDB", buffer, line);
+                }
+            }
+            data.spaceGroup = textPDBColumns(line, line_end, 56, 66).str();
+        } else if (len >= 6 && std::memcmp(line, "HEADER", 6) == 0) {
+            data.structureId = textPDBColumns(line, line_end, 63, 66).str();
+        }
+        line = line_end + 1;
+    }
+
+    const int num_rows = int(row_begins.size());
+    std::vector<TextAtomRow> rows(num_rows);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (int i = 0; i < num_rows; ++i) {
+        textParsePDBRow(rows[i], row_begins[i], row_ends[i]);
+        rows[i].model = row_models[i];
+    }
+    for (int i = 0; i < num_rows; ++i) {
+        if (!rows[i].valid) textThrowRowError("PDB", buffer, row_begins[i]);
+    }
+    textBuildStructure(data, rows, false, true);
+}
+
+inline void parsePDBFromFile(StructureData& data, const std::string& filename) {
+    std::vector<char> buffer;
+    textReadFile(buffer, filename);
+    parsePDBFromBuffer(data, buffer.empty() ? NULL : &buffer[0],
+                       buffer.size());
+}
+
+} // mmtf namespace
+
+#endif
@@ -0,0 +1,541 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Fast writers exporting mmtf::StructureData as PDB or mmCIF text.
+// See "examples/print_as_pdb.cpp" for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_TEXT_WRITER_H
+#define MMTF_TEXT_WRITER_H
+
+#include "structure_data.hpp"
+#include "hierarchy_index.hpp"
+#include "errors.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <math.h>
+
+namespace mmtf {
+
+/**
+ * @brief Write atoms of an MMTF data structure as PDB records.
+ * @param[in] data    MMTF data structure to be written
+ * @param[in] stream  Stream to write to
+ * @tparam Stream Any stream type compatible to std::ostream
+ * @throw mmtf::EncodeError if coordinate lists do not match numAtoms
+ * @throw mmtf::DecodeError if the model/chain/group hierarchy is inconsistent
+ *
+ * Writes CRYST1 (if unitCell is set), ATOM/HETATM, MODEL/ENDMDL (if there is
+ * more than one model) and END records. All records are exactly 80 characters
+ * wide. Fields are formatted into a preallocated buffer without going through
+ * iostream formatting (atoms are formatted in parallel if OpenMP is enabled).
+ *
+ * Legacy PDB limits apply: serial numbers are wrapped modulo 100000, residue
+ * numbers modulo 10000, residue names are cut to 4 and chain names to 1
+ * character. Numbers which do not fit their column (e.g. coordinates beyond
+ * 9999.999) are written as '*'. HETATM is set as in is_hetatm, but chains
+ * without entity are only classified by chemCompType.
+ */
+template <typename Stream>
+inline void writePDB(const StructureData& data, Stream& stream);
+
+/**
+ * @brief Write atoms of an MMTF data structure as PDB file.
+ * @param[in] data      MMTF data structure to be written
+ * @param[in] filename  Path to file to write
+ * @throw mmtf::EncodeError if file cannot be opened
+ *
+ * Other behavior as in ::writePDB.
+ */
+inline void writePDBToFile(const StructureData& data,
+                           const std::string& filename);
+
+/**
+ * @brief Write atoms of an MMTF data structure as mmCIF atom_site loop.
+ * @param[in] data    MMTF data structure to be written
+ * @param[in] stream  Stream to write to
+ * @tparam Stream Any stream type compatible to std::ostream
+ * @throw mmtf::EncodeError if coordinate lists do not match numAtoms
+ * @throw mmtf::DecodeError if the model/chain/group hierarchy is inconsistent
+ *
+ * Writes a data block named after structureId with _cell and _symmetry (if
+ * set) and an _atom_site loop. label_* items are taken from chainIdList,
+ * groupName, atom names and sequenceIndexList, auth_* items from chainNameList
+ * and groupIdList. Atoms are formatted in parallel chunks if OpenMP is enabled.
+ */
+template <typename Stream>
+inline void writeMmCIF(const StructureData& data, Stream& stream);
+
+/**
+ * @brief Write atoms of an MMTF data structure as mmCIF file.
+ * @param[in] data      MMTF data structure to be written
+ * @param[in] filename  Path to file to write
+ * @throw mmtf::EncodeError if file cannot be opened
+ *
+ * Other behavior as in ::writeMmCIF.
+ */
+inline void writeMmCIFToFile(const StructureData& data,
+                             const std::string& filename);
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+namespace { // private helpers
+
+// length of one PDB record incl. newline
+const int32_t PDB_LINE_LENGTH = 81;
+
+// write integer right-aligned into exactly width chars ('*' if too wide)
+inline void textWriteInt(char* dst, long value, int width) {
+    char tmp[24];
+    int n = 0;
+    const bool negative = (value < 0);
+    unsigned long v = negative ? (unsigned long)(-(value + 1)) + 1
+                               : (unsigned long)value;
+    do {
+        tmp[n++] = char('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (negative) tmp[n++] = '-';
+    if (n > width) {
+        for (int i = 0; i < width; ++i) dst[i] = '*';
+        return;
+    }
+    int i = 0;
+    for (; i < width - n; ++i) dst[i] = ' ';
+    while (n > 0) dst[i++] = tmp[--n];
+}
+
+// format fixed-point number (like printf("%.<decimals>f")) into tmp
+// -> returns number of chars written (tmp must hold 40 chars)
+inline int textFormatFixed(char* tmp, float value, int decimals) {
+    static const double scale[] = {1., 10., 100., 1000., 10000., 100000.};
+    // exact for floats: 24 bit mantissa * 17 bit scale < 53 bit
+    double v = double(value) * scale[decimals];
+    const bool negative = (v < 0);
+    if (negative) v = -v;
+    // treat NaN / huge values as not representable
+    if (!(v < 1e15)) {
+        tmp[0] = '*';
+        return 1;
+    }
+    // round half to even as printf does
+    double scaled = floor(v);
+    const double rest = v - scaled;
+    if (rest > 0.5 || (rest == 0.5 && fmod(scaled, 2.0) != 0)) scaled += 1;
+    char rev[40];
+    int n = 0;
+    if (scaled < 4294967295.0) {
+        // common case: integer arithmetic
+        unsigned long digits = (unsigned long)scaled;
+        for (int i = 0; i < decimals; ++i) {
+            rev[n++] = char('0' + digits % 10);
+            digits /= 10;
+        }
+        if (decimals > 0) rev[n++] = '.';
+        do {
+            rev[n++] = char('0' + digits % 10);
+            digits /= 10;
+        } while (digits > 0);
+    } else {
+        for (int i = 0; i < decimals; ++i) {
+            rev[n++] = char('0' + int(fmod(scaled, 10.0)));
+            scaled = floor(scaled / 10);
+        }
+        if (decimals > 0) rev[n++] = '.';
+        do {
+            rev[n++] = char('0' + int(fmod(scaled, 10.0)));
+            scaled = floor(scaled / 10);
+        } while (scaled > 0);
+    }
+    if (negative) rev[n++] = '-';
+    for (int i = 0; i < n; ++i) tmp[i] = rev[n - 1 - i];
+    return n;
+}
+
+// write fixed-point number right-aligned into exactly width chars
+inline void textWriteFixed(char* dst, float value, int width, int decimals) {
+    char tmp[40];
+    const int n = textFormatFixed(tmp, value, decimals);
+    if (n > width || tmp[0] == '*') {
+        for (int i = 0; i < width; ++i) dst[i] = '*';
+        return;
+    }
+    int i = 0;
+    for (; i < width - n; ++i) dst[i] = ' ';
+    for (int j = 0; j < n; ++j) dst[i++] = tmp[j];
+}
+
+// copy up to width chars of str left-aligned into dst (space padded)
+inline void textWriteLeft(char* dst, const std::string& str, int width,
+                          bool upper = false) {
+    const int n = std::min(int(str.size()), width);
+    for (int i = 0; i < n; ++i) {
+        char c = str[i];
+        if (upper && c >= 'a' && c <= 'z') c = char(c - 'a' + 'A');
+        dst[i] = c;
+    }
+    for (int i = n; i < width; ++i) dst[i] = ' ';
+}
+
+// copy up to width chars of str right-aligned into dst (space padded)
+inline void textWriteRight(char* dst, const std::string& str, int width,
+                           bool upper = false) {
+    const int n = std::min(int(str.size()), width);
+    for (int i = 0; i < width - n; ++i) dst[i] = ' ';
+    textWriteLeft(dst + width - n, str, n, upper);
+}
+
+// fill PDB record (80 chars + newline) with record name and blanks
+inline char* textStartPDBLine(char* dst, const char* record) {
+    int i = 0;
+    for (; record[i] != 0; ++i) dst[i] = record[i];
+    for (; i < PDB_LINE_LENGTH - 1; ++i) dst[i] = ' ';
+    dst[PDB_LINE_LENGTH - 1] = '\n';
+    return dst;
+}
+
+// check sizes of per-atom lists used by writers
+inline void textCheckData(const StructureData& data,
+                          const HierarchyIndex& index) {
+    if (index.numAtoms() != data.numAtoms
+        || int32_t(data.xCoordList.size()) != data.numAtoms
+        || int32_t(data.yCoordList.size()) != data.numAtoms
+        || int32_t(data.zCoordList.size()) != data.numAtoms) {
+        throw EncodeError("Cannot write text output: coordinate lists are "
+                          "inconsistent with numAtoms");
+    }
+}
+
+// HETATM classification which does not throw for chains without entity
+inline bool textIsHetatm(const ClassificationTable& classification,
+                         int32_t chain_index, int32_t group_type) {
+    return classification.groupTypeIsHetatm[group_type]
+        || (classification.chainEntityIndex[chain_index] != -1
+            && !classification.chainIsPolymer[chain_index]);
+}
+
+// write one ATOM/HETATM record for given atom
+inline void textWritePDBAtom(char* line, const StructureData& data,
+                             const HierarchyIndex& index,
+                             const ClassificationTable& classification,
+                             int32_t atom_index) {
+    const int32_t group_index = index.groupIndexOfAtom(atom_index);
+    const int32_t chain_index = index.chainIndexOfGroup(group_index);
+    const int32_t group_type = data.groupTypeList[group_index];
+    const GroupType& group = data.groupList[group_type];
+    const int32_t l = atom_index - index.atomBegin(group_index);
+
+    textStartPDBLine(line, textIsHetatm(classification, chain_index,
+                                        group_type) ? "HETATM" : "ATOM");
+    // serial (cols 7-11)
+    long serial = isDefaultValue(data.atomIdList) ? atom_index + 1
+                                                  : data.atomIdList[atom_index];
+    textWriteInt(line + 6, serial % 100000, 5);
+    // atom name (cols 13-16): 1-letter elements start in col 14
+    const std::string& name = group.atomNameList[l];
+    if (name.size() < 4 && group.elementList[l].size() < 2) {
+        textWriteLeft(line + 13, name, 3);
+    } else {
+        textWriteLeft(line + 12, name, 4);
+    }
+    // alt. loc (col 17)
+    if (!isDefaultValue(data.altLocList) && data.altLocList[atom_index] > ' ') {
+        line[16] = data.altLocList[atom_index];
+    }
+    // residue name (cols 18-20, col 21 only used for 4-letter names)
+    if (group.groupName.size() <= 3) {
+        textWriteRight(line + 17, group.groupName, 3);
+    } else {
+        textWriteLeft(line + 17, group.groupName, 4);
+    }
+    // chain (col 22)
+    const std::string& chain = isDefaultValue(data.chainNameList)
+                             ? data.chainIdList[chain_index]
+                             : data.chainNameList[chain_index];
+    if (!chain.empty()) line[21] = chain[0];
+    // residue number (cols 23-26) and insertion code (col 27)
+    textWriteInt(line + 22, data.groupIdList[group_index] % 10000, 4);
+    if (!isDefaultValue(data.insCodeList) && data.insCodeList[group_index] > ' ') {
+        line[26] = data.insCodeList[group_index];
+    }
+    // coordinates (cols 31-54)
+    textWriteFixed(line + 30, data.xCoordList[atom_index], 8, 3);
+    textWriteFixed(line + 38, data.yCoordList[atom_index], 8, 3);
+    textWriteFixed(line + 46, data.zCoordList[atom_index], 8, 3);
+    // occupancy (cols 55-60) and B-factor (cols 61-66)
+    textWriteFixed(line + 54, isDefaultValue(data.occupancyList) ? 1.0f
+                              : data.occupancyList[atom_index], 6, 2);
+    textWriteFixed(line + 60, isDefaultValue(data.bFactorList) ? 0.0f
+                              : data.bFactorList[atom_index], 6, 2);
+    // element (cols 77-78) and charge (cols 79-80)
+    textWriteRight(line + 76, group.elementList[l], 2, true);
+    const int32_t charge = group.formalChargeList[l];
+    if (charge != 0 && charge > -10 && charge < 10) {
+        line[78] = char('0' + (charge < 0 ? -charge : charge));
+        line[79] = (charge < 0) ? '-' : '+';
+    }
+}
+
+// append CIF token (quoted if needed) followed by a space
+inline void textAppendCIFToken(std::string& out, const std::string& token) {
+    bool quote = token.empty();
+    if (!quote) {
+        const char c = token[0];
+        quote = (c == '_' || c == '#' || c == '$' || c == '\'' || c == '"'
+                 || c == ';' || c == '[' || c == ']'
+                 || token == "." || token == "?");
+        for (size_t i = 0; !quote && i < token.size(); ++i) {
+            quote = (token[i] == ' ' || token[i] == '\t');
+        }
+    }
+    if (quote) {
+        const char q = (token.find('\'') == std::string::npos) ? '\'' : '"';
+        out += q;
+        out += token;
+        out += q;
+    } else {
+        out += token;
+    }
+    out += ' ';
+}
+
+inline void textAppendCIFInt(std::string& out, long value) {
+    char tmp[24];
+    int n = 0;
+    const bool negative = (value < 0);
+    unsigned long v = negative ? (unsigned long)(-(value + 1)) + 1
+                               : (unsigned long)value;
+    do {
+        tmp[n++] = char('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (negative) out += '-';
+    while (n > 0) out += tmp[--n];
+    out += ' ';
+}
+
+inline void textAppendCIFFixed(std::string& out, float value, int decimals) {
+    char tmp[40];
+    const int n = textFormatFixed(tmp, value, decimals);
+    if (tmp[0] == '*') out += '?';
+    else               out.append(tmp, n);
+    out += ' ';
+}
+
+inline void textAppendCIFChar(std::string& out, char c, char missing) {
+    out += (c > ' ') ? c : missing;
+    out += ' ';
+}
+
+// format atoms [atom_begin, atom_end) as atom_site rows
+inline void textWriteCIFAtoms(std::string& out, const StructureData& data,
+                              const HierarchyIndex& index,
+                              const ClassificationTable& classification,
+                              int32_t atom_begin, int32_t atom_end) {
+    out.reserve(out.size() + size_t(atom_end - atom_begin) * 100);
+    for (int32_t atom_index = atom_begin; atom_index < atom_end; ++atom_index) {
+        const int32_t group_index = index.groupIndexOfAtom(atom_index);
+        const int32_t chain_index = index.chainIndexOfGroup(group_index);
+        const int32_t model_index = index.modelIndexOfChain(chain_index);
+        const int32_t group_type = data.groupTypeList[group_index];
+        const GroupType& group = data.groupList[group_type];
+        const int32_t l = atom_index - index.atomBegin(group_index);
+        const int32_t entity = classification.chainEntityIndex[chain_index];
+
+        out += textIsHetatm(classification, chain_index, group_type)
+             ? "HETATM " : "ATOM ";
+        textAppendCIFInt(out, isDefaultValue(data.atomIdList)
+                              ? atom_index + 1 : data.atomIdList[atom_index]);
+        textAppendCIFToken(out, group.elementList[l]);
+        textAppendCIFToken(out, group.atomNameList[l]);
+        textAppendCIFChar(out, isDefaultValue(data.altLocList)
+                               ? 0 : data.altLocList[atom_index], '.');
+        textAppendCIFToken(out, group.groupName);
+        textAppendCIFToken(out, data.chainIdList[chain_index]);
+        if (entity >= 0) textAppendCIFInt(out, entity + 1);
+        else             out += "? ";
+        if (!isDefaultValue(data.sequenceIndexList)
+            && data.sequenceIndexList[group_index] >= 0) {
+            textAppendCIFInt(out, data.sequenceIndexList[group_index] + 1);
+        } else {
+            out += ". ";
+        }
+        textAppendCIFChar(out, isDefaultValue(data.insCodeList)
+                               ? 0 : data.insCodeList[group_index], '?');
+        textAppendCIFFixed(out, data.xCoordList[atom_index], 3);
+        textAppendCIFFixed(out, data.yCoordList[atom_index], 3);
+        textAppendCIFFixed(out, data.zCoordList[atom_index], 3);
+        textAppendCIFFixed(out, isDefaultValue(data.occupancyList) ? 1.0f
+                                : data.occupancyList[atom_index], 2);
+        textAppendCIFFixed(out, isDefaultValue(data.bFactorList) ? 0.0f
+                                : data.bFactorList[atom_index], 2);
+        textAppendCIFInt(out, group.formalChargeList[l]);
+        textAppendCIFInt(out, data.groupIdList[group_index]);
+        textAppendCIFToken(out, isDefaultValue(data.chainNameList)
+                                ? data.chainIdList[chain_index]
+                                : data.chainNameList[chain_index]);
+        textAppendCIFInt(out, model_index + 1);
+        out[out.size() - 1] = '\n';
+    }
+}
+
+} // anon ns
+
+template <typename Stream>
+inline void writePDB(const StructureData& data, Stream& stream) {
+    const HierarchyIndex index(data);
+    const ClassificationTable classification(data);
+    textCheckData(data, index);
+
+    const int32_t num_models = index.numModels();
+    const bool multi_model = (num_models > 1);
+    const bool has_cell = (data.unitCell.size() == 6);
+    // layout: [CRYST1] {[MODEL] atoms [ENDMDL]} END
+    const int32_t header_lines = has_cell ? 1 : 0;
+    const int32_t model_lines = multi_model ? 2 : 0;
+    const size_t num_lines = size_t(header_lines) + size_t(data.numAtoms)
+                           + size_t(model_lines) * num_models + 1;
+    std::vector<char> buffer(num_lines * PDB_LINE_LENGTH);
+    char* const first_line = &buffer[0];
+
+    if (has_cell) {
+        char* line = textStartPDBLine(first_line, "CRYST1");
+        textWriteFixed(line + 6, data.unitCell[0], 9, 3);
+        textWriteFixed(line + 15, data.unitCell[1], 9, 3);
+        textWriteFixed(line + 24, data.unitCell[2], 9, 3);
+        textWriteFixed(line + 33, data.unitCell[3], 7, 2);
+        textWriteFixed(line + 40, data.unitCell[4], 7, 2);
+        textWriteFixed(line + 47, data.unitCell[5], 7, 2);
+        textWriteLeft(line + 55, data.spaceGroup, 11);
+    }
+
+    // models are independent: atoms of model m start after m MODEL/ENDMDL pairs
+    for (int32_t m = 0; m < num_models; ++m) {
+        const int32_t atom_begin = index.modelAtomBegin(m);
+        const int32_t atom_end = index.modelAtomEnd(m);
+        char* model_start = first_line + (size_t(header_lines) + atom_begin
+                                          + size_t(model_lines) * m)
+                                         * PDB_LINE_LENGTH;
+        char* atom_start = model_start;
+        if (multi_model) {
+            textStartPDBLine(model_start, "MODEL");
+            textWriteInt(model_start + 10, m + 1, 4);
+            atom_start += PDB_LINE_LENGTH;
+            textStartPDBLine(atom_start
+                             + size_t(atom_end - atom_begin) * PDB_LINE_LENGTH,
+                             "ENDMDL");
+        }
+        const int num_atoms = atom_end - atom_begin;
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(static)
+        #endif
+        for (int i = 0; i < num_atoms; ++i) {
+            textWritePDBAtom(atom_start + size_t(i) * PDB_LINE_LENGTH, data,
+                             index, classification, atom_begin + i);
+        }
+    }
+    textStartPDBLine(first_line + (num_lines - 1) * PDB_LINE_LENGTH, "END");
+
+    stream.write(first_line, buffer.size());
+}
+
+inline void writePDBToFile(const StructureData& data,
+                           const std::string& filename) {
+    std::ofstream ofs(filename.c_str(), std::ios::binary | std::ios::out);
+    if (!ofs) {
+        throw EncodeError("Could not open >" + filename + "< for writing, exiting.");
+    }
+    writePDB(data, ofs);
+}
+
+template <typename Stream>
+inline void writeMmCIF(const StructureData& data, Stream& stream) {
+    const HierarchyIndex index(data);
+    const ClassificationTable classification(data);
+    textCheckData(data, index);
+
+    std::string header("data_");
+    header += isDefaultValue(data.structureId) ? std::string("unnamed")
+                                               : data.structureId;
+    header += "\n#\n";
+    if (data.unitCell.size() == 6) {
+        const char* cell_items[] = {"length_a", "length_b", "length_c",
+                                    "angle_alpha", "angle_beta", "angle_gamma"};
+        for (int i = 0; i < 6; ++i) {
+            header += "_cell.";
+            header += cell_items[i];
+            header += ' ';
+            textAppendCIFFixed(header, data.unitCell[i], (i < 3) ? 3 : 2);
+            header[header.size() - 1] = '\n';
+        }
+        header += "#\n";
+    }
+    if (!isDefaultValue(data.spaceGroup)) {
+        header += "_symmetry.space_group_name_H-M ";
+        textAppendCIFToken(header, data.spaceGroup);
+        header[header.size() - 1] = '\n';
+        header += "#\n";
+    }
+    header += "loop_\n"
+              "_atom_site.group_PDB\n"
+              "_atom_site.id\n"
+              "_atom_site.type_symbol\n"
+              "_atom_site.label_atom_id\n"
+              "_atom_site.label_alt_id\n"
+              "_atom_site.label_comp_id\n"
+              "_atom_site.label_asym_id\n"
+              "_atom_site.label_entity_id\n"
+              "_atom_site.label_seq_id\n"
+              "_atom_site.pdbx_PDB_ins_code\n"
+              "_atom_site.Cartn_x\n"
+              "_atom_site.Cartn_y\n"
+              "_atom_site.Cartn_z\n"
+              "_atom_site.occupancy\n"
+              "_atom_site.B_iso_or_equiv\n"
+              "_atom_site.pdbx_formal_charge\n"
+              "_atom_site.auth_seq_id\n"
+              "_atom_site.auth_asym_id\n"
+              "_atom_site.pdbx_PDB_model_num\n";
+    stream.write(header.data(), header.size());
+
+    // format fixed-size chunks of atoms independently
+    const int32_t chunk_size = 16384;
+    const int num_chunks = (data.numAtoms + chunk_size - 1) / chunk_size;
+    std::vector<std::string> chunks(num_chunks);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (int c = 0; c < num_chunks; ++c) {
+        const int32_t atom_begin = c * chunk_size;
+        const int32_t atom_end = std::min(atom_begin + chunk_size,
+                                          data.numAtoms);
+        textWriteCIFAtoms(chunks[c], data, index, classification,
+                          atom_begin, atom_end);
+    }
+    for (int c = 0; c < num_chunks; ++c) {
+        stream.write(chunks[c].data(), chunks[c].size());
+    }
+    stream.write("#\n", 2);
+}
+
+inline void writeMmCIFToFile(const StructureData& data,
+                             const std::string& filename) {
+    std::ofstream ofs(filename.c_str(), std::ios::binary | std::ios::out);
+    if (!ofs) {
+        throw EncodeError("Could not open >" + filename + "< for writing, exiting.");
+    }
+    writeMmCIF(data, ofs);
+}
+
+} // mmtf namespace
+
+#endif
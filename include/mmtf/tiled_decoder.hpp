@@ -0,0 +1,275 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Out-of-core access to MMTF files with per-atom columns split into tiles.
+// See tests/mmtf_tests.cpp (Test tiled encoding) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_TILED_DECODER_H
+#define MMTF_TILED_DECODER_H
+
+#include "structure_data.hpp"
+#include "binary_decoder.hpp"
+#include "map_decoder.hpp"
+#include "decoder.hpp"
+#include "errors.hpp"
+
+#include <msgpack.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mmtf {
+
+namespace impl {
+
+/**
+ * @brief Read-only view of a file (memory-mapped on POSIX systems, read into
+ *        memory elsewhere). Class cannot be copied.
+ */
+class MappedFile {
+public:
+    MappedFile(): data_(NULL), size_(0) {}
+    ~MappedFile() { close(); }
+
+    /**
+     * @brief Map file (closes previously mapped file).
+     * @throw mmtf::DecodeError if file cannot be opened.
+     */
+    void open(const std::string& filename);
+    void close();
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    std::size_t size_;
+#if defined(_WIN32)
+    std::string buffer_;
+#endif
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+} // impl namespace
+
+/**
+ * @brief Decoder for files written with mmtf::encodeTiles.
+ *
+ * On initialization, all fields but the tiled per-atom columns are decoded
+ * into ::header (incl. the global hierarchy, but without the property maps,
+ * which can be accessed with a mmtf::PropertyView on ::mapDecoder). Tiles of
+ * the per-atom columns are then decoded one at a time with ::decodeTile.
+ * Files opened with ::initFromFile are memory-mapped (on POSIX systems), so
+ * only the pages of decoded tiles are read from disk.
+ *
+ * decodeTile can be called concurrently. The class cannot be copied as it
+ * contains a MapDecoder.
+ */
+class TiledDecoder {
+public:
+    /**
+     * @brief Construct empty decoder. Use init-functions to fill it.
+     */
+    TiledDecoder() {}
+
+    /**
+     * @brief Initialize from MMTF file contents.
+     * @param[in]  buffer File contents (not copied, must stay alive while
+     *                    this decoder is used)
+     * @param[in]  size   Size of buffer
+     * @throw mmtf::DecodeError if an error occured or if there are no tiles.
+     */
+    void initFromBuffer(const char* buffer, std::size_t size);
+
+    /**
+     * @brief Initialize from an existing MMTF file.
+     * @param[in]  filename Path to file to map
+     * @throw mmtf::DecodeError if an error occured or if there are no tiles.
+     */
+    void initFromFile(const std::string& filename);
+
+    /** @brief Number of atoms in the file. */
+    int32_t numAtoms() const { return header_.numAtoms; }
+
+    /** @brief Number of atoms per tile (the last tile may be shorter). */
+    int32_t tileSize() const { return md_.getTileSize(); }
+
+    /** @brief Number of tiles. */
+    int32_t numTiles() const {
+        return (numAtoms() + tileSize() - 1) / tileSize();
+    }
+
+    /** @brief Index of first atom in tile. */
+    int32_t tileBegin(int32_t tile) const { return tile * tileSize(); }
+
+    /** @brief One past index of last atom in tile. */
+    int32_t tileEnd(int32_t tile) const {
+        return std::min(numAtoms(), (tile + 1) * tileSize());
+    }
+
+    /**
+     * @brief All fields but the tiled per-atom columns and property maps.
+     */
+    const StructureData& header() const { return header_; }
+
+    /**
+     * @brief True if per-atom column (e.g. "xCoordList") is tiled.
+     */
+    bool isTiled(const std::string& key) const {
+        return md_.getTiles(key) != NULL;
+    }
+
+    /**
+     * @brief Decode one tile of a per-atom column.
+     * @param[in]  key     Name of column (e.g. "xCoordList")
+     * @param[in]  tile    Index of tile
+     * @param[out] target  Values for atoms [tileBegin(tile), tileEnd(tile))
+     * @return False (and target unchanged) if column is not tiled.
+     * @throw mmtf::DecodeError if tile is invalid or an error occured.
+     */
+    template<typename T>
+    bool decodeTile(const std::string& key, int32_t tile,
+                    std::vector<T>& target) const;
+
+    /**
+     * @brief Raw data of the file (e.g. for a mmtf::PropertyView).
+     */
+    const MapDecoder& mapDecoder() const { return md_; }
+
+private:
+    impl::MappedFile file_;
+    MapDecoder md_;
+    StructureData header_;
+
+    void init_(const char* buffer, std::size_t size);
+};
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+namespace impl {
+
+inline void MappedFile::open(const std::string& filename) {
+    close();
+#if defined(_WIN32)
+    std::ifstream ifs(filename.c_str(), std::ifstream::in | std::ios::binary);
+    if (!ifs.is_open()) {
+        throw DecodeError("Could not open file: " + filename);
+    }
+    ifs.seekg(0, std::ios::end);
+    buffer_.resize(ifs.tellg());
+    ifs.seekg(0, std::ios::beg);
+    if (!buffer_.empty()) ifs.read(&buffer_[0], buffer_.size());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw DecodeError("Could not open file: " + filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw DecodeError("Could not read file: " + filename);
+    }
+    if (info.st_size > 0) {
+        void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw DecodeError("Could not map file: " + filename);
+        }
+        data_ = static_cast<const char*>(mapped);
+        size_ = info.st_size;
+    }
+    // mapping stays valid after closing the descriptor
+    ::close(fd);
+#endif
+}
+
+inline void MappedFile::close() {
+#if defined(_WIN32)
+    buffer_.clear();
+#else
+    if (data_) munmap(const_cast<char*>(data_), size_);
+#endif
+    data_ = NULL;
+    size_ = 0;
+}
+
+} // impl namespace
+
+inline void TiledDecoder::initFromBuffer(const char* buffer,
+                                         std::size_t size) {
+    file_.close();
+    init_(buffer, size);
+}
+
+inline void TiledDecoder::initFromFile(const std::string& filename) {
+    file_.open(filename);
+    init_(file_.data(), file_.size());
+}
+
+template<typename T>
+bool TiledDecoder::decodeTile(const std::string& key, int32_t tile,
+                              std::vector<T>& target) const {
+    const std::vector<const msgpack::object*>* tiles = md_.getTiles(key);
+    if (!tiles) return false;
+    if (tile < 0 || tile >= numTiles()) {
+        std::stringstream err;
+        err << "Invalid tile index " << tile << " for file with "
+            << numTiles() << " tiles";
+        throw DecodeError(err.str());
+    }
+    BinaryDecoder(*(*tiles)[tile], key).decode(target);
+    return true;
+}
+
+inline void TiledDecoder::init_(const char* buffer, std::size_t size) {
+    header_ = StructureData();
+    md_.initFromBuffer(buffer, size, true);
+    if (md_.getTileSize() == 0) {
+        throw DecodeError("File has no tiles (see mmtf::encodeTiles)");
+    }
+    md_.setDecodeTiles(false);
+    decodeFromMapDecoder(header_, md_, false);
+    // tile lengths were checked by MapDecoder, so only the total is left
+    static const char* const keys[] = {
+        "xCoordList", "yCoordList", "zCoordList", "bFactorList",
+        "occupancyList", "atomIdList", "altLocList"
+    };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+        const std::vector<const msgpack::object*>* tiles =
+            md_.getTiles(keys[i]);
+        if (!tiles) continue;
+        const int32_t last = int32_t(tiles->size()) - 1;
+        if (   tiles->size() != size_t(numTiles())
+            || (last >= 0 && BinaryDecoder(*tiles->back(), keys[i]).length()
+                             != tileEnd(last) - tileBegin(last))) {
+            std::stringstream err;
+            err << "Tiles of entry '" << keys[i] << "' do not match "
+                << numAtoms() << " atoms";
+            throw DecodeError(err.str());
+        }
+    }
+}
+
+} // mmtf namespace
+
+#endif
@@ -0,0 +1,132 @@
+// *************************************************************************
+//
+// Licensed under the MIT License (see accompanying LICENSE file).
+//
+// *************************************************************************
+//
+// Structured report of issues found by StructureData::validate.
+// See tests/mmtf_tests.cpp (Test validation report) for example usage.
+//
+// *************************************************************************
+
+#ifndef MMTF_VALIDATION_H
+#define MMTF_VALIDATION_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace mmtf {
+
+/**
+ * @brief Type of a ValidationIssue.
+ */
+enum ValidationCode {
+    VALIDATION_WRONG_SIZE,     ///< Vector size does not match expected size
+    VALIDATION_INVALID_INDEX,  ///< Index out of range
+    VALIDATION_INVALID_VALUE,  ///< Value not allowed (e.g. bond order 5)
+    VALIDATION_INVALID_FORMAT, ///< String with wrong format or length
+    VALIDATION_MISSING_FIELD,  ///< Field required by another set field unset
+    VALIDATION_WRONG_COUNT     ///< Count (e.g. numAtoms) does not match data
+};
+
+/**
+ * @brief Name of a ValidationCode (e.g. "wrong_size") for logs and tables.
+ */
+inline const char* getValidationCodeName(ValidationCode code);
+
+/**
+ * @brief Single issue found by StructureData::validate.
+ */
+struct ValidationIssue {
+    ValidationCode code;
+    std::string field;   ///< Name of field (group type fields as
+                         ///< "groupList[i].bondOrderList")
+    int64_t index;       ///< Index of offending element in field or -1 if
+                         ///< the field as a whole is affected
+    std::string message; ///< Human readable description
+
+    ValidationIssue(ValidationCode c, const std::string& f, int64_t i,
+                    const std::string& m)
+        : code(c), field(f), index(i), message(m) {}
+};
+
+/**
+ * @brief Collection of issues found by StructureData::validate.
+ *
+ * Collects up to maxIssues() issues. Once full, StructureData::validate stops
+ * and further issues are ignored, so that heavily broken files do not produce
+ * huge reports. Use a cap of 1 to only find the first issue.
+ */
+class ValidationReport {
+public:
+    /**
+     * @brief Construct empty report.
+     * @param max_issues  Max. number of issues to collect (0 = no limit)
+     */
+    explicit ValidationReport(size_t max_issues = 1000)
+        : max_issues_(max_issues) {}
+
+    /** @brief True if no issues were found. */
+    bool isValid() const { return issues_.empty(); }
+
+    /** @brief True if the cap was reached (there may be more issues). */
+    bool isFull() const {
+        return max_issues_ > 0 && issues_.size() >= max_issues_;
+    }
+
+    /** @brief Collected issues in order of discovery. */
+    const std::vector<ValidationIssue>& issues() const { return issues_; }
+
+    /** @brief Number of collected issues with given code. */
+    size_t count(ValidationCode code) const;
+
+    /** @brief Max. number of issues to collect (0 = no limit). */
+    size_t maxIssues() const { return max_issues_; }
+
+    /** @brief Add issue (ignored if report is full). */
+    void add(ValidationCode code, const std::string& field, int64_t index,
+             const std::string& message);
+
+    /** @brief Remove all issues. */
+    void clear() { issues_.clear(); }
+
+private:
+    std::vector<ValidationIssue> issues_;
+    size_t max_issues_;
+};
+
+// *************************************************************************
+// IMPLEMENTATION
+// *************************************************************************
+
+inline const char* getValidationCodeName(ValidationCode code) {
+    switch (code) {
+        case VALIDATION_WRONG_SIZE:     return "wrong_size";
+        case VALIDATION_INVALID_INDEX:  return "invalid_index";
+        case VALIDATION_INVALID_VALUE:  return "invalid_value";
+        case VALIDATION_INVALID_FORMAT: return "invalid_format";
+        case VALIDATION_MISSING_FIELD:  return "missing_field";
+        case VALIDATION_WRONG_COUNT:    return "wrong_count";
+    }
+    return "unknown";
+}
+
+inline size_t ValidationReport::count(ValidationCode code) const {
+    size_t num = 0;
+    for (size_t i = 0; i < issues_.size(); ++i) {
+        if (issues_[i].code == code) ++num;
+    }
+    return num;
+}
+
+inline void ValidationReport::add(ValidationCode code,
+                                  const std::string& field, int64_t index,
+                                  const std::string& message) {
+    if (isFull()) return;
+    issues_.push_back(ValidationIssue(code, field, index, message));
+}
+
+} // mmtf namespace
+
+#endif
@@ -9,6 +9,20 @@
 
 #include <mmtf.hpp>
 #include <mmtf/export_helpers.hpp>
+#include <mmtf/hierarchy_index.hpp>
+#include <mmtf/text_writer.hpp>
+#include <mmtf/text_reader.hpp>
+#include <mmtf/spatial_index.hpp>
+#include <mmtf/bond_inference.hpp>
+#include <mmtf/assembly.hpp>
+#include <mmtf/crystal.hpp>
+#include <mmtf/model_decoder.hpp>
+#include <mmtf/synthetic.hpp>
+#include <mmtf/property_view.hpp>
+#include <mmtf/property_columns.hpp>
+#include <mmtf/tiled_decoder.hpp>
+
+#include <set>
 
 
 // NOTE!!! Margin is set to 0.00001
@@ -919,6 +933,8 @@ TEST_CASE("Test export_helpers") {
   REQUIRE(sd.numBonds == 0);
   REQUIRE(sd.hasConsistentData());
 
+  mmtf::StructureData sd_bulk = sd;
+
   // re-add bonds
   mmtf::BondAdder bondadder(sd);
   for (size_t i = 0; i < bonddata.size(); i += 3) {
@@ -927,6 +943,35 @@ TEST_CASE("Test export_helpers") {
   REQUIRE(sd.numBonds == numbonds_ref);
   REQUIRE(sd.hasConsistentData());
 
+  // bulk insertion gives the same result
+  std::vector<int32_t> bulk_atoms;
+  std::vector<int8_t> bulk_orders;
+  for (size_t i = 0; i < bonddata.size(); i += 3) {
+    bulk_atoms.push_back(bonddata[i]);
+    bulk_atoms.push_back(bonddata[i + 1]);
+    bulk_orders.push_back(bonddata[i + 2]);
+  }
+  mmtf::StructureData sd_sorted = sd_bulk;
+  mmtf::BondAdder bulkadder(sd_bulk);
+  REQUIRE(bulkadder.addBonds(bulk_atoms, bulk_orders));
+  REQUIRE(sd_bulk.numBonds == numbonds_ref);
+  REQUIRE(sd_bulk.groupList == sd.groupList);
+  REQUIRE(sd_bulk.bondAtomList == sd.bondAtomList);
+  REQUIRE(sd_bulk.bondOrderList == sd.bondOrderList);
+  REQUIRE_FALSE(bulkadder.addBonds(std::vector<int32_t>(2, -1),
+                                   std::vector<int8_t>(1, 1)));
+  REQUIRE(sd_bulk.numBonds == numbonds_ref);
+
+  // sorted inter-group bonds
+  mmtf::BondAdder sortedadder(sd_sorted);
+  REQUIRE(sortedadder.addBonds(bulk_atoms, bulk_orders, true));
+  REQUIRE(sd_sorted.groupList == sd.groupList);
+  REQUIRE(sd_sorted.hasConsistentData());
+  for (size_t i = 2; i < sd_sorted.bondAtomList.size(); i += 2) {
+    REQUIRE(sd_sorted.bondAtomList[i] < sd_sorted.bondAtomList[i + 1]);
+    REQUIRE(sd_sorted.bondAtomList[i - 2] <= sd_sorted.bondAtomList[i]);
+  }
+
   // re-compress groupTypeList
   mmtf::compressGroupList(sd);
   REQUIRE(sd.groupTypeList.size() != sd.groupList.size());
@@ -941,6 +986,40 @@ TEST_CASE("Test export_helpers") {
   REQUIRE(sd_ref.groupList == sd.groupList);
 }
 
+TEST_CASE("Test compressGroupList") {
+  mmtf::StructureData sd;
+  mmtf::GroupType group;
+  group.groupName = "ALA";
+  group.singleLetterCode = 'A';
+  group.chemCompType = "L-PEPTIDE LINKING";
+  group.atomNameList.push_back("CA");
+  group.elementList.push_back("C");
+  group.formalChargeList.push_back(0);
+  // groups differing in a single field must stay separate
+  mmtf::GroupType other_charge = group;
+  other_charge.formalChargeList[0] = 1;
+  mmtf::GroupType other_letter = group;
+  other_letter.singleLetterCode = 'X';
+  mmtf::GroupType other_bonds = group;
+  other_bonds.bondAtomList.push_back(0);
+  other_bonds.bondAtomList.push_back(0);
+  other_bonds.bondOrderList.push_back(1);
+  const mmtf::GroupType* order[] = {&group, &other_charge, &group,
+                                    &other_letter, &other_bonds, &other_charge};
+  for (size_t i = 0; i < 6; ++i) {
+    sd.groupList.push_back(*order[i]);
+    sd.groupTypeList.push_back(i);
+  }
+  mmtf::compressGroupList(sd);
+  REQUIRE(sd.groupList.size() == 4);
+  REQUIRE(sd.groupList[0] == group);
+  REQUIRE(sd.groupList[1] == other_charge);
+  REQUIRE(sd.groupList[2] == other_letter);
+  REQUIRE(sd.groupList[3] == other_bonds);
+  const int32_t expected[] = {0, 1, 0, 2, 3, 1};
+  REQUIRE(sd.groupTypeList == std::vector<int32_t>(expected, expected + 6));
+}
+
 TEST_CASE("Test mapdecoder from raw mmtf") {
   std::string working_mmtf = "../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf";
   mmtf::MapDecoder md;
@@ -1050,8 +1129,1550 @@ TEST_CASE("Test is_hetatm (chain_index version)") {
   SECTION("throw check") {
     REQUIRE_THROWS_AS(is_polymer(999, sd.entityList), mmtf::DecodeError);
   }
+
+  SECTION("ClassificationTable") {
+    mmtf::ClassificationTable classification(sd);
+    REQUIRE(classification.chainIsPolymer.size() == size_t(sd.numChains));
+    REQUIRE(classification.groupTypeIsHetatm.size() == sd.groupList.size());
+    int chainIndex = 0;
+    int groupIndex = 0;
+    for (int i = 0; i < sd.numModels; i++) {
+      for (int j = 0; j < sd.chainsPerModel[i]; j++, chainIndex++) {
+        REQUIRE(classification.isPolymer(chainIndex)
+                == is_polymer(chainIndex, sd.entityList));
+        for (int k = 0; k < sd.groupsPerChain[chainIndex]; k++, groupIndex++) {
+          const int32_t groupType = sd.groupTypeList[groupIndex];
+          REQUIRE(classification.isHetatm(chainIndex, groupType)
+                  == is_hetatm(chainIndex, sd.entityList,
+                               sd.groupList[groupType]));
+        }
+      }
+    }
+    REQUIRE_THROWS_AS(classification.isPolymer(999), mmtf::DecodeError);
+  }
+}
+
+
+TEST_CASE("Test HierarchyIndex and AtomIterator") {
+  std::vector<std::string> files;
+  files.push_back("../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf");
+  files.push_back("../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf");
+  files.push_back("../temporary_test_data/3zqs.mmtf");
+  for (size_t f = 0; f < files.size(); ++f) {
+    mmtf::StructureData sd;
+    mmtf::decodeFromFile(sd, files[f]);
+    mmtf::HierarchyIndex index(sd);
+    REQUIRE(index.numModels() == sd.numModels);
+    REQUIRE(index.numChains() == sd.numChains);
+    REQUIRE(index.numGroups() == sd.numGroups);
+    REQUIRE(index.numAtoms() == sd.numAtoms);
+
+    // compare with hand-written traversal
+    mmtf::AtomIterator it = mmtf::atomsBegin(sd, index);
+    int chainIndex = 0;
+    int groupIndex = 0;
+    int atomIndex = 0;
+    for (int i = 0; i < sd.numModels; ++i) {
+      REQUIRE(index.chainBegin(i) == chainIndex);
+      REQUIRE(index.modelAtomBegin(i) == atomIndex);
+      for (int j = 0; j < sd.chainsPerModel[i]; ++j, ++chainIndex) {
+        REQUIRE(index.modelIndexOfChain(chainIndex) == i);
+        REQUIRE(index.groupBegin(chainIndex) == groupIndex);
+        REQUIRE(index.chainAtomBegin(chainIndex) == atomIndex);
+        for (int k = 0; k < sd.groupsPerChain[chainIndex]; ++k, ++groupIndex) {
+          const mmtf::GroupType& group =
+              sd.groupList[sd.groupTypeList[groupIndex]];
+          REQUIRE(index.chainIndexOfGroup(groupIndex) == chainIndex);
+          REQUIRE(index.atomBegin(groupIndex) == atomIndex);
+          REQUIRE(index.atomEnd(groupIndex) - index.atomBegin(groupIndex)
+                  == int(group.atomNameList.size()));
+          for (size_t l = 0; l < group.atomNameList.size(); ++l, ++atomIndex) {
+            REQUIRE(it->atomIndex() == atomIndex);
+            REQUIRE(it->groupIndex() == groupIndex);
+            REQUIRE(it->chainIndex() == chainIndex);
+            REQUIRE(it->modelIndex() == i);
+            REQUIRE(it->groupAtomIndex() == int(l));
+            REQUIRE(it->atomName() == group.atomNameList[l]);
+            REQUIRE(it->x() == sd.xCoordList[atomIndex]);
+            ++it;
+          }
+        }
+        REQUIRE(index.chainAtomEnd(chainIndex) == atomIndex);
+      }
+      REQUIRE(index.modelAtomEnd(i) == atomIndex);
+    }
+    REQUIRE(it == mmtf::atomsEnd(sd, index));
+
+    // nested model / chain / group iteration
+    int32_t num_chains = 0;
+    int32_t num_groups = 0;
+    int32_t num_atoms = 0;
+    for (mmtf::ModelIterator model = mmtf::modelsBegin(sd, index);
+         model != mmtf::modelsEnd(sd, index); ++model) {
+      REQUIRE(model->atomsBegin()->atomIndex() == index.modelAtomBegin(model->modelIndex()));
+      for (mmtf::ChainIterator chain = model->chainsBegin();
+           chain != model->chainsEnd(); ++chain, ++num_chains) {
+        REQUIRE(chain->chainIndex() == num_chains);
+        REQUIRE(chain->modelIndex() == model->modelIndex());
+        REQUIRE(chain->chainId() == sd.chainIdList[num_chains]);
+        for (mmtf::GroupIterator group = chain->groupsBegin();
+             group != chain->groupsEnd(); ++group, ++num_groups) {
+          REQUIRE(group->groupIndex() == num_groups);
+          REQUIRE(group->chainIndex() == chain->chainIndex());
+          REQUIRE(group->groupId() == sd.groupIdList[num_groups]);
+          for (mmtf::AtomIterator atom = group->atomsBegin();
+               atom != group->atomsEnd(); ++atom, ++num_atoms) {
+            REQUIRE(atom->atomIndex() == num_atoms);
+            REQUIRE(&atom->group() == &group->group());
+          }
+        }
+      }
+    }
+    REQUIRE(num_chains == sd.numChains);
+    REQUIRE(num_groups == sd.numGroups);
+    REQUIRE(num_atoms == sd.numAtoms);
+
+    // random access
+    if (sd.numAtoms > 0) {
+      mmtf::AtomIterator last(sd, index, sd.numAtoms - 1);
+      REQUIRE(last->modelIndex() == sd.numModels - 1);
+      REQUIRE(last->groupIndex() == sd.numGroups - 1);
+    }
+  }
+
+  SECTION("empty index") {
+    const mmtf::HierarchyIndex empty;
+    REQUIRE(empty.numModels() == 0);
+    REQUIRE(empty.numChains() == 0);
+    REQUIRE(empty.numGroups() == 0);
+    REQUIRE(empty.numAtoms() == 0);
+    REQUIRE(empty.atomOffsets().size() == 1);
+    mmtf::HierarchyIndex from_empty((mmtf::StructureData()));
+    REQUIRE(from_empty.numModels() == 0);
+    REQUIRE(from_empty.numGroups() == 0);
+  }
+
+  SECTION("inconsistent hierarchy") {
+    mmtf::StructureData sd;
+    mmtf::decodeFromFile(sd, files[0]);
+    sd.groupsPerChain.push_back(1);
+    REQUIRE_THROWS_AS(mmtf::HierarchyIndex(sd), mmtf::DecodeError);
+  }
+
+  SECTION("negative counts with matching total") {
+    mmtf::StructureData sd;
+    mmtf::decodeFromFile(sd, files[0]);
+    sd.chainsPerModel.push_back(-1);
+    sd.chainsPerModel.back() = sd.chainsPerModel[0] + 1;
+    sd.chainsPerModel[0] = -1;
+    REQUIRE_THROWS_AS(mmtf::HierarchyIndex(sd), mmtf::DecodeError);
+    mmtf::decodeFromFile(sd, files[0]);
+    sd.groupsPerChain[0] += sd.groupsPerChain[1] + 1;
+    sd.groupsPerChain[1] = -1;
+    REQUIRE_THROWS_AS(mmtf::HierarchyIndex(sd), mmtf::DecodeError);
+  }
+}
+
+TEST_CASE("Test text writers") {
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf");
+  mmtf::HierarchyIndex index(sd);
+
+  SECTION("PDB") {
+    std::ostringstream out;
+    mmtf::writePDB(sd, out);
+    std::istringstream in(out.str());
+    std::string line;
+    int atomIndex = 0;
+    int models = 0;
+    while (std::getline(in, line)) {
+      REQUIRE(line.size() == 80);
+      if (line.compare(0, 5, "MODEL") == 0) ++models;
+      if (line.compare(0, 4, "ATOM") != 0
+          && line.compare(0, 6, "HETATM") != 0) continue;
+      mmtf::AtomIterator it(sd, index, atomIndex);
+      char coords[32];
+      snprintf(coords, sizeof(coords), "%8.3f%8.3f%8.3f", it->x(), it->y(),
+               it->z());
+      REQUIRE(line.substr(30, 24) == coords);
+      REQUIRE(line.substr(17, 3).find(it->group().groupName)
+              != std::string::npos);
+      ++atomIndex;
+    }
+    REQUIRE(atomIndex == sd.numAtoms);
+    REQUIRE(models == (sd.numModels > 1 ? sd.numModels : 0));
+    REQUIRE(line.compare(0, 3, "END") == 0);
+  }
+
+  SECTION("mmCIF") {
+    std::ostringstream out;
+    mmtf::writeMmCIF(sd, out);
+    const std::string cif = out.str();
+    REQUIRE(cif.compare(0, 5, "data_") == 0);
+    std::istringstream in(cif);
+    std::string line;
+    int atomIndex = 0;
+    while (std::getline(in, line)) {
+      if (line.compare(0, 5, "ATOM ") != 0
+          && line.compare(0, 7, "HETATM ") != 0) continue;
+      std::istringstream tokens(line);
+      std::vector<std::string> row;
+      std::string token;
+      while (tokens >> token) row.push_back(token);
+      REQUIRE(row.size() == 19);
+      mmtf::AtomIterator it(sd, index, atomIndex);
+      REQUIRE(row[6] == sd.chainIdList[it->chainIndex()]);
+      REQUIRE(row[18] == std::to_string(it->modelIndex() + 1));
+      ++atomIndex;
+    }
+    REQUIRE(atomIndex == sd.numAtoms);
+  }
+
+  SECTION("inconsistent data") {
+    sd.xCoordList.pop_back();
+    std::ostringstream out;
+    REQUIRE_THROWS_AS(mmtf::writePDB(sd, out), mmtf::EncodeError);
+    REQUIRE_THROWS_AS(mmtf::writeMmCIF(sd, out), mmtf::EncodeError);
+  }
+}
+
+TEST_CASE("Test text parsers") {
+  SECTION("round trip through writers") {
+    mmtf::StructureData sd;
+    mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf");
+
+    std::ostringstream pdb_out;
+    mmtf::writePDB(sd, pdb_out);
+    const std::string pdb = pdb_out.str();
+    mmtf::StructureData from_pdb;
+    mmtf::parsePDBFromBuffer(from_pdb, pdb.data(), pdb.size());
+    REQUIRE(from_pdb.hasConsistentData());
+    REQUIRE(from_pdb.numAtoms == sd.numAtoms);
+    REQUIRE(from_pdb.numModels == sd.numModels);
+    // writing again gives identical records
+    std::ostringstream pdb_again;
+    mmtf::writePDB(from_pdb, pdb_again);
+    REQUIRE(pdb_again.str() == pdb);
+
+    std::ostringstream cif_out;
+    mmtf::writeMmCIF(sd, cif_out);
+    const std::string cif = cif_out.str();
+    mmtf::StructureData from_cif;
+    mmtf::parseMmCIFFromBuffer(from_cif, cif.data(), cif.size());
+    REQUIRE(from_cif.hasConsistentData());
+    REQUIRE(from_cif.structureId == sd.structureId);
+    REQUIRE(from_cif.numAtoms == sd.numAtoms);
+    REQUIRE(from_cif.numChains == sd.numChains);
+    REQUIRE(from_cif.numGroups == sd.numGroups);
+    REQUIRE(from_cif.chainIdList == sd.chainIdList);
+    REQUIRE(from_cif.groupIdList == sd.groupIdList);
+    for (int i = 0; i < sd.numAtoms; ++i) {
+      REQUIRE(from_cif.xCoordList[i] == Approx(sd.xCoordList[i]).margin(1e-3));
+    }
+  }
+
+  SECTION("mmCIF syntax") {
+    const std::string cif =
+      "data_TEST\n"
+      "_cell.length_a 10.5(2)\n_cell.length_b 20\n_cell.length_c 30\n"
+      "_cell.angle_alpha 90\n_cell.angle_beta 90\n_cell.angle_gamma 90\n"
+      "_symmetry.space_group_name_H-M 'P 21 21 21'\n"
+      "loop_\n_other.a\n_other.b\n1 'a b'\n2\n;text\n;\n"
+      "#\nloop_\n"
+      "_atom_site.group_PDB\n_atom_site.id\n_atom_site.type_symbol\n"
+      "_atom_site.label_atom_id\n_atom_site.label_comp_id\n"
+      "_atom_site.label_asym_id\n_atom_site.label_entity_id\n"
+      "_atom_site.label_seq_id\n_atom_site.Cartn_x\n_atom_site.Cartn_y\n"
+      "_atom_site.Cartn_z\n_atom_site.auth_asym_id\n"
+      "ATOM 1 N N ALA A 1 1 1.0 2.0 3.0 X\n"
+      "ATOM 2 C CA ALA A 1 1 -1.5e1 2 3 X\n"
+      "ATOM 3 O \"O5'\" ALA A 1 2 1 2 3 X\n"
+      "HETATM 4 O O HOH B 2 . 1 2 3 X\n"
+      "#\n";
+    mmtf::StructureData sd;
+    mmtf::parseMmCIFFromBuffer(sd, cif.data(), cif.size());
+    REQUIRE(sd.structureId == "TEST");
+    REQUIRE(sd.spaceGroup == "P 21 21 21");
+    REQUIRE(sd.unitCell.size() == 6);
+    REQUIRE(sd.unitCell[0] == Approx(10.5));
+    REQUIRE(sd.numAtoms == 4);
+    REQUIRE(sd.numGroups == 3);
+    REQUIRE(sd.numChains == 2);
+    REQUIRE(sd.xCoordList[1] == Approx(-15));
+    REQUIRE(sd.groupList[sd.groupTypeList[1]].atomNameList[0] == "O5'");
+    REQUIRE(sd.chainNameList[1] == "X");
+    REQUIRE(sd.entityList.size() == 2);
+    REQUIRE(sd.entityList[1].type == "water");
+    REQUIRE(sd.sequenceIndexList[2] == -1);
+    REQUIRE_FALSE(mmtf::is_hetatm(0, sd.entityList, sd.groupList[0]));
+    REQUIRE(mmtf::is_hetatm(1, sd.entityList, sd.groupList[sd.groupTypeList[2]]));
+  }
+
+  SECTION("mmCIF quoted names and keywords are values") {
+    const std::string cif =
+      "data_TEST\n"
+      "_cell.length_a 10\n_cell.length_b 20\n_cell.length_c 30\n"
+      "_cell.angle_alpha 90\n_cell.angle_beta 90\n_cell.angle_gamma 90\n"
+      "loop_\n_pdbx_audit_revision_item.ordinal\n"
+      "_pdbx_audit_revision_item.item\n"
+      "1 '_cell.length_a'\n2.0 'loop_'\n3 \"data_x\"\n4\n;_cell.length_b\n;\n"
+      "5.0\n"
+      "loop_\n"
+      "_atom_site.label_atom_id\n_atom_site.label_comp_id\n"
+      "_atom_site.label_asym_id\n_atom_site.Cartn_x\n_atom_site.Cartn_y\n"
+      "_atom_site.Cartn_z\n"
+      "N ALA A 1 2 3\n";
+    mmtf::StructureData sd;
+    mmtf::parseMmCIFFromBuffer(sd, cif.data(), cif.size());
+    REQUIRE(sd.structureId == "TEST");
+    REQUIRE(sd.unitCell.size() == 6);
+    REQUIRE(sd.unitCell[0] == Approx(10));
+    REQUIRE(sd.unitCell[1] == Approx(20));
+    REQUIRE(sd.numAtoms == 1);
+  }
+
+  SECTION("PDB elements from atom names") {
+    const std::string pdb =
+      "ATOM      1  CA  ALA A   1       1.000   2.000   3.000  1.00  0.00\n"
+      "ATOM      2 HG21 THR A   2       1.000   2.000   3.000  1.00  0.00\n"
+      "ATOM      3 1HG2 VAL A   3       1.000   2.000   3.000  1.00  0.00\n"
+      "ATOM      4 ZN    ZN A   4       1.000   2.000   3.000  1.00  0.00\n"
+      "HETATM    5 FE   HEM A   5       1.000   2.000   3.000  1.00  0.00\n"
+      "HETATM    6 HG    HG A   6       1.000   2.000   3.000  1.00  0.00\n"
+      "HETATM    7 HN1  LIG A   7       1.000   2.000   3.000  1.00  0.00\n";
+    mmtf::StructureData sd;
+    mmtf::parsePDBFromBuffer(sd, pdb.data(), pdb.size());
+    REQUIRE(sd.numGroups == 7);
+    const char* expected[] = {"C", "H", "H", "ZN", "FE", "HG", "H"};
+    for (int32_t i = 0; i < sd.numGroups; ++i) {
+      REQUIRE(sd.groupList[sd.groupTypeList[i]].elementList[0]
+              == expected[i]);
+    }
+  }
+
+  SECTION("errors") {
+    mmtf::StructureData sd;
+    const std::string bad_pdb =
+      "ATOM      1  N   ALA A   1       1.000   x.000   3.000  1.00  0.00\n";
+    REQUIRE_THROWS_AS(mmtf::parsePDBFromBuffer(sd, bad_pdb.data(),
+                                               bad_pdb.size()),
+                      mmtf::DecodeError);
+    const std::string bad_cif =
+      "data_X\nloop_\n_atom_site.label_atom_id\n_atom_site.Cartn_x\nN 1\n";
+    REQUIRE_THROWS_AS(mmtf::parseMmCIFFromBuffer(sd, bad_cif.data(),
+                                                 bad_cif.size()),
+                      mmtf::DecodeError);
+    const std::string overflow_cif =
+      "data_X\nloop_\n_atom_site.label_atom_id\n_atom_site.label_comp_id\n"
+      "_atom_site.label_asym_id\n_atom_site.label_seq_id\n"
+      "_atom_site.Cartn_x\n_atom_site.Cartn_y\n_atom_site.Cartn_z\n"
+      "N ALA A 4294967297 1 2 3\n";
+    REQUIRE_THROWS_AS(mmtf::parseMmCIFFromBuffer(sd, overflow_cif.data(),
+                                                 overflow_cif.size()),
+                      mmtf::DecodeError);
+    REQUIRE_THROWS_AS(mmtf::parsePDBFromFile(sd, "does_not_exist.pdb"),
+                      mmtf::DecodeError);
+  }
+}
+
+namespace {
+struct PairCollector {
+  std::vector<std::pair<int32_t, int32_t> > pairs;
+  void operator()(int32_t i, int32_t j, float) {
+    pairs.push_back(std::make_pair(std::min(i, j), std::max(i, j)));
+  }
+};
+}
+
+TEST_CASE("Test SpatialIndex") {
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf");
+  const float cutoff = 3.0f;
+  mmtf::SpatialIndex index(sd, cutoff);
+  REQUIRE(index.numPoints() == sd.numAtoms);
+
+  // brute force reference
+  std::vector<std::pair<int32_t, int32_t> > reference;
+  for (int32_t i = 0; i < sd.numAtoms; ++i) {
+    for (int32_t j = i + 1; j < sd.numAtoms; ++j) {
+      const float dx = sd.xCoordList[i] - sd.xCoordList[j];
+      const float dy = sd.yCoordList[i] - sd.yCoordList[j];
+      const float dz = sd.zCoordList[i] - sd.zCoordList[j];
+      if (dx * dx + dy * dy + dz * dz <= cutoff * cutoff) {
+        reference.push_back(std::make_pair(i, j));
+      }
+    }
+  }
+
+  SECTION("all pairs") {
+    PairCollector collector;
+    index.forEachPairWithin(cutoff, collector);
+    std::sort(collector.pairs.begin(), collector.pairs.end());
+    REQUIRE(collector.pairs == reference);
+  }
+
+  SECTION("radius and nearest queries") {
+    std::vector<int32_t> found;
+    index.findWithinRadius(sd.xCoordList[0], sd.yCoordList[0],
+                           sd.zCoordList[0], cutoff, found);
+    size_t expected = 1; // atom itself
+    for (size_t i = 0; i < reference.size(); ++i) {
+      if (reference[i].first == 0) ++expected;
+    }
+    REQUIRE(found.size() == expected);
+
+    index.findNearest(sd.xCoordList[0], sd.yCoordList[0], sd.zCoordList[0],
+                      1, found);
+    REQUIRE(found.size() == 1);
+    REQUIRE(found[0] == 0);
+    index.findNearest(1e4f, 1e4f, 1e4f, 3, found);
+    REQUIRE(found.size() == 3);
+    index.findNearest(1e4f, 1e4f, 1e4f, 3, found, 10.0f);
+    REQUIRE(found.empty());
+  }
+
+  SECTION("non-finite coordinates") {
+    std::vector<float> x(sd.xCoordList), y(sd.yCoordList), z(sd.zCoordList);
+    x[1] = std::numeric_limits<float>::quiet_NaN();
+    y[2] = std::numeric_limits<float>::infinity();
+    z[3] = -std::numeric_limits<float>::infinity();
+    mmtf::SpatialIndex bad(&x[0], &y[0], &z[0], int32_t(x.size()), cutoff);
+    REQUIRE(bad.numPoints() == sd.numAtoms);
+    PairCollector collector;
+    bad.forEachPairWithin(cutoff, collector);
+    std::sort(collector.pairs.begin(), collector.pairs.end());
+    // pairs with atoms 1 to 3 are lost
+    std::vector<std::pair<int32_t, int32_t> > expected;
+    for (size_t i = 0; i < reference.size(); ++i) {
+      const int32_t a = reference[i].first, b = reference[i].second;
+      if ((a < 1 || a > 3) && (b < 1 || b > 3)) {
+        expected.push_back(reference[i]);
+      }
+    }
+    REQUIRE(collector.pairs == expected);
+    std::vector<int32_t> found;
+    bad.findNearest(x[1], y[1], z[1], 1, found);
+    REQUIRE(found.empty());
+    bad.findNearest(x[0], y[0], z[0], 1, found);
+    REQUIRE(found.size() == 1);
+    REQUIRE(found[0] == 0);
+  }
+}
+
+TEST_CASE("Test inferBonds") {
+  REQUIRE(mmtf::getCovalentRadius("C") == Approx(0.76));
+  REQUIRE(mmtf::getCovalentRadius("Fe") == mmtf::getCovalentRadius("FE"));
+  REQUIRE(mmtf::getCovalentRadius("Xx") == 0);
+
+  // all bonds as sorted pairs of atom indices
+  auto collectBonds = [](const mmtf::StructureData& sd) {
+    std::set<std::pair<int32_t, int32_t> > bonds;
+    mmtf::HierarchyIndex index(sd);
+    for (int32_t g = 0; g < index.numGroups(); ++g) {
+      const mmtf::GroupType& group = sd.groupList[sd.groupTypeList[g]];
+      for (size_t i = 0; i < group.bondAtomList.size(); i += 2) {
+        const int32_t a = group.bondAtomList[i] + index.atomBegin(g);
+        const int32_t b = group.bondAtomList[i + 1] + index.atomBegin(g);
+        bonds.insert(std::make_pair(std::min(a, b), std::max(a, b)));
+      }
+    }
+    for (size_t i = 0; i < sd.bondAtomList.size(); i += 2) {
+      const int32_t a = sd.bondAtomList[i];
+      const int32_t b = sd.bondAtomList[i + 1];
+      bonds.insert(std::make_pair(std::min(a, b), std::max(a, b)));
+    }
+    return bonds;
+  };
+
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/3NJW.mmtf");
+  const std::set<std::pair<int32_t, int32_t> > reference = collectBonds(sd);
+  const size_t num_groups = sd.groupList.size();
+
+  const int32_t num_bonds = mmtf::inferBonds(sd);
+  REQUIRE(num_bonds == sd.numBonds);
+  REQUIRE(sd.hasConsistentData());
+  REQUIRE(sd.groupList.size() <= num_groups * 2);
+  const std::set<std::pair<int32_t, int32_t> > inferred = collectBonds(sd);
+  REQUIRE(inferred.size() == size_t(num_bonds));
+  size_t found = 0;
+  for (auto bond : reference) found += inferred.count(bond);
+  REQUIRE(found >= reference.size() * 95 / 100);
+}
+
+TEST_CASE("Test buildAssembly") {
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf");
+  REQUIRE(!sd.bioAssemblyList.empty());
+  mmtf::HierarchyIndex index(sd);
+
+  mmtf::StructureData assembly;
+  mmtf::buildAssembly(assembly, sd, 0);
+  REQUIRE(assembly.hasConsistentData());
+  REQUIRE(assembly.bioAssemblyList.empty());
+
+  // expected size and first copy
+  const mmtf::BioAssembly& bio_assembly = sd.bioAssemblyList[0];
+  int32_t num_atoms = 0;
+  int32_t num_chains = 0;
+  for (size_t t = 0; t < bio_assembly.transformList.size(); ++t) {
+    const std::vector<int32_t>& chains = bio_assembly.transformList[t].chainIndexList;
+    for (size_t k = 0; k < chains.size(); ++k) {
+      num_atoms += index.chainAtomEnd(chains[k]) - index.chainAtomBegin(chains[k]);
+      ++num_chains;
+    }
+  }
+  REQUIRE(assembly.numAtoms == num_atoms);
+  REQUIRE(assembly.numChains == num_chains);
+
+  // matrices are row-major with translation in elements 3, 7 and 11
+  const float rotate_shift[16] = {0, -1, 0, 5, 1, 0, 0, 0, 0, 0, 1, -2,
+                                  0, 0, 0, 1};
+  const float px[2] = {1, -4}, py[2] = {2, 0.5f}, pz[2] = {3, 10};
+  float tx[2], ty[2], tz[2];
+  mmtf::transformCoordinates(rotate_shift, px, py, pz, 2, tx, ty, tz);
+  REQUIRE(tx[0] == Approx(3));
+  REQUIRE(ty[0] == Approx(1));
+  REQUIRE(tz[0] == Approx(1));
+  REQUIRE(tx[1] == Approx(4.5));
+  REQUIRE(ty[1] == Approx(-4));
+  REQUIRE(tz[1] == Approx(8));
+
+  // transform 2 of 3zqs maps (x, y, z) to (-x - 147.6, y, -z)
+  const int32_t chain = bio_assembly.transformList[0].chainIndexList[0];
+  const int32_t first = index.chainAtomBegin(chain);
+  const float twofold[16] = {-1, 0, 0, -147.6f, 0, 1, 0, 0, 0, 0, -1, 0,
+                             0, 0, 0, 1};
+  mmtf::BioAssembly literal;
+  literal.transformList.resize(1);
+  std::copy(twofold, twofold + 16, literal.transformList[0].matrix);
+  literal.transformList[0].chainIndexList.push_back(chain);
+  mmtf::StructureData mate;
+  mmtf::buildAssembly(mate, sd, literal);
+  REQUIRE(mate.xCoordList[0] == Approx(-sd.xCoordList[first] - 147.6f));
+  REQUIRE(mate.yCoordList[0] == Approx(sd.yCoordList[first]));
+  REQUIRE(mate.zCoordList[0] == Approx(-sd.zCoordList[first]));
+
+  // round trip through encoder
+  mmtf::StructureData decoded;
+  std::ostringstream out;
+  mmtf::encodeToStream(assembly, out);
+  const std::string buffer = out.str();
+  mmtf::decodeFromBuffer(decoded, buffer.data(), buffer.size());
+  REQUIRE(decoded.numAtoms == num_atoms);
+
+  // chains listed by several entities belong to the first one
+  mmtf::Entity duplicate;
+  duplicate.type = "non-polymer";
+  duplicate.chainIndexList.push_back(chain);
+  sd.entityList.push_back(duplicate);
+  mmtf::StructureData assembly2;
+  mmtf::buildAssembly(assembly2, sd, 0);
+  REQUIRE(assembly2.entityList.back().chainIndexList.empty());
+  for (size_t e = 0; e < assembly.entityList.size(); ++e) {
+    REQUIRE(assembly2.entityList[e].chainIndexList
+            == assembly.entityList[e].chainIndexList);
+  }
+
+  REQUIRE_THROWS_AS(mmtf::buildAssembly(assembly, sd, sd.bioAssemblyList.size()),
+                    mmtf::DecodeError);
+}
+
+TEST_CASE("Test AssemblyView") {
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf");
+  REQUIRE(!sd.bioAssemblyList.empty());
+  mmtf::StructureData assembly;
+  mmtf::buildAssembly(assembly, sd, 0);
+  mmtf::AssemblyView view(sd, 0);
+  REQUIRE(view.numAtoms() == assembly.numAtoms);
+  REQUIRE(view.numCopies() == assembly.numChains);
+  REQUIRE(view.numModels() == assembly.numModels);
+
+  // same atoms as full expansion (single and tiled access)
+  std::vector<float> x(view.numAtoms()), y(view.numAtoms()), z(view.numAtoms());
+  view.getCoordinates(0, view.numAtoms(), &x[0], &y[0], &z[0]);
+  mmtf::HierarchyIndex index(assembly);
+  for (int32_t i = 0; i < view.numAtoms(); i += 7) {
+    float xi, yi, zi;
+    view.getCoordinates(i, xi, yi, zi);
+    REQUIRE(xi == x[i]);
+    REQUIRE(yi == y[i]);
+    REQUIRE(zi == z[i]);
+    REQUIRE(x[i] == assembly.xCoordList[i]);
+    REQUIRE(z[i] == assembly.zCoordList[i]);
+    const mmtf::AtomIterator atom = view.sourceAtom(i);
+    REQUIRE(atom.atomName() == mmtf::AtomIterator(assembly, index, i).atomName());
+    REQUIRE(sd.chainIdList[atom.chainIndex()]
+            == assembly.chainIdList[index.chainIndexOfAtom(i)]);
+  }
+
+  // boxes enclose copies
+  for (int32_t k = 0; k < view.numCopies(); ++k) {
+    const float* box = view.copyBoundingBox(k);
+    for (int32_t i = view.copyAtomBegin(k); i < view.copyAtomEnd(k); ++i) {
+      REQUIRE(x[i] >= box[0] - 1e-3f);
+      REQUIRE(z[i] <= box[5] + 1e-3f);
+    }
+  }
+
+  // culled query equals brute force
+  const float radius = 12;
+  std::vector<int32_t> found, expected;
+  view.findWithinRadius(x[0], y[0], z[0], radius, found);
+  for (int32_t i = 0; i < view.numAtoms(); ++i) {
+    const float dx = x[i] - x[0], dy = y[i] - y[0], dz = z[i] - z[0];
+    if (dx * dx + dy * dy + dz * dz <= radius * radius) expected.push_back(i);
+  }
+  REQUIRE(found == expected);
+
+  // literal row-major operator (transform 2 of 3zqs: -x - 147.6, y, -z)
+  mmtf::HierarchyIndex sd_index(sd);
+  mmtf::BioAssembly twofold;
+  twofold.transformList.resize(1);
+  const float op[16] = {-1, 0, 0, -147.6f, 0, 1, 0, 0, 0, 0, -1, 0,
+                        0, 0, 0, 1};
+  std::copy(op, op + 16, twofold.transformList[0].matrix);
+  twofold.transformList[0].chainIndexList.push_back(0);
+  mmtf::AssemblyView mate_view(sd, twofold);
+  const int32_t mate_atoms = sd_index.chainAtomEnd(0);
+  REQUIRE(mate_view.numAtoms() == mate_atoms);
+  float source_box[6] = {sd.xCoordList[0], sd.yCoordList[0], sd.zCoordList[0],
+                         sd.xCoordList[0], sd.yCoordList[0], sd.zCoordList[0]};
+  for (int32_t i = 0; i < mate_atoms; ++i) {
+    float xi, yi, zi;
+    mate_view.getCoordinates(i, xi, yi, zi);
+    REQUIRE(xi == Approx(-sd.xCoordList[i] - 147.6f));
+    REQUIRE(yi == Approx(sd.yCoordList[i]));
+    REQUIRE(zi == Approx(-sd.zCoordList[i]));
+    source_box[0] = std::min(source_box[0], sd.xCoordList[i]);
+    source_box[1] = std::min(source_box[1], sd.yCoordList[i]);
+    source_box[2] = std::min(source_box[2], sd.zCoordList[i]);
+    source_box[3] = std::max(source_box[3], sd.xCoordList[i]);
+    source_box[4] = std::max(source_box[4], sd.yCoordList[i]);
+    source_box[5] = std::max(source_box[5], sd.zCoordList[i]);
+  }
+  const float* mate_box = mate_view.copyBoundingBox(0);
+  REQUIRE(mate_box[0] == Approx(-source_box[3] - 147.6f));
+  REQUIRE(mate_box[1] == Approx(source_box[1]));
+  REQUIRE(mate_box[2] == Approx(-source_box[5]));
+  REQUIRE(mate_box[3] == Approx(-source_box[0] - 147.6f));
+  REQUIRE(mate_box[4] == Approx(source_box[4]));
+  REQUIRE(mate_box[5] == Approx(-source_box[2]));
+
+  REQUIRE_THROWS_AS(mmtf::AssemblyView(sd, sd.bioAssemblyList.size()),
+                    mmtf::DecodeError);
+}
+
+TEST_CASE("Test crystal symmetry") {
+  SECTION("operators and cell matrices") {
+    std::vector<float> ops;
+    REQUIRE(mmtf::getSymmetryOperators("P 21 21 21", ops));
+    REQUIRE(ops.size() == 4 * 16);
+    REQUIRE(mmtf::getSymmetryOperators("P 1 21 1", ops));
+    REQUIRE(ops.size() == 2 * 16);
+    REQUIRE(mmtf::getSymmetryOperators("H 3 2", ops));
+    REQUIRE(ops.size() == 18 * 16);
+    REQUIRE(mmtf::getSymmetryOperators("F 41 3 2", ops));
+    REQUIRE(ops.size() == 96 * 16);
+    REQUIRE_FALSE(mmtf::getSymmetryOperators("X 1", ops));
+
+    // -x+1/2,-y,z+1/2 is part of P 21 21 21
+    float op[16];
+    REQUIRE(mmtf::parseSymmetryOperator("-x+1/2, -y, z+1/2", op));
+    // row-major as Transform::matrix (translation in elements 3, 7, 11)
+    const float expected_op[16] = {-1, 0, 0, 0.5f, 0, -1, 0, 0, 0, 0, 1, 0.5f,
+                                   0, 0, 0, 1};
+    REQUIRE(std::equal(op, op + 16, expected_op));
+    REQUIRE(mmtf::getSymmetryOperators("P 21 21 21", ops));
+    bool found = false;
+    for (size_t k = 0; k < ops.size(); k += 16) {
+      found = found || std::equal(op, op + 16, ops.begin() + k);
+    }
+    REQUIRE(found);
+    REQUIRE_FALSE(mmtf::parseSymmetryOperator("x,y", op));
+    REQUIRE_FALSE(mmtf::parseSymmetryOperator("x,y,q", op));
+
+    std::vector<float> cell = {50, 60, 70, 80, 100, 110};
+    float orth[16], frac[16];
+    REQUIRE(mmtf::getOrthogonalizationMatrix(cell, orth));
+    REQUIRE(mmtf::getFractionalizationMatrix(cell, frac));
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        float sum = 0;
+        for (int k = 0; k < 3; ++k) sum += orth[4 * i + k] * frac[4 * k + j];
+        REQUIRE(sum == Approx(i == j ? 1.0f : 0.0f).margin(1e-5));
+      }
+    }
+    // hexagonal cell: b has x component b * cos(gamma)
+    const std::vector<float> hex_cell = {50, 60, 70, 90, 90, 120};
+    REQUIRE(mmtf::getOrthogonalizationMatrix(hex_cell, orth));
+    REQUIRE(orth[0] == Approx(50));
+    REQUIRE(orth[1] == Approx(-30));
+    REQUIRE(orth[4] == Approx(0).margin(1e-5));
+    REQUIRE(orth[5] == Approx(51.961524));
+    REQUIRE(orth[3] == 0);
+    REQUIRE_FALSE(mmtf::getOrthogonalizationMatrix(std::vector<float>(), orth));
+  }
+
+  SECTION("mates in P 1") {
+    // two atoms 2 A apart across the cell boundary along a
+    std::string pdb;
+    char line[82];
+    snprintf(line, sizeof(line), "CRYST1%9.3f%9.3f%9.3f%7.2f%7.2f%7.2f %-11s%4d\n",
+             10.0, 10.0, 10.0, 90.0, 90.0, 90.0, "P 1", 1);
+    pdb += line;
+    for (int i = 0; i < 2; ++i) {
+      snprintf(line, sizeof(line),
+               "HETATM%5d  O   HOH %c%4d    %8.3f%8.3f%8.3f%6.2f%6.2f          %2s\n",
+               i + 1, 'A' + i, i + 1, i == 0 ? 1.0 : 9.0, 1.0, 1.0, 1.0, 0.0, "O");
+      pdb += line;
+    }
+    mmtf::StructureData sd;
+    mmtf::parsePDBFromBuffer(sd, pdb.data(), pdb.size());
+    REQUIRE(sd.spaceGroup == "P 1");
+    std::vector<mmtf::Transform> mates;
+    mmtf::findSymmetryMates(sd, 3.0f, mates);
+    REQUIRE(mates.size() == 2);
+    for (size_t k = 0; k < mates.size(); ++k) {
+      REQUIRE(mates[k].chainIndexList.size() == 1);
+      const int32_t chain = mates[k].chainIndexList[0];
+      REQUIRE(mates[k].matrix[3] == Approx(chain == 0 ? 10.0f : -10.0f));
+      REQUIRE(mates[k].matrix[12] == 0);
+    }
+    mmtf::findSymmetryMates(sd, 1.0f, mates);
+    REQUIRE(mates.empty());
+  }
+
+  SECTION("mates of a real structure") {
+    mmtf::StructureData sd;
+    mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf");
+    const float cutoff = 4.0f;
+    std::vector<mmtf::Transform> mates;
+    mmtf::findSymmetryMates(sd, cutoff, mates);
+    REQUIRE(!mates.empty());
+    // every reported chain has a contact
+    mmtf::HierarchyIndex index(sd);
+    mmtf::SpatialIndex grid(sd, cutoff);
+    std::vector<int32_t> neighbors;
+    for (size_t k = 0; k < mates.size(); ++k) {
+      for (size_t n = 0; n < mates[k].chainIndexList.size(); ++n) {
+        const int32_t chain = mates[k].chainIndexList[n];
+        bool contact = false;
+        for (int32_t i = index.chainAtomBegin(chain);
+             i < index.chainAtomEnd(chain) && !contact; ++i) {
+          float x, y, z;
+          mmtf::transformCoordinates(mates[k].matrix, &sd.xCoordList[i],
+                                     &sd.yCoordList[i], &sd.zCoordList[i], 1,
+                                     &x, &y, &z);
+          grid.findWithinRadius(x, y, z, cutoff, neighbors);
+          contact = !neighbors.empty();
+        }
+        REQUIRE(contact);
+      }
+    }
+    sd.spaceGroup = "unknown";
+    REQUIRE_THROWS_AS(mmtf::findSymmetryMates(sd, cutoff, mates),
+                      mmtf::DecodeError);
+  }
+}
+
+TEST_CASE("Test NCS expansion") {
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf");
+  // two row-major operators without identity: rotation by 90 degrees about
+  // z with translation (x, y, z) -> (-y + 10, x, z - 5) and a shift along x
+  const float rotation_op[16] = {0, -1, 0, 10, 1, 0, 0, 0, 0, 0, 1, -5,
+                                 0, 0, 0, 1};
+  const float shift_op[16] = {1, 0, 0, 100, 0, 1, 0, 0, 0, 0, 1, 0,
+                              0, 0, 0, 1};
+  std::vector<float> rotation(rotation_op, rotation_op + 16);
+  std::vector<float> shift(shift_op, shift_op + 16);
+  sd.ncsOperatorList.push_back(rotation);
+  sd.ncsOperatorList.push_back(shift);
+
+  std::vector<float> matrices;
+  mmtf::getNcsOperators(sd, matrices);
+  REQUIRE(matrices.size() == 32);
+  REQUIRE(matrices[16 + 3] == 100);
+
+  mmtf::BioAssembly ncs;
+  mmtf::getNcsAssembly(sd, ncs);
+  REQUIRE(ncs.transformList.size() == 3);  // identity added
+  REQUIRE(ncs.transformList[0].matrix[0] == 1);
+
+  mmtf::StructureData expanded;
+  mmtf::buildNcsAssembly(expanded, sd);
+  REQUIRE(expanded.hasConsistentData());
+  REQUIRE(expanded.numAtoms == 3 * sd.numAtoms);
+  mmtf::HierarchyIndex index(expanded);
+  // first model: original, rotated and shifted chains
+  const int32_t num = sd.chainsPerModel[0];
+  const int32_t rotated = index.chainAtomBegin(num);
+  const int32_t shifted = index.chainAtomBegin(2 * num);
+  REQUIRE(expanded.xCoordList[0] == sd.xCoordList[0]);
+  REQUIRE(expanded.xCoordList[rotated] == Approx(-sd.yCoordList[0] + 10));
+  REQUIRE(expanded.yCoordList[rotated] == Approx(sd.xCoordList[0]));
+  REQUIRE(expanded.zCoordList[rotated] == Approx(sd.zCoordList[0] - 5));
+  REQUIRE(expanded.xCoordList[shifted] == Approx(sd.xCoordList[0] + 100));
+  REQUIRE(expanded.yCoordList[shifted] == Approx(sd.yCoordList[0]));
+  REQUIRE(expanded.zCoordList[shifted] == Approx(sd.zCoordList[0]));
+
+  // view gives same coordinates
+  mmtf::AssemblyView view(sd, ncs);
+  REQUIRE(view.numAtoms() == expanded.numAtoms);
+  float x, y, z;
+  view.getCoordinates(rotated, x, y, z);
+  REQUIRE(x == expanded.xCoordList[rotated]);
+  REQUIRE(y == expanded.yCoordList[rotated]);
+
+  sd.ncsOperatorList[1].resize(12);
+  REQUIRE_THROWS_AS(mmtf::buildNcsAssembly(expanded, sd), mmtf::DecodeError);
+}
+
+TEST_CASE("Test model delta coordinates") {
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf");
+  mmtf::HierarchyIndex index(sd);
+
+  SECTION("binary codec") {
+    std::vector<int32_t> model_sizes;
+    for (int32_t m = 0; m < index.numModels(); ++m) {
+      model_sizes.push_back(index.modelAtomEnd(m) - index.modelAtomBegin(m));
+    }
+    const std::vector<char> encoded =
+      mmtf::encodeModelDeltaFloat(sd.xCoordList, model_sizes, 1000, 2);
+    msgpack::zone m_zone;
+    msgpack::object obj(encoded, m_zone);
+    mmtf::BinaryDecoder bd(obj, "xCoordList");
+    std::vector<float> decoded;
+    bd.decode(decoded);
+    REQUIRE(approx_equal_vector(decoded, sd.xCoordList));
+    for (int32_t m = 0; m < index.numModels(); ++m) {
+      std::vector<float> model;
+      bd.decodeModel(m, model);
+      REQUIRE(model == std::vector<float>(decoded.begin() + index.modelAtomBegin(m),
+                                          decoded.begin() + index.modelAtomEnd(m)));
+    }
+    std::vector<float> model;
+    REQUIRE_THROWS_AS(bd.decodeModel(index.numModels(), model),
+                      mmtf::DecodeError);
+    REQUIRE_THROWS_AS(mmtf::encodeModelDeltaFloat(sd.xCoordList, model_sizes, 1000, 0),
+                      mmtf::EncodeError);
+    // negative sizes are rejected even if the total matches
+    std::vector<int32_t> negative_sizes(model_sizes);
+    negative_sizes.push_back(-1);
+    negative_sizes.push_back(1);
+    REQUIRE_THROWS_AS(mmtf::encodeModelDeltaFloat(sd.xCoordList, negative_sizes, 1000),
+                      mmtf::EncodeError);
+    // model sizes whose 32 bit sum wraps around to the length are rejected
+    std::stringstream ss;
+    mmtf::add_header(ss, 1, 100, 1000);
+    const int32_t layout[] = {3, 1, 2147483647, 2147483647, 3, 0, 0, 0, 0};
+    mmtf::writeInts<int32_t>(ss, std::vector<int32_t>(layout, layout + 9));
+    const std::vector<char> wrapped = mmtf::stringstreamToCharVector(ss);
+    msgpack::object wrapped_obj(wrapped, m_zone);
+    mmtf::BinaryDecoder wrapped_bd(wrapped_obj, "xCoordList");
+    REQUIRE_THROWS_AS(wrapped_bd.decode(decoded), mmtf::DecodeError);
+    REQUIRE_THROWS_AS(wrapped_bd.decodeModel(0, model), mmtf::DecodeError);
+  }
+
+  SECTION("full round trip") {
+    msgpack::zone m_zone;
+    std::map<std::string, msgpack::object> data_map = mmtf::encodeToMap(sd, m_zone);
+    mmtf::encodeModelDeltaCoordinates(data_map, sd, m_zone);
+    std::stringstream buffer;
+    msgpack::pack(buffer, data_map);
+    const std::string packed = buffer.str();
+    mmtf::StructureData decoded;
+    mmtf::decodeFromBuffer(decoded, packed.data(), packed.size());
+    REQUIRE(decoded.numAtoms == sd.numAtoms);
+    REQUIRE(approx_equal_vector(decoded.xCoordList, sd.xCoordList));
+    REQUIRE(approx_equal_vector(decoded.yCoordList, sd.yCoordList));
+    REQUIRE(approx_equal_vector(decoded.zCoordList, sd.zCoordList));
+  }
+}
+
+TEST_CASE("Test ModelDecoder") {
+  const std::string filename = "../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf";
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, filename);
+  mmtf::HierarchyIndex index(sd);
+
+  SECTION("binary ranges") {
+    msgpack::zone m_zone;
+    msgpack::object obj(mmtf::encodeDeltaRecursiveFloat(sd.xCoordList, 1000),
+                        m_zone);
+    mmtf::BinaryDecoder bd(obj, "xCoordList");
+    std::vector<float> all;
+    bd.decode(all);
+    std::vector<int32_t> indices;
+    for (int32_t i = 0; i < sd.numAtoms; i += 97) indices.push_back(i);
+    indices.push_back(sd.numAtoms);
+    std::vector<mmtf::BinarySeekPoint> points;
+    bd.findSeekPoints(indices, points);
+    REQUIRE(points.size() == indices.size());
+    for (size_t i = 0; i + 1 < indices.size(); ++i) {
+      std::vector<float> part;
+      bd.decodeRange(points[i], indices[i + 1], part);
+      REQUIRE(part == std::vector<float>(all.begin() + indices[i],
+                                         all.begin() + indices[i + 1]));
+    }
+    std::vector<float> part;
+    bd.decodeRange(10, 20, part);
+    REQUIRE(part == std::vector<float>(all.begin() + 10, all.begin() + 20));
+    REQUIRE_THROWS_AS(bd.decodeRange(0, sd.numAtoms + 1, part),
+                      mmtf::DecodeError);
+    std::vector<int32_t> wrong_type;
+    REQUIRE_THROWS_AS(bd.decodeRange(0, 1, wrong_type), mmtf::DecodeError);
+  }
+
+  SECTION("single models") {
+    mmtf::ModelDecoder decoder;
+    decoder.initFromFile(filename);
+    REQUIRE(decoder.numModels() == sd.numModels);
+    int32_t num_bonds = 0;
+    for (int32_t m = 0; m < decoder.numModels(); ++m) {
+      mmtf::StructureData model;
+      decoder.decodeModel(model, m);
+      REQUIRE(model.hasConsistentData());
+      const int32_t atom_begin = index.modelAtomBegin(m);
+      const int32_t atom_end = index.modelAtomEnd(m);
+      const int32_t group_begin = index.groupBegin(index.chainBegin(m));
+      const int32_t group_end = index.groupBegin(index.chainEnd(m));
+      REQUIRE(model.numModels == 1);
+      REQUIRE(model.numAtoms == atom_end - atom_begin);
+      REQUIRE(model.xCoordList == std::vector<float>(sd.xCoordList.begin() + atom_begin,
+                                                     sd.xCoordList.begin() + atom_end));
+      REQUIRE(model.atomIdList == std::vector<int32_t>(sd.atomIdList.begin() + atom_begin,
+                                                       sd.atomIdList.begin() + atom_end));
+      REQUIRE(model.altLocList == std::vector<char>(sd.altLocList.begin() + atom_begin,
+                                                    sd.altLocList.begin() + atom_end));
+      REQUIRE(model.groupIdList == std::vector<int32_t>(sd.groupIdList.begin() + group_begin,
+                                                        sd.groupIdList.begin() + group_end));
+      REQUIRE(model.chainIdList == std::vector<std::string>(sd.chainIdList.begin() + index.chainBegin(m),
+                                                            sd.chainIdList.begin() + index.chainEnd(m)));
+      num_bonds += model.numBonds;
+    }
+    REQUIRE(num_bonds == sd.numBonds);
+    mmtf::StructureData model;
+    REQUIRE_THROWS_AS(decoder.decodeModel(model, sd.numModels), mmtf::DecodeError);
+  }
+
+  SECTION("model delta coordinates") {
+    msgpack::zone m_zone;
+    std::map<std::string, msgpack::object> data_map = mmtf::encodeToMap(sd, m_zone);
+    mmtf::encodeModelDeltaCoordinates(data_map, sd, m_zone, 1000, 2);
+    std::stringstream buffer;
+    msgpack::pack(buffer, data_map);
+    const std::string packed = buffer.str();
+    const int32_t last = sd.numModels - 1;
+    mmtf::StructureData model;
+    mmtf::decodeModelFromBuffer(model, packed.data(), packed.size(), last);
+    REQUIRE(model.hasConsistentData());
+    REQUIRE(approx_equal_vector(model.zCoordList,
+                                std::vector<float>(sd.zCoordList.begin() + index.modelAtomBegin(last),
+                                                   sd.zCoordList.end())));
+  }
+}
+
+TEST_CASE("Test checkpoints") {
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf");
+  msgpack::zone m_zone;
+  std::map<std::string, msgpack::object> data_map = mmtf::encodeToMap(sd, m_zone);
+  mmtf::encodeCheckpoints(data_map, m_zone, 100);
+  REQUIRE(data_map.count("extraProperties") == 1);
+  REQUIRE_THROWS_AS(mmtf::encodeCheckpoints(data_map, m_zone, 0), mmtf::EncodeError);
+  std::stringstream buffer;
+  msgpack::pack(buffer, data_map);
+  const std::string packed = buffer.str();
+
+  mmtf::MapDecoder md;
+  mmtf::mapDecoderFromBuffer(md, packed.data(), packed.size());
+  const std::vector<mmtf::BinarySeekPoint>* checkpoints = md.getCheckpoints("xCoordList");
+  REQUIRE(checkpoints != NULL);
+  REQUIRE(checkpoints->size() == size_t((sd.numAtoms - 1) / 100));
+  REQUIRE(md.getCheckpoints("chainIdList") == NULL);
+
+  // full decode in chunks, checkpoints are not kept
+  mmtf::StructureData decoded;
+  mmtf::decodeFromMapDecoder(decoded, md);
+  REQUIRE(decoded.extraProperties.empty());
+  REQUIRE(approx_equal_vector(decoded.xCoordList, sd.xCoordList));
+  REQUIRE(decoded.atomIdList == sd.atomIdList);
+  REQUIRE(decoded.groupIdList == sd.groupIdList);
+
+  // wrong checkpoints are detected and ignored
+  const msgpack::object* obj = md.getObject("xCoordList");
+  mmtf::BinaryDecoder bd(*obj, "xCoordList");
+  REQUIRE(bd.matchesCheckpoints(*checkpoints));
+  std::vector<mmtf::BinarySeekPoint> wrong(*checkpoints);
+  wrong[wrong.size() / 2].value += 1;
+  REQUIRE_FALSE(bd.matchesCheckpoints(wrong));
+  std::vector<float> values;
+  bd.decode(wrong, values);
+  REQUIRE(values == decoded.xCoordList);
+  std::vector<int32_t> wrong_type;
+  REQUIRE_THROWS_AS(bd.decode(*checkpoints, wrong_type), mmtf::DecodeError);
+
+  // stale table left by re-encoding a field is ignored
+  std::vector<int32_t> shifted_ids(sd.atomIdList);
+  for (size_t i = 0; i < shifted_ids.size(); ++i) shifted_ids[i] += int32_t(i % 3);
+  std::map<std::string, msgpack::object> stale_map(data_map);
+  stale_map["atomIdList"] = msgpack::object(mmtf::encodeRunLengthDeltaInt(shifted_ids), m_zone);
+  std::stringstream stale_buffer;
+  msgpack::pack(stale_buffer, stale_map);
+  const std::string stale = stale_buffer.str();
+  mmtf::StructureData stale_sd;
+  mmtf::decodeFromBuffer(stale_sd, stale.data(), stale.size());
+  REQUIRE(stale_sd.atomIdList == shifted_ids);
+  mmtf::ModelDecoder stale_decoder(stale.data(), stale.size());
+  mmtf::HierarchyIndex stale_index(sd);
+  mmtf::StructureData stale_model;
+  stale_decoder.decodeModel(stale_model, sd.numModels - 1);
+  REQUIRE(stale_model.atomIdList == std::vector<int32_t>(shifted_ids.begin() + stale_index.modelAtomBegin(sd.numModels - 1),
+                                                         shifted_ids.end()));
+
+  // models located via checkpoints
+  mmtf::ModelDecoder decoder(packed.data(), packed.size());
+  mmtf::HierarchyIndex index(sd);
+  const int32_t last = sd.numModels - 1;
+  mmtf::StructureData model;
+  decoder.decodeModel(model, last);
+  REQUIRE(model.atomIdList == std::vector<int32_t>(sd.atomIdList.begin() + index.modelAtomBegin(last),
+                                                   sd.atomIdList.end()));
+}
+
+TEST_CASE("Test field statistics") {
+  std::string fn("../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf");
+  mmtf::StructureData sd_ref;
+  mmtf::decodeFromFile(sd_ref, fn);
+
+  SECTION("decode") {
+    mmtf::MapDecoder md;
+    mmtf::mapDecoderFromFile(md, fn);
+    mmtf::Statistics stats;
+    mmtf::StructureData sd;
+    mmtf::decodeFromMapDecoder(sd, md, stats);
+    REQUIRE(sd_ref == sd);
+    const mmtf::Statistics::FieldMap& fields = stats.fields();
+    REQUIRE(fields.count("xCoordList") == 1);
+    const mmtf::FieldStatistics& x = fields.find("xCoordList")->second;
+    REQUIRE(x.key == "xCoordList");
+    REQUIRE(x.strategy == 10);
+    REQUIRE(x.numElements == uint64_t(sd.numAtoms));
+    REQUIRE(x.encodedBytes > 12);
+    REQUIRE(x.seconds >= 0);
+    REQUIRE(x.count == 1);
+    const mmtf::FieldStatistics& groups = fields.find("groupList")->second;
+    REQUIRE(groups.strategy == 0);
+    REQUIRE(groups.numElements == sd.groupList.size());
+    REQUIRE(fields.find("numAtoms")->second.numElements == 1);
+    // optional fields which are not in the file are not recorded
+    REQUIRE(fields.count("bondProperties") == 0);
+    REQUIRE(stats.totalBytes() > x.encodedBytes);
+
+    // sums over multiple files
+    mmtf::MapDecoder md2;
+    mmtf::mapDecoderFromFile(md2, fn);
+    mmtf::decodeFromMapDecoder(sd, md2, stats);
+    REQUIRE(stats.fields().find("xCoordList")->second.count == 2);
+    REQUIRE(stats.fields().find("xCoordList")->second.numElements
+            == 2 * uint64_t(sd.numAtoms));
+
+    // no overhead variant gives identical results
+    mmtf::MapDecoder md3;
+    mmtf::mapDecoderFromFile(md3, fn);
+    mmtf::NoStatistics no_stats;
+    mmtf::StructureData sd3;
+    mmtf::decodeFromMapDecoder(sd3, md3, no_stats);
+    REQUIRE(sd_ref == sd3);
+  }
+
+  SECTION("encode") {
+    msgpack::zone m_zone;
+    mmtf::Statistics stats;
+    std::map<std::string, msgpack::object> data_map =
+      mmtf::encodeToMap(sd_ref, m_zone, 1000, 100, 4, stats);
+    REQUIRE(stats.fields().size() == data_map.size());
+    const mmtf::FieldStatistics& ids = stats.fields().find("groupIdList")->second;
+    REQUIRE(ids.strategy == 8);
+    REQUIRE(ids.numElements == uint64_t(sd_ref.numGroups));
+    REQUIRE(ids.encodedBytes == data_map["groupIdList"].via.bin.size);
+    msgpack::zone m_zone2;
+    std::map<std::string, msgpack::object> plain_map =
+      mmtf::encodeToMap(sd_ref, m_zone2);
+    std::stringstream with_stats, without_stats;
+    msgpack::pack(with_stats, data_map);
+    msgpack::pack(without_stats, plain_map);
+    REQUIRE(with_stats.str() == without_stats.str());
+  }
+}
+
+TEST_CASE("Test synthetic structures") {
+  mmtf::SyntheticOptions options;
+  options.numAtoms = 5000;
+  mmtf::StructureData sd;
+  mmtf::generateSyntheticStructure(sd, options);
+  REQUIRE(sd.hasConsistentData());
+  REQUIRE(sd.numAtoms == 5000);
+  REQUIRE(sd.numModels == 1);
+  REQUIRE(sd.numBonds > sd.numAtoms / 2);
+  REQUIRE(std::count(sd.altLocList.begin(), sd.altLocList.end(), 'B') > 0);
+  REQUIRE(sd.experimentalMethods.size() == 1);
+
+  // deterministic by seed
+  mmtf::StructureData same;
+  mmtf::generateSyntheticStructure(same, options);
+  REQUIRE(same == sd);
+  options.seed = 7;
+  mmtf::StructureData other;
+  mmtf::generateSyntheticStructure(other, options);
+  REQUIRE_FALSE(other == sd);
+
+  // loss-less encoding
+  std::stringstream buffer;
+  mmtf::encodeToStream(sd, buffer);
+  const std::string packed = buffer.str();
+  mmtf::StructureData decoded;
+  mmtf::decodeFromBuffer(decoded, packed.data(), packed.size());
+  REQUIRE(decoded == sd);
+
+  // models
+  options.numAtoms = 1000;
+  options.numModels = 5;
+  options.waterFraction = 0;
+  mmtf::generateSyntheticStructure(sd, options);
+  REQUIRE(sd.hasConsistentData());
+  REQUIRE(sd.numModels == 5);
+  mmtf::HierarchyIndex index(sd);
+  REQUIRE(index.modelAtomEnd(0) == 1000);
+  REQUIRE(sd.numAtoms == 5 * index.modelAtomEnd(0));
+  REQUIRE(sd.groupTypeList[0] == sd.groupTypeList[sd.numGroups / 5]);
+
+  // exact size also for tiny structures
+  options.numModels = 1;
+  options.waterFraction = 0.1f;
+  for (int32_t num_atoms = 1; num_atoms <= 60; num_atoms += 7) {
+    options.numAtoms = num_atoms;
+    mmtf::generateSyntheticStructure(sd, options);
+    REQUIRE(sd.hasConsistentData());
+    REQUIRE(sd.numAtoms == num_atoms);
+  }
+
+  options.numAtoms = 0;
+  REQUIRE_THROWS_AS(mmtf::generateSyntheticStructure(sd, options), mmtf::EncodeError);
+  options.numAtoms = 1 << 30;
+  options.numModels = 2;
+  REQUIRE_THROWS_AS(mmtf::generateSyntheticStructure(sd, options), mmtf::EncodeError);
+}
+
+TEST_CASE("Test consistency check and trusted encoding") {
+  mmtf::SyntheticOptions options;
+  options.numAtoms = 3000;
+  options.numModels = 2;
+  mmtf::StructureData sd;
+  mmtf::generateSyntheticStructure(sd, options);
+  REQUIRE(sd.hasConsistentData());
+
+  SECTION("bond orders are checked in unused group types") {
+    mmtf::GroupType unused = sd.groupList[0];
+    unused.bondOrderList[0] = 0;
+    sd.groupList.push_back(unused);
+    REQUIRE_FALSE(sd.hasConsistentData());
+    sd.groupList.back().bondOrderList[0] = -1;
+    REQUIRE(sd.hasConsistentData());
+  }
+  SECTION("invalid group type index") {
+    sd.groupTypeList[sd.numGroups - 1] = int32_t(sd.groupList.size());
+    REQUIRE_FALSE(sd.hasConsistentData());
+    sd.groupTypeList[sd.numGroups - 1] = -1;
+    REQUIRE_FALSE(sd.hasConsistentData());
+  }
+  SECTION("invalid hierarchy counts") {
+    sd.groupsPerChain[0] += 1;
+    REQUIRE_FALSE(sd.hasConsistentData());
+    sd.groupsPerChain[1] -= 1;
+    REQUIRE(sd.hasConsistentData());
+    sd.groupsPerChain[0] = -1;
+    REQUIRE_FALSE(sd.hasConsistentData());
+  }
+  SECTION("copies keep bond resonances") {
+    sd.bondResonanceList.assign(sd.bondOrderList.size(), 0);
+    for (size_t i = 0; i < sd.groupList.size(); ++i) {
+      mmtf::GroupType& group = sd.groupList[i];
+      group.bondResonanceList.assign(group.bondOrderList.size(), 0);
+    }
+    mmtf::StructureData copy(sd);
+    REQUIRE(copy.bondResonanceList == sd.bondResonanceList);
+    REQUIRE(copy.hasConsistentData());
+  }
+  SECTION("trusted encoding skips check") {
+    sd.depositionDate = "yesterday";
+    REQUIRE_FALSE(sd.hasConsistentData());
+    msgpack::zone zone;
+    REQUIRE_THROWS_AS(mmtf::encodeToMap(sd, zone), mmtf::EncodeError);
+    std::stringstream buffer;
+    mmtf::encodeToStream(sd, buffer, 1000, 100, 4, false);
+    const std::string packed = buffer.str();
+    mmtf::StructureData decoded;
+    mmtf::decodeFromBuffer(decoded, packed.data(), packed.size());
+    REQUIRE(decoded == sd);
+  }
+}
+
+TEST_CASE("Test validation report") {
+  mmtf::SyntheticOptions options;
+  options.numAtoms = 3000;
+  options.numModels = 2;
+  mmtf::StructureData sd;
+  mmtf::generateSyntheticStructure(sd, options);
+  mmtf::ValidationReport report;
+  REQUIRE(sd.validate(report));
+  REQUIRE(report.isValid());
+
+  // all issues are collected
+  sd.depositionDate = "yesterday";
+  sd.groupList[0].bondOrderList[0] = 5;
+  sd.groupList[0].bondAtomList[1] = 100;
+  sd.bondOrderList[2] = 0;
+  sd.bFactorList.pop_back();
+  sd.groupTypeList[10] = -1;
+  sd.chainIdList[1] = "ABCDE";
+  REQUIRE_FALSE(sd.validate(report));
+  REQUIRE(report.issues().size() == 7);
+  REQUIRE_FALSE(report.isFull());
+  REQUIRE(report.count(mmtf::VALIDATION_INVALID_VALUE) == 2);
+  REQUIRE(report.count(mmtf::VALIDATION_INVALID_INDEX) == 2);
+  REQUIRE(report.count(mmtf::VALIDATION_INVALID_FORMAT) == 2);
+  REQUIRE(report.count(mmtf::VALIDATION_WRONG_SIZE) == 1);
+  const mmtf::ValidationIssue& issue = report.issues()[1];
+  REQUIRE(issue.code == mmtf::VALIDATION_INVALID_VALUE);
+  REQUIRE(issue.field == "groupList[0].bondOrderList");
+  REQUIRE(issue.index == 0);
+  REQUIRE(report.issues()[2].field == "groupList[0].bondAtomList");
+  REQUIRE(report.issues()[2].index == 1);
+  REQUIRE(report.issues()[5].field == "groupTypeList");
+  REQUIRE(report.issues()[5].index == 10);
+  REQUIRE(std::string(mmtf::getValidationCodeName(issue.code))
+          == "invalid_value");
+
+  // capped report stops early
+  mmtf::ValidationReport capped(3);
+  REQUIRE_FALSE(sd.validate(capped));
+  REQUIRE(capped.isFull());
+  REQUIRE(capped.issues().size() == 3);
+  REQUIRE(capped.issues()[2].field == report.issues()[2].field);
+  REQUIRE_FALSE(sd.hasConsistentData());
+
+  // dependent checks are skipped
+  sd.groupsPerChain.pop_back();
+  REQUIRE_FALSE(sd.validate(report));
+  REQUIRE(report.count(mmtf::VALIDATION_WRONG_COUNT) == 0);
+  REQUIRE(report.issues().back().field == "groupsPerChain");
+}
+
+TEST_CASE("Test fixed width string list") {
+  std::vector<std::string> ids;
+  ids.push_back("A");
+  ids.push_back("");
+  ids.push_back("ABCD");
+  ids.push_back("xy");
+  const std::vector<char> encoded = mmtf::encodeStringVector(ids, 4);
+  const std::string binary(encoded.begin(), encoded.end());
+  mmtf::BinaryDecoder bd(binary, "chainIdList");
+  mmtf::FixedWidthStringList packed;
+  bd.decode(packed);
+  REQUIRE(packed.width() == 4);
+  REQUIRE(packed.size() == 4);
+  REQUIRE(packed.bytes().size() == 16);
+  REQUIRE(packed.get(0) == "A");
+  REQUIRE(packed[1] == "");
+  REQUIRE(packed.length(2) == 4);
+  REQUIRE(std::string(packed.data(3), 2) == "xy");
+  REQUIRE(packed.toVector() == ids);
+  REQUIRE(packed == mmtf::FixedWidthStringList(ids, 4));
+
+  // encoding copies records (or repacks for other widths)
+  REQUIRE(mmtf::encodeStringVector(packed, 4) == encoded);
+  REQUIRE(mmtf::encodeStringVector(packed, 5)
+          == mmtf::encodeStringVector(ids, 5));
+
+  // modification
+  packed.set(1, "Q");
+  packed.push_back("BB");
+  REQUIRE(packed.size() == 5);
+  REQUIRE(packed.get(1) == "Q");
+  REQUIRE(packed.get(4) == "BB");
+  REQUIRE_THROWS_AS(packed.push_back("ABCDE"), mmtf::EncodeError);
+  REQUIRE_THROWS_AS(packed.set(0, "ABCDE"), mmtf::EncodeError);
+
+  // same strings as std::string decoding for full files
+  mmtf::MapDecoder md;
+  mmtf::mapDecoderFromFile(md,
+      "../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf");
+  mmtf::StructureData sd;
+  mmtf::decodeFromMapDecoder(sd, md);
+  mmtf::FixedWidthStringList chain_ids;
+  md.decode("chainIdList", true, chain_ids);
+  REQUIRE(chain_ids.toVector() == sd.chainIdList);
+
+  // unencoded array of empty strings gives width 0 (but keeps its size)
+  msgpack::zone zone;
+  std::map<std::string, msgpack::object> map_in;
+  map_in["chainIdList"]
+    = msgpack::object(std::vector<std::string>(3), zone);
+  mmtf::FixedWidthStringList empty_ids;
+  mmtf::MapDecoder(map_in).decode("chainIdList", true, empty_ids);
+  REQUIRE(empty_ids.width() == 0);
+  REQUIRE(empty_ids.size() == 3);
+  REQUIRE(empty_ids.get(2) == "");
+  empty_ids.push_back("");
+  REQUIRE(empty_ids.toVector() == std::vector<std::string>(4));
+  REQUIRE_THROWS_AS(empty_ids.push_back("A"), mmtf::EncodeError);
+}
+
+TEST_CASE("Test property views") {
+  std::string working_mmtf = "../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf";
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, working_mmtf);
+  std::vector<float> charges;
+  std::vector<int32_t> features;
+  for (int32_t i = 0; i < sd.numAtoms; ++i) {
+    charges.push_back(float(i % 7) * 0.5f - 1.5f);
+    features.push_back(i % 3);
+  }
+  sd.atomProperties["charge"]
+    = msgpack::object(mmtf::encodeDeltaRecursiveFloat(charges, 10), sd.msgpack_zone);
+  sd.atomProperties["feature"] = msgpack::object(features, sd.msgpack_zone);
+  sd.extraProperties["note"] = msgpack::object("hello", sd.msgpack_zone);
+  mmtf::encodeToFile(sd, "test_property_views.mmtf");
+
+  // decode without copying property maps
+  mmtf::MapDecoder md;
+  mmtf::mapDecoderFromFile(md, "test_property_views.mmtf");
+  mmtf::StructureData sd2;
+  mmtf::decodeFromMapDecoder(sd2, md, false);
+  REQUIRE(sd2.atomProperties.empty());
+  REQUIRE(sd2.numAtoms == sd.numAtoms);
+
+  mmtf::PropertyView atom_props(md, "atomProperties");
+  REQUIRE(atom_props.size() == 2);
+  REQUIRE(atom_props.has("charge"));
+  REQUIRE(!atom_props.has("NONEXISTANT"));
+  REQUIRE(atom_props.names()[1] == "feature");
+  REQUIRE(atom_props.isBinary("charge"));
+  REQUIRE(!atom_props.isBinary("feature"));
+  REQUIRE(atom_props.strategy("charge") == 10);
+  REQUIRE(atom_props.strategy("feature") == -1);
+  REQUIRE(atom_props.length("charge") == sd.numAtoms);
+  REQUIRE(atom_props.length("feature") == sd.numAtoms);
+
+  std::vector<float> charges_in;
+  std::vector<int32_t> features_in, nothing;
+  REQUIRE(atom_props.decode("charge", charges_in));
+  REQUIRE(atom_props.decode("feature", features_in));
+  REQUIRE(!atom_props.decode("NONEXISTANT", nothing));
+  REQUIRE(charges_in == charges);
+  REQUIRE(features_in == features);
+
+  // partial access
+  std::vector<float> charge_range;
+  std::vector<int32_t> feature_range;
+  REQUIRE(atom_props.decodeRange("charge", 5, 12, charge_range));
+  REQUIRE(atom_props.decodeRange("feature", 5, 12, feature_range));
+  REQUIRE(charge_range
+          == std::vector<float>(charges.begin() + 5, charges.begin() + 12));
+  REQUIRE(feature_range
+          == std::vector<int32_t>(features.begin() + 5, features.begin() + 12));
+  REQUIRE_THROWS_AS(atom_props.decodeRange("feature", 5, sd.numAtoms + 1,
+                                           feature_range),
+                    mmtf::DecodeError);
+  mmtf::BinaryDecoder bd = atom_props.binary("charge");
+  bd.decodeRange(0, 3, charge_range);
+  REQUIRE(charge_range.size() == 3);
+  REQUIRE_THROWS_AS(atom_props.binary("NONEXISTANT"), mmtf::DecodeError);
+
+  std::string note;
+  REQUIRE(mmtf::PropertyView(md, "extraProperties").decode("note", note));
+  REQUIRE(note == "hello");
+  REQUIRE(mmtf::PropertyView(md, "bondProperties").empty());
+}
+
+// helper to decode output of an encoder
+template <typename T>
+std::vector<T> decode_encoded(const std::vector<char>& encoded,
+                              int32_t strategy) {
+  const std::string binary(encoded.begin(), encoded.end());
+  mmtf::BinaryDecoder bd(binary, "a_test");
+  REQUIRE(bd.strategy() == strategy);
+  std::vector<T> decoded;
+  bd.decode(decoded);
+  return decoded;
+}
+
+TEST_CASE("Test property columns") {
+  // encoders for all strategies
+  std::vector<float> floats;
+  std::vector<int32_t> ints;
+  std::vector<int16_t> shorts;
+  for (int32_t i = 0; i < 100; ++i) {
+    floats.push_back(float(i % 9) * 0.25f - 1.0f);
+    ints.push_back((i / 10) * 1000 - 40000);
+    shorts.push_back(int16_t(i * 300 - 15000));
+  }
+  floats[50] = 1234.5f;
+  REQUIRE(approx_equal_vector(decode_encoded<float>(
+      mmtf::encodeFourByteFloat(floats), 1), floats));
+  REQUIRE(decode_encoded<int16_t>(mmtf::encodeTwoByteInt(shorts), 3)
+          == shorts);
+  REQUIRE(decode_encoded<int32_t>(mmtf::encodeRunLengthInt(ints), 7) == ints);
+  REQUIRE(approx_equal_vector(decode_encoded<float>(
+      mmtf::encodeTwoByteFloat(floats, 10), 11), floats));
+  REQUIRE(approx_equal_vector(decode_encoded<float>(
+      mmtf::encodeRecursiveFloat(floats, 100), 12), floats));
+  REQUIRE(approx_equal_vector(decode_encoded<float>(
+      mmtf::encodeRecursiveByteFloat(floats, 100), 13), floats));
+  REQUIRE(decode_encoded<int32_t>(mmtf::encodeRecursiveInt(ints), 14) == ints);
+  REQUIRE(decode_encoded<int32_t>(mmtf::encodeRecursiveByteInt(ints), 15)
+          == ints);
+  REQUIRE(mmtf::encodeBinary(ints, 8) == mmtf::encodeRunLengthDeltaInt(ints));
+  REQUIRE(mmtf::encodeBinary(floats, 10, 100)
+          == mmtf::encodeDeltaRecursiveFloat(floats, 100));
+  REQUIRE_THROWS_AS(mmtf::encodeTwoByteFloat(floats, 100), mmtf::EncodeError);
+  REQUIRE_THROWS_AS(mmtf::encodeBinary(floats, 4), mmtf::EncodeError);
+  REQUIRE_THROWS_AS(mmtf::encodeBinary(ints, 10), mmtf::EncodeError);
+  // float strategies other than 1 need a multiplier
+  const float few_floats[3] = {0.25f, -1.5f, 3.75f};
+  const std::vector<float> few(few_floats, few_floats + 3);
+  for (int32_t strategy = 9; strategy <= 13; ++strategy) {
+    REQUIRE_THROWS_AS(mmtf::encodeBinary(few, strategy), mmtf::EncodeError);
+    REQUIRE_THROWS_AS(mmtf::encodeBinary(few, strategy, -4),
+                      mmtf::EncodeError);
+  }
+  REQUIRE(mmtf::encodeBinary(few, 1) == mmtf::encodeFourByteFloat(few));
+
+  // typed per-atom columns
+  std::string working_mmtf = "../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf";
+  mmtf::StructureData sd, sd2;
+  mmtf::decodeFromFile(sd, working_mmtf);
+  std::vector<float> charges;
+  std::vector<int32_t> features;
+  for (int32_t i = 0; i < sd.numAtoms; ++i) {
+    charges.push_back(float(i % 13) * 0.05f - 0.3f);
+    features.push_back(i / 50);
+  }
+  std::stringstream plain, binary;
+  sd.atomProperties["charge"] = msgpack::object(charges, sd.msgpack_zone);
+  mmtf::encodeToStream(sd, plain);
+  mmtf::setAtomPropertyColumn(sd, "charge", charges, 10, 100);
+  mmtf::setAtomPropertyColumn(sd, "feature", features, 8);
+  REQUIRE_THROWS_AS(mmtf::setAtomPropertyColumn(sd, "bad", ints, 8),
+                    mmtf::EncodeError);
+  REQUIRE_THROWS_AS(mmtf::setAtomPropertyColumn(sd, "bad", features, 10),
+                    mmtf::EncodeError);
+  // strings need a length parameter that fits all of them
+  std::vector<std::string> names(sd.numAtoms, "CA");
+  REQUIRE_THROWS_AS(mmtf::setAtomPropertyColumn(sd, "bad", names, 5),
+                    mmtf::EncodeError);
+  REQUIRE_THROWS_AS(mmtf::setAtomPropertyColumn(sd, "bad", names, 5, 1),
+                    mmtf::EncodeError);
+  REQUIRE_THROWS_AS(mmtf::setAtomPropertyColumn(sd, "bad", charges, 10),
+                    mmtf::EncodeError);
+  REQUIRE(sd.atomProperties.count("bad") == 0);
+  mmtf::encodeToStream(sd, binary);
+  // binary column (with extra feature column) is smaller than plain floats
+  REQUIRE(binary.str().size() < plain.str().size());
+
+  mmtf::decodeFromBuffer(sd2, binary.str().data(), binary.str().size());
+  std::vector<float> charges_in;
+  std::vector<int32_t> features_in;
+  REQUIRE(mmtf::getAtomPropertyColumn(sd2, "charge", charges_in));
+  REQUIRE(mmtf::getAtomPropertyColumn(sd2, "feature", features_in));
+  REQUIRE(!mmtf::getAtomPropertyColumn(sd2, "NONEXISTANT", features_in));
+  REQUIRE(approx_equal_vector(charges_in, charges));
+  REQUIRE(features_in == features);
+
+  // other levels
+  std::vector<int32_t> group_flags(sd.numGroups, 1);
+  mmtf::setGroupPropertyColumn(sd, "flag", group_flags, 7);
+  REQUIRE(mmtf::getGroupPropertyColumn(sd, "flag", features_in));
+  REQUIRE(features_in == group_flags);
+  REQUIRE_THROWS_AS(mmtf::setChainPropertyColumn(sd, "flag", group_flags, 7),
+                    mmtf::EncodeError);
 }
 
+TEST_CASE("Test tiled encoding") {
+  mmtf::StructureData sd;
+  mmtf::decodeFromFile(sd, "../submodules/mmtf_spec/test-suite/mmtf/1AUY.mmtf");
+  sd.extraProperties["app"] = msgpack::object(42, sd.msgpack_zone);
+  msgpack::zone m_zone;
+  std::map<std::string, msgpack::object> data_map = mmtf::encodeToMap(sd, m_zone);
+  REQUIRE_THROWS_AS(mmtf::encodeTiles(data_map, sd, m_zone, 0), mmtf::EncodeError);
+  const int32_t tile_size = 100;
+  mmtf::encodeTiles(data_map, sd, m_zone, tile_size);
+  REQUIRE(data_map.count("xCoordList") == 0);
+  REQUIRE(data_map.count("groupIdList") == 1);
+  std::stringstream buffer;
+  msgpack::pack(buffer, data_map);
+  const std::string packed = buffer.str();
+
+  // tiles are concatenated transparently and not kept in extraProperties
+  mmtf::StructureData decoded;
+  mmtf::decodeFromBuffer(decoded, packed.data(), packed.size());
+  REQUIRE(approx_equal_vector(decoded.xCoordList, sd.xCoordList));
+  REQUIRE(approx_equal_vector(decoded.bFactorList, sd.bFactorList));
+  REQUIRE(decoded.atomIdList == sd.atomIdList);
+  REQUIRE(decoded.altLocList == sd.altLocList);
+  REQUIRE(decoded.extraProperties.size() == 1);
+  REQUIRE(decoded.extraProperties.count("app") == 1);
+
+  // single tiles
+  mmtf::TiledDecoder tiled;
+  tiled.initFromBuffer(packed.data(), packed.size());
+  REQUIRE(tiled.numAtoms() == sd.numAtoms);
+  REQUIRE(tiled.tileSize() == tile_size);
+  REQUIRE(tiled.numTiles() == (sd.numAtoms + tile_size - 1) / tile_size);
+  REQUIRE(tiled.header().xCoordList.empty());
+  REQUIRE(tiled.header().groupIdList == sd.groupIdList);
+  REQUIRE(tiled.isTiled("zCoordList"));
+  REQUIRE_FALSE(tiled.isTiled("groupIdList"));
+  for (int32_t t = 0; t < tiled.numTiles(); ++t) {
+    const int32_t begin = tiled.tileBegin(t);
+    const int32_t end = tiled.tileEnd(t);
+    std::vector<float> z;
+    std::vector<int32_t> ids;
+    REQUIRE(tiled.decodeTile("zCoordList", t, z));
+    REQUIRE(tiled.decodeTile("atomIdList", t, ids));
+    REQUIRE(z == std::vector<float>(decoded.zCoordList.begin() + begin,
+                                    decoded.zCoordList.begin() + end));
+    REQUIRE(ids == std::vector<int32_t>(sd.atomIdList.begin() + begin,
+                                        sd.atomIdList.begin() + end));
+  }
+  std::vector<float> values;
+  REQUIRE_FALSE(tiled.decodeTile("groupIdList", 0, values));
+  REQUIRE_THROWS_AS(tiled.decodeTile("xCoordList", tiled.numTiles(), values),
+                    mmtf::DecodeError);
+  REQUIRE_THROWS_AS(tiled.initFromFile("../submodules/mmtf_spec/test-suite/mmtf/173D.mmtf"),
+                    mmtf::DecodeError);
+
+  // ranges across tile borders and single models
+  mmtf::MapDecoder md;
+  mmtf::mapDecoderFromBuffer(md, packed.data(), packed.size());
+  md.decodeTiledRange("yCoordList", tile_size - 10, tile_size + 10, values);
+  REQUIRE(values == std::vector<float>(decoded.yCoordList.begin() + tile_size - 10,
+                                       decoded.yCoordList.begin() + tile_size + 10));
+  REQUIRE_THROWS_AS(md.decodeTiledRange("yCoordList", 0, sd.numAtoms + 1, values),
+                    mmtf::DecodeError);
+  mmtf::ModelDecoder decoder(packed.data(), packed.size());
+  mmtf::HierarchyIndex index(sd);
+  const int32_t last = sd.numModels - 1;
+  mmtf::StructureData model;
+  decoder.decodeModel(model, last);
+  REQUIRE(model.atomIdList == std::vector<int32_t>(sd.atomIdList.begin() + index.modelAtomBegin(last),
+                                                   sd.atomIdList.end()));
+}
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>